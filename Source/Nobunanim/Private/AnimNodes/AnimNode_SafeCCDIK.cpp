@@ -5,6 +5,8 @@
 #include "AnimationRuntime.h"
 #include "DrawDebugHelpers.h"
 #include "Animation/AnimInstanceProxy.h"
+#include "Algo/Reverse.h"
+#include "Nobunanim/Public/GaitMath.h"
 
 PRAGMA_DISABLE_OPTIMIZATION
 /////////////////////////////////////////////////////
@@ -53,53 +55,62 @@ void FAnimNode_SafeCCDIK::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseC
 	FVector const CSEffectorLocation = CSEffectorTransform.GetLocation();
 
 	// Gather all bone indices between root and tip.
-	TArray<FCompactPoseBoneIndex> BoneIndices;
+	BoneIndices.Reset();
 
 	{
 		const FCompactPoseBoneIndex RootIndex = RootBone.GetCompactPoseIndex(BoneContainer);
 		FCompactPoseBoneIndex BoneIndex = TipBone.GetCompactPoseIndex(BoneContainer);
 		do
 		{
-			BoneIndices.Insert(BoneIndex, 0);
+			BoneIndices.Add(BoneIndex);
 			BoneIndex = Output.Pose.GetPose().GetParentBoneIndex(BoneIndex);
 		} while (BoneIndex != RootIndex);
-		BoneIndices.Insert(BoneIndex, 0);
+		BoneIndices.Add(BoneIndex);
+
+		// Gathered from tip to root.
+		Algo::Reverse(BoneIndices);
 	}
 
 	// Gather transforms
 	int32 const NumTransforms = BoneIndices.Num();
 	OutBoneTransforms.AddUninitialized(NumTransforms);
+	LocalTransforms.Reset(NumTransforms);
+
+	for (int32 TransformIndex = 0; TransformIndex < NumTransforms; TransformIndex++)
+	{
+		const FCompactPoseBoneIndex& BoneIndex = BoneIndices[TransformIndex];
+
+		OutBoneTransforms[TransformIndex] = FBoneTransform(BoneIndex, Output.Pose.GetComponentSpaceTransform(BoneIndex));
+		LocalTransforms.Add(Output.Pose.GetLocalSpaceTransform(BoneIndex));
+	}
+
+	SolveChain(OutBoneTransforms, LocalTransforms, CSEffectorLocation);
+}
+
+bool FAnimNode_SafeCCDIK::SolveChain(TArray<FBoneTransform>& InOutBoneTransforms, const TArray<FTransform>& InLocalTransforms, const FVector& TargetLocation)
+{
+	int32 const NumTransforms = InOutBoneTransforms.Num();
 
 	// Gather chain links. These are non zero length bones.
-	TArray<SafeCCDIKChainLink> Chain;
-	Chain.Reserve(NumTransforms);
+	Chain.Reset(NumTransforms);
 	// Start with Root Bone
 	{
-		const FCompactPoseBoneIndex& RootBoneIndex = BoneIndices[0];
-		const FTransform& LocalTransform = Output.Pose.GetLocalSpaceTransform(RootBoneIndex);
-		const FTransform& BoneCSTransform = Output.Pose.GetComponentSpaceTransform(RootBoneIndex);
-
-		OutBoneTransforms[0] = FBoneTransform(RootBoneIndex, BoneCSTransform);
-		Chain.Add(SafeCCDIKChainLink(BoneCSTransform, LocalTransform, RootBoneIndex, 0));
+		const FBoneTransform& RootBoneTransform = InOutBoneTransforms[0];
+		Chain.Add(SafeCCDIKChainLink(RootBoneTransform.Transform, InLocalTransforms[0], RootBoneTransform.BoneIndex, 0));
 	}
 
 	// Go through remaining transforms
 	for (int32 TransformIndex = 1; TransformIndex < NumTransforms; TransformIndex++)
 	{
-		const FCompactPoseBoneIndex& BoneIndex = BoneIndices[TransformIndex];
-
-		const FTransform& LocalTransform = Output.Pose.GetLocalSpaceTransform(BoneIndex);
-		const FTransform& BoneCSTransform = Output.Pose.GetComponentSpaceTransform(BoneIndex);
-		FVector const BoneCSPosition = BoneCSTransform.GetLocation();
-
-		OutBoneTransforms[TransformIndex] = FBoneTransform(BoneIndex, BoneCSTransform);
+		const FBoneTransform& BoneTransform = InOutBoneTransforms[TransformIndex];
+		FVector const BoneCSPosition = BoneTransform.Transform.GetLocation();
 
 		// Calculate the combined length of this segment of skeleton
-		float const BoneLength = FVector::Dist(BoneCSPosition, OutBoneTransforms[TransformIndex - 1].Transform.GetLocation());
+		float const BoneLength = FVector::Dist(BoneCSPosition, InOutBoneTransforms[TransformIndex - 1].Transform.GetLocation());
 
 		if (!FMath::IsNearlyZero(BoneLength))
 		{
-			Chain.Add(SafeCCDIKChainLink(BoneCSTransform, LocalTransform, BoneIndex, TransformIndex));
+			Chain.Add(SafeCCDIKChainLink(BoneTransform.Transform, InLocalTransforms[TransformIndex], BoneTransform.BoneIndex, TransformIndex));
 		}
 		else
 		{
@@ -111,7 +122,7 @@ void FAnimNode_SafeCCDIK::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseC
 	}
 
 	bool bBoneLocationUpdated = false;
-	int32 const NumChainLinks = BoneIndices.Num();
+	int32 const NumChainLinks = NumTransforms;
 
 	// iterate
 	{
@@ -120,12 +131,12 @@ void FAnimNode_SafeCCDIK::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseC
 		// @todo optimize locally if no update, stop?
 		bool bLocalUpdated = false;
 		// check how far
-		const FVector TargetPos = CSEffectorLocation;
+		const FVector TargetPos = TargetLocation;
 		
 		if (Chain.Num() <= TipBoneLinkIndex)
 		{
 			// prevent crash, skip this frame
-			return;
+			return false;
 		}
 
 		FVector TipPos = Chain[TipBoneLinkIndex].Transform.GetLocation();
@@ -149,7 +160,7 @@ void FAnimNode_SafeCCDIK::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseC
 				}
 			}
 
-			Distance = FVector::Dist(Chain[TipBoneLinkIndex].Transform.GetLocation(), CSEffectorLocation);
+			Distance = FVector::Dist(Chain[TipBoneLinkIndex].Transform.GetLocation(), TargetLocation);
 
 			bBoneLocationUpdated |= bLocalUpdated;
 
@@ -168,26 +179,28 @@ void FAnimNode_SafeCCDIK::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseC
 		for (int32 LinkIndex = 0; LinkIndex < NumChainLinks; LinkIndex++)
 		{
 			SafeCCDIKChainLink const & ChainLink = Chain[LinkIndex];
-			OutBoneTransforms[ChainLink.TransformIndex].Transform = ChainLink.Transform;
+			InOutBoneTransforms[ChainLink.TransformIndex].Transform = ChainLink.Transform;
 
 			// If there are any zero length children, update position of those
 			int32 const NumChildren = ChainLink.ChildZeroLengthTransformIndices.Num();
 			for (int32 ChildIndex = 0; ChildIndex < NumChildren; ChildIndex++)
 			{
-				OutBoneTransforms[ChainLink.ChildZeroLengthTransformIndices[ChildIndex]].Transform = ChainLink.Transform;
+				InOutBoneTransforms[ChainLink.ChildZeroLengthTransformIndices[ChildIndex]].Transform = ChainLink.Transform;
 			}
 		}
 
 #if WITH_EDITOR
-		DebugLines.Reset(OutBoneTransforms.Num());
-		DebugLines.AddUninitialized(OutBoneTransforms.Num());
-		for (int32 Index = 0; Index < OutBoneTransforms.Num(); ++Index)
+		DebugLines.Reset(InOutBoneTransforms.Num());
+		DebugLines.AddUninitialized(InOutBoneTransforms.Num());
+		for (int32 Index = 0; Index < InOutBoneTransforms.Num(); ++Index)
 		{
-			DebugLines[Index] = OutBoneTransforms[Index].Transform.GetLocation();
+			DebugLines[Index] = InOutBoneTransforms[Index].Transform.GetLocation();
 		}
 #endif // WITH_EDITOR
 
 	}
+
+	return bBoneLocationUpdated;
 }
 
 bool FAnimNode_SafeCCDIK::UpdateChainLink(TArray<SafeCCDIKChainLink>& Chain, int32 LinkIndex, const FVector& TargetPos) const
@@ -201,70 +214,44 @@ bool FAnimNode_SafeCCDIK::UpdateChainLink(TArray<SafeCCDIKChainLink>& Chain, int
 	FVector TipPos = Chain[TipBoneLinkIndex].Transform.GetLocation();
 
 	FTransform& CurrentLinkTransform = CurrentLink.Transform;
-	FVector ToEnd = TipPos - CurrentLinkTransform.GetLocation();
-	FVector ToTarget = TargetPos - CurrentLinkTransform.GetLocation();
-
-	ToEnd.Normalize();
-	ToTarget.Normalize();
 
 	if (RotationLimitPerJoints.Num() > LinkIndex)
 	{
 		float RotationLimitPerJointInRadian = FMath::DegreesToRadians(RotationLimitPerJoints[LinkIndex]);
-		float Angle = FMath::ClampAngle(FMath::Acos(FVector::DotProduct(ToEnd, ToTarget)), -RotationLimitPerJointInRadian, RotationLimitPerJointInRadian);
-		bool bCanRotate = (FMath::Abs(Angle) > KINDA_SMALL_NUMBER) && (!bEnableRotationLimit || RotationLimitPerJointInRadian > CurrentLink.CurrentAngleDelta);
-		if (bCanRotate)
+		FVector RotationAxis;
+		float Angle;
+		if (FGaitMath::ComputeCCDLinkRotation(CurrentLinkTransform.GetLocation(), TipPos, TargetPos, RotationLimitPerJointInRadian, bEnableRotationLimit, CurrentLink.CurrentAngleDelta, RotationAxis, Angle))
 		{
-			// check rotation limit first, if fails, just abort
-			if (bEnableRotationLimit)
-			{
-				if (RotationLimitPerJointInRadian < CurrentLink.CurrentAngleDelta + Angle)
-				{
-					Angle = RotationLimitPerJointInRadian - CurrentLink.CurrentAngleDelta;
-					if (Angle <= KINDA_SMALL_NUMBER)
-					{
-						return false;
-					}
-				}
+			// Delta Rotation is the rotation to target
+			FQuat DeltaRotation(RotationAxis, Angle);
 
-				CurrentLink.CurrentAngleDelta += Angle;
-			}
+			FQuat NewRotation = DeltaRotation * CurrentLinkTransform.GetRotation();
+			NewRotation.Normalize();
+			CurrentLinkTransform.SetRotation(NewRotation);
 
-			// continue with rotating toward to target
-			FVector RotationAxis = FVector::CrossProduct(ToEnd, ToTarget);
-			if (RotationAxis.SizeSquared() > 0.f)
+			// if I have parent, make sure to refresh local transform since my current transform has changed
+			if (LinkIndex > 0)
 			{
-				RotationAxis.Normalize();
-				// Delta Rotation is the rotation to target
-				FQuat DeltaRotation(RotationAxis, Angle);
-
-				FQuat NewRotation = DeltaRotation * CurrentLinkTransform.GetRotation();
-				NewRotation.Normalize();
-				CurrentLinkTransform.SetRotation(NewRotation);
-
-				// if I have parent, make sure to refresh local transform since my current transform has changed
-				if (LinkIndex > 0)
-				{
-					SafeCCDIKChainLink const & Parent = Chain[LinkIndex - 1];
-					CurrentLink.LocalTransform = CurrentLinkTransform.GetRelativeTransform(Parent.Transform);
-					CurrentLink.LocalTransform.NormalizeRotation();
-				}
+				SafeCCDIKChainLink const & Parent = Chain[LinkIndex - 1];
+				CurrentLink.LocalTransform = CurrentLinkTransform.GetRelativeTransform(Parent.Transform);
+				CurrentLink.LocalTransform.NormalizeRotation();
+			}
 
-				// now update all my children to have proper transform
-				FTransform CurrentParentTransform = CurrentLinkTransform;
+			// now update all my children to have proper transform
+			FTransform CurrentParentTransform = CurrentLinkTransform;
 
-				// now update all chain
-				for (int32 ChildLinkIndex = LinkIndex + 1; ChildLinkIndex <= TipBoneLinkIndex; ++ChildLinkIndex)
-				{
-					SafeCCDIKChainLink& ChildIterLink = Chain[ChildLinkIndex];
-					FCompactPoseBoneIndex ChildBoneIndex = ChildIterLink.BoneIndex;
-					const FTransform LocalTransform = ChildIterLink.LocalTransform;
-					ChildIterLink.Transform = LocalTransform * CurrentParentTransform;
-					ChildIterLink.Transform.NormalizeRotation();
-					CurrentParentTransform = ChildIterLink.Transform;
-				}
-
-				return true;
+			// now update all chain
+			for (int32 ChildLinkIndex = LinkIndex + 1; ChildLinkIndex <= TipBoneLinkIndex; ++ChildLinkIndex)
+			{
+				SafeCCDIKChainLink& ChildIterLink = Chain[ChildLinkIndex];
+				FCompactPoseBoneIndex ChildBoneIndex = ChildIterLink.BoneIndex;
+				const FTransform LocalTransform = ChildIterLink.LocalTransform;
+				ChildIterLink.Transform = LocalTransform * CurrentParentTransform;
+				ChildIterLink.Transform.NormalizeRotation();
+				CurrentParentTransform = ChildIterLink.Transform;
 			}
+
+			return true;
 		}
 	}
 
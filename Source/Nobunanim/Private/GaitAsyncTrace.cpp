@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitAsyncTrace.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/GaitQueryCounters.h"
+
+#include <Engine/World.h>
+
+
+/** A result older than this (in seconds) is dropped: the effector moved too much since the request. */
+#define ASYNC_TRACE_MAX_AGE 0.25f
+
+
+bool FGaitAsyncTraceQueue::Trace(int32 Key, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, float SphereCastRadius, bool bSweepFallback,
+	const FCollisionQueryParams& Params, const FVector& Velocity, float Now, bool bExtrapolate, TArray<FHitResult>& OutHits)
+{
+	bool bFoundHit = false;
+	OutHits.Reset();
+
+	// Step 1: Consume the previous result.
+	FResult* Result = Results.Find(Key);
+	if (Result
+		&& !Result->bConsumed
+		&& Result->bLineDone
+		&& (!Result->bSweepFallback || Result->bSweepDone))
+	{
+		Result->bConsumed = true;
+
+		const float Age = Now - Result->Time;
+		if (Age <= ASYNC_TRACE_MAX_AGE)
+		{
+			// Same as synchronous traces: the sweep is only used if the line didn't hit.
+			const bool bLineHit = Result->LineHits.ContainsByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+			const bool bSweepHit = !bLineHit && Result->bSweepFallback && Result->SweepHits.ContainsByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+
+			if (bLineHit || bSweepHit)
+			{
+				bFoundHit = true;
+				OutHits = bLineHit ? Result->LineHits : Result->SweepHits;
+
+				// Step 1.1: Move the hits along the ground by the distance travelled since the request.
+				if (bExtrapolate && Age > 0.f)
+				{
+					const FVector Travel = Velocity * Age;
+					for (FHitResult& Hit : OutHits)
+					{
+						const FVector Normal = Hit.ImpactNormal.IsNearlyZero() ? FVector::UpVector : FVector(Hit.ImpactNormal);
+						const FVector Offset = FVector::VectorPlaneProject(Travel, Normal);
+						Hit.ImpactPoint += Offset;
+						Hit.Location += Offset;
+					}
+				}
+			}
+		}
+	}
+
+	// Step 2: Request the trace of the next update.
+	FRequest& Request = Requests.AddDefaulted_GetRef();
+	Request.Key = Key;
+	Request.Origin = Origin;
+	Request.Dest = Dest;
+	Request.Channel = TraceChannel;
+	Request.Radius = SphereCastRadius;
+	Request.bSweepFallback = bSweepFallback;
+	Request.Time = Now;
+	Request.Params = Params;
+
+	return bFoundHit;
+}
+
+bool FGaitAsyncTraceQueue::IsResultReady(int32 Key, float Now) const
+{
+	const FResult* Result = Results.Find(Key);
+	return Result
+		&& !Result->bConsumed
+		&& Result->bLineDone
+		&& (!Result->bSweepFallback || Result->bSweepDone)
+		&& Now - Result->Time <= ASYNC_TRACE_MAX_AGE;
+}
+
+void FGaitAsyncTraceQueue::Flush(UWorld* World, UObject* Owner)
+{
+	if (!World || !Owner)
+	{
+		Requests.Reset();
+		return;
+	}
+
+	NOBUNANIM_SCOPE_COUNTER(GaitAsyncTrace_Flush);
+
+	for (const FRequest& Request : Requests)
+	{
+		FResult& Result = Results.FindOrAdd(Request.Key);
+		Result.LineHits.Reset();
+		Result.SweepHits.Reset();
+		Result.Time = Request.Time;
+		Result.Serial = ++NextSerial;
+		Result.bLineDone = false;
+		Result.bSweepDone = false;
+		Result.bSweepFallback = Request.bSweepFallback;
+		Result.bConsumed = false;
+
+		const int32 Key = Request.Key;
+		const uint32 Serial = Result.Serial;
+
+		FTraceDelegate LineDelegate = FTraceDelegate::CreateWeakLambda(Owner, [this, Key, Serial](const FTraceHandle& Handle, FTraceDatum& Datum)
+		{
+			OnTraceDone(Key, Serial, false, Datum);
+		});
+		FGaitQueryCounters::AddTrace();
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Multi, Request.Origin, Request.Dest, Request.Channel, Request.Params, FCollisionResponseParams::DefaultResponseParam, &LineDelegate);
+
+		if (Request.bSweepFallback)
+		{
+			// Issued with the line (not after a miss) to keep a single update of latency.
+			FTraceDelegate SweepDelegate = FTraceDelegate::CreateWeakLambda(Owner, [this, Key, Serial](const FTraceHandle& Handle, FTraceDatum& Datum)
+			{
+				OnTraceDone(Key, Serial, true, Datum);
+			});
+			FGaitQueryCounters::AddSweep();
+			World->AsyncSweepByChannel(EAsyncTraceType::Multi, Request.Origin, Request.Dest, FQuat::Identity, Request.Channel, FCollisionShape::MakeSphere(Request.Radius), Request.Params, FCollisionResponseParams::DefaultResponseParam, &SweepDelegate);
+		}
+	}
+
+	Requests.Reset();
+}
+
+void FGaitAsyncTraceQueue::Reset()
+{
+	Requests.Reset();
+	Results.Reset();
+}
+
+void FGaitAsyncTraceQueue::OnTraceDone(int32 Key, uint32 Serial, bool bSweep, const FTraceDatum& Datum)
+{
+	FResult* Result = Results.Find(Key);
+	if (!Result || Result->Serial != Serial)
+	{
+		return;
+	}
+
+	if (bSweep)
+	{
+		Result->SweepHits = Datum.OutHits;
+		Result->bSweepDone = true;
+	}
+	else
+	{
+		Result->LineHits = Datum.OutHits;
+		Result->bLineDone = true;
+	}
+}
@@ -0,0 +1,516 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitCrowdEvaluator.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/GaitDataAsset.h"
+
+#include <Math/VectorRegister.h>
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd - Agents evaluated"), STAT_GaitCrowdAgents, STATGROUP_Nobunanim);
+
+
+namespace
+{
+	typedef VectorRegister4Float FGaitLanes;
+
+	FORCEINLINE FGaitLanes LoadLanes(const float* Source) { return VectorLoadAligned(Source); }
+	FORCEINLINE void StoreLanes(const FGaitLanes& Value, float* Dest) { VectorStoreAligned(Value, Dest); }
+
+	/** Write @Value in the lanes of @Mask only. */
+	FORCEINLINE void StoreLanes(const FGaitLanes& Mask, const FGaitLanes& Value, float* Dest)
+	{
+		VectorStoreAligned(VectorSelect(Mask, Value, VectorLoadAligned(Dest)), Dest);
+	}
+
+	/** Mask of a boolean channel (0 or 1). */
+	FORCEINLINE FGaitLanes LoadMask(const float* Source) { return VectorCompareGT(VectorLoadAligned(Source), VectorSetFloat1(0.5f)); }
+	/** 1 in the lanes of @Mask, 0 elsewhere. */
+	FORCEINLINE FGaitLanes MaskToBool(const FGaitLanes& Mask) { return VectorSelect(Mask, VectorOneFloat(), VectorZeroFloat()); }
+	FORCEINLINE FGaitLanes MaskNot(const FGaitLanes& Mask) { return VectorBitwiseXor(Mask, VectorCompareEQ(VectorZeroFloat(), VectorZeroFloat())); }
+	FORCEINLINE FGaitLanes MaskAnd(const FGaitLanes& A, const FGaitLanes& B) { return VectorBitwiseAnd(A, B); }
+	FORCEINLINE FGaitLanes MaskOr(const FGaitLanes& A, const FGaitLanes& B) { return VectorBitwiseOr(A, B); }
+	FORCEINLINE FGaitLanes ConstantMask(bool bValue) { return bValue ? VectorCompareEQ(VectorZeroFloat(), VectorZeroFloat()) : VectorZeroFloat(); }
+	FORCEINLINE bool AnyLane(const FGaitLanes& Mask) { return VectorMaskBits(Mask) != 0; }
+
+	/** Vector of 4 agents, one register per component. */
+	struct FGaitLanes3
+	{
+		FGaitLanes X, Y, Z;
+	};
+
+	FORCEINLINE FGaitLanes3 LoadLanes3(const float* X, const float* Y, const float* Z) { return { LoadLanes(X), LoadLanes(Y), LoadLanes(Z) }; }
+
+	/** @Vector transformed by the row major rotation matrices stored from @Matrix (9 channels of @Stride agents), like FRotator::RotateVector. */
+	FORCEINLINE FGaitLanes3 RotateLanes(const float* Matrix, int32 Stride, const FGaitLanes3& Vector)
+	{
+		FGaitLanes3 Result;
+		FGaitLanes* Components[3] = { &Result.X, &Result.Y, &Result.Z };
+		for (int32 c = 0; c < 3; ++c)
+		{
+			FGaitLanes Value = VectorMultiply(Vector.X, LoadLanes(Matrix + (0 * 3 + c) * Stride));
+			Value = VectorMultiplyAdd(Vector.Y, LoadLanes(Matrix + (1 * 3 + c) * Stride), Value);
+			Value = VectorMultiplyAdd(Vector.Z, LoadLanes(Matrix + (2 * 3 + c) * Stride), Value);
+			*Components[c] = Value;
+		}
+		return Result;
+	}
+
+	/** Store a row major rotation matrix of @Rotation in 9 channels of @Stride agents. */
+	void StoreRotation(const FRotator& Rotation, float* Matrix, int32 Stride, int32 Index)
+	{
+		const FMatrix RotationMatrix = FRotationMatrix(Rotation);
+		for (int32 r = 0; r < 3; ++r)
+		{
+			for (int32 c = 0; c < 3; ++c)
+			{
+				Matrix[(r * 3 + c) * Stride + Index] = RotationMatrix.M[r][c];
+			}
+		}
+	}
+}
+
+
+void FGaitCrowdEvaluator::Initialize(const UGaitDataAsset* InGait)
+{
+	Reset();
+
+	Gait = InGait;
+	Table = Gait ? &Gait->GetRuntimeTable() : nullptr;
+	EffectorCount = Table ? Table->Num() : 0;
+}
+
+void FGaitCrowdEvaluator::Reset()
+{
+	NumAgents = 0;
+	Stride = 0;
+	AgentData.Reset();
+	EffectorData.Reset();
+	AgentIndices.Reset();
+	AgentIds.Reset();
+	FreeIds.Reset();
+}
+
+void FGaitCrowdEvaluator::Reserve(int32 NewStride)
+{
+	check(NewStride % Width == 0);
+
+	TArray<float, TAlignedHeapAllocator<16>> NewAgentData;
+	TArray<float, TAlignedHeapAllocator<16>> NewEffectorData;
+	NewAgentData.SetNumZeroed(AC_Num * NewStride);
+	NewEffectorData.SetNumZeroed(EC_Num * EffectorCount * NewStride);
+
+	if (NumAgents > 0)
+	{
+		for (int32 Channel = 0; Channel < AC_Num; ++Channel)
+		{
+			FMemory::Memcpy(&NewAgentData[Channel * NewStride], &AgentData[Channel * Stride], NumAgents * sizeof(float));
+		}
+		for (int32 Row = 0, NumRows = EC_Num * EffectorCount; Row < NumRows; ++Row)
+		{
+			FMemory::Memcpy(&NewEffectorData[Row * NewStride], &EffectorData[Row * Stride], NumAgents * sizeof(float));
+		}
+	}
+
+	AgentData = MoveTemp(NewAgentData);
+	EffectorData = MoveTemp(NewEffectorData);
+	Stride = NewStride;
+}
+
+void FGaitCrowdEvaluator::CopyAgent(int32 From, int32 To)
+{
+	for (int32 Channel = 0; Channel < AC_Num; ++Channel)
+	{
+		AgentData[Channel * Stride + To] = AgentData[Channel * Stride + From];
+	}
+	for (int32 Row = 0, NumRows = EC_Num * EffectorCount; Row < NumRows; ++Row)
+	{
+		EffectorData[Row * Stride + To] = EffectorData[Row * Stride + From];
+	}
+}
+
+int32 FGaitCrowdEvaluator::AddAgent(const FVector& Location, float PlayRate)
+{
+	if (!Table)
+	{
+		return INDEX_NONE;
+	}
+
+	if (NumAgents == Stride)
+	{
+		Reserve(FMath::Max(Width, Stride * 2));
+	}
+
+	const int32 Index = NumAgents++;
+	const int32 AgentId = FreeIds.Num() > 0 ? FreeIds.Pop() : AgentIndices.AddUninitialized();
+	AgentIndices[AgentId] = Index;
+	AgentIds.Add(AgentId);
+
+	// Padding lanes are zeroed: inactive, no output.
+	AgentChannel(AC_TimeBuffer)[Index] = 0.f;
+	AgentChannel(AC_CurrentTime)[Index] = 0.f;
+	AgentChannel(AC_PlayRate)[Index] = PlayRate;
+	AgentChannel(AC_Active)[Index] = 0.f;
+	StoreRotation(FRotator::ZeroRotator, AgentChannel(AC_Orient), Stride, Index);
+	StoreRotation(FRotator::ZeroRotator, AgentChannel(AC_Component), Stride, Index);
+
+	for (int32 Effector = 0; Effector < EffectorCount; ++Effector)
+	{
+		for (int32 Channel = 0; Channel < EC_Num; ++Channel)
+		{
+			EffectorChannel(Channel, Effector)[Index] = 0.f;
+		}
+		EffectorChannel(EC_BlockTime, Effector)[Index] = -1.f;
+		for (int32 c = 0; c < 3; ++c)
+		{
+			EffectorChannel(EC_Current + c, Effector)[Index] = Location[c];
+			EffectorChannel(EC_Ideal + c, Effector)[Index] = Location[c];
+			EffectorChannel(EC_Ground + c, Effector)[Index] = Location[c];
+		}
+	}
+
+	return AgentId;
+}
+
+void FGaitCrowdEvaluator::RemoveAgent(int32 AgentId)
+{
+	if (!IsValidAgent(AgentId))
+	{
+		return;
+	}
+
+	// Swap with the last agent.
+	const int32 Index = AgentIndices[AgentId];
+	const int32 Last = --NumAgents;
+	if (Index != Last)
+	{
+		CopyAgent(Last, Index);
+		AgentIds[Index] = AgentIds[Last];
+		AgentIndices[AgentIds[Index]] = Index;
+	}
+	AgentIds.Pop();
+	AgentIndices[AgentId] = INDEX_NONE;
+	FreeIds.Add(AgentId);
+
+	// The freed lane becomes padding.
+	AgentChannel(AC_Active)[Last] = 0.f;
+	for (int32 Effector = 0; Effector < EffectorCount; ++Effector)
+	{
+		for (int32 Channel = EC_OutTranslationFlag; Channel <= EC_OutCorrectionFlag; ++Channel)
+		{
+			EffectorChannel(Channel, Effector)[Last] = 0.f;
+		}
+	}
+}
+
+void FGaitCrowdEvaluator::SetAgentInputs(int32 AgentId, const FVector& Velocity, const FRotator& ComponentRotation, const FVector* IdealLocations, const FVector* GroundLocations)
+{
+	if (!IsValidAgent(AgentId))
+	{
+		return;
+	}
+
+	const int32 Index = AgentIndices[AgentId];
+	const bool bZeroVelocity = Velocity.SizeSquared() == 0.f;
+
+	AgentChannel(AC_Active)[Index] = Gait->bComputeWithVelocityOnly && bZeroVelocity ? 0.f : 1.f;
+	if (!bZeroVelocity)
+	{
+		StoreRotation(Velocity.Rotation(), AgentChannel(AC_Orient), Stride, Index);
+	}
+	StoreRotation(ComponentRotation, AgentChannel(AC_Component), Stride, Index);
+
+	for (int32 Effector = 0; Effector < EffectorCount; ++Effector)
+	{
+		for (int32 c = 0; c < 3; ++c)
+		{
+			EffectorChannel(EC_Ideal + c, Effector)[Index] = IdealLocations[Effector][c];
+			EffectorChannel(EC_Ground + c, Effector)[Index] = GroundLocations[Effector][c];
+		}
+	}
+}
+
+void FGaitCrowdEvaluator::SetAgentPlayRate(int32 AgentId, float PlayRate)
+{
+	if (IsValidAgent(AgentId))
+	{
+		AgentChannel(AC_PlayRate)[AgentIndices[AgentId]] = PlayRate;
+	}
+}
+
+void FGaitCrowdEvaluator::Evaluate(float DeltaTime)
+{
+	NOBUNANIM_SCOPE_COUNTER(GaitCrowd_Evaluate);
+
+	if (!Table || NumAgents == 0)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_GaitCrowdAgents, NumAgents);
+	const int32 NumLanes = Align(NumAgents, Width);
+
+	// Step 1: Timers. Idle agents restart at 0.
+	{
+		const FGaitLanes TimeScale = VectorSetFloat1(DeltaTime * Gait->GetFrameRatio());
+		float* TimeBuffer = AgentChannel(AC_TimeBuffer);
+		float* CurrentTime = AgentChannel(AC_CurrentTime);
+		const float* PlayRate = AgentChannel(AC_PlayRate);
+		const float* Active = AgentChannel(AC_Active);
+
+		for (int32 First = 0; First < NumLanes; First += Width)
+		{
+			const FGaitLanes ActiveMask = LoadMask(Active + First);
+			const FGaitLanes Buffer = VectorMultiplyAdd(TimeScale, LoadLanes(PlayRate + First), LoadLanes(TimeBuffer + First));
+			StoreLanes(ActiveMask, Buffer, TimeBuffer + First);
+			StoreLanes(VectorSelect(ActiveMask, VectorSubtract(Buffer, VectorFloor(Buffer)), VectorZeroFloat()), CurrentTime + First);
+		}
+	}
+
+	// Step 2: Effectors, in table order (a stance reads the force swing of its parent).
+	for (int32 Effector = 0; Effector < EffectorCount; ++Effector)
+	{
+		NOBUNANIM_SCOPE_COUNTER(GaitCrowd_Evaluate_PerEffector);
+
+		for (int32 First = 0; First < NumLanes; First += Width)
+		{
+			EvaluateEffector(Effector, First, DeltaTime);
+		}
+	}
+}
+
+void FGaitCrowdEvaluator::EvaluateEffector(int32 EffectorIndex, int32 First, float DeltaTime)
+{
+	const FGaitRuntimeEffector& Data = Table->Effectors[EffectorIndex];
+	const FGaitLanes Zero = VectorZeroFloat();
+	const FGaitLanes One = VectorOneFloat();
+	const FGaitLanes MinusOne = VectorSetFloat1(-1.f);
+
+	auto Channel = [this, EffectorIndex, First](int32 InChannel) { return EffectorChannel(InChannel, EffectorIndex) + First; };
+
+	const FGaitLanes CurrentTime = LoadLanes(AgentChannel(AC_CurrentTime) + First);
+	const FGaitLanes Active = LoadMask(AgentChannel(AC_Active) + First);
+
+	// Blend in.
+	FGaitLanes BlendValue = LoadLanes(Channel(EC_BlendValue));
+	BlendValue = Data.BlendInTime == 0 ? One : VectorMin(VectorAdd(BlendValue, VectorSetFloat1(DeltaTime / Data.BlendInTime)), One);
+	StoreLanes(Active, BlendValue, Channel(EC_BlendValue));
+	BlendValue = LoadLanes(Channel(EC_BlendValue));
+
+	// Phase classification.
+	const FGaitLanes BlockTime = LoadLanes(Channel(EC_BlockTime));
+	const FGaitLanes BeginSwingConst = VectorSetFloat1(Data.BeginSwing);
+	const FGaitLanes CanCompute = MaskAnd(Active, MaskOr(VectorCompareEQ(BlockTime, MinusOne),
+		MaskOr(MaskAnd(VectorCompareGT(BlockTime, BeginSwingConst), VectorCompareGE(CurrentTime, BlockTime)),
+			MaskAnd(VectorCompareLT(BlockTime, BeginSwingConst), MaskAnd(VectorCompareLT(CurrentTime, BeginSwingConst), VectorCompareGE(CurrentTime, BlockTime))))));
+
+	if (!AnyLane(CanCompute))
+	{
+		StoreLanes(Zero, Channel(EC_OutTranslationFlag));
+		StoreLanes(Zero, Channel(EC_OutRotationFlag));
+		StoreLanes(Zero, Channel(EC_OutLerpFlag));
+		StoreLanes(Zero, Channel(EC_OutCorrectionFlag));
+		return;
+	}
+
+	const FGaitLanes ForceSwing = LoadMask(Channel(EC_ForceSwing));
+	const FGaitLanes BeginSwing = VectorSelect(ForceSwing, LoadLanes(Channel(EC_BeginForceSwing)), BeginSwingConst);
+	const FGaitLanes EndSwing = VectorSelect(ForceSwing, LoadLanes(Channel(EC_EndForceSwing)), VectorSetFloat1(Data.EndSwing));
+
+	// Swing window, wrapping around the cycle (see FGaitMath::IsInSwingRange).
+	const FGaitLanes Inside = MaskAnd(VectorCompareGE(CurrentTime, BeginSwing), VectorCompareLE(CurrentTime, EndSwing));
+	const FGaitLanes AfterEnd = VectorCompareGE(CurrentTime, EndSwing);
+	const FGaitLanes RangeMin = VectorSelect(MaskOr(Inside, AfterEnd), BeginSwing, VectorSubtract(BeginSwing, One));
+	const FGaitLanes RangeMax = VectorSelect(MaskAnd(MaskNot(Inside), AfterEnd), VectorAdd(EndSwing, One), EndSwing);
+	const FGaitLanes Wrapped = MaskAnd(VectorCompareGE(BeginSwing, EndSwing),
+		MaskOr(MaskAnd(VectorCompareLE(CurrentTime, BeginSwing), VectorCompareLE(CurrentTime, EndSwing)),
+			MaskAnd(VectorCompareGE(CurrentTime, BeginSwing), AfterEnd)));
+
+	const FGaitLanes Swing = MaskAnd(CanCompute, MaskOr(Inside, Wrapped));
+	const FGaitLanes Stance = MaskAnd(CanCompute, MaskNot(MaskOr(Inside, Wrapped)));
+	const FGaitLanes StanceForced = MaskAnd(Stance, ForceSwing);
+	const FGaitLanes StanceFree = MaskAnd(Stance, MaskNot(ForceSwing));
+
+	FGaitLanes WriteTranslation = MaskAnd(StanceFree, ConstantMask(true));
+	FGaitLanes WriteRotation = Zero;
+	FGaitLanes Lerp = MaskAnd(StanceFree, ConstantMask(Data.LerpSpeed > 0));
+	FGaitLanes LerpSpeed = VectorSelect(StanceFree, VectorSetFloat1(Data.LerpSpeed), Zero);
+
+	// Step 2.2: Swing.
+	if (AnyLane(Swing))
+	{
+		StoreLanes(Swing, Zero, Channel(EC_CorrectionIK));
+
+		// Curve position (FMath::GetMappedRangeValueClamped).
+		const FGaitLanes Divisor = VectorSubtract(RangeMax, RangeMin);
+		const FGaitLanes PointRange = VectorCompareLE(VectorAbs(Divisor), VectorSetFloat1(SMALL_NUMBER));
+		FGaitLanes CurvePosition = VectorDivide(VectorSubtract(CurrentTime, RangeMin), VectorSelect(PointRange, One, Divisor));
+		CurvePosition = VectorSelect(PointRange, MaskToBool(VectorCompareGE(CurrentTime, RangeMax)), CurvePosition);
+		CurvePosition = VectorMin(VectorMax(CurvePosition, Zero), One);
+
+		alignas(16) float Positions[Width];
+		StoreLanes(CurvePosition, Positions);
+
+		// Lerp speed, accelerated while blending in.
+		FGaitLanes SwingLerpSpeed = Zero;
+		if (Data.LerpSpeed > 0)
+		{
+			alignas(16) float Blends[Width];
+			alignas(16) float Accelerations[Width];
+			StoreLanes(BlendValue, Blends);
+			Table->SampleFloatBatch(Data.BlendInAcceleration, Blends, Width, Accelerations);
+			SwingLerpSpeed = VectorMultiply(VectorSetFloat1(Data.LerpSpeed), VectorSelect(VectorCompareEQ(BlendValue, One), One, LoadLanes(Accelerations)));
+		}
+		LerpSpeed = VectorSelect(Swing, SwingLerpSpeed, LerpSpeed);
+		Lerp = MaskOr(Lerp, MaskAnd(Swing, VectorCompareGT(SwingLerpSpeed, Zero)));
+
+		// Step 2.2.1: Rotation.
+		if (Data.bAffectRotation)
+		{
+			alignas(16) float Curve[3][Width];
+			Table->SampleVectorBatch(Data.SwingRotationCurve, Positions, Width, Curve[0], Curve[1], Curve[2]);
+			for (int32 c = 0; c < 3; ++c)
+			{
+				StoreLanes(Swing, VectorMultiply(VectorSetFloat1(Data.RotationFactor[c]), LoadLanes(Curve[c])), Channel(EC_OutRotation + c));
+			}
+			WriteRotation = Swing;
+		}
+
+		// Step 2.2.2: Translation.
+		if (Data.bAffectTranslation)
+		{
+			alignas(16) float Curve[3][Width];
+			Table->SampleVectorBatch(Data.SwingTranslationCurve, Positions, Width, Curve[0], Curve[1], Curve[2]);
+			FGaitLanes3 CurveValue = LoadLanes3(Curve[0], Curve[1], Curve[2]);
+
+			const FGaitLanes SwingForced = MaskAnd(Swing, ForceSwing);
+			if (AnyLane(SwingForced))
+			{
+				Table->SampleVectorBatch(Data.CorrectionSwingTranslationCurve, Positions, Width, Curve[0], Curve[1], Curve[2]);
+				CurveValue.X = VectorSelect(SwingForced, LoadLanes(Curve[0]), CurveValue.X);
+				CurveValue.Y = VectorSelect(SwingForced, LoadLanes(Curve[1]), CurveValue.Y);
+				CurveValue.Z = VectorSelect(SwingForced, LoadLanes(Curve[2]), CurveValue.Z);
+			}
+
+			CurveValue.X = VectorMultiply(CurveValue.X, VectorSetFloat1(Data.TranslationScale.X));
+			CurveValue.Y = VectorMultiply(CurveValue.Y, VectorSetFloat1(Data.TranslationScale.Y));
+			CurveValue.Z = VectorMultiply(CurveValue.Z, VectorSetFloat1(Data.TranslationScale.Z));
+
+			const float* Rotation = AgentChannel(Data.bOrientToVelocity ? AC_Orient : AC_Component) + First;
+			CurveValue = RotateLanes(Rotation, Stride, CurveValue);
+			const FGaitLanes3 Offset = RotateLanes(Rotation, Stride,
+				{ VectorSetFloat1(Data.TranslationOffset.X), VectorSetFloat1(Data.TranslationOffset.Y), VectorSetFloat1(Data.TranslationOffset.Z) });
+
+			const int32 Base = Data.bAdaptToGroundLevel ? EC_Ground : EC_Ideal;
+			const FGaitLanes3 BaseLocation = LoadLanes3(Channel(Base), Channel(Base + 1), Channel(Base + 2));
+
+			const FGaitLanes NewLocation[3] =
+			{
+				VectorAdd(BaseLocation.X, VectorAdd(Offset.X, CurveValue.X)),
+				VectorAdd(BaseLocation.Y, VectorAdd(Offset.Y, CurveValue.Y)),
+				VectorAdd(BaseLocation.Z, VectorAdd(Offset.Z, CurveValue.Z))
+			};
+			for (int32 c = 0; c < 3; ++c)
+			{
+				StoreLanes(Swing, NewLocation[c], Channel(EC_Current + c));
+			}
+			WriteTranslation = MaskOr(WriteTranslation, Swing);
+		}
+	}
+
+	// Step 2.3: Stance.
+	if (AnyLane(Stance))
+	{
+		// A force swing ended: block until the end of the regular swing.
+		StoreLanes(StanceForced, VectorSetFloat1(Data.EndSwing >= 0.99f ? 0.f : Data.EndSwing), Channel(EC_BlockTime));
+		StoreLanes(StanceFree, MinusOne, Channel(EC_BlockTime));
+		StoreLanes(Stance, Zero, Channel(EC_ForceSwing));
+
+		// Step 2.3.1: Check if the effector need to be adjusted.
+		if (Data.bAutoAdjustWithIdealEffector)
+		{
+			const FGaitLanes DeltaX = VectorSubtract(LoadLanes(Channel(EC_Current)), LoadLanes(Channel(EC_Ideal)));
+			const FGaitLanes DeltaY = VectorSubtract(LoadLanes(Channel(EC_Current + 1)), LoadLanes(Channel(EC_Ideal + 1)));
+			const FGaitLanes DistanceSquared2D = VectorMultiplyAdd(DeltaX, DeltaX, VectorMultiply(DeltaY, DeltaY));
+
+			const float Treshold = Data.DistanceTresholdToAdjust;
+			FGaitLanes Adjust = Treshold <= 0.f ? ConstantMask(true) : VectorCompareGE(DistanceSquared2D, VectorSetFloat1(Treshold * Treshold));
+			if (Data.ParentIndex != INDEX_NONE)
+			{
+				Adjust = MaskOr(Adjust, LoadMask(EffectorChannel(EC_ForceSwing, Data.ParentIndex) + First));
+			}
+			Adjust = MaskAnd(Stance, Adjust);
+
+			if (AnyLane(Adjust))
+			{
+				// New swing interval, as long as the swing and starting now.
+				const FGaitLanes Duration = VectorSelect(VectorCompareGT(BeginSwing, EndSwing), VectorAdd(VectorSubtract(One, BeginSwing), EndSwing), VectorSubtract(EndSwing, BeginSwing));
+				FGaitLanes End = VectorAdd(CurrentTime, Duration);
+				End = VectorSelect(VectorCompareGE(End, One), VectorSubtract(End, One), End);
+
+				StoreLanes(Adjust, CurrentTime, Channel(EC_BeginForceSwing));
+				StoreLanes(Adjust, End, Channel(EC_EndForceSwing));
+				StoreLanes(Adjust, One, Channel(EC_ForceSwing));
+				StoreLanes(Adjust, MinusOne, Channel(EC_BlockTime));
+			}
+		}
+	}
+
+	// Outputs.
+	for (int32 c = 0; c < 3; ++c)
+	{
+		StoreLanes(LoadLanes(Channel(EC_Current + c)), Channel(EC_OutTranslation + c));
+	}
+	const FGaitLanes NeedsCorrection = MaskAnd(MaskAnd(StanceFree, ConstantMask(Data.bComputeCollision)), MaskNot(LoadMask(Channel(EC_CorrectionIK))));
+	StoreLanes(LerpSpeed, Channel(EC_OutLerpSpeed));
+	StoreLanes(MaskToBool(WriteTranslation), Channel(EC_OutTranslationFlag));
+	StoreLanes(MaskToBool(WriteRotation), Channel(EC_OutRotationFlag));
+	StoreLanes(MaskToBool(Lerp), Channel(EC_OutLerpFlag));
+	StoreLanes(MaskToBool(NeedsCorrection), Channel(EC_OutCorrectionFlag));
+}
+
+void FGaitCrowdEvaluator::GetAgentOutputs(int32 AgentId, TArray<FGaitCrowdEffectorOutput>& OutOutputs) const
+{
+	OutOutputs.Reset();
+	if (!IsValidAgent(AgentId))
+	{
+		return;
+	}
+
+	const int32 Index = AgentIndices[AgentId];
+	OutOutputs.SetNum(EffectorCount);
+	for (int32 Effector = 0; Effector < EffectorCount; ++Effector)
+	{
+		FGaitCrowdEffectorOutput& Output = OutOutputs[Effector];
+		Output.Translation = FVector(EffectorChannel(EC_OutTranslation, Effector)[Index], EffectorChannel(EC_OutTranslation + 1, Effector)[Index], EffectorChannel(EC_OutTranslation + 2, Effector)[Index]);
+		Output.Rotation = FRotator(EffectorChannel(EC_OutRotation, Effector)[Index], EffectorChannel(EC_OutRotation + 1, Effector)[Index], EffectorChannel(EC_OutRotation + 2, Effector)[Index]);
+		Output.LerpSpeed = EffectorChannel(EC_OutLerpSpeed, Effector)[Index];
+		Output.bTranslation = EffectorChannel(EC_OutTranslationFlag, Effector)[Index] > 0.5f;
+		Output.bRotation = EffectorChannel(EC_OutRotationFlag, Effector)[Index] > 0.5f;
+		Output.bLerp = EffectorChannel(EC_OutLerpFlag, Effector)[Index] > 0.5f;
+		Output.bNeedsCorrection = EffectorChannel(EC_OutCorrectionFlag, Effector)[Index] > 0.5f;
+	}
+}
+
+float FGaitCrowdEvaluator::GetAgentTime(int32 AgentId) const
+{
+	return IsValidAgent(AgentId) ? AgentChannel(AC_CurrentTime)[AgentIndices[AgentId]] : 0.f;
+}
+
+void FGaitCrowdEvaluator::ApplyCorrection(int32 AgentId, int32 EffectorIndex, const FVector& Location)
+{
+	if (!IsValidAgent(AgentId) || EffectorIndex < 0 || EffectorIndex >= EffectorCount)
+	{
+		return;
+	}
+
+	const int32 Index = AgentIndices[AgentId];
+	for (int32 c = 0; c < 3; ++c)
+	{
+		EffectorChannel(EC_Current + c, EffectorIndex)[Index] = Location[c];
+		EffectorChannel(EC_OutTranslation + c, EffectorIndex)[Index] = Location[c];
+	}
+	EffectorChannel(EC_CorrectionIK, EffectorIndex)[Index] = 1.f;
+	EffectorChannel(EC_OutCorrectionFlag, EffectorIndex)[Index] = 0.f;
+}
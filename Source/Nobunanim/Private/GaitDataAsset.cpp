@@ -3,11 +3,433 @@
 
 #include "GaitDataAsset.h"
 
+#include "Nobunanim/Private/Nobunanim.h"
 #include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Public/GaitMath.h"
+
+#include <Engine/Classes/Curves/CurveFloat.h>
+#include <Engine/Classes/Curves/CurveVector.h>
+
+#include <atomic>
+
+/** Number of checks per LUT segment when measuring the deviation of a baked curve. */
+#define CURVE_BAKE_CHECKS_PER_SEGMENT 8
+
+/** Last runtime table version given. Tables may be built by the loading thread (PostLoad). */
+static std::atomic<uint32> GaitRuntimeTableVersion{ 0 };
+
+
+namespace
+{
+	/** Evaluate the source curve of a LUT. */
+	void EvaluateSourceCurve(const UCurveBase* Curve, int32 NumComponents, float Time, float* OutValues)
+	{
+		if (NumComponents == 3)
+		{
+			const FVector Value = static_cast<const UCurveVector*>(Curve)->GetVectorValue(Time);
+			OutValues[0] = Value.X;
+			OutValues[1] = Value.Y;
+			OutValues[2] = Value.Z;
+		}
+		else
+		{
+			OutValues[0] = static_cast<const UCurveFloat*>(Curve)->GetFloatValue(Time);
+		}
+	}
+}
+
+
+void FGaitRuntimeTable::Reset()
+{
+	EffectorNames.Reset();
+	Effectors.Reset();
+	SwingData.Reset();
+	LUTs.Reset();
+	Values.Reset();
+	HalfValues.Reset();
+	bHalfPrecision = false;
+	bBuilt = false;
+	Version = 0;
+}
+
+template<int32 NumComponents>
+void FGaitRuntimeTable::SampleLUT(const FGaitCurveLUT& LUT, float Time, float* OutValues) const
+{
+	if (bHalfPrecision)
+	{
+		FGaitMath::SampleLUT<NumComponents>(HalfValues.GetData() + LUT.FirstValue, LUT.NumSamples, Time, OutValues);
+	}
+	else
+	{
+		FGaitMath::SampleLUT<NumComponents>(Values.GetData() + LUT.FirstValue, LUT.NumSamples, Time, OutValues);
+	}
+}
+
+FVector FGaitRuntimeTable::SampleVector(const FGaitRuntimeVectorCurve& Curve, float Time) const
+{
+	if (Curve.LUTIndex != INDEX_NONE)
+	{
+		float Result[3];
+		SampleLUT<3>(LUTs[Curve.LUTIndex], Time, Result);
+		return FVector(Result[0], Result[1], Result[2]);
+	}
+
+	return Curve.Curve ? Curve.Curve->GetVectorValue(Time) : FVector(1, 1, 1);
+}
+
+float FGaitRuntimeTable::SampleFloat(const FGaitRuntimeFloatCurve& Curve, float Time) const
+{
+	if (Curve.LUTIndex != INDEX_NONE)
+	{
+		float Result;
+		SampleLUT<1>(LUTs[Curve.LUTIndex], Time, &Result);
+		return Result;
+	}
+
+	return Curve.Curve ? Curve.Curve->GetFloatValue(Time) : 1.f;
+}
+
+void FGaitRuntimeTable::SampleVectorBatch(const FGaitRuntimeVectorCurve& Curve, const float* Times, int32 Num, float* OutX, float* OutY, float* OutZ) const
+{
+	if (Curve.LUTIndex != INDEX_NONE)
+	{
+		const FGaitCurveLUT& LUT = LUTs[Curve.LUTIndex];
+		float Result[3];
+		for (int32 i = 0; i < Num; ++i)
+		{
+			SampleLUT<3>(LUT, Times[i], Result);
+			OutX[i] = Result[0];
+			OutY[i] = Result[1];
+			OutZ[i] = Result[2];
+		}
+	}
+	else
+	{
+		for (int32 i = 0; i < Num; ++i)
+		{
+			const FVector Result = Curve.Curve ? Curve.Curve->GetVectorValue(Times[i]) : FVector(1, 1, 1);
+			OutX[i] = Result.X;
+			OutY[i] = Result.Y;
+			OutZ[i] = Result.Z;
+		}
+	}
+}
+
+void FGaitRuntimeTable::SampleFloatBatch(const FGaitRuntimeFloatCurve& Curve, const float* Times, int32 Num, float* OutValues) const
+{
+	if (Curve.LUTIndex != INDEX_NONE)
+	{
+		const FGaitCurveLUT& LUT = LUTs[Curve.LUTIndex];
+		for (int32 i = 0; i < Num; ++i)
+		{
+			SampleLUT<1>(LUT, Times[i], &OutValues[i]);
+		}
+	}
+	else
+	{
+		for (int32 i = 0; i < Num; ++i)
+		{
+			OutValues[i] = Curve.Curve ? Curve.Curve->GetFloatValue(Times[i]) : 1.f;
+		}
+	}
+}
 
 
 /** Return the ratio according to the animation framecount. (1 sec = 60frames). */
 float UGaitDataAsset::GetFrameRatio() const
 {
 	return (float)UNobunanimSettings::GetFramePerSecond() / (float)AnimationFrameCount;// /*/ (float)TargetFramePerSecond*/;
-}
\ No newline at end of file
+}
+
+const FGaitRuntimeTable& UGaitDataAsset::GetRuntimeTable() const
+{
+	// Workers (parallel compute, anim proxy) must never race to build the table: they read an empty table instead.
+	if (!RuntimeTable.bBuilt && ensureMsgf(IsInGameThread(), TEXT("Gait %s evaluated off the game thread before its runtime table was built."), *GetName()))
+	{
+		const_cast<UGaitDataAsset*>(this)->BuildRuntimeTable();
+	}
+
+	return RuntimeTable;
+}
+
+void UGaitDataAsset::ConditionalBuildRuntimeTable()
+{
+	check(IsInGameThread());
+
+	if (!RuntimeTable.bBuilt)
+	{
+		BuildRuntimeTable();
+	}
+}
+
+void UGaitDataAsset::BuildRuntimeTable()
+{
+	RuntimeTable.Reset();
+	RuntimeTable.bHalfPrecision = CurveBakeSettings.bHalfPrecision;
+
+#if WITH_EDITORONLY_DATA
+	CurveBakeReport.Reset();
+#endif
+	TMap<const UCurveBase*, int32> BakedCurves;
+
+	const int32 Num = GaitSwingValues.Num();
+	RuntimeTable.EffectorNames.Reserve(Num);
+	RuntimeTable.Effectors.Reserve(Num);
+	RuntimeTable.SwingData.Reserve(Num);
+
+	for (TMap<FName, FGaitSwingData>::TConstIterator It = GaitSwingValues.CreateConstIterator(); It; ++It)
+	{
+		const FGaitSwingData& Data = It->Value;
+
+		FGaitRuntimeEffector Effector;
+		Effector.BeginSwing = Data.BeginSwing;
+		Effector.EndSwing = Data.EndSwing;
+
+		Effector.BlendInTime = Data.BlendData.BlendInTime;
+		Effector.BlendOutTime = Data.BlendData.BlendOutTime;
+		Effector.BlendInAcceleration.Curve = Data.BlendData.BlendInAcceleration;
+		Effector.BlendOutAcceleration.Curve = Data.BlendData.BlendOutAcceleration;
+
+		Effector.SwingTranslationCurve.Curve = Data.TranslationData.SwingTranslationCurve;
+		Effector.CorrectionSwingTranslationCurve.Curve = Data.CorrectionData.CorrectionSwingTranslationCurve;
+		Effector.SwingRotationCurve.Curve = Data.RotationData.SwingRotationCurve;
+
+		if (CurveBakeSettings.bBakeCurves)
+		{
+			const FString EffectorName = It->Key.ToString();
+			Effector.BlendInAcceleration.LUTIndex = BakeCurve(Effector.BlendInAcceleration.Curve, 1, EffectorName + TEXT(".BlendInAcceleration"), BakedCurves);
+			Effector.BlendOutAcceleration.LUTIndex = BakeCurve(Effector.BlendOutAcceleration.Curve, 1, EffectorName + TEXT(".BlendOutAcceleration"), BakedCurves);
+			Effector.SwingTranslationCurve.LUTIndex = BakeCurve(Effector.SwingTranslationCurve.Curve, 3, EffectorName + TEXT(".SwingTranslationCurve"), BakedCurves);
+			Effector.CorrectionSwingTranslationCurve.LUTIndex = BakeCurve(Effector.CorrectionSwingTranslationCurve.Curve, 3, EffectorName + TEXT(".CorrectionSwingTranslationCurve"), BakedCurves);
+			Effector.SwingRotationCurve.LUTIndex = BakeCurve(Effector.SwingRotationCurve.Curve, 3, EffectorName + TEXT(".SwingRotationCurve"), BakedCurves);
+		}
+
+		Effector.TranslationScale = Data.TranslationData.TranslationFactor * Data.TranslationData.TranslationSwingScale;
+		Effector.TranslationOffset = Data.TranslationData.Offset * Data.TranslationData.TranslationFactor;
+		Effector.RotationFactor = Data.RotationData.RotationFactor;
+		Effector.LerpSpeed = Data.TranslationData.LerpSpeed;
+		Effector.DistanceTresholdToAdjust = Data.CorrectionData.DistanceTresholdToAdjust;
+
+		Effector.TransformSpace = Data.TranslationData.TransformSpace;
+		Effector.bAffectTranslation = Data.TranslationData.bAffectEffector;
+		Effector.bAffectRotation = Data.RotationData.bAffectEffector;
+		Effector.bOrientToVelocity = Data.TranslationData.bOrientToVelocity;
+		Effector.bAdaptToGroundLevel = Data.TranslationData.bAdaptToGroundLevel;
+		Effector.bAutoAdjustWithIdealEffector = Data.CorrectionData.bAutoAdjustWithIdealEffector;
+		Effector.bComputeCollision = Data.CorrectionData.bComputeCollision;
+		Effector.bRaiseOnCollisionEvent = Data.EventData.bRaiseOnCollisionEvent;
+
+		RuntimeTable.EffectorNames.Add(It->Key);
+		RuntimeTable.Effectors.Add(Effector);
+		RuntimeTable.SwingData.Add(&Data);
+	}
+
+	// Resolve parents once all effectors are known.
+	for (int32 i = 0; i < Num; ++i)
+	{
+		RuntimeTable.Effectors[i].ParentIndex = RuntimeTable.Find(RuntimeTable.SwingData[i]->SwingTime.ParentEffector);
+	}
+
+	RuntimeTable.bBuilt = true;
+	RuntimeTable.Version = ++GaitRuntimeTableVersion;
+}
+
+int32 UGaitDataAsset::BakeCurve(const UCurveBase* Curve, int32 NumComponents, const FString& CurveName, TMap<const UCurveBase*, int32>& BakedCurves)
+{
+	if (!Curve)
+	{
+		return INDEX_NONE;
+	}
+
+	// Curves shared by several effectors are baked once.
+	if (const int32* LUTIndex = BakedCurves.Find(Curve))
+	{
+		return *LUTIndex;
+	}
+
+	// Referenced curves may not be post loaded yet.
+	const_cast<UCurveBase*>(Curve)->ConditionalPostLoad();
+
+	const int32 MaxResolution = FMath::Max(CurveBakeSettings.MaxResolution, 2);
+	int32 Resolution = FMath::Clamp(CurveBakeSettings.MinResolution, 2, MaxResolution);
+	TArray<float> Samples;
+	float MaxDeviation = 0.f;
+
+	// Double the resolution until the LUT fits the tolerance.
+	while (true)
+	{
+		Samples.SetNumUninitialized(Resolution * NumComponents);
+		for (int32 i = 0; i < Resolution; ++i)
+		{
+			EvaluateSourceCurve(Curve, NumComponents, (float)i / (float)(Resolution - 1), &Samples[i * NumComponents]);
+		}
+
+		// Measure what the runtime will actually read.
+		if (CurveBakeSettings.bHalfPrecision)
+		{
+			for (float& Sample : Samples)
+			{
+				Sample = FFloat16(Sample).GetFloat();
+			}
+		}
+
+		MaxDeviation = 0.f;
+		const int32 NumChecks = (Resolution - 1) * CURVE_BAKE_CHECKS_PER_SEGMENT;
+		for (int32 k = 0; k <= NumChecks; ++k)
+		{
+			const float Time = (float)k / (float)NumChecks;
+			const float Position = Time * (float)(Resolution - 1);
+			const int32 Index = FMath::Min(FMath::FloorToInt(Position), Resolution - 2);
+			const float Alpha = Position - (float)Index;
+
+			float Source[3];
+			EvaluateSourceCurve(Curve, NumComponents, Time, Source);
+			for (int32 c = 0; c < NumComponents; ++c)
+			{
+				const float Baked = FMath::Lerp(Samples[Index * NumComponents + c], Samples[(Index + 1) * NumComponents + c], Alpha);
+				MaxDeviation = FMath::Max(MaxDeviation, FMath::Abs(Baked - Source[c]));
+			}
+		}
+
+		if (MaxDeviation <= CurveBakeSettings.Tolerance || Resolution >= MaxResolution)
+		{
+			break;
+		}
+		Resolution = FMath::Min(Resolution * 2, MaxResolution);
+	}
+
+	FGaitCurveLUT LUT;
+	LUT.NumSamples = Resolution;
+	if (RuntimeTable.bHalfPrecision)
+	{
+		LUT.FirstValue = RuntimeTable.HalfValues.Num();
+		for (float Sample : Samples)
+		{
+			RuntimeTable.HalfValues.Add(FFloat16(Sample));
+		}
+	}
+	else
+	{
+		LUT.FirstValue = RuntimeTable.Values.Num();
+		RuntimeTable.Values.Append(Samples);
+	}
+
+	const int32 LUTIndex = RuntimeTable.LUTs.Add(LUT);
+	BakedCurves.Add(Curve, LUTIndex);
+
+#if WITH_EDITORONLY_DATA
+	FGaitCurveBakeReport& Report = CurveBakeReport.AddDefaulted_GetRef();
+	Report.CurveName = FString::Printf(TEXT("%s (%s)"), *CurveName, *Curve->GetName());
+	Report.Resolution = Resolution;
+	Report.MaxDeviation = MaxDeviation;
+	Report.bWithinTolerance = MaxDeviation <= CurveBakeSettings.Tolerance;
+
+	if (!Report.bWithinTolerance)
+	{
+		DEBUG_LOG_FORMAT(Warning, "Baked curve %s of gait %s deviates by %f from its source (tolerance %f) at max resolution %d.", *Report.CurveName, *GetName(), MaxDeviation, CurveBakeSettings.Tolerance, Resolution);
+	}
+#endif
+
+	return LUTIndex;
+}
+
+void UGaitDataAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	BuildRuntimeTable();
+}
+
+#if WITH_EDITOR
+void UGaitDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BuildRuntimeTable();
+}
+
+void UGaitDataAsset::PostEditUndo()
+{
+	Super::PostEditUndo();
+
+	// Undo reallocates @GaitSwingValues: the table points into it.
+	BuildRuntimeTable();
+}
+#endif
+
+
+void FGaitSetBinding::Build(const TMap<FName, UGaitDataAsset*>& GaitsData)
+{
+	Reset();
+
+	for (TMap<FName, UGaitDataAsset*>::TConstIterator It = GaitsData.CreateConstIterator(); It; ++It)
+	{
+		if (It->Value)
+		{
+			GaitNames.Add(It->Key);
+		}
+	}
+
+	// Gait indices are replicated (see @FGaitReplicatedState): sorted by name, they don't depend on the map order of each machine.
+	GaitNames.Sort(FNameLexicalLess());
+
+	for (const FName& GaitName : GaitNames)
+	{
+		UGaitDataAsset* Asset = GaitsData.FindChecked(GaitName);
+
+		// Built here, on the game thread, before any worker reads it.
+		Asset->ConditionalBuildRuntimeTable();
+		Assets.Add(Asset);
+		TableVersions.Add(Asset->GetRuntimeTable().Version);
+	}
+
+	// Slots are the union of every gait effectors.
+	for (int32 GaitIndex = 0, n = Assets.Num(); GaitIndex < n; ++GaitIndex)
+	{
+		const FGaitRuntimeTable& Table = GetTable(GaitIndex);
+		GaitOffsets.Add(SlotOfEffector.Num());
+
+		for (int32 EffectorIndex = 0, m = Table.Num(); EffectorIndex < m; ++EffectorIndex)
+		{
+			SlotOfEffector.Add(SlotNames.AddUnique(Table.EffectorNames[EffectorIndex]));
+		}
+	}
+
+	const int32 NumSlots = SlotNames.Num();
+	EffectorOfSlot.Init(INDEX_NONE, Assets.Num() * NumSlots);
+	for (int32 GaitIndex = 0, n = Assets.Num(); GaitIndex < n; ++GaitIndex)
+	{
+		for (int32 EffectorIndex = 0, m = GetTable(GaitIndex).Num(); EffectorIndex < m; ++EffectorIndex)
+		{
+			EffectorOfSlot[GaitIndex * NumSlots + GetSlot(GaitIndex, EffectorIndex)] = EffectorIndex;
+		}
+	}
+
+	bBuilt = true;
+}
+
+void FGaitSetBinding::Reset()
+{
+	GaitNames.Reset();
+	Assets.Reset();
+	SlotNames.Reset();
+	GaitOffsets.Reset();
+	SlotOfEffector.Reset();
+	EffectorOfSlot.Reset();
+	TableVersions.Reset();
+	bBuilt = false;
+}
+
+bool FGaitSetBinding::IsOutdated() const
+{
+	check(IsInGameThread());
+
+	for (int32 GaitIndex = 0, n = Assets.Num(); GaitIndex < n; ++GaitIndex)
+	{
+		if (GetTable(GaitIndex).Version != TableVersions[GaitIndex])
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitEvaluationCacheSubsystem.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Public/GaitDataAsset.h"
+#include "Nobunanim/Public/GaitMath.h"
+
+#include <Engine/World.h>
+
+#include <atomic>
+
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Evaluation cache - Hits"), STAT_GaitEvaluationCacheHits, STATGROUP_Nobunanim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Evaluation cache - Misses"), STAT_GaitEvaluationCacheMisses, STATGROUP_Nobunanim);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Evaluation cache - Samples"), STAT_GaitEvaluationCacheSamples, STATGROUP_Nobunanim);
+
+
+namespace
+{
+	constexpr int32 NumSharedCurves = (int32)EGaitSharedCurve::BlendOutAcceleration + 1;
+
+	/** Samples of one runtime table, flattened [Effector][Curve][Phase]. */
+	struct FGaitTableSamples
+	{
+		/** @FGaitRuntimeTable::Version sampled. */
+		uint32 Version = 0;
+		int32 NumPhases = 0;
+		/** Float curves use X. */
+		TArray<FVector> Values;
+		TBitArray<> bValid;
+	};
+
+	/** Samples of one thread. */
+	struct FGaitThreadSamples
+	{
+		TMap<const FGaitRuntimeTable*, FGaitTableSamples> Tables;
+		int32 NumSamples = 0;
+	};
+
+	/** Never shared: no lock on the compute phase. */
+	thread_local FGaitThreadSamples GaitThreadSamples;
+
+	/** Samples allocated by every thread, for stats. */
+	std::atomic<int32> GaitNumCachedSamples{ 0 };
+
+	/** Samples of @Table for the calling thread, (re)allocated if needed. Null if @Table doesn't fit in @MaxSamples. */
+	FGaitTableSamples* FindOrAddTableSamples(const FGaitRuntimeTable& Table, int32 NumPhases, int32 MaxSamples)
+	{
+		FGaitThreadSamples& ThreadSamples = GaitThreadSamples;
+		const int32 NumSamples = Table.Num() * NumSharedCurves * NumPhases;
+
+		FGaitTableSamples* TableSamples = ThreadSamples.Tables.Find(&Table);
+		if (TableSamples && TableSamples->Version == Table.Version && TableSamples->NumPhases == NumPhases)
+		{
+			return TableSamples;
+		}
+
+		if (NumSamples > MaxSamples)
+		{
+			return nullptr;
+		}
+
+		// Rebuilt table, new table at the address of a destroyed one, or phase step edited: versions are unique, the layout may have changed.
+		if (TableSamples)
+		{
+			ThreadSamples.NumSamples -= TableSamples->Values.Num();
+			GaitNumCachedSamples -= TableSamples->Values.Num();
+			ThreadSamples.Tables.Remove(&Table);
+		}
+
+		// Full: start over rather than tracking the use of each table.
+		if (ThreadSamples.NumSamples + NumSamples > MaxSamples)
+		{
+			GaitNumCachedSamples -= ThreadSamples.NumSamples;
+			ThreadSamples.NumSamples = 0;
+			ThreadSamples.Tables.Reset();
+		}
+
+		TableSamples = &ThreadSamples.Tables.Add(&Table);
+		TableSamples->Version = Table.Version;
+		TableSamples->NumPhases = NumPhases;
+		TableSamples->Values.SetNumUninitialized(NumSamples);
+		TableSamples->bValid.Init(false, NumSamples);
+		ThreadSamples.NumSamples += NumSamples;
+		GaitNumCachedSamples += NumSamples;
+		return TableSamples;
+	}
+}
+
+
+#pragma region UNREAL METHODS
+
+bool UGaitEvaluationCacheSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGaitEvaluationCacheSubsystem::Tick(float DeltaTime)
+{
+	SET_DWORD_STAT(STAT_GaitEvaluationCacheSamples, GetNumSamples());
+}
+
+TStatId UGaitEvaluationCacheSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGaitEvaluationCacheSubsystem, STATGROUP_Nobunanim);
+}
+
+#pragma endregion
+
+
+#pragma region EVALUATION CACHE
+
+UGaitEvaluationCacheSubsystem* UGaitEvaluationCacheSubsystem::Get(const UWorld* World)
+{
+	if (!World || !UNobunanimSettings::GetSharedEvaluationSettings().bEnabled)
+	{
+		return nullptr;
+	}
+
+	return World->GetSubsystem<UGaitEvaluationCacheSubsystem>();
+}
+
+FVector UGaitEvaluationCacheSubsystem::SampleVector(UGaitEvaluationCacheSubsystem* Cache, const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase)
+{
+	return Cache ? Cache->FindOrSample(Table, EffectorIndex, Curve, Phase) : Sample(Table, EffectorIndex, Curve, Phase);
+}
+
+float UGaitEvaluationCacheSubsystem::SampleFloat(UGaitEvaluationCacheSubsystem* Cache, const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase)
+{
+	return SampleVector(Cache, Table, EffectorIndex, Curve, Phase).X;
+}
+
+int32 UGaitEvaluationCacheSubsystem::GetNumSamples() const
+{
+	return GaitNumCachedSamples;
+}
+
+FVector UGaitEvaluationCacheSubsystem::FindOrSample(const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase)
+{
+	const FGaitSharedEvaluationSettings& Settings = UNobunanimSettings::GetSharedEvaluationSettings();
+	const int32 NumPhases = FGaitMath::GetNumQuantizedPhases(Settings.PhaseStep);
+	const int32 PhaseIndex = FGaitMath::QuantizePhase(Phase, Settings.PhaseStep);
+	// Evaluated at the quantized phase: the value doesn't depend on which instance fills the entry, nor on the table fitting in the cache.
+	const float QuantizedPhase = FMath::Min((float)PhaseIndex * Settings.PhaseStep, 1.f);
+
+	FGaitTableSamples* TableSamples = FindOrAddTableSamples(Table, NumPhases, Settings.MaxSamples);
+	if (!TableSamples)
+	{
+		INC_DWORD_STAT(STAT_GaitEvaluationCacheMisses);
+		return Sample(Table, EffectorIndex, Curve, QuantizedPhase);
+	}
+
+	const int32 SampleIndex = (EffectorIndex * NumSharedCurves + (int32)Curve) * NumPhases + PhaseIndex;
+	if (TableSamples->bValid[SampleIndex])
+	{
+		INC_DWORD_STAT(STAT_GaitEvaluationCacheHits);
+		return TableSamples->Values[SampleIndex];
+	}
+
+	INC_DWORD_STAT(STAT_GaitEvaluationCacheMisses);
+	const FVector Value = Sample(Table, EffectorIndex, Curve, QuantizedPhase);
+	TableSamples->Values[SampleIndex] = Value;
+	TableSamples->bValid[SampleIndex] = true;
+	return Value;
+}
+
+FVector UGaitEvaluationCacheSubsystem::Sample(const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase)
+{
+	const FGaitRuntimeEffector& Effector = Table.Effectors[EffectorIndex];
+	switch (Curve)
+	{
+	case EGaitSharedCurve::SwingTranslation:
+		return Table.SampleVector(Effector.SwingTranslationCurve, Phase);
+	case EGaitSharedCurve::CorrectionSwingTranslation:
+		return Table.SampleVector(Effector.CorrectionSwingTranslationCurve, Phase);
+	case EGaitSharedCurve::SwingRotation:
+		return Table.SampleVector(Effector.SwingRotationCurve, Phase);
+	case EGaitSharedCurve::BlendInAcceleration:
+		return FVector(Table.SampleFloat(Effector.BlendInAcceleration, Phase), 0.f, 0.f);
+	case EGaitSharedCurve::BlendOutAcceleration:
+		return FVector(Table.SampleFloat(Effector.BlendOutAcceleration, Phase), 0.f, 0.f);
+	}
+	return FVector(1.f, 1.f, 1.f);
+}
+
+#pragma endregion
@@ -0,0 +1,405 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitEvaluator.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/GaitEvaluationCacheSubsystem.h"
+#include "Nobunanim/Public/GaitReplicatedState.h"
+#include "Nobunanim/Public/GaitMath.h"
+
+
+FGaitReplicatedState FGaitEvaluationState::GetReplicatedState(const FGaitSetBinding& Binding) const
+{
+	FGaitReplicatedState Replicated;
+	Replicated.GaitIndex = CurrentGaitIndex;
+	Replicated.PendingGaitIndex = PendingGaitIndex;
+	Replicated.SetPhase(TimeBuffer);
+
+	if (CurrentGaitIndex != INDEX_NONE)
+	{
+		float BlendSum = 0.f;
+		const int32 NumGaitEffectors = Binding.GetTable(CurrentGaitIndex).Num();
+		for (int32 j = 0; j < NumGaitEffectors; ++j)
+		{
+			BlendSum += Effectors[Binding.GetSlot(CurrentGaitIndex, j)].CurrentBlendValue;
+		}
+		Replicated.SetBlendProgress(NumGaitEffectors > 0 ? BlendSum / NumGaitEffectors : 1.f);
+	}
+
+	return Replicated;
+}
+
+void FGaitEvaluationState::ApplyReplicatedState(const FGaitReplicatedState& Replicated, const FGaitSetBinding& Binding, TFunctionRef<void(FName GaitName)> SwitchGait)
+{
+	if (!Binding.Assets.IsValidIndex(Replicated.GaitIndex))
+	{
+		return;
+	}
+	const int32 ReplicatedPendingIndex = Binding.Assets.IsValidIndex(Replicated.PendingGaitIndex) ? Replicated.PendingGaitIndex : INDEX_NONE;
+
+	// First state: start where the server is.
+	if (CurrentGaitIndex == INDEX_NONE)
+	{
+		SwitchGait(Binding.GaitNames[Replicated.GaitIndex]);
+		if (CurrentGaitIndex != Replicated.GaitIndex)
+		{
+			return;
+		}
+
+		PendingGaitIndex = ReplicatedPendingIndex;
+		TimeBuffer = Replicated.GetPhase();
+		CurrentTime = TimeBuffer;
+		for (int32 j = 0, n = Binding.GetTable(CurrentGaitIndex).Num(); j < n; ++j)
+		{
+			Effectors[Binding.GetSlot(CurrentGaitIndex, j)].CurrentBlendValue = Replicated.GetBlendProgress();
+		}
+		PhaseError = 0.f;
+		return;
+	}
+
+	// Gait change: blend to the server gait like a local change.
+	const int32 ReplicatedTargetIndex = ReplicatedPendingIndex != INDEX_NONE ? ReplicatedPendingIndex : Replicated.GaitIndex;
+	const int32 LocalTargetIndex = PendingGaitIndex != INDEX_NONE ? PendingGaitIndex : CurrentGaitIndex;
+	if (ReplicatedTargetIndex != LocalTargetIndex)
+	{
+		SwitchGait(Binding.GaitNames[ReplicatedTargetIndex]);
+	}
+
+	// The phase is caught up by the next evaluations.
+	PhaseError = Replicated.GetPhaseError(TimeBuffer);
+}
+
+
+bool FGaitEvaluator::IsGaitPlaying(const FGaitEvaluationState& State, const FGaitEvaluationInputs& Inputs)
+{
+	return State.CurrentGaitIndex != INDEX_NONE
+		&& (!Inputs.Binding->Assets[State.CurrentGaitIndex]->bComputeWithVelocityOnly || Inputs.Velocity.SizeSquared() != 0.f);
+}
+
+EGaitEvaluationResult FGaitEvaluator::Evaluate(FGaitEvaluationState& State, const FGaitEvaluationInputs& Inputs, IGaitEvaluationSink& Sink)
+{
+	if (State.CurrentGaitIndex == INDEX_NONE)
+	{
+		State.CurrentTime = 0;
+		return EGaitEvaluationResult::NoGait;
+	}
+
+	if (!IsGaitPlaying(State, Inputs))
+	{
+		State.CurrentTime = 0;
+		return EGaitEvaluationResult::Idle;
+	}
+
+	const FGaitSetBinding& GaitBinding = *Inputs.Binding;
+	const FProceduralGaitLODSettings& LODSetting = *Inputs.LODSetting;
+	const UGaitDataAsset& CurrentAsset = *GaitBinding.Assets[State.CurrentGaitIndex];
+	const FGaitRuntimeTable& CurrentTable = CurrentAsset.GetRuntimeTable();
+	const float DeltaTime = Inputs.DeltaTime;
+	// PhaseOnly keeps the cycle and the events but writes no effector output.
+	const bool bEmitOutputs = Inputs.OffscreenPolicy != EGaitOffscreenPolicy::PhaseOnly;
+
+	FVector NewCurrentLocation;
+	FVector IdealEffectorLocation;
+	FVector CurrentEffectorLocation;
+	float Treshold = 0.f;
+	bool bForceSwing = false;
+	bool bAllEffectorBlendOutEnd = true;
+
+	if (Inputs.Velocity.SizeSquared() != 0.f)
+	{
+		State.LastVelocity = Inputs.Velocity;
+	}
+	const FRotator VelocityRotation = State.LastVelocity.Rotation();
+
+	// Step 1: Timers.
+	const float TimeAdvance = DeltaTime * CurrentAsset.GetFrameRatio() * Inputs.PlayRate;
+	float PhaseCorrection = 0.f;
+	if (State.PhaseError != 0.f)
+	{
+		PhaseCorrection = FGaitReplicatedState::ConsumePhaseError(State.PhaseError, TimeAdvance, UNobunanimSettings::GetReplicationSettings().MaxPhaseCorrection);
+	}
+	State.CurrentTime = FGaitMath::AdvancePhase(State.TimeBuffer, TimeAdvance + PhaseCorrection);
+	const float CurrentTime = State.CurrentTime;
+
+	// Step 2: Foreach swing values, we will check if we are in 'Swing' or 'Stance' according to @CurrentTime.
+	for (int j = 0, m = CurrentTable.Num(); j < m; ++j)
+	{
+		NOBUNANIM_SCOPE_COUNTER(Gait_Evaluate_PerEffector);
+
+		const int32 Slot = GaitBinding.GetSlot(State.CurrentGaitIndex, j);
+		const FName Key = GaitBinding.SlotNames[Slot];
+		const FGaitRuntimeEffector& CurrentData = CurrentTable.Effectors[j];
+		FGaitEffectorData& Effector = State.Effectors[Slot];
+
+		bool bBlendIn = true;
+
+		// Update blend value
+		{
+			// If there isn't any pending gait, so it's a blend in
+			if (State.PendingGaitIndex == INDEX_NONE || Effector.CurrentGaitIndex == State.PendingGaitIndex)
+			{
+				if (CurrentData.BlendInTime == 0)
+				{
+					Effector.CurrentBlendValue = 1.f;
+				}
+				else
+				{
+					bBlendIn = true;
+					if (Effector.CurrentBlendValue < 1.f)
+					{
+						Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue + (DeltaTime / CurrentData.BlendInTime), 0.f, 1.f);
+					}
+				}
+
+				if (State.PendingGaitIndex == INDEX_NONE)
+				{
+					bAllEffectorBlendOutEnd = false;
+				}
+			}
+			else
+			{
+				if (CurrentData.BlendOutTime == 0)
+				{
+					Effector.CurrentBlendValue = 0.f;
+					Effector.CurrentGaitIndex = State.PendingGaitIndex;
+				}
+				else
+				{
+					bBlendIn = false;
+					if (Effector.CurrentBlendValue > 0.f)
+					{
+						Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue - (DeltaTime / CurrentData.BlendOutTime), 0.f, 1.f);
+					}
+
+					// if end blend out, swap gait.
+					if (Effector.CurrentBlendValue == 0.f)
+					{
+						Effector.CurrentGaitIndex = State.PendingGaitIndex;
+					}
+				}
+				bAllEffectorBlendOutEnd = false;
+			}
+		}
+
+		// no need to check, check is made when the gait mode is updated.
+		const int32 UpdatedGaitIndex = Effector.CurrentGaitIndex == INDEX_NONE ? State.CurrentGaitIndex : Effector.CurrentGaitIndex;
+		const int32 UpdatedIndex = GaitBinding.GetEffector(UpdatedGaitIndex, Slot);
+		if (UpdatedIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FGaitRuntimeTable& UpdatedTable = GaitBinding.GetTable(UpdatedGaitIndex);
+		const FGaitRuntimeEffector& UpdatedCurrentData = UpdatedTable.Effectors[UpdatedIndex];
+		const FGaitSwingData& UpdatedSwingData = *UpdatedTable.SwingData[UpdatedIndex];
+		const int32 ParentSlot = UpdatedCurrentData.ParentIndex != INDEX_NONE ? GaitBinding.GetSlot(UpdatedGaitIndex, UpdatedCurrentData.ParentIndex) : INDEX_NONE;
+
+		// Planted effector: nothing changes until its swing begins, only the output and the auto adjust test are updated.
+		if (State.TimeBuffer < Effector.PlantedUntil && Inputs.PlayRate > 0.f && State.PendingGaitIndex == INDEX_NONE && !Inputs.bShowDebug
+			&& !(UpdatedCurrentData.bAutoAdjustWithIdealEffector && ((ParentSlot != INDEX_NONE && State.Effectors[ParentSlot].bForceSwing)
+				|| (Effector.CurrentEffectorLocation - Effector.IdealEffectorLocation).Size2D() >= UpdatedCurrentData.DistanceTresholdToAdjust)))
+		{
+			if (bEmitOutputs)
+			{
+				Sink.EmitEffectorTranslation(Key, Effector.CurrentEffectorLocation, UpdatedCurrentData.LerpSpeed > 0, UpdatedCurrentData.LerpSpeed);
+			}
+			continue;
+		}
+		Effector.PlantedUntil = -1.f;
+
+		float BeginSwing = UpdatedCurrentData.BeginSwing;
+		float EndSwing = UpdatedCurrentData.EndSwing;
+
+		bool bCanCompute = Effector.BlockTime == -1.f
+			|| (Effector.BlockTime > BeginSwing && CurrentTime >= Effector.BlockTime)
+			|| (Effector.BlockTime < BeginSwing && CurrentTime < BeginSwing && CurrentTime >= Effector.BlockTime);
+
+		if (!bCanCompute)
+		{
+			continue;
+		}
+
+		float MinRange, MaxRange;
+		BeginSwing = Effector.bForceSwing ? Effector.BeginForceSwingInterval : BeginSwing;
+		EndSwing = Effector.bForceSwing ? Effector.EndForceSwingInterval : EndSwing;
+
+		bool InRange = FGaitMath::IsInSwingRange(CurrentTime, BeginSwing, EndSwing, MinRange, MaxRange);
+
+		// Step 2.2: If the effector is in 'Swing'.
+		if (InRange)
+		{
+			NOBUNANIM_SCOPE_COUNTER(Gait_Swing);
+
+			if (!Effector.bSwinging)
+			{
+				Effector.bSwinging = true;
+				Sink.EmitGaitEvent(EGaitEventType::BeginSwing, Key, Effector.CurrentEffectorLocation);
+			}
+
+			Effector.bCorrectionIK = false;
+
+			float CurrentCurvePosition = FMath::GetMappedRangeValueClamped(FVector2D(MinRange, MaxRange), FVector2D(0.f, 1.f), CurrentTime);
+
+			// :D hue hue :D
+			float lerpSpeed = UpdatedCurrentData.LerpSpeed <= 0 ? 0
+				: UpdatedCurrentData.LerpSpeed * (Effector.CurrentBlendValue == 1.f ? 1.f
+					: UGaitEvaluationCacheSubsystem::SampleFloat(Inputs.EvaluationCache, UpdatedTable, UpdatedIndex,
+						bBlendIn ? EGaitSharedCurve::BlendInAcceleration : EGaitSharedCurve::BlendOutAcceleration, Effector.CurrentBlendValue));
+
+			// Step 2.2.1: Apply 'Swing' rotation (for bones).
+			if (UpdatedCurrentData.bAffectRotation && bEmitOutputs)
+			{
+				FVector CurrentCurveValue = UpdatedCurrentData.RotationFactor
+					* UGaitEvaluationCacheSubsystem::SampleVector(Inputs.EvaluationCache, UpdatedTable, UpdatedIndex, EGaitSharedCurve::SwingRotation, CurrentCurvePosition);
+
+				Sink.EmitEffectorRotation(Key, FRotator(CurrentCurveValue.X, CurrentCurveValue.Y, CurrentCurveValue.Z), lerpSpeed);
+			}
+
+			// Step 2.2.1: Apply 'Swing' translation (for effectors IK(socket)).
+			if (UpdatedCurrentData.bAffectTranslation)
+			{
+				FVector CurrentCurveValue = UpdatedCurrentData.TranslationScale
+					* UGaitEvaluationCacheSubsystem::SampleVector(Inputs.EvaluationCache, UpdatedTable, UpdatedIndex,
+						Effector.bForceSwing ? EGaitSharedCurve::CorrectionSwingTranslation : EGaitSharedCurve::SwingTranslation, CurrentCurvePosition);
+
+				CurrentCurveValue = UpdatedCurrentData.bOrientToVelocity ?
+					VelocityRotation.RotateVector(CurrentCurveValue) : Inputs.ComponentRotation.RotateVector(CurrentCurveValue);
+
+				FVector Offset = UpdatedCurrentData.bOrientToVelocity ?
+					VelocityRotation.RotateVector(UpdatedCurrentData.TranslationOffset) : Inputs.ComponentRotation.RotateVector(UpdatedCurrentData.TranslationOffset);
+
+				CurrentEffectorLocation = Effector.CurrentEffectorLocation;
+
+				IdealEffectorLocation = UpdatedCurrentData.bAdaptToGroundLevel ? Effector.GroundLocation : Effector.IdealEffectorLocation;
+				NewCurrentLocation = IdealEffectorLocation + Offset + CurrentCurveValue;
+				Treshold = UpdatedCurrentData.DistanceTresholdToAdjust;
+				bForceSwing = Effector.bForceSwing;
+
+				if (bEmitOutputs)
+				{
+					Sink.EmitEffectorTranslation(Key, NewCurrentLocation, lerpSpeed > 0, lerpSpeed);
+				}
+
+				Effector.CurrentEffectorLocation = NewCurrentLocation;
+			}
+		}
+		// Step 2.3: If the effector is in 'Stance'.
+		else
+		{
+			if (Effector.bSwinging)
+			{
+				Effector.bSwinging = false;
+				Sink.EmitGaitEvent(EGaitEventType::EndSwing, Key, Effector.CurrentEffectorLocation);
+			}
+
+			if (Effector.bForceSwing)
+			{
+				Effector.BlockTime = UpdatedCurrentData.EndSwing >= 0.99f ? 0.f : UpdatedCurrentData.EndSwing;
+			}
+			else
+			{
+				Effector.BlockTime = -1.f;
+
+				// check for foot ik.
+				if (Inputs.bCanTrace && !Effector.bCorrectionIK && UpdatedCurrentData.bComputeCollision)
+				{
+					if (Inputs.OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly)
+					{
+						// No trace: the foot lands where it is, but the footfall is still raised.
+						Effector.bCorrectionIK = true;
+						if (UpdatedCurrentData.bRaiseOnCollisionEvent)
+						{
+							Sink.EmitGaitEvent(EGaitEventType::Footfall, Key, Effector.CurrentEffectorLocation);
+						}
+					}
+					// Off phase: a later update of this stance corrects it.
+					else if (LODSetting.bCanComputeCollisionCorrection && LODSetting.IsTracePhase(Inputs.UpdateCounter, Slot, Inputs.TracePhase))
+					{
+						NOBUNANIM_SCOPE_COUNTER(Gait_Stance_IKCorrection);
+
+						const FGaitCorrectionData& CorrectionData = UpdatedSwingData.CorrectionData;
+
+						// Get origin for IK
+						FVector Origin = CorrectionData.bUseCurrentEffector ? Effector.CurrentEffectorLocation : Sink.GetCorrectionOrigin(Slot, CorrectionData.OriginCollisionSocketName);
+						FVector Dir = CorrectionData.bOrientToVelocity ? VelocityRotation.RotateVector(CorrectionData.AbsoluteDirection) : CorrectionData.AbsoluteDirection;
+
+						// Get Dest
+						FVector Dest = Origin + Dir;
+
+						// Add inverse absolute direction
+						Origin -= Dir;
+
+						FVector ImpactPoint;
+						if (Sink.TraceCorrection(Slot, Origin, Dest, CorrectionData.TraceChannel, ImpactPoint))
+						{
+							const FVector SnapOffset = VelocityRotation.RotateVector(CorrectionData.CollisionSnapOffset);
+
+#if WITH_EDITOR
+							if (LODSetting.Debug.bShowCollisionCorrection)
+							{
+								Sink.DrawCorrectionDebug(ImpactPoint + SnapOffset);
+							}
+#endif
+
+							// if hit ground
+							Effector.CurrentEffectorLocation = ImpactPoint + SnapOffset;
+							Effector.bCorrectionIK = true;
+							if (UpdatedCurrentData.bRaiseOnCollisionEvent)
+							{
+								Sink.EmitGaitEvent(EGaitEventType::Footfall, Key, Effector.CurrentEffectorLocation);
+							}
+						}
+					}
+				}
+
+				if (bEmitOutputs)
+				{
+					Sink.EmitEffectorTranslation(Key, Effector.CurrentEffectorLocation, UpdatedCurrentData.LerpSpeed > 0, UpdatedCurrentData.LerpSpeed);
+				}
+			}
+
+			bForceSwing = Effector.bForceSwing = false;
+
+			CurrentEffectorLocation = Effector.CurrentEffectorLocation;
+			IdealEffectorLocation = Effector.IdealEffectorLocation;
+			NewCurrentLocation = CurrentEffectorLocation;
+			Treshold = UpdatedCurrentData.DistanceTresholdToAdjust;
+
+			// Step 2.3.1: Check if the effector need to be adjusted
+			if (UpdatedCurrentData.bAutoAdjustWithIdealEffector)
+			{
+				float VectorLength = (Effector.CurrentEffectorLocation - Effector.IdealEffectorLocation).Size2D();
+
+				// Is the distance breaking treshold?
+				if ((ParentSlot != INDEX_NONE && State.Effectors[ParentSlot].bForceSwing) || VectorLength >= UpdatedCurrentData.DistanceTresholdToAdjust)
+				{
+					// Here we compute the new interval of swing.
+					FGaitMath::ComputeForceSwingInterval(CurrentTime, BeginSwing, EndSwing, Effector.BeginForceSwingInterval, Effector.EndForceSwingInterval);
+					bForceSwing = Effector.bForceSwing = true;
+					Effector.BlockTime = -1.f;
+				}
+			}
+
+			// Step 2.3.2: Planted until the next swing begins (in time buffer units, so play rate changes are accounted for).
+			if (!Effector.bForceSwing && Effector.bCorrectionIK && Effector.BlockTime == -1.f && State.PendingGaitIndex == INDEX_NONE && Inputs.PlayRate > 0.f)
+			{
+				Effector.PlantedUntil = State.TimeBuffer + FGaitMath::GetTimeUntilPhase(CurrentTime, UpdatedCurrentData.BeginSwing);
+			}
+		}
+
+#if WITH_EDITOR
+		// Step 3: Draw Debug.
+		Sink.DrawEffectorDebug(NewCurrentLocation, IdealEffectorLocation, CurrentEffectorLocation, Treshold, UpdatedCurrentData.bAutoAdjustWithIdealEffector, bForceSwing, &UpdatedSwingData.DebugData);
+#endif
+	}
+
+	// Step 3: if all effector end blend out swtich gait
+	if (bAllEffectorBlendOutEnd == true)
+	{
+		State.CurrentGaitIndex = State.PendingGaitIndex;
+		State.PendingGaitIndex = INDEX_NONE;
+	}
+
+	return EGaitEvaluationResult::Updated;
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitEventSubsystem.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+
+#include <Engine/World.h>
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gait events - Flushed"), STAT_GaitEventsFlushed, STATGROUP_Nobunanim);
+
+
+#pragma region UNREAL METHODS
+
+bool UGaitEventSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGaitEventSubsystem::Deinitialize()
+{
+	Events.Empty();
+	FlushedEvents.Empty();
+	OnGaitEvents.Clear();
+
+	Super::Deinitialize();
+}
+
+void UGaitEventSubsystem::Tick(float DeltaTime)
+{
+	Flush();
+}
+
+TStatId UGaitEventSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGaitEventSubsystem, STATGROUP_Nobunanim);
+}
+
+#pragma endregion
+
+
+#pragma region EVENT QUEUE
+
+UGaitEventSubsystem* UGaitEventSubsystem::Get(const UWorld* World)
+{
+	return World ? World->GetSubsystem<UGaitEventSubsystem>() : nullptr;
+}
+
+void UGaitEventSubsystem::QueueEvent(const FGaitEventRecord& Event)
+{
+	check(IsInGameThread());
+	Events.Add(Event);
+}
+
+void UGaitEventSubsystem::Flush()
+{
+	NOBUNANIM_SCOPE_COUNTER(GaitEvents_Flush);
+
+	SET_DWORD_STAT(STAT_GaitEventsFlushed, Events.Num());
+	if (Events.Num() == 0)
+	{
+		return;
+	}
+
+	Swap(Events, FlushedEvents);
+	OnGaitEvents.Broadcast(FlushedEvents);
+	FlushedEvents.Reset();
+}
+
+#pragma endregion
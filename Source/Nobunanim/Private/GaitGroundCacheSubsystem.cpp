@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitGroundCacheSubsystem.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/NobunanimSettings.h"
+
+#include <Engine/World.h>
+#include <Components/PrimitiveComponent.h>
+
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground cache - Hits"), STAT_GaitGroundCacheHits, STATGROUP_Nobunanim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground cache - Misses"), STAT_GaitGroundCacheMisses, STATGROUP_Nobunanim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground cache - Stores"), STAT_GaitGroundCacheStores, STATGROUP_Nobunanim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground cache - Invalidations"), STAT_GaitGroundCacheInvalidations, STATGROUP_Nobunanim);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ground cache - Cells"), STAT_GaitGroundCacheCells, STATGROUP_Nobunanim);
+
+/** Maximum horizontal drift (in cm) for a trace to be considered vertical. */
+#define GROUND_CACHE_VERTICAL_TOLERANCE 1.f
+/** Ground steeper than this (normal Z) is never cached: its height varies too much across a cell. */
+#define GROUND_CACHE_MIN_NORMAL_Z 0.5f
+
+
+#pragma region UNREAL METHODS
+
+bool UGaitGroundCacheSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGaitGroundCacheSubsystem::Deinitialize()
+{
+	// The world is going away: nothing to notify, listeners may already be destroyed.
+	{
+		FWriteScopeLock WriteLock(CellsLock);
+		Cells.Empty();
+		SET_DWORD_STAT(STAT_GaitGroundCacheCells, 0);
+	}
+	OnGroundChanged.Clear();
+
+	Super::Deinitialize();
+}
+
+#pragma endregion
+
+
+#pragma region GROUND CACHE
+
+UGaitGroundCacheSubsystem* UGaitGroundCacheSubsystem::Get(const UWorld* World)
+{
+	if (!World || !UNobunanimSettings::GetGroundCacheSettings().bEnabled)
+	{
+		return nullptr;
+	}
+
+	return World->GetSubsystem<UGaitGroundCacheSubsystem>();
+}
+
+bool UGaitGroundCacheSubsystem::IsCacheable(const FVector& Origin, const FVector& Dest)
+{
+	return Dest.Z < Origin.Z
+		&& FVector::DistSquared2D(Origin, Dest) <= FMath::Square(GROUND_CACHE_VERTICAL_TOLERANCE);
+}
+
+bool UGaitGroundCacheSubsystem::FindGround(const FVector& Origin, const FVector& Dest, const FGaitGroundQuery& Query, float Now, FHitResult& OutHit) const
+{
+	const FGaitGroundCacheSettings& Settings = UNobunanimSettings::GetGroundCacheSettings();
+	const FCellKey Key = MakeKey(Origin, Query, Settings.CellSize);
+
+	FSample Sample;
+	{
+		FReadScopeLock ReadLock(CellsLock);
+
+		const FSample* Found = Cells.Find(Key);
+		if (!Found)
+		{
+			INC_DWORD_STAT(STAT_GaitGroundCacheMisses);
+			return false;
+		}
+		Sample = *Found;
+	}
+
+	if (Now - Sample.Time > Settings.Lifetime)
+	{
+		INC_DWORD_STAT(STAT_GaitGroundCacheMisses);
+		return false;
+	}
+
+	// Height of the sample plane under the trace.
+	const FVector Delta = Origin - Sample.Location;
+	const float GroundZ = Sample.Location.Z - (Sample.Normal.X * Delta.X + Sample.Normal.Y * Delta.Y) / Sample.Normal.Z;
+
+	// The trace must start in the range proven empty by the sample and reach the ground.
+	if (Origin.Z > Sample.ClearZ || Origin.Z < GroundZ || Dest.Z > GroundZ)
+	{
+		INC_DWORD_STAT(STAT_GaitGroundCacheMisses);
+		return false;
+	}
+
+	const FVector ImpactPoint(Origin.X, Origin.Y, GroundZ);
+
+	OutHit = FHitResult(Origin, Dest);
+	OutHit.bBlockingHit = true;
+	OutHit.Time = (Origin.Z - GroundZ) / (Origin.Z - Dest.Z);
+	OutHit.Distance = Origin.Z - GroundZ;
+	OutHit.Location = ImpactPoint;
+	OutHit.ImpactPoint = ImpactPoint;
+	OutHit.Normal = Sample.Normal;
+	OutHit.ImpactNormal = Sample.Normal;
+
+	INC_DWORD_STAT(STAT_GaitGroundCacheHits);
+	return true;
+}
+
+void UGaitGroundCacheSubsystem::StoreGround(const FVector& Origin, const FVector& Dest, const FGaitGroundQuery& Query, float Now, TArrayView<const FHitResult> HitResults)
+{
+	const FHitResult* BlockingHit = HitResults.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	if (!BlockingHit)
+	{
+		return;
+	}
+
+	const FGaitGroundCacheSettings& Settings = UNobunanimSettings::GetGroundCacheSettings();
+	const FCellKey Key = MakeKey(Origin, Query, Settings.CellSize);
+
+	// Something movable (or overlapping the trace before the ground) may not be there next time.
+	const UPrimitiveComponent* Component = BlockingHit->GetComponent();
+	const bool bStatic = Component && Component->Mobility == EComponentMobility::Static;
+	const bool bOverlap = HitResults.ContainsByPredicate([](const FHitResult& Hit)
+	{
+		const UPrimitiveComponent* HitComponent = Hit.GetComponent();
+		return !Hit.bBlockingHit && HitComponent && HitComponent->Mobility != EComponentMobility::Static;
+	});
+
+	FWriteScopeLock WriteLock(CellsLock);
+
+	if (!bStatic || bOverlap || BlockingHit->ImpactNormal.Z < GROUND_CACHE_MIN_NORMAL_Z)
+	{
+		if (Cells.Remove(Key) > 0)
+		{
+			INC_DWORD_STAT(STAT_GaitGroundCacheInvalidations);
+		}
+	}
+	else
+	{
+		if (Cells.Num() >= Settings.MaxCells)
+		{
+			PurgeExpired(Now, Settings.Lifetime);
+		}
+
+		FSample& Sample = Cells.FindOrAdd(Key);
+		Sample.Location = BlockingHit->ImpactPoint;
+		Sample.Normal = BlockingHit->ImpactNormal;
+		Sample.ClearZ = Origin.Z;
+		Sample.Time = Now;
+
+		INC_DWORD_STAT(STAT_GaitGroundCacheStores);
+	}
+
+	SET_DWORD_STAT(STAT_GaitGroundCacheCells, Cells.Num());
+}
+
+void UGaitGroundCacheSubsystem::InvalidateBox(const FBox& Box)
+{
+	const float CellSize = UNobunanimSettings::GetGroundCacheSettings().CellSize;
+	const int32 MinX = FMath::FloorToInt(Box.Min.X / CellSize);
+	const int32 MaxX = FMath::FloorToInt(Box.Max.X / CellSize);
+	const int32 MinY = FMath::FloorToInt(Box.Min.Y / CellSize);
+	const int32 MaxY = FMath::FloorToInt(Box.Max.Y / CellSize);
+
+	{
+		FWriteScopeLock WriteLock(CellsLock);
+
+		int32 NumRemoved = 0;
+		for (auto It = Cells.CreateIterator(); It; ++It)
+		{
+			const FCellKey& Key = It.Key();
+			if (Key.X >= MinX && Key.X <= MaxX && Key.Y >= MinY && Key.Y <= MaxY)
+			{
+				It.RemoveCurrent();
+				++NumRemoved;
+			}
+		}
+
+		INC_DWORD_STAT_BY(STAT_GaitGroundCacheInvalidations, NumRemoved);
+		SET_DWORD_STAT(STAT_GaitGroundCacheCells, Cells.Num());
+	}
+
+	OnGroundChanged.Broadcast(Box);
+}
+
+void UGaitGroundCacheSubsystem::InvalidateAll()
+{
+	{
+		FWriteScopeLock WriteLock(CellsLock);
+
+		INC_DWORD_STAT_BY(STAT_GaitGroundCacheInvalidations, Cells.Num());
+		Cells.Empty();
+		SET_DWORD_STAT(STAT_GaitGroundCacheCells, 0);
+	}
+
+	OnGroundChanged.Broadcast(FBox(FVector(-HALF_WORLD_MAX), FVector(HALF_WORLD_MAX)));
+}
+
+int32 UGaitGroundCacheSubsystem::GetNumCells() const
+{
+	FReadScopeLock ReadLock(CellsLock);
+	return Cells.Num();
+}
+
+#pragma endregion
+
+
+#pragma region GROUND CACHE UTILITIES
+
+UGaitGroundCacheSubsystem::FCellKey UGaitGroundCacheSubsystem::MakeKey(const FVector& Location, const FGaitGroundQuery& Query, float CellSize)
+{
+	FCellKey Key;
+	Key.X = FMath::FloorToInt(Location.X / CellSize);
+	Key.Y = FMath::FloorToInt(Location.Y / CellSize);
+	Key.Channel = (uint8)Query.Channel;
+	Key.Flags = (Query.bObjectQuery ? 1 : 0) | (Query.bTraceComplex ? 2 : 0);
+	return Key;
+}
+
+void UGaitGroundCacheSubsystem::PurgeExpired(float Now, float Lifetime)
+{
+	for (auto It = Cells.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().Time > Lifetime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Still full of valid cells: start over rather than growing forever.
+	if (Cells.Num() >= UNobunanimSettings::GetGroundCacheSettings().MaxCells)
+	{
+		Cells.Reset();
+	}
+}
+
+#pragma endregion
@@ -0,0 +1,8 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitQueryCounters.h"
+
+
+std::atomic<uint64> FGaitQueryCounters::NumTraces{ 0 };
+std::atomic<uint64> FGaitQueryCounters::NumSweeps{ 0 };
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitReplicatedState.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+
+
+float FGaitReplicatedState::ConsumePhaseError(float& PhaseError, float Advance, float MaxCorrection)
+{
+	const float MaxStep = FMath::Abs(Advance) * MaxCorrection;
+	const float Step = FMath::Clamp(PhaseError, -MaxStep, MaxStep);
+	PhaseError -= Step;
+	return Step;
+}
+
+bool FGaitReplicatedState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// 0 is no gait.
+	uint32 Gait = 0;
+	uint32 Pending = 0;
+	uint8 bPending = 0;
+	if (Ar.IsSaving())
+	{
+		Gait = GaitIndex >= 0 && GaitIndex < MaxGaits ? GaitIndex + 1 : 0;
+		bPending = PendingGaitIndex >= 0 && PendingGaitIndex < MaxGaits ? 1 : 0;
+		Pending = bPending ? PendingGaitIndex : 0;
+	}
+
+	Ar.SerializeInt(Gait, MaxGaits + 1);
+	Ar.SerializeBits(&bPending, 1);
+	if (bPending)
+	{
+		Ar.SerializeInt(Pending, MaxGaits);
+	}
+	Ar << Phase;
+	Ar << BlendProgress;
+
+	if (Ar.IsLoading())
+	{
+		GaitIndex = (int32)Gait - 1;
+		PendingGaitIndex = bPending ? (int32)Pending : INDEX_NONE;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FGaitReplicatedState::operator==(const FGaitReplicatedState& Other) const
+{
+	return GaitIndex == Other.GaitIndex && PendingGaitIndex == Other.PendingGaitIndex && Phase == Other.Phase && BlendProgress == Other.BlendProgress;
+}
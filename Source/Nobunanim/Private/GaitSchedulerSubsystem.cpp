@@ -0,0 +1,441 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitSchedulerSubsystem.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/NobunanimSettings.h"
+
+#include <Algo/BinarySearch.h>
+#include <Async/ParallelFor.h>
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gait scheduler - Registered instances"), STAT_GaitSchedulerInstances, STATGROUP_Nobunanim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gait scheduler - Updated instances"), STAT_GaitSchedulerUpdatedInstances, STATGROUP_Nobunanim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gait scheduler - Parallel instances"), STAT_GaitSchedulerParallelInstances, STATGROUP_Nobunanim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gait scheduler - Traces"), STAT_GaitSchedulerTraces, STATGROUP_Nobunanim);
+
+
+#pragma region UNREAL METHODS
+
+bool UGaitSchedulerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Same as the timers it replaces: only game worlds run procedural gait.
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGaitSchedulerSubsystem::Deinitialize()
+{
+	Buckets.Empty();
+	Registry.Empty();
+	PendingChanges.Empty();
+	FrameHistory.Empty();
+
+	SET_DWORD_STAT(STAT_GaitSchedulerInstances, 0);
+
+	Super::Deinitialize();
+}
+
+void UGaitSchedulerSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	NOBUNANIM_SCOPE_COUNTER(GaitScheduler_Tick);
+
+	const bool bAmortize = UNobunanimSettings::IsGaitUpdateAmortizationEnabled();
+	FFrameLoad FrameLoad;
+
+	bIsUpdating = true;
+	for (FBucket& Bucket : Buckets)
+	{
+		Bucket.Stats.NumUpdatedLastFrame = 0;
+		Bucket.Stats.NumParallelLastFrame = 0;
+		Bucket.Stats.NumTracesLastFrame = 0;
+		Bucket.Stats.LastUpdateTimeMs = 0.f;
+
+		const int32 NumEntries = Bucket.Entries.Num();
+		if (bAmortize)
+		{
+			// Every entry is owed one update per interval: update that share of the bucket each frame.
+			Bucket.Progress += (DeltaTime / Bucket.Interval) * (float)NumEntries;
+			const int32 NumToUpdate = FMath::Min(FMath::FloorToInt(Bucket.Progress), NumEntries);
+			Bucket.Progress -= (float)NumToUpdate;
+			if (Bucket.Progress >= 1.f)
+			{
+				// At most one update per entry and frame: drop what we are late of.
+				Bucket.Progress = FMath::Frac(Bucket.Progress);
+			}
+
+			if (NumToUpdate > 0)
+			{
+				const int32 FirstEntry = Bucket.Cursor % NumEntries;
+				UpdateBucket(Bucket, FirstEntry, NumToUpdate);
+				Bucket.Cursor = (FirstEntry + NumToUpdate) % NumEntries;
+			}
+		}
+		else
+		{
+			Bucket.Accumulator += DeltaTime;
+			if (Bucket.Accumulator >= Bucket.Interval)
+			{
+				// At most one update per frame: drop the whole intervals we are late of.
+				Bucket.Accumulator -= Bucket.Interval;
+				if (Bucket.Accumulator >= Bucket.Interval)
+				{
+					Bucket.Accumulator = FMath::Fmod(Bucket.Accumulator, Bucket.Interval);
+				}
+
+				UpdateBucket(Bucket, 0, NumEntries);
+			}
+		}
+
+		FrameLoad.NumUpdated += Bucket.Stats.NumUpdatedLastFrame;
+		FrameLoad.NumTraces += Bucket.Stats.NumTracesLastFrame;
+	}
+	bIsUpdating = false;
+
+	if (FrameHistory.Num() < FrameHistorySize)
+	{
+		FrameHistory.Add(FrameLoad);
+	}
+	else
+	{
+		FrameHistory[FrameHistoryIndex] = FrameLoad;
+	}
+	FrameHistoryIndex = (FrameHistoryIndex + 1) % FrameHistorySize;
+
+	// Apply registration changes requested during the update (in request order).
+	if (PendingChanges.Num() > 0)
+	{
+		TArray<FPendingChange> Changes = MoveTemp(PendingChanges);
+		PendingChanges.Reset();
+
+		for (const FPendingChange& Change : Changes)
+		{
+			if (Change.TargetFPS == INDEX_NONE)
+			{
+				ApplyUnregister(Change.Instance);
+			}
+			else
+			{
+				ApplyRegister(Change.Instance, Change.TargetFPS);
+			}
+		}
+	}
+}
+
+TStatId UGaitSchedulerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGaitSchedulerSubsystem, STATGROUP_Nobunanim);
+}
+
+#pragma endregion
+
+
+#pragma region SCHEDULER
+
+void UGaitSchedulerSubsystem::RegisterInstance(IGaitScheduledInstance* Instance, int32 TargetFPS)
+{
+	if (!Instance)
+	{
+		return;
+	}
+
+	TargetFPS = FMath::Max(TargetFPS, 1);
+
+	if (bIsUpdating)
+	{
+		PendingChanges.Add({ Instance, TargetFPS });
+	}
+	else
+	{
+		ApplyRegister(Instance, TargetFPS);
+	}
+}
+
+void UGaitSchedulerSubsystem::UnregisterInstance(IGaitScheduledInstance* Instance)
+{
+	if (!Instance)
+	{
+		return;
+	}
+
+	if (bIsUpdating)
+	{
+		// The instance may be destroyed right after this call: make sure the running update skips it.
+		if (const TPair<uint32, int32>* Registered = Registry.Find(Instance))
+		{
+			const int32 BucketIndex = FindBucketIndex(Registered->Value);
+			if (BucketIndex != INDEX_NONE)
+			{
+				for (FScheduledEntry& Entry : Buckets[BucketIndex].Entries)
+				{
+					if (Entry.Instance == Instance)
+					{
+						Entry.Instance = nullptr;
+						Entry.Object.Reset();
+						break;
+					}
+				}
+			}
+		}
+
+		PendingChanges.Add({ Instance, INDEX_NONE });
+	}
+	else
+	{
+		ApplyUnregister(Instance);
+	}
+}
+
+bool UGaitSchedulerSubsystem::IsInstanceRegistered(IGaitScheduledInstance* Instance) const
+{
+	// Last pending change wins.
+	for (int32 ChangeIdx = PendingChanges.Num() - 1; ChangeIdx >= 0; --ChangeIdx)
+	{
+		if (PendingChanges[ChangeIdx].Instance == Instance)
+		{
+			return PendingChanges[ChangeIdx].TargetFPS != INDEX_NONE;
+		}
+	}
+
+	return Registry.Contains(Instance);
+}
+
+int32 UGaitSchedulerSubsystem::GetNumInstances() const
+{
+	return Registry.Num();
+}
+
+TArray<FGaitSchedulerBucketStats> UGaitSchedulerSubsystem::GetBucketStats() const
+{
+	TArray<FGaitSchedulerBucketStats> Stats;
+	Stats.Reserve(Buckets.Num());
+
+	for (const FBucket& Bucket : Buckets)
+	{
+		Stats.Add(Bucket.Stats);
+	}
+
+	return Stats;
+}
+
+FGaitSchedulerFrameStats UGaitSchedulerSubsystem::GetFrameStats() const
+{
+	FGaitSchedulerFrameStats Stats;
+	Stats.NumFrames = FrameHistory.Num();
+	if (Stats.NumFrames == 0)
+	{
+		return Stats;
+	}
+
+	const FFrameLoad& LastFrame = FrameHistory[(FrameHistoryIndex + FrameHistorySize - 1) % FrameHistorySize];
+	Stats.NumUpdatedLastFrame = LastFrame.NumUpdated;
+	Stats.NumTracesLastFrame = LastFrame.NumTraces;
+
+	int64 TotalUpdated = 0;
+	int64 TotalTraces = 0;
+	for (const FFrameLoad& Frame : FrameHistory)
+	{
+		Stats.MaxUpdatedPerFrame = FMath::Max(Stats.MaxUpdatedPerFrame, Frame.NumUpdated);
+		Stats.MaxTracesPerFrame = FMath::Max(Stats.MaxTracesPerFrame, Frame.NumTraces);
+		TotalUpdated += Frame.NumUpdated;
+		TotalTraces += Frame.NumTraces;
+	}
+	Stats.AverageUpdatedPerFrame = (float)TotalUpdated / (float)Stats.NumFrames;
+	Stats.AverageTracesPerFrame = (float)TotalTraces / (float)Stats.NumFrames;
+
+	return Stats;
+}
+
+float UGaitSchedulerSubsystem::GetUpdatePhase(const UObject* Object)
+{
+	// Fibonacci hashing: consecutive unique ids land far apart.
+	const uint32 Hash = (Object ? Object->GetUniqueID() : 0u) * 2654435761u;
+	return (float)(Hash >> 8) / (float)(1u << 24);
+}
+
+#pragma endregion
+
+
+#pragma region SCHEDULER UTILITIES
+
+void UGaitSchedulerSubsystem::ApplyRegister(IGaitScheduledInstance* Instance, int32 TargetFPS)
+{
+	UObject* Object = Instance->GetScheduledObject();
+	if (!Object)
+	{
+		return;
+	}
+
+	FScheduledEntry Entry;
+	Entry.Instance = Instance;
+	Entry.Object = Object;
+
+	if (TPair<uint32, int32>* Registered = Registry.Find(Instance))
+	{
+		if (Registered->Value == TargetFPS)
+		{
+			return;
+		}
+
+		// Move to the new bucket, keeping the original serial.
+		Entry.Serial = Registered->Key;
+		ApplyUnregister(Instance);
+	}
+	else
+	{
+		Entry.Serial = NextSerial++;
+	}
+
+	FBucket& Bucket = FindOrAddBucket(TargetFPS);
+	const int32 InsertIndex = Algo::LowerBoundBy(Bucket.Entries, Entry.Serial, [](const FScheduledEntry& Other) { return Other.Serial; });
+	Bucket.Entries.Insert(Entry, InsertIndex);
+	Bucket.Stats.NumInstances = Bucket.Entries.Num();
+
+	Registry.Add(Instance, TPair<uint32, int32>(Entry.Serial, TargetFPS));
+	SET_DWORD_STAT(STAT_GaitSchedulerInstances, Registry.Num());
+}
+
+void UGaitSchedulerSubsystem::ApplyUnregister(IGaitScheduledInstance* Instance)
+{
+	TPair<uint32, int32> Registered;
+	if (!Registry.RemoveAndCopyValue(Instance, Registered))
+	{
+		return;
+	}
+
+	const int32 BucketIndex = FindBucketIndex(Registered.Value);
+	if (BucketIndex != INDEX_NONE)
+	{
+		FBucket& Bucket = Buckets[BucketIndex];
+		const int32 EntryIndex = Algo::BinarySearchBy(Bucket.Entries, Registered.Key, [](const FScheduledEntry& Other) { return Other.Serial; });
+		if (EntryIndex != INDEX_NONE)
+		{
+			Bucket.Entries.RemoveAt(EntryIndex);
+		}
+
+		Bucket.Stats.NumInstances = Bucket.Entries.Num();
+		if (Bucket.Entries.Num() == 0)
+		{
+			Buckets.RemoveAt(BucketIndex);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_GaitSchedulerInstances, Registry.Num());
+}
+
+UGaitSchedulerSubsystem::FBucket& UGaitSchedulerSubsystem::FindOrAddBucket(int32 TargetFPS)
+{
+	const int32 InsertIndex = Algo::LowerBoundBy(Buckets, TargetFPS, [](const FBucket& Bucket) { return Bucket.TargetFPS; });
+	if (Buckets.IsValidIndex(InsertIndex) && Buckets[InsertIndex].TargetFPS == TargetFPS)
+	{
+		return Buckets[InsertIndex];
+	}
+
+	FBucket& Bucket = Buckets.InsertDefaulted_GetRef(InsertIndex);
+	Bucket.TargetFPS = TargetFPS;
+	Bucket.Interval = 1.f / (float)TargetFPS;
+	Bucket.Stats.TargetFPS = TargetFPS;
+	return Bucket;
+}
+
+int32 UGaitSchedulerSubsystem::FindBucketIndex(int32 TargetFPS) const
+{
+	return Algo::BinarySearchBy(Buckets, TargetFPS, [](const FBucket& Bucket) { return Bucket.TargetFPS; });
+}
+
+void UGaitSchedulerSubsystem::UpdateBucket(FBucket& Bucket, int32 FirstEntry, int32 NumEntries)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumUpdated = 0;
+	int32 NumTraces = 0;
+
+	PreparedEntries.Reset();
+
+	// Step 1: Update serial instances and prepare the others (game thread).
+	// Entries can't be added or removed while updating (see @PendingChanges), only invalidated.
+	{
+		NOBUNANIM_SCOPE_COUNTER(GaitScheduler_Prepare);
+
+		for (int32 Step = 0; Step < NumEntries; ++Step)
+		{
+			const int32 EntryIdx = (FirstEntry + Step) % Bucket.Entries.Num();
+			FScheduledEntry& Entry = Bucket.Entries[EntryIdx];
+			if (!Entry.Instance)
+			{
+				continue;
+			}
+
+			if (!Entry.Object.IsValid())
+			{
+				// Owner destroyed without unregistering.
+				PendingChanges.Add({ Entry.Instance, INDEX_NONE });
+				Entry.Instance = nullptr;
+				continue;
+			}
+
+			if (Entry.Instance->SupportsParallelGaitUpdate())
+			{
+				if (Entry.Instance->PrepareGaitUpdate())
+				{
+					PreparedEntries.Add(EntryIdx);
+				}
+			}
+			else
+			{
+				Entry.Instance->ScheduledGaitUpdate();
+				NumTraces += Entry.Instance->GetNumTracesLastUpdate();
+			}
+			++NumUpdated;
+		}
+	}
+
+	// Step 2: Compute (worker threads).
+	if (PreparedEntries.Num() > 0)
+	{
+		NOBUNANIM_SCOPE_COUNTER(GaitScheduler_Compute);
+
+		const bool bSingleThread = !UNobunanimSettings::IsParallelGaitUpdateEnabled()
+			|| PreparedEntries.Num() < UNobunanimSettings::GetParallelGaitUpdateMinInstances()
+			|| !FApp::ShouldUseThreadingForPerformance();
+
+		TArray<FScheduledEntry>& Entries = Bucket.Entries;
+		const TArray<int32>& Prepared = PreparedEntries;
+		ParallelFor(Prepared.Num(), [&Entries, &Prepared](int32 PreparedIdx)
+		{
+			Entries[Prepared[PreparedIdx]].Instance->ComputeGaitUpdate();
+		}, bSingleThread);
+
+		if (!bSingleThread)
+		{
+			Bucket.Stats.NumParallelLastFrame = PreparedEntries.Num();
+			INC_DWORD_STAT_BY(STAT_GaitSchedulerParallelInstances, PreparedEntries.Num());
+		}
+	}
+
+	// Step 3: Finalize (game thread, update order).
+	{
+		NOBUNANIM_SCOPE_COUNTER(GaitScheduler_Finalize);
+
+		for (int32 EntryIdx : PreparedEntries)
+		{
+			// May have been unregistered by the finalize of a previous instance.
+			if (IGaitScheduledInstance* Instance = Bucket.Entries[EntryIdx].Instance)
+			{
+				Instance->FinalizeGaitUpdate();
+				NumTraces += Instance->GetNumTracesLastUpdate();
+			}
+		}
+	}
+
+	Bucket.Stats.NumUpdatedLastFrame = NumUpdated;
+	Bucket.Stats.NumTracesLastFrame = NumTraces;
+	Bucket.Stats.NumBucketUpdates++;
+	Bucket.Stats.LastUpdateTimeMs = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	INC_DWORD_STAT_BY(STAT_GaitSchedulerUpdatedInstances, NumUpdated);
+	INC_DWORD_STAT_BY(STAT_GaitSchedulerTraces, NumTraces);
+}
+
+#pragma endregion
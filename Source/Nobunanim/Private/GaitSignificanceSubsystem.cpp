@@ -0,0 +1,260 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitSignificanceSubsystem.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Public/GaitSchedulerSubsystem.h"
+
+#include <Engine/World.h>
+#include <GameFramework/PlayerController.h>
+#include <Camera/PlayerCameraManager.h>
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gait significance - Degraded instances"), STAT_GaitSignificanceDegraded, STATGROUP_Nobunanim);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Gait significance - Estimated cost (ms)"), STAT_GaitSignificanceCost, STATGROUP_Nobunanim);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Gait significance - Estimated traces"), STAT_GaitSignificanceTraces, STATGROUP_Nobunanim);
+
+/** Smoothing factor of the measured update cost and frame time. */
+#define SIGNIFICANCE_SMOOTHING 0.1f
+
+
+#pragma region UNREAL METHODS
+
+bool UGaitSignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGaitSignificanceSubsystem::Deinitialize()
+{
+	Instances.Empty();
+	Scored.Empty();
+
+	Super::Deinitialize();
+}
+
+void UGaitSignificanceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const FGaitSignificanceSettings& Settings = UNobunanimSettings::GetSignificanceSettings();
+	if (!Settings.bEnabled)
+	{
+		if (bHasConstraints)
+		{
+			ReleaseConstraints();
+		}
+		return;
+	}
+
+	NOBUNANIM_SCOPE_COUNTER(GaitSignificance_Tick);
+
+	AverageDeltaTime = FMath::Lerp(AverageDeltaTime, FMath::Max(DeltaTime, KINDA_SMALL_NUMBER), SIGNIFICANCE_SMOOTHING);
+	MeasureUpdateCost();
+
+	TimeSinceEvaluation += DeltaTime;
+	if (TimeSinceEvaluation >= Settings.EvaluationInterval)
+	{
+		TimeSinceEvaluation = 0.f;
+		Evaluate();
+	}
+}
+
+TStatId UGaitSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGaitSignificanceSubsystem, STATGROUP_Nobunanim);
+}
+
+#pragma endregion
+
+
+#pragma region SIGNIFICANCE
+
+void UGaitSignificanceSubsystem::RegisterInstance(IGaitSignificanceInstance* Instance)
+{
+	if (!Instance || Instances.ContainsByPredicate([Instance](const FRegisteredInstance& Other) { return Other.Instance == Instance; }))
+	{
+		return;
+	}
+
+	FRegisteredInstance& Registered = Instances.AddDefaulted_GetRef();
+	Registered.Instance = Instance;
+	Registered.Object = Instance->GetSignificanceObject();
+}
+
+void UGaitSignificanceSubsystem::UnregisterInstance(IGaitSignificanceInstance* Instance)
+{
+	Instances.RemoveAllSwap([Instance](const FRegisteredInstance& Other) { return Other.Instance == Instance; });
+}
+
+FGaitSignificanceStats UGaitSignificanceSubsystem::GetLastStats() const
+{
+	return LastStats;
+}
+
+#pragma endregion
+
+
+#pragma region SIGNIFICANCE UTILITIES
+
+void UGaitSignificanceSubsystem::Evaluate()
+{
+	NOBUNANIM_SCOPE_COUNTER(GaitSignificance_Evaluate);
+
+	const FGaitSignificanceSettings& Settings = UNobunanimSettings::GetSignificanceSettings();
+	UWorld* World = GetWorld();
+
+	// Step 1: Player views.
+	struct FView
+	{
+		FVector Location;
+		/** tan(FOV / 2). */
+		float TanHalfFOV;
+	};
+	TArray<FView, TInlineAllocator<4>> Views;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector Location;
+			FRotator Rotation;
+			PlayerController->GetPlayerViewPoint(Location, Rotation);
+
+			const float FOV = PlayerController->PlayerCameraManager ? PlayerController->PlayerCameraManager->GetFOVAngle() : 90.f;
+			Views.Add({ Location, FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(FOV, 1.f, 170.f) * 0.5f)) });
+		}
+	}
+
+	// Step 2: Score. Owners destroyed without unregistering are removed first, so the scored indices stay valid.
+	Instances.RemoveAllSwap([](const FRegisteredInstance& Registered) { return !Registered.Object.IsValid(); });
+
+	Scored.Reset();
+	for (int32 Index = 0; Index < Instances.Num(); ++Index)
+	{
+		const FRegisteredInstance& Registered = Instances[Index];
+
+		FScoredInstance Entry;
+		Entry.RegisteredIndex = Index;
+		if (!Registered.Instance->GetSignificanceInputs(Entry.Inputs))
+		{
+			continue;
+		}
+
+		// Screen size relative to the closest view. Without view (i.e. dedicated server) only importance counts.
+		float ScreenSize = Views.Num() > 0 ? 0.f : 1.f;
+		for (const FView& View : Views)
+		{
+			const float Distance = FMath::Max(FVector::Dist(View.Location, Entry.Inputs.Location), 1.f);
+			ScreenSize = FMath::Max(ScreenSize, Entry.Inputs.BoundsRadius / (Distance * View.TanHalfFOV));
+		}
+
+		Entry.Significance = ScreenSize
+			* FMath::Max(Entry.Inputs.Importance, 0.f)
+			* (Entry.Inputs.bVisible ? 1.f : Settings.OffscreenSignificanceScale);
+
+		Scored.Add(Entry);
+	}
+
+	Scored.Sort([](const FScoredInstance& A, const FScoredInstance& B) { return A.Significance > B.Significance; });
+
+	// Step 3: Distribute the budget by descending significance.
+	const int32 NumLODs = UNobunanimSettings::GetNumLODSettings();
+	const float UpdateCostMs = AverageUpdateCostMs >= 0.f ? AverageUpdateCostMs : Settings.DefaultUpdateCostMs;
+	float RemainingMs = Settings.FrameBudgetMs;
+	float RemainingTraces = (float)Settings.TraceBudgetPerFrame;
+
+	FGaitSignificanceStats Stats;
+	Stats.NumInstances = Scored.Num();
+	Stats.AverageUpdateCostMs = UpdateCostMs;
+
+	for (const FScoredInstance& Entry : Scored)
+	{
+		const int32 NaturalLOD = FMath::Clamp(Entry.Inputs.NaturalLOD, 0, NumLODs - 1);
+
+		int32 LOD = NaturalLOD;
+		float CostMs = 0.f;
+		float Traces = 0.f;
+		for (; LOD < NumLODs; ++LOD)
+		{
+			const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(LOD);
+			const float UpdatesPerFrame = FMath::Min((float)LODSetting.TargetFPS * AverageDeltaTime, 1.f);
+
+			float TracesPerUpdate = 0.f;
+			if (LODSetting.CorrectionLevel != ENobunanimIKCorrectionLevel::IKL_Level0)
+			{
+				// The sweep fallback doubles the worst case.
+				TracesPerUpdate = (float)Entry.Inputs.TracesPerUpdate * (LODSetting.CorrectionLevel == ENobunanimIKCorrectionLevel::IKL_Level2 ? 2.f : 1.f);
+			}
+
+			CostMs = UpdateCostMs * UpdatesPerFrame;
+			Traces = TracesPerUpdate * UpdatesPerFrame;
+			if (CostMs <= RemainingMs && Traces <= RemainingTraces)
+			{
+				break;
+			}
+		}
+		// Nothing fits: cheapest LOD, never culled.
+		LOD = FMath::Min(LOD, NumLODs - 1);
+
+		RemainingMs -= CostMs;
+		RemainingTraces -= Traces;
+
+		Stats.EstimatedFrameCostMs += CostMs;
+		Stats.EstimatedTracesPerFrame += Traces;
+		if (LOD > NaturalLOD)
+		{
+			++Stats.NumDegraded;
+		}
+
+		Instances[Entry.RegisteredIndex].Instance->ApplySignificance(Entry.Significance, LOD > NaturalLOD ? LOD : 0);
+	}
+
+	bHasConstraints = Stats.NumDegraded > 0;
+	LastStats = Stats;
+
+	SET_DWORD_STAT(STAT_GaitSignificanceDegraded, Stats.NumDegraded);
+	SET_FLOAT_STAT(STAT_GaitSignificanceCost, Stats.EstimatedFrameCostMs);
+	SET_FLOAT_STAT(STAT_GaitSignificanceTraces, Stats.EstimatedTracesPerFrame);
+}
+
+void UGaitSignificanceSubsystem::MeasureUpdateCost()
+{
+	const UGaitSchedulerSubsystem* Scheduler = GetWorld()->GetSubsystem<UGaitSchedulerSubsystem>();
+	if (!Scheduler)
+	{
+		return;
+	}
+
+	float TimeMs = 0.f;
+	int32 NumUpdated = 0;
+	for (const FGaitSchedulerBucketStats& Bucket : Scheduler->GetBucketStats())
+	{
+		TimeMs += Bucket.LastUpdateTimeMs;
+		NumUpdated += Bucket.NumUpdatedLastFrame;
+	}
+
+	if (NumUpdated > 0)
+	{
+		const float CostMs = TimeMs / (float)NumUpdated;
+		AverageUpdateCostMs = AverageUpdateCostMs < 0.f ? CostMs : FMath::Lerp(AverageUpdateCostMs, CostMs, SIGNIFICANCE_SMOOTHING);
+	}
+}
+
+void UGaitSignificanceSubsystem::ReleaseConstraints()
+{
+	for (const FRegisteredInstance& Registered : Instances)
+	{
+		if (Registered.Object.IsValid())
+		{
+			Registered.Instance->ApplySignificance(1.f, 0);
+		}
+	}
+
+	bHasConstraints = false;
+	LastStats = FGaitSignificanceStats();
+}
+
+#pragma endregion
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitSocketCache.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+
+#include <Components/SkeletalMeshComponent.h>
+#include <Engine/SkeletalMesh.h>
+#include <GameFramework/Actor.h>
+
+
+void FGaitSocketCache::Reset()
+{
+	Entries.Reset();
+	SocketIndices.Reset();
+	ResolvedMesh.Reset();
+	bResolved = false;
+	bRefreshed = false;
+}
+
+int32 FGaitSocketCache::AddSocket(FName SocketName)
+{
+	if (const int32* Index = SocketIndices.Find(SocketName))
+	{
+		return *Index;
+	}
+
+	const int32 Index = Entries.AddDefaulted();
+	Entries[Index].Name = SocketName;
+	SocketIndices.Add(SocketName, Index);
+
+	// Resolved on next refresh.
+	bResolved = false;
+	return Index;
+}
+
+void FGaitSocketCache::Refresh(const USkeletalMeshComponent* Mesh)
+{
+	NOBUNANIM_SCOPE_COUNTER(GaitSocketCache_Refresh);
+
+	bRefreshed = Mesh != nullptr;
+	if (!Mesh)
+	{
+		return;
+	}
+
+	if (!bResolved || ResolvedMesh.Get() != Mesh->GetSkeletalMeshAsset())
+	{
+		Resolve(Mesh);
+	}
+
+	const TArray<FTransform>& ComponentSpaceTransforms = Mesh->GetComponentSpaceTransforms();
+	const FTransform& ComponentToWorld = Mesh->GetComponentTransform();
+
+	for (FEntry& Entry : Entries)
+	{
+		if (ComponentSpaceTransforms.IsValidIndex(Entry.BoneIndex))
+		{
+			Entry.ComponentTransform = Entry.LocalTransform * ComponentSpaceTransforms[Entry.BoneIndex];
+			Entry.WorldTransform = Entry.ComponentTransform * ComponentToWorld;
+		}
+		else
+		{
+			// Not a socket nor a bone of this mesh (i.e. a virtual socket): same result as the mesh would give.
+			Entry.WorldTransform = Mesh->GetSocketTransform(Entry.Name, RTS_World);
+			Entry.ComponentTransform = Entry.WorldTransform.GetRelativeTransform(ComponentToWorld);
+		}
+	}
+}
+
+FVector FGaitSocketCache::GetWorldLocation(const USkeletalMeshComponent* Mesh, FName SocketName) const
+{
+	const int32 Index = bRefreshed ? FindSocket(SocketName) : INDEX_NONE;
+	return Index != INDEX_NONE ? Entries[Index].WorldTransform.GetLocation() : Mesh->GetSocketLocation(SocketName);
+}
+
+FTransform FGaitSocketCache::GetTransform(const USkeletalMeshComponent* Mesh, int32 Index, ERelativeTransformSpace Space) const
+{
+	const FEntry& Entry = Entries[Index];
+	switch (Space)
+	{
+		case RTS_World:
+			return Entry.WorldTransform;
+
+		case RTS_Component:
+			return Entry.ComponentTransform;
+
+		case RTS_Actor:
+			if (const AActor* Actor = Mesh->GetOwner())
+			{
+				return Entry.WorldTransform.GetRelativeTransform(Actor->GetTransform());
+			}
+			return Entry.ComponentTransform;
+
+		default:
+			// Parent bone space: rare enough to go through the mesh.
+			return Mesh->GetSocketTransform(Entry.Name, Space);
+	}
+}
+
+void FGaitSocketCache::Resolve(const USkeletalMeshComponent* Mesh)
+{
+	const USkeletalMesh* SkeletalMesh = Mesh->GetSkeletalMeshAsset();
+
+	for (FEntry& Entry : Entries)
+	{
+		Entry.BoneIndex = INDEX_NONE;
+		Entry.LocalTransform = FTransform::Identity;
+
+		if (!SkeletalMesh)
+		{
+			continue;
+		}
+
+		int32 SocketIndex = INDEX_NONE;
+		if (!SkeletalMesh->FindSocketInfo(Entry.Name, Entry.LocalTransform, Entry.BoneIndex, SocketIndex))
+		{
+			Entry.LocalTransform = FTransform::Identity;
+			Entry.BoneIndex = Mesh->GetBoneIndex(Entry.Name);
+		}
+	}
+
+	ResolvedMesh = SkeletalMesh;
+	bResolved = true;
+}
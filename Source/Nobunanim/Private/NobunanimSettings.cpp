@@ -2,16 +2,187 @@
 
 #include "NobunanimSettings.h"
 
+#include <Components/PrimitiveComponent.h>
+
 /** Static accessor of FramePerSecond. */
 int32 UNobunanimSettings::GetFramePerSecond()
 {
 	return GetDefault<UNobunanimSettings>()->FramePerSecond;
 }
 
-/** Gets the specified LOD setting. Return default one if invalid settings or @Lod. */
-FProceduralGaitLODSettings UNobunanimSettings::GetLODSetting(int32 Lod)
+/** Gets the specified LOD setting, from the resolved LOD table (O(1)). @Lod is clamped to the defined range. */
+const FProceduralGaitLODSettings& UNobunanimSettings::GetLODSetting(int32 Lod)
+{
+	const TArray<FProceduralGaitLODSettings>& Resolved = GetDefault<UNobunanimSettings>()->ResolvedLODSettings;
+	if (Resolved.Num() == 0)
+	{
+		static const FProceduralGaitLODSettings DefaultLODSetting;
+		return DefaultLODSetting;
+	}
+
+	return Resolved[FMath::Clamp(Lod, 0, Resolved.Num() - 1)];
+}
+
+/** Blueprint version of @GetLODSetting. */
+FProceduralGaitLODSettings UNobunanimSettings::K2_GetLODSetting(int32 Lod)
+{
+	return GetLODSetting(Lod);
+}
+
+/** Number of entries of the resolved LOD table (at least 1). */
+int32 UNobunanimSettings::GetNumLODSettings()
+{
+	return FMath::Max(GetDefault<UNobunanimSettings>()->ResolvedLODSettings.Num(), 1);
+}
+
+/** Static accessor of LODHysteresisTime. */
+float UNobunanimSettings::GetLODHysteresisTime()
+{
+	return GetDefault<UNobunanimSettings>()->LODHysteresisTime;
+}
+
+/** Static accessor of bParallelGaitUpdate. */
+bool UNobunanimSettings::IsParallelGaitUpdateEnabled()
+{
+	return GetDefault<UNobunanimSettings>()->bParallelGaitUpdate;
+}
+
+/** Static accessor of ParallelGaitUpdateMinInstances. */
+int32 UNobunanimSettings::GetParallelGaitUpdateMinInstances()
+{
+	return GetDefault<UNobunanimSettings>()->ParallelGaitUpdateMinInstances;
+}
+
+/** Static accessor of bAmortizeGaitUpdates. */
+bool UNobunanimSettings::IsGaitUpdateAmortizationEnabled()
+{
+	return GetDefault<UNobunanimSettings>()->bAmortizeGaitUpdates;
+}
+
+/** Static accessor of bGaitDormancy. */
+bool UNobunanimSettings::IsGaitDormancyEnabled()
+{
+	return GetDefault<UNobunanimSettings>()->bGaitDormancy;
+}
+
+/** Static accessor of GaitDormancyDelay. */
+float UNobunanimSettings::GetGaitDormancyDelay()
+{
+	return GetDefault<UNobunanimSettings>()->GaitDormancyDelay;
+}
+
+/** Static accessor of NetMode. */
+const FGaitNetModeSettings& UNobunanimSettings::GetNetModeSettings()
+{
+	return GetDefault<UNobunanimSettings>()->NetMode;
+}
+
+EGaitOffscreenPolicy UNobunanimSettings::ResolveOffscreenPolicy(ENetMode NetMode, int32 Lod, const UPrimitiveComponent* Mesh)
+{
+	// The net mode policy wins (i.e. footfall events only on dedicated servers).
+	const EGaitOffscreenPolicy NetModePolicy = GetNetModeSettings().GetPolicy(NetMode);
+	if (NetModePolicy != EGaitOffscreenPolicy::KeepUpdating || NetMode == NM_DedicatedServer)
+	{
+		return NetModePolicy;
+	}
+
+	const FProceduralGaitLODSettings& LODSetting = GetLODSetting(Lod);
+	const bool bOffscreen = LODSetting.OffscreenPolicy != EGaitOffscreenPolicy::KeepUpdating && Mesh && !Mesh->WasRecentlyRendered(LODSetting.OffscreenDelay);
+	return bOffscreen ? LODSetting.OffscreenPolicy : EGaitOffscreenPolicy::KeepUpdating;
+}
+
+/** Static accessor of Replication. */
+const FGaitReplicationSettings& UNobunanimSettings::GetReplicationSettings()
+{
+	return GetDefault<UNobunanimSettings>()->Replication;
+}
+
+/** Static accessor of GroundCache. */
+const FGaitGroundCacheSettings& UNobunanimSettings::GetGroundCacheSettings()
+{
+	return GetDefault<UNobunanimSettings>()->GroundCache;
+}
+
+/** Static accessor of SharedEvaluation. */
+const FGaitSharedEvaluationSettings& UNobunanimSettings::GetSharedEvaluationSettings()
+{
+	return GetDefault<UNobunanimSettings>()->SharedEvaluation;
+}
+
+/** Static accessor of Significance. */
+const FGaitSignificanceSettings& UNobunanimSettings::GetSignificanceSettings()
 {
-	const UNobunanimSettings* Default = GetDefault<UNobunanimSettings>();
+	return GetDefault<UNobunanimSettings>()->Significance;
+}
+
+
+#pragma region UNREAL METHODS
+
+void UNobunanimSettings::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	ResolveLODSettings();
+}
+
+void UNobunanimSettings::PostReloadConfig(FProperty* PropertyThatWasLoaded)
+{
+	Super::PostReloadConfig(PropertyThatWasLoaded);
+
+	ResolveLODSettings();
+}
+
+#if WITH_EDITOR
+void UNobunanimSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	ResolveLODSettings();
+	OnSettingsChanged().Broadcast();
+}
+
+FOnNobunanimSettingsChanged& UNobunanimSettings::OnSettingsChanged()
+{
+	static FOnNobunanimSettingsChanged SettingsChanged;
+	return SettingsChanged;
+}
+#endif
+
+#pragma endregion
+
+
+void UNobunanimSettings::ResolveLODSettings()
+{
+	ResolvedLODSettings.Reset();
+
+	if (ProceduralGaitLODSettings.Num() == 0)
+	{
+		return;
+	}
+
+	int32 MaxLOD = 0;
+	for (const TPair<int32, FProceduralGaitLODSettings>& Pair : ProceduralGaitLODSettings)
+	{
+		MaxLOD = FMath::Max(MaxLOD, Pair.Key);
+	}
+
+	ResolvedLODSettings.SetNum(MaxLOD + 1);
+	for (int32 Lod = 0; Lod <= MaxLOD; ++Lod)
+	{
+		// Nearest defined LOD, the more detailed one on tie.
+		for (int32 Distance = 0; Distance <= MaxLOD; ++Distance)
+		{
+			const FProceduralGaitLODSettings* Setting = ProceduralGaitLODSettings.Find(Lod - Distance);
+			if (!Setting)
+			{
+				Setting = ProceduralGaitLODSettings.Find(Lod + Distance);
+			}
 
-	return Default->ProceduralGaitLODSettings.Contains(Lod) ? Default->ProceduralGaitLODSettings[Lod] : FProceduralGaitLODSettings();
+			if (Setting)
+			{
+				ResolvedLODSettings[Lod] = *Setting;
+				break;
+			}
+		}
+	}
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <Components/SkeletalMeshComponent.h>
 
 #include <Nobunanim/Public/NobunanimSettings.h>
+#include <Nobunanim/Public/GaitMath.h>
 
 //#include <Nobunanim/Public/LocomotionComponent.h>
 
@@ -119,22 +120,49 @@ void UProceduralAnimator::SetActive(bool _bEnable)
 	if (_bEnable /*&& bEvaluationActive*/)
 	{
 		bEvaluationActive = true;
-		float delay = 1.f / (float)UNobunanimSettings::GetLODSetting(currentLOD = mesh->PredictedLODLevel).TargetFPS;
+		int32 targetFPS = UNobunanimSettings::GetLODSetting(currentLOD = mesh->PredictedLODLevel).TargetFPS;
 
-		// Set timer will auto-clear if needed.
-		world->GetTimerManager().SetTimer(updateTimerHandle, this, &UProceduralAnimator::Evaluate_Internal, delay, true, false);
+		// Register will move the animator to the right bucket if already registered.
+		scheduler = world->GetSubsystem<UGaitSchedulerSubsystem>();
+		if (scheduler.IsValid())
+		{
+			scheduler->RegisterInstance(this, targetFPS);
+		}
 		
 		Execute_SetProceduralGaitEnable(this, true);
 	}
 	else if (!_bEnable /*&& bEvaluationActive*/)
 	{
 		bEvaluationActive = false;
-		world->GetTimerManager().ClearTimer(updateTimerHandle);
+		if (scheduler.IsValid())
+		{
+			scheduler->UnregisterInstance(this);
+		}
 
 		Execute_SetProceduralGaitEnable(this, false);
 	}
 }
 
+void UProceduralAnimator::BeginDestroy()
+{
+	if (scheduler.IsValid())
+	{
+		scheduler->UnregisterInstance(this);
+	}
+
+	Super::BeginDestroy();
+}
+
+void UProceduralAnimator::ScheduledGaitUpdate()
+{
+	Evaluate_Internal();
+}
+
+UObject* UProceduralAnimator::GetScheduledObject()
+{
+	return this;
+}
+
 
 void UProceduralAnimator::Evaluate_Internal()
 {
@@ -194,7 +222,7 @@ void UProceduralAnimator::EvaluateAnimSet()
 		timeBuffers[it->Key] += buffToAdd;
 
 		// Modulo to 1.
-		float currentTime = FMath::Fmod(timeBuffers[it->Key], 1.f);
+		float currentTime = FGaitMath::GetPhase(timeBuffers[it->Key]);
 		
 
 		for (TMap<FName, FProceduralAnimData>::TConstIterator ite{ it->Value->Effectors.CreateConstIterator() }; ite; ++ite)
@@ -277,7 +305,7 @@ void UProceduralAnimator::EvaluateEffector(const UProceduralAnimAsset* _AnimAsse
 	
 	float minRange, maxRange;
 	
-	bool bInRange = IsInSwingRange(_CurrentTime, effector.currentBeginSwing, effector.currentEndSwing, minRange, maxRange);
+	bool bInRange = FGaitMath::IsInSwingRange(_CurrentTime, effector.currentBeginSwing, effector.currentEndSwing, minRange, maxRange);
 	if (bInRange)
 	{
 		if (!effector.bStartSwing)
@@ -425,29 +453,6 @@ void UProceduralAnimator::UpdateGlobalWeight()
 	globalWeight = globalWeight < TNumericLimits<float>().Min() ? 1.0f : 1.0f / globalWeight;
 }
 
-bool UProceduralAnimator::IsInSwingRange(float Value, float Min, float Max, float& OutRangeMin, float& OutRangeMax)
-{
-	bool A = Value >= Min && Value <= Max;
-	bool APrime = Value >= Max;
-
-	// Gave me headache ._.
-	OutRangeMin = A ? Min : (APrime ? Min : Min - 1.f);
-	OutRangeMax = A ? Max : (APrime ? 1.f /*- Min + Min*/ + Max : Max);
-
-	if (A)
-	{
-		return true;
-	}
-	else
-	{
-		bool B1 = Value <= Min && Value <= Max;
-		bool B2 = Value >= Min && Value >= Max;
-		bool B3 = B1 || B2;
-		bool C = Min >= Max && B3;
-
-		return C;
-	}
-}
 
 
 void UProceduralAnimator::UpdateEffectorTranslation_Implementation(const FName& _Socket, FVector _Translation, bool _bLerp, float _LerpSpeed)
@@ -2,18 +2,21 @@
 
 
 #include "ProceduralGaitAnimInstance.h"
+#include "ProceduralGaitAnimInstanceProxy.h"
 
 #include "Nobunanim/Private/Nobunanim.h"
 #include "Nobunanim/Public/GaitDataAsset.h"
 #include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Public/GaitGroundCacheSubsystem.h"
+#include "Nobunanim/Public/GaitEvaluationCacheSubsystem.h"
+#include "Nobunanim/Public/GaitQueryCounters.h"
+#include "Nobunanim/Public/GaitMath.h"
 
 #include <Engine/Classes/Curves/CurveVector.h>
 #include <Engine/Classes/Curves/CurveLinearColor.h>
 #include <Engine/Classes/Kismet/KismetSystemLibrary.h>
 
 
-#define ORIENT_TO_VELOCITY(Input) LastVelocity.Rotation().RotateVector(Input)
-
 #define SPHERECAST_IK_CORRECTION_RADIUS 30.f
 #define MAX_DELTATIME_CLAMP (1.f / 30.f)
 
@@ -51,26 +54,6 @@ FName FProceduralGaitAnimInstanceTickFunction::DiagnosticContext(bool bDetailed)
 }
 
 
-FVector GetAverage(const TArray<FVector>& Vectors)
-{
-	FVector Sum(0.f);
-	FVector Average(0.f);
-
-	if (Vectors.Num() > 0)
-	{
-		for (int32 VecIdx = 0; VecIdx < Vectors.Num(); VecIdx++)
-		{
-			Sum += Vectors[VecIdx];
-		}
-
-		Average = Sum / ((float)Vectors.Num());
-	}
-
-	return Average;
-}
-
-
-
 void UProceduralGaitAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 {
 	Super::NativeUpdateAnimation(DeltaSeconds);
@@ -86,18 +69,23 @@ void UProceduralGaitAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 
 	//CurrentLOD = OwnedMesh->PredictedLODLevel;
 	
-	FRotator Rotation(0,0,0);
-	
-	if (CurrentLOD == 0)
-	{
-		Rotation = ComputeGroundReflection_LOD0();
-	}
-	else //if (CurrentLOD == 1)
+	// In AnimationProxy mode, the ground reflection is computed by the proxy.
+	// While upsampling, the ground is traced once per gait update.
+	if (GaitUpdateMode == EProceduralGaitUpdateMode::Scheduler && !AreGaitOutputsSuspended() && !bGaitDormant)
 	{
-		Rotation = ComputeGroundReflection_LOD1();
-	}
+		FRotator SolvedTarget;
+		const bool bSampleGround = UpsampleMode == EGaitOutputUpsampling::None || bGroundReflectionSampleDue;
+		if (bSampleGround)
+		{
+			FGroundReflectionSamples Samples;
+			GatherGroundReflectionSamples(Samples);
+			SolvedTarget = SolveGroundReflection(Samples).GetInverse();
+			bGroundReflectionSampleDue = false;
+		}
 
-	GroundReflectionRotation = FMath::Lerp(GroundReflectionRotation, Rotation.GetInverse(), DeltaSeconds * GroundReflectionLerpSpeed);
+		const FRotator Target = UpsampleOutputs(bSampleGround ? &SolvedTarget : nullptr, GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f);
+		GroundReflectionRotation = FMath::Lerp(GroundReflectionRotation, Target, DeltaSeconds * GroundReflectionLerpSpeed);
+	}
 
 	UpdateLOD();
 
@@ -105,6 +93,11 @@ void UProceduralGaitAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 	//ProceduralGaitUpdate();
 }
 
+FAnimInstanceProxy* UProceduralGaitAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FProceduralGaitAnimInstanceProxy(this);
+}
+
 void UProceduralGaitAnimInstance::NativeBeginPlay()
 {
 	Super::NativeBeginPlay();
@@ -114,6 +107,26 @@ void UProceduralGaitAnimInstance::NativeBeginPlay()
 	PrimaryAnimInstanceTick.bCanEverTick = true;
 	PrimaryAnimInstanceTick.bStartWithTickEnabled = true;
 
+	if (!GaitBinding.IsBuilt())
+	{
+		InitializeGaitBinding();
+	}
+
+	if (GroundReflection.bUseHalfVector)
+	{
+		DEBUG_LOG_FORMAT(Warning, "GroundReflection.bUseHalfVector of %s is deprecated and ignored: the ground plane is a least-squares fit of all the probes.", *GetName());
+	}
+
+	UWorld* World = GetWorld();
+	if (World && World->IsGameWorld())
+	{
+		if (UGaitSignificanceSubsystem* Significance = World->GetSubsystem<UGaitSignificanceSubsystem>())
+		{
+			Significance->RegisterInstance(this);
+			bRegisteredSignificance = true;
+		}
+	}
+
 	UpdateLOD(true);
 	/*ACharacter* Chara = Cast<ACharacter>(GetOwningActor());
 	if (Chara)
@@ -125,27 +138,139 @@ void UProceduralGaitAnimInstance::NativeBeginPlay()
 	}*/
 }
 
+void UProceduralGaitAnimInstance::NativeUninitializeAnimation()
+{
+	if (bUpdateGaitActive)
+	{
+		SetProceduralGaitUpdateEnable(false);
+	}
+	UnregisterSignificance();
+
+	Super::NativeUninitializeAnimation();
+}
+
+void UProceduralGaitAnimInstance::BeginDestroy()
+{
+	if (bUpdateGaitActive)
+	{
+		SetProceduralGaitUpdateEnable(false);
+	}
+	UnregisterSignificance();
+
+	Super::BeginDestroy();
+}
+
+
+#pragma region GAIT SCHEDULER INTERFACE
+
+void UProceduralGaitAnimInstance::ScheduledGaitUpdate()
+{
+	ProceduralGaitUpdate();
+}
+
+UObject* UProceduralGaitAnimInstance::GetScheduledObject()
+{
+	return this;
+}
+
+bool UProceduralGaitAnimInstance::SupportsParallelGaitUpdate() const
+{
+	return true;
+}
+
+int32 UProceduralGaitAnimInstance::GetNumTracesLastUpdate() const
+{
+	return NumGaitTraces;
+}
+
+#pragma endregion
+
+
+#pragma region GAIT SIGNIFICANCE INTERFACE
+
+bool UProceduralGaitAnimInstance::GetSignificanceInputs(FGaitSignificanceInputs& OutInputs)
+{
+	if (!OwnedMesh || !bUpdateGaitActive)
+	{
+		return false;
+	}
+
+	OutInputs.Location = OwnedMesh->Bounds.Origin;
+	OutInputs.BoundsRadius = OwnedMesh->Bounds.SphereRadius;
+	OutInputs.bVisible = OwnedMesh->WasRecentlyRendered(0.2f);
+	OutInputs.Importance = GaitImportance;
+	OutInputs.NaturalLOD = OwnedMesh->PredictedLODLevel;
+	// Ground adaptation and stance correction, at most one each per slot.
+	OutInputs.TracesPerUpdate = GaitBinding.NumSlots() * 2;
+	return true;
+}
+
+void UProceduralGaitAnimInstance::ApplySignificance(float Significance, int32 MinLOD)
+{
+	GaitSignificance = Significance;
+	SignificanceMinLOD = MinLOD;
+}
+
+UObject* UProceduralGaitAnimInstance::GetSignificanceObject()
+{
+	return this;
+}
+
+void UProceduralGaitAnimInstance::UnregisterSignificance()
+{
+	if (!bRegisteredSignificance)
+	{
+		return;
+	}
+
+	bRegisteredSignificance = false;
+	SignificanceMinLOD = 0;
+	if (UGaitSignificanceSubsystem* Significance = UWorld::GetSubsystem<UGaitSignificanceSubsystem>(GetWorld()))
+	{
+		Significance->UnregisterInstance(this);
+	}
+}
+
+#pragma endregion
+
 
 #pragma region PROCEDURAL GAIT INTERFACE
 
 void UProceduralGaitAnimInstance::ProceduralGaitUpdate()
+{
+	if (PrepareGaitUpdate())
+	{
+		ComputeGaitUpdate();
+		FinalizeGaitUpdate();
+	}
+}
+
+bool UProceduralGaitAnimInstance::PrepareGaitUpdate()
 {
 	if (!bGaitActive)
 	{
-		return;
+		return false;
 	}
 
-	NOBUNANIM_SCOPE_COUNTER(Gait_Update);
+	UpdateOffscreenPolicy();
+	if (OffscreenPolicy == EGaitOffscreenPolicy::Suspend)
+	{
+		return false;
+	}
+
+	NOBUNANIM_SCOPE_COUNTER(Gait_Prepare);
 
-	FVector NewCurrentLocation;
-	FVector IdealEffectorLocation;
-	FVector CurrentEffectorLocation;
-	float Treshold = 0.f;
-	bool bForceSwing = false;
-	bool bAllEffectorBlendOutEnd = true;
+	// A gait edited while playing rebuilt its runtime table: slots and effector indices may have changed.
+	if (GaitBinding.IsOutdated())
+	{
+		InitializeGaitBinding();
+	}
 
 	UWorld* World = GetWorld();
-	FVector CurrentVelocity = GetOwningActor()->GetVelocity();
+	GaitUpdateWorld = World;
+	GaitUpdateEvaluationCache = UGaitEvaluationCacheSubsystem::Get(World);
+	GaitUpdateVelocity = GetOwningActor()->GetVelocity();
+	GaitUpdateComponentRotation = OwnedMesh->GetComponentRotation();
 
 	/*if (!bGaitActive)
 	{
@@ -158,377 +283,144 @@ void UProceduralGaitAnimInstance::ProceduralGaitUpdate()
 	LastTime = World->TimeSeconds;
 
 	// force 60 fps refresh rate
-	const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
-	if (LODSetting.bForceDeltaTimeAtTargetFPS)
+	GaitUpdateLODSetting = &UNobunanimSettings::GetLODSetting(CurrentLOD);
+	if (GaitUpdateLODSetting->bForceDeltaTimeAtTargetFPS)
 	{
-		DeltaTime = 1.f / LODSetting.TargetFPS;
+		DeltaTime = 1.f / GaitUpdateLODSetting->TargetFPS;
 	}
-
-	// Update Gaits Data.
-	if (GaitsData.Contains(CurrentGaitMode))
+	else if (bResyncGait)
 	{
-		const UGaitDataAsset& CurrentAsset = *GaitsData[CurrentGaitMode];
+		// Don't replay the time spent suspended.
+		DeltaTime = FMath::Min(DeltaTime, 1.f / (float)FMath::Max(GaitUpdateLODSetting->TargetFPS, 1));
+	}
 
-		//if (bGaitActive)
-		//{
-		UpdateEffectors(CurrentAsset);
-		/*if (bLastFrameWasDisable)
-		{
-			bLastFrameWasDisable = false;
-			return;
-		}*/
-		//}
+	++GaitUpdateCounter;
+	NumGaitTraces = 0;
 
-		bool bZeroVelocity = CurrentVelocity.SizeSquared() == 0.f;
-		bool bCond = CurrentAsset.bComputeWithVelocityOnly ? !bZeroVelocity : true;
+	// Ideal and ground locations (socket reads and ground traces).
+	SocketCache.Refresh(OwnedMesh);
+	if (GaitState.CurrentGaitIndex != INDEX_NONE)
+	{
+		UpdateEffectors(GaitState.CurrentGaitIndex);
+	}
 
-		if (bCond)
+	// Back on screen: the effectors restart from the ideal pose, and outputs snap to it.
+	if (bResyncGait)
+	{
+		bResyncGait = false;
+		bSnapGaitOutputs = true;
+		for (FGaitEffectorData& Effector : GaitState.Effectors)
 		{
-			if (!bZeroVelocity)
-			{
-				LastVelocity = CurrentVelocity;
-			}
+			Effector.CurrentEffectorLocation = Effector.IdealEffectorLocation;
+			Effector.bCorrectionIK = false;
+			Effector.bForceSwing = false;
+			Effector.BlockTime = -1.f;
+			Effector.PlantedUntil = -1.f;
+		}
+	}
 
-			//Execute_SetProceduralGaitEnable(this, true);
+	return true;
+}
 
-			// Step 1: Timers.
-			TimeBuffer += (DeltaTime * CurrentAsset.GetFrameRatio() * PlayRate);
-			CurrentTime = FMath::Fmod(TimeBuffer, 1.f);
+void UProceduralGaitAnimInstance::ComputeGaitUpdate()
+{
+	NOBUNANIM_SCOPE_COUNTER(Gait_Update);
 
-			TArray<FName> SwingValuesKeys;
-			CurrentAsset.GaitSwingValues.GetKeys(SwingValuesKeys);
+	// May run on a worker thread: only this instance state is written. Collision correction traces are read only scene queries (like async traces),
+	// everything touching other objects (interface calls, events, debug draws) goes through the Queue* methods.
+
+	TGuardValue<bool> ComputingGuard(bComputingGaitUpdate, true);
+
+	FGaitEvaluationInputs Inputs;
+	Inputs.Binding = &GaitBinding;
+	Inputs.LODSetting = GaitUpdateLODSetting;
+	Inputs.EvaluationCache = GaitUpdateEvaluationCache;
+	Inputs.OffscreenPolicy = OffscreenPolicy;
+	Inputs.DeltaTime = DeltaTime;
+	Inputs.PlayRate = PlayRate;
+	Inputs.Velocity = GaitUpdateVelocity;
+	Inputs.ComponentRotation = GaitUpdateComponentRotation;
+	Inputs.UpdateCounter = GaitUpdateCounter;
+	Inputs.TracePhase = GetUniqueID();
+	Inputs.bCanTrace = GaitUpdateWorld != nullptr;
+	Inputs.bShowDebug = bShowDebug;
+
+	bIdleGaitUpdate = FGaitEvaluator::Evaluate(GaitState, Inputs, *this) == EGaitEvaluationResult::Idle;
+}
 
-			// Step 2: Foreach swing values, we will check if we are in 'Swing' or 'Stance' according to @CurrentTime.
-			for (int j = 0, m = SwingValuesKeys.Num(); j < m; ++j)
-			{
-				NOBUNANIM_SCOPE_COUNTER(Gait_Evaluate_PerEffector);
+void UProceduralGaitAnimInstance::FinalizeGaitUpdate()
+{
+	NOBUNANIM_SCOPE_COUNTER(Gait_Finalize);
 
-				FName Key = SwingValuesKeys[j];
-				const FGaitSwingData& CurrentData = CurrentAsset.GaitSwingValues[Key];
+	// One output sample per gait sample: in AnimationProxy mode it began before the compute phase, which writes the outputs itself.
+	if (GaitUpdateMode != EProceduralGaitUpdateMode::AnimationProxy)
+	{
+		BeginOutputSample();
+	}
 
-				if (Effectors.Contains(Key))
-				{
-					FGaitEffectorData& Effector = Effectors[Key];
-					
-					bool bBlendIn;
+	for (const FGaitDeferredCommand& Command : DeferredCommands)
+	{
+		switch (Command.Type)
+		{
+			case FGaitDeferredCommand::EType::Translation:
+				Execute_UpdateEffectorTranslation(this, Command.Key, Command.Value, Command.bLerp, Command.LerpSpeed);
+				break;
 
-					// Update blend value
-					{
-						// If there isn't any pending gait, so it's a blend in
-						if (PendingGaitMode.IsNone() || Effector.CurrentGait == PendingGaitMode)
-						{
-							if (CurrentData.BlendData.BlendInTime == 0)
-							{
-								Effector.CurrentBlendValue = 1.f;
-							}
-							else
-							{
-								bBlendIn = true;
-								if (Effector.CurrentBlendValue < 1.f)
-								{
-									Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue + (DeltaTime / CurrentData.BlendData.BlendInTime), 0.f, 1.f);
-								}
-							}
-
-							if (PendingGaitMode.IsNone())
-							{
-								bAllEffectorBlendOutEnd = false;
-							}
-						}
-						else
-						{
-							if (CurrentData.BlendData.BlendOutTime == 0)
-							{
-								Effector.CurrentBlendValue = 0.f;
-								Effector.CurrentGait = PendingGaitMode;
-							}
-							else
-							{
-								bBlendIn = false;
-								if (Effector.CurrentBlendValue > 0.f)
-								{
-									Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue - (DeltaTime / CurrentData.BlendData.BlendOutTime), 0.f, 1.f);
-								}
-
-								// if end blend out, swap gait.
-								if (Effector.CurrentBlendValue == 0.f)
-								{
-									Effector.CurrentGait = PendingGaitMode;
-								}
-							}
-							bAllEffectorBlendOutEnd = false;
-						}
-					}
+			case FGaitDeferredCommand::EType::Rotation:
+				Execute_UpdateEffectorRotation(this, Command.Key, FRotator(Command.Value.X, Command.Value.Y, Command.Value.Z), Command.LerpSpeed);
+				break;
 
-					// no need to check, check is made when @UpdateGaitMode.
-					const UGaitDataAsset& UpdatedCurrentAsset = *GaitsData[Effector.CurrentGait.IsNone() ? CurrentGaitMode : Effector.CurrentGait];
-					if (UpdatedCurrentAsset.GaitSwingValues.Contains(Key))
-					{
-						const FGaitSwingData& UpdatedCurrentData = UpdatedCurrentAsset.GaitSwingValues[Key];
-
-						// Step 2.1: Check if valid swing data.
-						/*if (Effector.bForceSwing)
-						{
-							if (!CurrentData.CorrectionData.CorrectionSwingTranslationCurve)
-							{
-								DEBUG_LOG_FORMAT(Warning, "Correction is query but there is no valid CorrectionSwingTranslationCurve. From actor %s.", *GetOwner()->GetName());
-								continue;
-							}
-						}*/
-						/*else if ((!CurrentData.TranslationData.SwingTranslationCurve || CurrentData.TranslationData.TranslationFactor == FVector::ZeroVector)
-							&& (!CurrentData.RotationData.SwingRotationCurve || CurrentData.RotationData.RotationFactor == FVector::ZeroVector))
-						{
-							continue;
-						}*/
-
-						float BeginSwing = (UpdatedCurrentAsset.GaitSwingValues.Contains(UpdatedCurrentData.SwingTime.ParentEffector) ? (UpdatedCurrentAsset.GaitSwingValues[Key].BeginSwing) : UpdatedCurrentData.BeginSwing);
-						float EndSwing = (UpdatedCurrentAsset.GaitSwingValues.Contains(UpdatedCurrentData.SwingTime.ParentEffector) ? (UpdatedCurrentAsset.GaitSwingValues[Key].EndSwing) : UpdatedCurrentData.EndSwing);
-
-						bool bCanCompute = Effector.BlockTime == -1.f
-							|| (Effector.BlockTime > BeginSwing && CurrentTime >= Effector.BlockTime)
-							|| (Effector.BlockTime < BeginSwing && CurrentTime < BeginSwing && CurrentTime >= Effector.BlockTime);
-
-						if (bCanCompute)
-						{
-							float MinRange, MaxRange;
-							BeginSwing = Effector.bForceSwing ? Effector.BeginForceSwingInterval : BeginSwing;
-							EndSwing = Effector.bForceSwing ? Effector.EndForceSwingInterval : EndSwing;
-
-							bool InRange = IsInRange(CurrentTime, BeginSwing, EndSwing, MinRange, MaxRange);
-
-							// Step 2.2: If the effector is in 'Swing'.
-							if (InRange)
-							{
-								NOBUNANIM_SCOPE_COUNTER(Gait_Swing);
-
-								Effector.bCorrectionIK = false;
-
-								float CurrentCurvePosition = FMath::GetMappedRangeValueClamped(FVector2D(MinRange, MaxRange), FVector2D(0.f, 1.f), CurrentTime);
-
-								// :D hue hue :D
-								float lerpSpeed = UpdatedCurrentData.TranslationData.LerpSpeed <= 0 ? 0 
-									: UpdatedCurrentData.TranslationData.LerpSpeed * (Effector.CurrentBlendValue == 1.f ? 1.f 
-										: (bBlendIn ? (UpdatedCurrentData.BlendData.BlendInAcceleration ? UpdatedCurrentData.BlendData.BlendInAcceleration->GetFloatValue(Effector.CurrentBlendValue) 
-											: 1.f) 
-											: (UpdatedCurrentData.BlendData.BlendOutAcceleration ? UpdatedCurrentData.BlendData.BlendOutAcceleration->GetFloatValue(Effector.CurrentBlendValue) 
-												: 1.f)));
-
-								// Step 2.2.1: Apply 'Swing' rotation (for bones).
-								if (UpdatedCurrentData.RotationData.bAffectEffector)
-								{
-									FVector CurrentCurveValue = UpdatedCurrentData.RotationData.RotationFactor * (UpdatedCurrentData.RotationData.SwingRotationCurve ?
-										UpdatedCurrentData.RotationData.SwingRotationCurve->GetVectorValue(CurrentCurvePosition) : FVector(1, 1, 1));
-
-									Execute_UpdateEffectorRotation(this, Key, FRotator(CurrentCurveValue.X, CurrentCurveValue.Y, CurrentCurveValue.Z)/*OwnedMesh->GetComponentRotation().RotateVector(CurrentCurveValue).Rotation()*/, lerpSpeed);
-								}
-
-								// Step 2.2.1: Apply 'Swing' translation (for effectors IK(socket)).
-								//if (UpdatedCurrentData.TranslationData.SwingTranslationCurve || (Effector.bForceSwing && UpdatedCurrentData.CorrectionData.CorrectionSwingTranslationCurve))
-								if (UpdatedCurrentData.TranslationData.bAffectEffector)
-								{
-									FVector CurrentCurveValue = UpdatedCurrentData.TranslationData.TranslationFactor * UpdatedCurrentData.TranslationData.TranslationSwingScale
-										* (Effector.bForceSwing ? (UpdatedCurrentData.CorrectionData.CorrectionSwingTranslationCurve ? UpdatedCurrentData.CorrectionData.CorrectionSwingTranslationCurve->GetVectorValue(CurrentCurvePosition) : FVector(1, 1, 1))
-											: (UpdatedCurrentData.TranslationData.SwingTranslationCurve ? UpdatedCurrentData.TranslationData.SwingTranslationCurve->GetVectorValue(CurrentCurvePosition) : FVector(1, 1, 1)));
-
-									CurrentCurveValue = UpdatedCurrentData.TranslationData.bOrientToVelocity ?
-										ORIENT_TO_VELOCITY(CurrentCurveValue) : OwnedMesh->GetComponentRotation().RotateVector(CurrentCurveValue);
-
-									FVector Offset = UpdatedCurrentData.TranslationData.Offset * UpdatedCurrentData.TranslationData.TranslationFactor;
-									Offset = UpdatedCurrentData.TranslationData.bOrientToVelocity ?
-										ORIENT_TO_VELOCITY(Offset) : OwnedMesh->GetComponentRotation().RotateVector(Offset);
-
-									CurrentEffectorLocation = Effector.CurrentEffectorLocation;
-
-									
-									IdealEffectorLocation = UpdatedCurrentData.TranslationData.bAdaptToGroundLevel ? Effector.GroundLocation : Effector.IdealEffectorLocation;
-									//IdealEffectorLocation = UpdatedCurrentData.TranslationData.bAdaptToGroundLevel ? Effector.IdealEffectorLocation + (Effector.IdealEffectorLocation  - Effector.GroundLocation) : Effector.IdealEffectorLocation;
-									NewCurrentLocation = IdealEffectorLocation + Offset + CurrentCurveValue;
-									Treshold = UpdatedCurrentData.CorrectionData.DistanceTresholdToAdjust;
-									bForceSwing = Effector.bForceSwing;
-
-									/*if (UpdatedCurrentData.TranslationData.bAdaptToGroundLevel)
-									{
-										NewCurrentLocation = Effector.IdealEffectorLocation.Z - Effector.GroundLocation.Z;
-										
-									}*/
-									
-
-									Execute_UpdateEffectorTranslation(this, Key, NewCurrentLocation, lerpSpeed > 0/*!bLastFrameWasDisable*/, lerpSpeed);
-
-									Effector.CurrentEffectorLocation = NewCurrentLocation;
-								}
-							}
-							// Step 2.3: If the effector is in 'Stance'.
-							else
-							{
-								if (Effector.bForceSwing)
-								{
-									Effector.BlockTime = UpdatedCurrentData.EndSwing >= 0.99f ? 0.f : UpdatedCurrentData.EndSwing;
-								}
-								else
-								{
-									Effector.BlockTime = -1.f;
-
-									// check for foot ik.
-									if (/*!bLastFrameWasDisable &&*/ World && !Effector.bCorrectionIK && UpdatedCurrentData.CorrectionData.bComputeCollision)
-									{
-										//const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
-										if (LODSetting.bCanComputeCollisionCorrection)
-										{
-											NOBUNANIM_SCOPE_COUNTER(Gait_Stance_IKCorrection);
-
-											// Get origin for IK
-											FVector Origin;
-											if (UpdatedCurrentData.CorrectionData.bUseCurrentEffector)
-											{
-												Origin = Effector.CurrentEffectorLocation;
-											}
-											else
-											{
-												Origin = UpdatedCurrentData.CorrectionData.OriginCollisionSocketName.IsNone() ?
-													OwnedMesh->GetSocketLocation(Key) :
-													OwnedMesh->GetSocketLocation(UpdatedCurrentData.CorrectionData.OriginCollisionSocketName);
-											}
-											FVector Dir = UpdatedCurrentData.CorrectionData.bOrientToVelocity ? ORIENT_TO_VELOCITY(UpdatedCurrentData.CorrectionData.AbsoluteDirection) : UpdatedCurrentData.CorrectionData.AbsoluteDirection;
-
-											// Get Dest
-											FVector Dest = Origin + Dir;
-
-											// Add inverse absolute direction
-											Origin -= Dir;
-
-											FCollisionQueryParams SweepParam(*GetOwningActor()->GetName(), false, GetOwningActor());
-											TArray<FHitResult> HitResults;
-											bool bFoundHit = TraceRay(World, HitResults, Origin, Dest, UpdatedCurrentData.CorrectionData.TraceChannel, SPHERECAST_IK_CORRECTION_RADIUS);
-
-
-											if (bFoundHit)
-											{
-
-												FHitResult& HitResult = GetBestHitResult(HitResults, Origin);
-
-												{
-#if WITH_EDITOR
-													if (HitResult.bBlockingHit && LODSetting.Debug.bShowCollisionCorrection)
-													{
-														if (HitResult.bBlockingHit)
-														{
-															DrawDebugPoint(World, HitResult.ImpactPoint + ORIENT_TO_VELOCITY(UpdatedCurrentData.CorrectionData.CollisionSnapOffset), 10.f, FColor::Red, false, 3.f);
-														}
-													}
-#endif
-												}
-
-												// if hit ground
-												if (HitResult.bBlockingHit)
-												{
-													Effector.CurrentEffectorLocation = HitResult.ImpactPoint + ORIENT_TO_VELOCITY(UpdatedCurrentData.CorrectionData.CollisionSnapOffset);
-													Effector.bCorrectionIK = true;
-													if (UpdatedCurrentData.EventData.bRaiseOnCollisionEvent)
-													{
-														OnCollisionEvent.Broadcast(Key, Effector.CurrentEffectorLocation);
-													}
-												}
-											}
-										}
-									}
-
-									Execute_UpdateEffectorTranslation(this, Key, Effector.CurrentEffectorLocation, UpdatedCurrentData.TranslationData.LerpSpeed > 0/*!bLastFrameWasDisable*/, UpdatedCurrentData.TranslationData.LerpSpeed);
-								}
-
-								bForceSwing = Effector.bForceSwing = false;
-								//Effector.BeginForceSwingInterval = CurrentAsset.GaitSwingValues[Key].BeginSwing;
-								//Effector.EndForceSwingInterval = CurrentAsset.GaitSwingValues[Key].EndSwing;
-
-								CurrentEffectorLocation = Effector.CurrentEffectorLocation;
-								IdealEffectorLocation = Effector.IdealEffectorLocation;
-								NewCurrentLocation = CurrentEffectorLocation;// Effector.IdealEffectorLocation + TranslationData.Offset + CurrentCurveValue;
-								Treshold = UpdatedCurrentData.CorrectionData.DistanceTresholdToAdjust;
-
-								bool bUseParentData = UpdatedCurrentAsset.GaitSwingValues.Contains(UpdatedCurrentData.SwingTime.ParentEffector) && Effectors.Contains(UpdatedCurrentData.SwingTime.ParentEffector);
-								const FGaitCorrectionData& CurrentCorrectionData = UpdatedCurrentAsset.GaitSwingValues.Contains(UpdatedCurrentData.SwingTime.ParentEffector) ? UpdatedCurrentAsset.GaitSwingValues[Key].CorrectionData : UpdatedCurrentData.CorrectionData;
-								// Step 2.3.1: Check if the effector need to be adjusted
-								if (CurrentCorrectionData.bAutoAdjustWithIdealEffector)
-								{
-									float VectorLength = (Effector.CurrentEffectorLocation - Effector.IdealEffectorLocation).Size2D();
-
-									// Is the distance breaking treshold?
-									if ((bUseParentData && Effectors[UpdatedCurrentData.SwingTime.ParentEffector].bForceSwing) || VectorLength >= UpdatedCurrentData.CorrectionData.DistanceTresholdToAdjust)
-									{
-										// Here we compute the new interval of swing.
-										float Begin =/* CurrentAsset.GaitSwingValues[Key].*/BeginSwing;
-										float End = /*CurrentAsset.GaitSwingValues[Key].*/EndSwing;
-
-										float Alpha = 0.f;
-										if (Begin > End)
-										{
-											Alpha = (1.f - Begin) + End;
-										}
-										else
-										{
-											Alpha = End - Begin;
-										}
-
-										float Beta = CurrentTime + Alpha;
-										// if the end swing is > 1 (absolute time) we just consider that the swing will end the next cycle.
-										if (Beta >= 1.f)
-										{
-											Beta -= 1.f;
-										}
-
-										Effector.BeginForceSwingInterval = CurrentTime;
-										Effector.EndForceSwingInterval = Beta;
-										bForceSwing = Effector.bForceSwing = true;
-										Effector.BlockTime = -1.f;
-									}
-								}
-
-
-							}
+			case FGaitDeferredCommand::EType::GaitEvent:
+				RaiseGaitEvent(Command.EventType, Command.Key, Command.Value);
+				break;
+		}
+	}
+	DeferredCommands.Reset();
+	bSnapGaitOutputs = false;
 
-#if WITH_EDITOR
-							// Step 3: Draw Debug.
-							{
-								DrawGaitDebug(NewCurrentLocation, IdealEffectorLocation, CurrentEffectorLocation, Treshold,
-									UpdatedCurrentData.CorrectionData.bAutoAdjustWithIdealEffector, bForceSwing,
-									&UpdatedCurrentData.DebugData);
-							}
-#endif
-						}
-					}
-				}
-			}
+	AsyncTraces.Flush(GetWorld(), this);
 
-			// Step 3: if all effector end blend out swtich gait
-			if (bAllEffectorBlendOutEnd == true)
-			{
-				CurrentGaitMode = PendingGaitMode;
-				PendingGaitMode = "";
-			}
-		}
-		else
+#if WITH_EDITOR
+	if (UWorld* World = GetWorld())
+	{
+		for (const TFunction<void(UWorld*)>& Draw : DeferredDebugDraws)
 		{
-			CurrentTime = 0;
-			//Execute_SetProceduralGaitEnable(this, false);
+			Draw(World);
 		}
-
 	}
-	else
-	{
-		CurrentTime = 0;
-		//Execute_SetProceduralGaitEnable(this, false);
-	}
-
+	DeferredDebugDraws.Reset();
+#endif
 
 #if WITH_EDITOR
 	UpdateLOD();
 #else
 	UpdateLOD();
 #endif
+
+	UpdateGaitDormancy();
 }
 
 void UProceduralGaitAnimInstance::UpdateEffectorTranslation_Implementation(const FName& TargetBone, FVector Translation, bool bLerp, float LerpSpeed)
 {
+	// Upsampling: the gait writes its sample, @PresentUpsampledOutputs writes @EffectorsTranslation.
+	if (UpsampleMode != EGaitOutputUpsampling::None)
+	{
+		TGaitOutputSamples<FVector>* Samples = UpsampledTranslations.Find(TargetBone);
+		if (!Samples)
+		{
+			const FVector* Presented = EffectorsTranslation.Find(TargetBone);
+			const FVector Start = Presented ? *Presented : Translation;
+			Samples = &UpsampledTranslations.Add(TargetBone, { Start, Start });
+		}
+
+		Samples->Current = bLerp && !bSnapGaitOutputs ? FMath::Lerp(Samples->Current, Translation, LerpSpeed * DeltaTime) : Translation;
+		if (bSnapGaitOutputs)
+		{
+			Samples->Previous = Samples->Current;
+		}
+		return;
+	}
+
 	const FVector* Vec = EffectorsTranslation.Find(TargetBone);
 	if (!Vec)
 	{
@@ -536,12 +428,30 @@ void UProceduralGaitAnimInstance::UpdateEffectorTranslation_Implementation(const
 	}
 	else
 	{
-		EffectorsTranslation[TargetBone] = bLerp ? FMath::Lerp(*Vec, Translation, LerpSpeed * DeltaTime) : Translation;
+		EffectorsTranslation[TargetBone] = bLerp && !bSnapGaitOutputs ? FMath::Lerp(*Vec, Translation, LerpSpeed * DeltaTime) : Translation;
 	}
 }
 
 void UProceduralGaitAnimInstance::UpdateEffectorRotation_Implementation(const FName& TargetBone, FRotator Rotation, float LerpSpeed)
 {
+	if (UpsampleMode != EGaitOutputUpsampling::None)
+	{
+		TGaitOutputSamples<FRotator>* Samples = UpsampledRotations.Find(TargetBone);
+		if (!Samples)
+		{
+			const FRotator* Presented = BonesRotation.Find(TargetBone);
+			const FRotator Start = Presented ? *Presented : Rotation;
+			Samples = &UpsampledRotations.Add(TargetBone, { Start, Start });
+		}
+
+		Samples->Current = bSnapGaitOutputs ? Rotation : FMath::Lerp(Samples->Current, Rotation, LerpSpeed * DeltaTime);
+		if (bSnapGaitOutputs)
+		{
+			Samples->Previous = Samples->Current;
+		}
+		return;
+	}
+
 	const FRotator* Vec = BonesRotation.Find(TargetBone);
 	if (!Vec)
 	{
@@ -549,7 +459,7 @@ void UProceduralGaitAnimInstance::UpdateEffectorRotation_Implementation(const FN
 	}
 	else
 	{
-		BonesRotation[TargetBone] = FMath::Lerp(*Vec, Rotation, LerpSpeed * DeltaTime);
+		BonesRotation[TargetBone] = bSnapGaitOutputs ? Rotation : FMath::Lerp(*Vec, Rotation, LerpSpeed * DeltaTime);
 	}
 }
 
@@ -560,8 +470,8 @@ void UProceduralGaitAnimInstance::SetProceduralGaitEnable_Implementation(bool bE
 	SetProceduralGaitUpdateEnable(bGaitActive);
 	//if (!bGaitActive)
 	//{
-	//	// WARNING, clear timer will prevent the procedural gait update!!!
-	//	// GetWorld()->GetTimerManager().ClearTimer(GaitUpdateTimer);
+	//	// WARNING, unregistering from the gait scheduler will prevent the procedural gait update!!!
+	//	// GetWorld()->GetSubsystem<UGaitSchedulerSubsystem>()->UnregisterInstance(this);
 	//	// GaitActive
 	//}
 }
@@ -569,144 +479,271 @@ void UProceduralGaitAnimInstance::SetProceduralGaitEnable_Implementation(bool bE
 #pragma endregion
 
 
-#pragma region TERRAIN PREDICTION UTILITIES
+#pragma region GAIT EVALUATION SINK
 
-FRotator UProceduralGaitAnimInstance::GetPlaneRotation(FVector A, FVector B, FVector C, FVector RightVector, FRotator& OutRotation, bool bComputeHalf, bool bDebug)
+void UProceduralGaitAnimInstance::EmitEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed)
 {
-	FRotator Rotation;
+	QueueEffectorTranslation(Key, Translation, bLerp, LerpSpeed);
+}
 
-	FVector AP = bComputeHalf ? (A + B) * 0.5f : A;
-	FVector BP = bComputeHalf ? (B + C) * 0.5f : B;
-	FVector CP = bComputeHalf ? (C + A) * 0.5f : C;
+void UProceduralGaitAnimInstance::EmitEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed)
+{
+	QueueEffectorRotation(Key, Rotation, LerpSpeed);
+}
 
-	FVector AB = BP - AP;
-	FVector AC = CP - AP;
-	FVector CrossABC = AB ^ AC;
-	CrossABC.Normalize();
+void UProceduralGaitAnimInstance::EmitGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location)
+{
+	QueueGaitEvent(Type, Key, Location);
+}
 
-	const FVector FloorZAxis = CrossABC;
-	const FVector FloorXAxis = RightVector ^ FloorZAxis;
-	const FVector FloorYAxis = FloorZAxis ^ FloorXAxis;
+FVector UProceduralGaitAnimInstance::GetCorrectionOrigin(int32 Slot, const FName& SocketName)
+{
+	return SocketName.IsNone() ? SocketCache.GetWorldLocation(Slot) : SocketCache.GetWorldLocation(OwnedMesh, SocketName);
+}
 
-	float OutSlopePitchDegreeAngle = 90.f - FMath::RadiansToDegrees(FMath::Acos(FloorXAxis | FVector(0, 0, 1.f)));
-	float OutSlopeRollDegreeAngle = 90.f - FMath::RadiansToDegrees(FMath::Acos(FloorYAxis | FVector(0, 0, 1.f)));
+bool UProceduralGaitAnimInstance::TraceCorrection(int32 Slot, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, FVector& OutImpactPoint)
+{
+	TArray<FHitResult>& HitResults = TraceHits;
+	if (!TraceRay(GaitUpdateWorld, HitResults, Origin, Dest, TraceChannel, SPHERECAST_IK_CORRECTION_RADIUS, FGaitAsyncTraceQueue::MakeKey(Slot, EGaitAsyncTraceKind::Correction)))
+	{
+		return false;
+	}
 
-	OutRotation.Pitch = 0;
-	OutRotation.Roll += OutSlopeRollDegreeAngle * 0.25f;
-	OutRotation.Yaw += OutSlopePitchDegreeAngle * 0.25f;
+	const FHitResult& HitResult = GetBestHitResult(HitResults, Origin);
+	OutImpactPoint = HitResult.ImpactPoint;
+	return HitResult.bBlockingHit;
+}
 
 #if WITH_EDITOR
-	if (bDebug)
+void UProceduralGaitAnimInstance::DrawCorrectionDebug(const FVector& Location)
+{
+	QueueDebugDraw([Location](UWorld* DebugWorld) { DrawDebugPoint(DebugWorld, Location, 10.f, FColor::Red, false, 3.f); });
+}
+
+void UProceduralGaitAnimInstance::DrawEffectorDebug(const FVector& Position, const FVector& EffectorLocation, const FVector& CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData)
+{
+	// Only queued if something is drawn (see @DrawGaitDebug): queuing allocates.
+	if (!(bShowDebug && DebugData->bDrawDebug) && !bShowLOD && !(GaitUpdateLODSetting && GaitUpdateLODSetting->Debug.bShowLOD))
 	{
-		//DEBUG_LOG_FORMAT(Log, "\t=> Rotation: %s", *OutRotation.ToString());
-		DrawDebugLine(GetWorld(), AP, BP, FColor(255.f, 255.f, 255.f), false, 0.f, 0, 0.5f);
-		DrawDebugLine(GetWorld(), BP, CP, FColor(255.f, 255.f, 255.f), false, 0.f, 0, 0.5f);
-		DrawDebugLine(GetWorld(), CP, AP, FColor(255.f, 255.f, 255.f), false, 0.f, 0, 0.5f);
+		return;
 	}
-#endif
 
-	return Rotation;
+	QueueDebugDraw([this, Position, EffectorLocation, CurrentLocation, Treshold, bAutoAdjustWithIdealEffector, bForceSwing, DebugData](UWorld*)
+	{
+		DrawGaitDebug(Position, EffectorLocation, CurrentLocation, Treshold, bAutoAdjustWithIdealEffector, bForceSwing, DebugData);
+	});
 }
+#endif
+
+#pragma endregion
+
+
+#pragma region TERRAIN PREDICTION UTILITIES
 
-FVector UProceduralGaitAnimInstance::TraceGroundRaycast(UWorld* World, FVector Origin, FVector Dest)
+bool UProceduralGaitAnimInstance::TraceGroundProbes(UWorld* World, const FVector* Origins, int32 NumProbes, FVector* OutPoints)
 {
+	NOBUNANIM_SCOPE_COUNTER(GroundReflection_Trace);
+
 	const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
 
-	FCollisionObjectQueryParams ObjectQuery(ECollisionChannel::ECC_WorldStatic);
-	FCollisionQueryParams SweepParam(*this->GetName(), LODSetting.bTraceOnComplex);
-	FHitResult Hit;
-	if (!World->LineTraceSingleByObjectType
-	(
-		Hit,
-		Origin,
-		Dest,
-		ObjectQuery,
-		SweepParam
-	))
+	// Shared by every probe of the batch.
+	const FCollisionObjectQueryParams ObjectQuery(ECollisionChannel::ECC_WorldStatic);
+	const FCollisionQueryParams SweepParam(SCENE_QUERY_STAT(ProceduralGaitGroundReflection), LODSetting.bTraceOnComplex);
+	const FGaitGroundQuery GroundQuery{ ECollisionChannel::ECC_WorldStatic, true, LODSetting.bTraceOnComplex };
+	UGaitGroundCacheSubsystem* GroundCache = UGaitGroundCacheSubsystem::IsCacheable(FVector::ZeroVector, RayVector) ? UGaitGroundCacheSubsystem::Get(World) : nullptr;
+	const float Now = World->GetTimeSeconds();
+	bool bComplete = true;
+
+	for (int32 ProbeIdx = 0; ProbeIdx < NumProbes; ++ProbeIdx)
 	{
-		Hit.ImpactPoint = Dest;
+		const FVector& Origin = Origins[ProbeIdx];
+		const FVector Dest = Origin + RayVector;
+
+		FHitResult Hit;
+		if (GroundCache && GroundCache->FindGround(Origin, Dest, GroundQuery, Now, Hit))
+		{
+			// Cache hit.
+		}
+		else if (LODSetting.bUseAsyncTraces)
+		{
+			// Async traces go by channel: the closest blocking hit of the world static channel.
+			const int32 Key = FGaitAsyncTraceQueue::MakeKey(ProbeIdx, EGaitAsyncTraceKind::GroundReflection);
+			bComplete &= AsyncTraces.IsResultReady(Key, Now);
+
+			const FHitResult* BlockingHit = nullptr;
+			if (AsyncTraces.Trace(Key, Origin, Dest, ECollisionChannel::ECC_WorldStatic, 0.f, false, SweepParam, GetOwningActor()->GetVelocity(), Now, LODSetting.bExtrapolateAsyncTraces, GroundProbeHits))
+			{
+				BlockingHit = GroundProbeHits.FindByPredicate([](const FHitResult& ProbeHit) { return ProbeHit.bBlockingHit; });
+			}
+			Hit.ImpactPoint = BlockingHit ? BlockingHit->ImpactPoint : Dest;
+		}
+		else
+		{
+			FGaitQueryCounters::AddTrace();
+			if (!World->LineTraceSingleByObjectType
+			(
+				Hit,
+				Origin,
+				Dest,
+				ObjectQuery,
+				SweepParam
+			))
+			{
+				Hit.ImpactPoint = Dest;
+			}
+			else if (GroundCache)
+			{
+				GroundCache->StoreGround(Origin, Dest, GroundQuery, Now, MakeArrayView(&Hit, 1));
+			}
+		}
+
+		OutPoints[ProbeIdx] = Hit.ImpactPoint;
+
+		if (GroundReflection.bShowDebugPlanes)
+		{
+			DrawDebugLine(World, Origin, Dest, FColor::Cyan, false, 0.f, 0, 0.5f);
+			DrawDebugPoint(World, Hit.ImpactPoint, 10, FColor::Cyan, false, 0.f);
+		}
 	}
 
-	if (GroundReflection.bShowDebugPlanes)
+	if (LODSetting.bUseAsyncTraces)
 	{
-		DrawDebugLine(World, Origin, Dest, FColor::Cyan, false, 0.f, 0, 0.5f);
-		DrawDebugPoint(World, Hit.ImpactPoint, 10, FColor::Cyan, false, 0.f);
+		// The probes of the batch are issued together, without waiting for the next gait update.
+		AsyncTraces.Flush(World, this);
 	}
-	return Hit.ImpactPoint;
+
+	return bComplete;
 }
 
-FRotator UProceduralGaitAnimInstance::ComputeGroundReflection_LOD0()
+void UProceduralGaitAnimInstance::GatherGroundReflectionSamples(FGroundReflectionSamples& OutSamples)
 {
+	const FTransform& MeshTransform = OwnedMesh->GetComponentTransform();
+
+	// Temporal coherence: nothing to trace if the mesh barely moved since the last samples (at the same LOD).
+	OutSamples.bReuseLastSolve = LastGroundReflectionLOD == CurrentLOD
+		&& FVector::DistSquared(MeshTransform.GetLocation(), LastGroundReflectionTransform.GetLocation()) <= FMath::Square(GroundReflection.RecomputeDistanceEpsilon)
+		&& FMath::RadiansToDegrees(MeshTransform.GetRotation().AngularDistance(LastGroundReflectionTransform.GetRotation())) <= GroundReflection.RecomputeAngleEpsilon;
+
+	if (OutSamples.bReuseLastSolve)
+	{
+		return;
+	}
+
 	// Get Socket location
-	FVector F = OwnedMesh->GetSocketLocation(GroundReflection.FrontSocket);
-	FVector B = OwnedMesh->GetSocketLocation(GroundReflection.BackSocket);
-	FVector R = OwnedMesh->GetSocketLocation(GroundReflection.RightSocket);
-	FVector L = OwnedMesh->GetSocketLocation(GroundReflection.LeftSocket);
-
-	// Compute centroid
-	TArray<FVector> Average;
-	Average.Add(F);
-	Average.Add(B);
-	Average.Add(R);
-	Average.Add(L);
-	FVector C = GetAverage(Average);
+	SocketCache.Refresh(OwnedMesh);
+	FVector Origins[FGroundReflectionSamples::MaxPoints];
+	Origins[0] = SocketCache.GetWorldLocation(OwnedMesh, GroundReflection.FrontSocket);
+	Origins[1] = SocketCache.GetWorldLocation(OwnedMesh, GroundReflection.BackSocket);
+	Origins[2] = SocketCache.GetWorldLocation(OwnedMesh, GroundReflection.RightSocket);
+	Origins[3] = SocketCache.GetWorldLocation(OwnedMesh, GroundReflection.LeftSocket);
+	OutSamples.NumPoints = 4;
+
+	// Centroid is only used at LOD 0.
+	if (CurrentLOD == 0)
+	{
+		Origins[4] = (Origins[0] + Origins[1] + Origins[2] + Origins[3]) * 0.25f;
+		OutSamples.NumPoints = 5;
+	}
 
 	// Trace for ground
-	F = TraceGroundRaycast(GetWorld(), F, F + RayVector);
-	B = TraceGroundRaycast(GetWorld(), B, B + RayVector);
-	R = TraceGroundRaycast(GetWorld(), R, R + RayVector);
-	L = TraceGroundRaycast(GetWorld(), L, L + RayVector);
-	C = TraceGroundRaycast(GetWorld(), C, C + RayVector);
+	if (!TraceGroundProbes(GetWorld(), Origins, OutSamples.NumPoints, OutSamples.Points))
+	{
+		// Async results missing: keep the last solve, and trace again on the next update.
+		OutSamples.bReuseLastSolve = true;
+		return;
+	}
 
-	// Compute ground reflection
-	FRotator Rotation(0, 0, 0);
-	FVector RightVec = OwnedMesh->GetRightVector();
-	GetPlaneRotation(F, R, C, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
-	GetPlaneRotation(C, R, B, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
-	GetPlaneRotation(C, B, L, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
-	GetPlaneRotation(F, C, L, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
+	LastGroundReflectionTransform = MeshTransform;
+	LastGroundReflectionLOD = CurrentLOD;
 
-	return Rotation;
+	OutSamples.RightVector = OwnedMesh->GetRightVector();
 }
 
-FRotator UProceduralGaitAnimInstance::ComputeGroundReflection_LOD1()
+FRotator UProceduralGaitAnimInstance::SolveGroundReflection(const FGroundReflectionSamples& Samples)
 {
-	FVector Front = OwnedMesh->GetSocketLocation(GroundReflection.FrontSocket);
-	Front = TraceGroundRaycast(GetWorld(), Front, Front + RayVector);
-	FVector Back = OwnedMesh->GetSocketLocation(GroundReflection.BackSocket);
-	Back = TraceGroundRaycast(GetWorld(), Back, Back + RayVector);
-	FVector Right = OwnedMesh->GetSocketLocation(GroundReflection.RightSocket);
-	Right = TraceGroundRaycast(GetWorld(), Right, Right + RayVector);
-	FVector Left = OwnedMesh->GetSocketLocation(GroundReflection.LeftSocket);
-	Left = TraceGroundRaycast(GetWorld(), Left, Left + RayVector);
+	if (Samples.bReuseLastSolve)
+	{
+		return LastGroundReflectionSolve;
+	}
 
-	FVector RightVec = OwnedMesh->GetRightVector();
+	NOBUNANIM_SCOPE_COUNTER(GroundReflection_Solve);
 
-	FRotator Rotation(0, 0, 0);
-	GetPlaneRotation(Front, Right, Back, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
-	GetPlaneRotation(Front, Back, Left, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
-	GetPlaneRotation(Front, Right, Left, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
-	GetPlaneRotation(Right, Back, Left, RightVec, Rotation, GroundReflection.bUseHalfVector, GroundReflection.bShowDebugPlanes);
+	FVector Centroid, FloorZAxis;
+	if (!FGaitMath::FitPlane(Samples.Points, Samples.NumPoints, Centroid, FloorZAxis))
+	{
+		return LastGroundReflectionSolve;
+	}
 
-	return Rotation;
-}
+	// Compute ground reflection
+	const FVector FloorXAxis = Samples.RightVector ^ FloorZAxis;
+	const FVector FloorYAxis = FloorZAxis ^ FloorXAxis;
 
-#pragma endregion
+	// 90 - Acos(x) == Asin(x).
+	FRotator Rotation(0, 0, 0);
+	Rotation.Roll = FMath::RadiansToDegrees(FMath::Asin(FMath::Clamp(FloorYAxis.Z, -1.f, 1.f)));
+	Rotation.Yaw = FMath::RadiansToDegrees(FMath::Asin(FMath::Clamp(FloorXAxis.Z, -1.f, 1.f)));
 
- 
-#pragma region PROCEDURAL GAIT UTILITIES
-bool UProceduralGaitAnimInstance::TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius)
-{
-	const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
+	LastGroundReflectionSolve = Rotation;
 
-	// if correction Level0 then zero computation.
-	if (LODSetting.CorrectionLevel == ENobunanimIKCorrectionLevel::IKL_Level0)
+#if WITH_EDITOR
+	if (GroundReflection.bShowDebugPlanes)
+	{
+		TArray<FVector, TInlineAllocator<FGroundReflectionSamples::MaxPoints>> Points(Samples.Points, Samples.NumPoints);
+		QueueDebugDraw([Points, Centroid, FloorZAxis](UWorld* DebugWorld)
+		{
+			for (const FVector& Point : Points)
+			{
+				DrawDebugLine(DebugWorld, Centroid, Point, FColor(255.f, 255.f, 255.f), false, 0.f, 0, 0.5f);
+			}
+			DrawDebugDirectionalArrow(DebugWorld, Centroid, Centroid + FloorZAxis * 50.f, 5.f, FColor(255.f, 255.f, 255.f), false, 0.f, 0, 0.5f);
+		});
+	}
+#endif
+
+	return Rotation;
+}
+
+#pragma endregion
+
+ 
+#pragma region PROCEDURAL GAIT UTILITIES
+bool UProceduralGaitAnimInstance::TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius, int32 AsyncKey, bool bUseGroundCache)
+{
+	const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
+
+	HitResults.Reset();
+
+	// if correction Level0 (or phase only off screen) then zero computation.
+	if (LODSetting.CorrectionLevel == ENobunanimIKCorrectionLevel::IKL_Level0 || OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly)
 	{
 		return false;
 	}
 
-	FCollisionQueryParams SweepParam(*GetOwningActor()->GetName(), LODSetting.bTraceOnComplex, GetOwningActor());
+	// Static trace tag: building one from the owner name would allocate each trace.
+	FCollisionQueryParams SweepParam(SCENE_QUERY_STAT(ProceduralGaitTrace), LODSetting.bTraceOnComplex, GetOwningActor());
 
+	UGaitGroundCacheSubsystem* GroundCache = bUseGroundCache && UGaitGroundCacheSubsystem::IsCacheable(Origin, Dest) ? UGaitGroundCacheSubsystem::Get(World) : nullptr;
+	const FGaitGroundQuery GroundQuery{ TraceChannel, false, LODSetting.bTraceOnComplex };
+	if (GroundCache)
+	{
+		FHitResult CachedHit;
+		if (GroundCache->FindGround(Origin, Dest, GroundQuery, World->GetTimeSeconds(), CachedHit))
+		{
+			HitResults.Reset();
+			HitResults.Add(CachedHit);
+			return true;
+		}
+	}
+
+	++NumGaitTraces;
+
+	if (AsyncKey != INDEX_NONE && LODSetting.bUseAsyncTraces)
+	{
+		const bool bSweepFallback = LODSetting.CorrectionLevel == ENobunanimIKCorrectionLevel::IKL_Level2;
+		return AsyncTraces.Trace(AsyncKey, Origin, Dest, TraceChannel, SphereCastRadius, bSweepFallback, SweepParam, GaitUpdateVelocity, World->GetTimeSeconds(), LODSetting.bExtrapolateAsyncTraces, HitResults);
+	}
+
+	FGaitQueryCounters::AddTrace();
 	bool bFoundHit = World->LineTraceMultiByChannel
 	(
 		HitResults,
@@ -717,11 +754,21 @@ bool UProceduralGaitAnimInstance::TraceRay(UWorld* World, TArray<FHitResult>& Hi
 		FCollisionResponseParams::DefaultResponseParam
 	);
 
+	// Only plain line traces are cached: sweep hits aren't under the trace.
+	if (GroundCache)
+	{
+		GroundCache->StoreGround(Origin, Dest, GroundQuery, World->GetTimeSeconds(), HitResults);
+	}
+
 #if WITH_EDITOR
 	if (LODSetting.Debug.bShowCollisionCorrection)
 	{
-		DrawDebugDirectionalArrow(World, Origin, Dest, 5, LODSetting.Debug.IKTraceColor, false, LODSetting.Debug.IKTraceDuration, 0, 0.5f);
-		DrawDebugPoint(World, Dest, 10, LODSetting.Debug.LODColor, false, LODSetting.Debug.IKTraceDuration);
+		const FProceduralGaitLODSettingsDebugData Debug = LODSetting.Debug;
+		QueueDebugDraw([Origin, Dest, Debug](UWorld* DebugWorld)
+		{
+			DrawDebugDirectionalArrow(DebugWorld, Origin, Dest, 5, Debug.IKTraceColor, false, Debug.IKTraceDuration, 0, 0.5f);
+			DrawDebugPoint(DebugWorld, Dest, 10, Debug.LODColor, false, Debug.IKTraceDuration);
+		});
 	}
 #endif
 
@@ -732,6 +779,8 @@ bool UProceduralGaitAnimInstance::TraceRay(UWorld* World, TArray<FHitResult>& Hi
 
 	if (!bFoundHit)
 	{
+		++NumGaitTraces;
+		FGaitQueryCounters::AddSweep();
 		bFoundHit = World->SweepMultiByChannel
 		(
 			HitResults,
@@ -747,7 +796,11 @@ bool UProceduralGaitAnimInstance::TraceRay(UWorld* World, TArray<FHitResult>& Hi
 #if WITH_EDITOR
 		if (LODSetting.Debug.bShowCollisionCorrection)
 		{
-			DrawDebugCapsule(World, (Dest + Origin) * 0.5f, ((Dest - Origin)).Size()* 0.5f, SphereCastRadius, FQuat((Origin - Dest).GetUnsafeNormal().Rotation()), LODSetting.Debug.LODColor, false, LODSetting.Debug.IKTraceDuration, 0, .5f);
+			const FProceduralGaitLODSettingsDebugData Debug = LODSetting.Debug;
+			QueueDebugDraw([Origin, Dest, SphereCastRadius, Debug](UWorld* DebugWorld)
+			{
+				DrawDebugCapsule(DebugWorld, (Dest + Origin) * 0.5f, ((Dest - Origin)).Size()* 0.5f, SphereCastRadius, FQuat((Origin - Dest).GetUnsafeNormal().Rotation()), Debug.LODColor, false, Debug.IKTraceDuration, 0, .5f);
+			});
 		}
 #endif
 	}
@@ -779,18 +832,30 @@ FHitResult& UProceduralGaitAnimInstance::GetBestHitResult(TArray<FHitResult>& Hi
 
 void UProceduralGaitAnimInstance::UpdateGaitMode_Implementation(const FName& NewGaitName)
 {
-	if (GaitsData.Contains(NewGaitName))
+	if (!GaitBinding.IsBuilt())
 	{
-		if (CurrentGaitMode != NewGaitName && PendingGaitMode != NewGaitName)
+		InitializeGaitBinding();
+	}
+
+	const int32 NewGaitIndex = GaitBinding.FindGait(NewGaitName);
+	if (NewGaitIndex != INDEX_NONE)
+	{
+		if (GaitState.CurrentGaitIndex != NewGaitIndex && GaitState.PendingGaitIndex != NewGaitIndex)
 		{
-			if (CurrentGaitMode.IsNone() || CurrentGaitMode == "None")
+			if (GaitState.CurrentGaitIndex == INDEX_NONE)
 			{
-				CurrentGaitMode = NewGaitName;
+				GaitState.CurrentGaitIndex = NewGaitIndex;
 
 			}
 			else
 			{
-				PendingGaitMode = NewGaitName;
+				GaitState.PendingGaitIndex = NewGaitIndex;
+			}
+
+			// Swing windows change with the gait.
+			for (FGaitEffectorData& Effector : GaitState.Effectors)
+			{
+				Effector.PlantedUntil = -1.f;
 			}
 
 			Execute_SetProceduralGaitEnable(this, true);
@@ -809,106 +874,120 @@ void UProceduralGaitAnimInstance::UpdateGaitMode_Implementation(const FName& New
 }
 
 
-void UProceduralGaitAnimInstance::UpdateEffectors(const UGaitDataAsset& CurrentAsset)
+void UProceduralGaitAnimInstance::InitializeGaitBinding()
+{
+	// Rebinding (gaits edited while playing) keeps playing the same gaits.
+	const FName CurrentGaitName = GaitBinding.GetGaitName(GaitState.CurrentGaitIndex);
+	const FName PendingGaitName = GaitBinding.GetGaitName(GaitState.PendingGaitIndex);
+
+	GaitBinding.Build(GaitsData);
+	AsyncTraces.Reset();
+	BuildSocketCache();
+
+	GaitState.Effectors.Reset();
+	GaitState.Effectors.SetNum(GaitBinding.NumSlots());
+
+	GaitState.CurrentGaitIndex = GaitBinding.FindGait(CurrentGaitName);
+	GaitState.PendingGaitIndex = GaitBinding.FindGait(PendingGaitName);
+}
+
+
+void UProceduralGaitAnimInstance::BuildSocketCache()
+{
+	SocketCache.Reset();
+
+	// Slots come first: the socket index of a slot is the slot.
+	for (const FName& SlotName : GaitBinding.SlotNames)
+	{
+		SocketCache.AddSocket(SlotName);
+	}
+
+	for (int32 GaitIndex = 0, n = GaitBinding.NumGaits(); GaitIndex < n; ++GaitIndex)
+	{
+		for (const FGaitSwingData* SwingData : GaitBinding.GetTable(GaitIndex).SwingData)
+		{
+			if (!SwingData->TranslationData.GroundReferenceSocket.IsNone())
+			{
+				SocketCache.AddSocket(SwingData->TranslationData.GroundReferenceSocket);
+			}
+			if (!SwingData->CorrectionData.OriginCollisionSocketName.IsNone())
+			{
+				SocketCache.AddSocket(SwingData->CorrectionData.OriginCollisionSocketName);
+			}
+		}
+	}
+
+	SocketCache.AddSocket(GroundReflection.FrontSocket);
+	SocketCache.AddSocket(GroundReflection.BackSocket);
+	SocketCache.AddSocket(GroundReflection.RightSocket);
+	SocketCache.AddSocket(GroundReflection.LeftSocket);
+}
+
+
+void UProceduralGaitAnimInstance::UpdateEffectors(int32 GaitIndex)
 {
 	NOBUNANIM_SCOPE_COUNTER(Gait_UpdateEffectors);
 
-	TArray<FName> SwingValuesKeys;
-	const TMap<FName, FGaitSwingData>& SwingValues = CurrentAsset.GaitSwingValues;//GaitsData[Keys[i]]->GaitSwingValues;
-	SwingValues.GetKeys(SwingValuesKeys);
+	const FGaitRuntimeTable& Table = GaitBinding.GetTable(GaitIndex);
 
-	for (int j = 0, m = SwingValuesKeys.Num(); j < m; ++j)
+	for (int j = 0, m = Table.Num(); j < m; ++j)
 	{
 		NOBUNANIM_SCOPE_COUNTER(Gait_UpdateEffector_One);
 
-		FName Key = SwingValuesKeys[j];
-		FVector EffectorLocation = OwnedMesh->GetSocketTransform(Key, CurrentAsset.GaitSwingValues[Key].TranslationData.TransformSpace.GetValue()).GetLocation();
+		const FName Key = Table.EffectorNames[j];
+		const FGaitRuntimeEffector& Data = Table.Effectors[j];
+		const int32 Slot = GaitBinding.GetSlot(GaitIndex, j);
+		FGaitEffectorData& Effector = GaitState.Effectors[Slot];
 
-		if (Effectors.Contains(Key))
-		{
-			Effectors[Key].IdealEffectorLocation = EffectorLocation;
+		FVector EffectorLocation = SocketCache.GetTransform(OwnedMesh, Slot, Data.TransformSpace.GetValue()).GetLocation();
+		Effector.IdealEffectorLocation = EffectorLocation;
 
-			if (CurrentAsset.GaitSwingValues[Key].TranslationData.bAdaptToGroundLevel)
+		if (Data.bAdaptToGroundLevel && !GaitUpdateLODSetting->IsTracePhase(GaitUpdateCounter, Slot, GetUniqueID()))
+		{
+			// Off phase: keep the last ground adaptation.
+			Effector.GroundLocation = EffectorLocation + Effector.GroundOffset;
+		}
+		else if (Data.bAdaptToGroundLevel)
+		{
+			FVector Dir = FVector::UpVector;
+			FVector GroundLocation;
+			TArray<FHitResult>& HitResults = TraceHits;
+			FVector GroundReferenceLocation = SocketCache.GetWorldLocation(OwnedMesh, Table.SwingData[j]->TranslationData.GroundReferenceSocket);
+			bool bFound = TraceRay(GetWorld(), HitResults, EffectorLocation, FVector(EffectorLocation.X, EffectorLocation.Y, GroundReferenceLocation.Z), ECollisionChannel::ECC_Visibility, SPHERECAST_IK_CORRECTION_RADIUS, FGaitAsyncTraceQueue::MakeKey(Slot, EGaitAsyncTraceKind::Ground), true);
+			if (!bFound)
 			{
-				FVector Dir = FVector::UpVector;
-				FVector GroundLocation;
-				TArray<FHitResult> HitResults;
-				FVector GroundReferenceLocation = OwnedMesh->GetSocketLocation(CurrentAsset.GaitSwingValues[Key].TranslationData.GroundReferenceSocket);
-				bool bFound = TraceRay(GetWorld(), HitResults, EffectorLocation, FVector(EffectorLocation.X, EffectorLocation.Y, GroundReferenceLocation.Z), ECollisionChannel::ECC_Visibility, SPHERECAST_IK_CORRECTION_RADIUS);
-				if (!bFound)
-				{
-					//GroundLocation = EffectorLocation + RayVector; 
-					Effectors[Key].GroundLocation = EffectorLocation;
-				}
-				else
+				Effector.GroundLocation = EffectorLocation;
+			}
+			else
+			{
+				FHitResult& HitResult = GetBestHitResult(HitResults, EffectorLocation);
+				if (HitResult.bBlockingHit)
 				{
-					FHitResult& HitResult = GetBestHitResult(HitResults, EffectorLocation);
-					if (HitResult.bBlockingHit)
+					GroundLocation = HitResult.ImpactPoint;
+					Dir = HitResult.Normal;
+
+					if (GroundLocation.Z > GroundReferenceLocation.Z)
 					{
-						GroundLocation = HitResult.ImpactPoint;
-						Dir = HitResult.Normal;
-
-						if (GroundLocation.Z > GroundReferenceLocation.Z)
-						{
-							FVector Correction = Dir * (GroundLocation.Z - GroundReferenceLocation.Z);
-							Effectors[Key].GroundLocation = EffectorLocation + Correction;
-						}
-						else
-						{
-							Effectors[Key].GroundLocation = EffectorLocation;
-						}
+						FVector Correction = Dir * (GroundLocation.Z - GroundReferenceLocation.Z);
+						Effector.GroundLocation = EffectorLocation + Correction;
 					}
 					else
 					{
-						Effectors[Key].GroundLocation = EffectorLocation;
-						//GroundLocation = EffectorLocation + RayVector;
+						Effector.GroundLocation = EffectorLocation;
 					}
 				}
-
-				//Effectors[Key].GroundLocation = GroundLocation;
-				//Effectors[Key].GroundLocation = EffectorLocation;// +(Dir * (Effectors[Key].IdealEffectorLocation.Z - GroundLocation.Z));
-				//Effectors[Key].GroundLocation.X = Effectors[Key].GroundLocation.Y = 0.f;
+				else
+				{
+					Effector.GroundLocation = EffectorLocation;
+				}
 			}
 
-			/*if (bLastFrameWasDisable)
-			{
-				Effectors[Key].CurrentEffectorLocation = EffectorLocation;
-				Execute_UpdateEffectorTranslation(this, Key, EffectorLocation, false, 0);
-			}*/
-		}
-		else
-		{
-			FGaitEffectorData Effector;
-			Effector.IdealEffectorLocation = EffectorLocation;
-			Effectors.Add(Key, Effector);
+			Effector.GroundOffset = Effector.GroundLocation - EffectorLocation;
 		}
 	}
 }
 
 
-bool UProceduralGaitAnimInstance::IsInRange(float Value, float Min, float Max, float& OutRangeMin, float& OutRangeMax)
-{
-	bool A = Value >= Min && Value <= Max;
-	bool APrime = Value >= Max;
-
-	// Gave me headache ._.
-	OutRangeMin = A ? Min : (APrime ? Min : Min - 1.f);
-	OutRangeMax = A ? Max : (APrime ? 1.f /*- Min + Min*/ + Max : Max);
-
-	if (A)
-	{
-		return true;
-	}
-	else
-	{
-		bool B1 = Value <= Min && Value <= Max;
-		bool B2 = Value >= Min && Value >= Max;
-		bool B3 = B1 || B2;
-		bool C = Min >= Max && B3;
-
-		return C;
-	}
-}
 
 void UProceduralGaitAnimInstance::DrawGaitDebug(FVector Position, FVector EffectorLocation, FVector CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData)
 {
@@ -926,7 +1005,7 @@ void UProceduralGaitAnimInstance::DrawGaitDebug(FVector Position, FVector Effect
 			DrawDebugLine(World, EffectorLocation, Position, FColor(255.f, 255.f, 255.f), false, 0.f, 0, 0.5f);
 			//DrawDebugLine(World, CurrentLocation, EffectorLocation, FColor(255.f, 0.f, 0.f), false, 0.f, 0, 1.f);
 
-			FRotator Rot = LastVelocity.Rotation();
+			FRotator Rot = GaitState.LastVelocity.Rotation();
 			DrawDebugDirectionalArrow(World, EffectorLocation, EffectorLocation + (Rot.RotateVector(FVector::ForwardVector) * 10.f), 1, DebugData->VelocityColor, false, 0, 0, 1.f);
 
 			if (bAutoAdjustWithIdealEffector)
@@ -950,23 +1029,162 @@ void UProceduralGaitAnimInstance::DrawGaitDebug(FVector Position, FVector Effect
 #endif
 }
 
+void UProceduralGaitAnimInstance::QueueEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed)
+{
+	if (OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly)
+	{
+		return;
+	}
+
+	if (bComputingGaitUpdate && GaitUpdateMode == EProceduralGaitUpdateMode::AnimationProxy)
+	{
+		// Consumed by the graph right after the proxy update.
+		UpdateEffectorTranslation_Implementation(Key, Translation, bLerp, LerpSpeed);
+	}
+	else if (bComputingGaitUpdate)
+	{
+		DeferredCommands.Add({ FGaitDeferredCommand::EType::Translation, Key, Translation, LerpSpeed, bLerp });
+	}
+	else
+	{
+		Execute_UpdateEffectorTranslation(this, Key, Translation, bLerp, LerpSpeed);
+	}
+}
+
+void UProceduralGaitAnimInstance::QueueEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed)
+{
+	if (OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly)
+	{
+		return;
+	}
+
+	if (bComputingGaitUpdate && GaitUpdateMode == EProceduralGaitUpdateMode::AnimationProxy)
+	{
+		UpdateEffectorRotation_Implementation(Key, Rotation, LerpSpeed);
+	}
+	else if (bComputingGaitUpdate)
+	{
+		DeferredCommands.Add({ FGaitDeferredCommand::EType::Rotation, Key, FVector(Rotation.Pitch, Rotation.Yaw, Rotation.Roll), LerpSpeed, false });
+	}
+	else
+	{
+		Execute_UpdateEffectorRotation(this, Key, Rotation, LerpSpeed);
+	}
+}
+
+void UProceduralGaitAnimInstance::QueueGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location)
+{
+	if (bComputingGaitUpdate)
+	{
+		DeferredCommands.Add({ FGaitDeferredCommand::EType::GaitEvent, Key, Location, 0.f, false, Type });
+	}
+	else
+	{
+		RaiseGaitEvent(Type, Key, Location);
+	}
+}
+
+void UProceduralGaitAnimInstance::RaiseGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location)
+{
+	if (UGaitEventSubsystem* GaitEvents = UGaitEventSubsystem::Get(GetWorld()))
+	{
+		GaitEvents->QueueEvent({ this, GetOwningActor(), Key, Location, Type });
+	}
+
+	if (Type == EGaitEventType::Footfall && bBroadcastCollisionEvent)
+	{
+		OnCollisionEvent.Broadcast(Key, Location);
+	}
+}
+
+#if WITH_EDITOR
+void UProceduralGaitAnimInstance::QueueDebugDraw(TFunction<void(UWorld*)>&& Draw)
+{
+	if (bComputingGaitUpdate)
+	{
+		DeferredDebugDraws.Add(MoveTemp(Draw));
+	}
+	else if (UWorld* World = GetWorld())
+	{
+		Draw(World);
+	}
+}
+#endif
+
 void UProceduralGaitAnimInstance::UpdateLOD(bool bForceUpdate)
 {
-	if (CurrentLOD != OwnedMesh->PredictedLODLevel
-		|| bForceUpdate)
+	// The gait budget can push the LOD further than the mesh.
+	const int32 PredictedLOD = FMath::Max(OwnedMesh->PredictedLODLevel, SignificanceMinLOD);
+	if (!bForceUpdate)
 	{
-		CurrentLOD = OwnedMesh->PredictedLODLevel;
+		if (PredictedLOD == CurrentLOD)
+		{
+			PendingLOD = INDEX_NONE;
+			return;
+		}
+
+		// Hysteresis: the new LOD must be kept for a while before being applied.
+		const float Now = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+		if (PredictedLOD != PendingLOD)
+		{
+			PendingLOD = PredictedLOD;
+			PendingLODStartTime = Now;
+		}
+
+		if (Now - PendingLODStartTime < UNobunanimSettings::GetLODHysteresisTime())
+		{
+			return;
+		}
+	}
+
+	PendingLOD = INDEX_NONE;
+	CurrentLOD = PredictedLOD;
+
+	// If procedural gait update is running, move to the bucket of the new LOD framerate.
+	RescheduleGaitUpdate();
+}
 
-		// If procedural gait update is running, hard reset to adapt framerate.
-		if (bUpdateGaitActive)
+int32 UProceduralGaitAnimInstance::GetGaitTargetFPS() const
+{
+	return UNobunanimSettings::GetLODSetting(CurrentLOD).GetEffectiveTargetFPS(OffscreenPolicy);
+}
+
+void UProceduralGaitAnimInstance::RescheduleGaitUpdate()
+{
+	if (bUpdateGaitActive && !bGaitDormant && GaitUpdateMode == EProceduralGaitUpdateMode::Scheduler)
+	{
+		const int32 TargetFPS = GetGaitTargetFPS();
+		if (TargetFPS != ScheduledTargetFPS)
 		{
-			float Delay = 1.f / (float)UNobunanimSettings::GetLODSetting(CurrentLOD = OwnedMesh->PredictedLODLevel).TargetFPS;
-			// Set timer will auto-clear if needed.
-			GetWorld()->GetTimerManager().SetTimer(GaitUpdateTimer, [this]() { ProceduralGaitUpdate(); }, Delay, true, false);
+			if (UGaitSchedulerSubsystem* Scheduler = UWorld::GetSubsystem<UGaitSchedulerSubsystem>(GetWorld()))
+			{
+				ScheduledTargetFPS = TargetFPS;
+				Scheduler->RegisterInstance(this, ScheduledTargetFPS);
+			}
 		}
 	}
 }
 
+void UProceduralGaitAnimInstance::UpdateOffscreenPolicy()
+{
+	const UWorld* World = GetWorld();
+	const EGaitOffscreenPolicy NewPolicy = UNobunanimSettings::ResolveOffscreenPolicy(World ? World->GetNetMode() : NM_Standalone, CurrentLOD, OwnedMesh);
+
+	if (NewPolicy == OffscreenPolicy)
+	{
+		return;
+	}
+
+	// Leaving a policy without effector outputs: effectors and outputs are stale.
+	if (AreGaitOutputsSuspended())
+	{
+		bResyncGait = true;
+	}
+
+	OffscreenPolicy = NewPolicy;
+	RescheduleGaitUpdate();
+}
+
 void UProceduralGaitAnimInstance::SetProceduralGaitUpdateEnable(bool bEnable)
 {
 	UWorld* World = GetWorld();
@@ -974,20 +1192,340 @@ void UProceduralGaitAnimInstance::SetProceduralGaitUpdateEnable(bool bEnable)
 	{
 		return;
 	}
+
+	// Any explicit enable or disable ends the dormancy.
+	const bool bWasDormant = bGaitDormant;
+	ExitGaitDormancy();
+
+	// The proxy checks @bUpdateGaitActive each animation update.
+	if (GaitUpdateMode == EProceduralGaitUpdateMode::AnimationProxy)
+	{
+		if (bEnable && !bUpdateGaitActive && UNobunanimSettings::IsGaitUpdateAmortizationEnabled())
+		{
+			// Start at the phase of this instance so proxies enabled together don't update together.
+			const float Interval = 1.f / (float)FMath::Max(GetGaitTargetFPS(), 1);
+			ProxyGaitTimeAccumulator = UGaitSchedulerSubsystem::GetUpdatePhase(this) * Interval;
+		}
+
+		bUpdateGaitActive = bEnable;
+		return;
+	}
+
+	UGaitSchedulerSubsystem* Scheduler = World->GetSubsystem<UGaitSchedulerSubsystem>();
+	if (!Scheduler)
+	{
+		return;
+	}
 	
 	if (bEnable && !bUpdateGaitActive)
 	{
 		bUpdateGaitActive = true;
-		float Delay = 1.f / (float)UNobunanimSettings::GetLODSetting(CurrentLOD = OwnedMesh->PredictedLODLevel).TargetFPS;
-		// Set timer will auto-clear if needed.
-		World->GetTimerManager().SetTimer(GaitUpdateTimer, [this]() { ProceduralGaitUpdate(); }, Delay, true, false);
+		CurrentLOD = OwnedMesh->PredictedLODLevel;
+		ScheduledTargetFPS = GetGaitTargetFPS();
+		Scheduler->RegisterInstance(this, ScheduledTargetFPS);
 	}
 	else if(!bEnable && bUpdateGaitActive)
 	{
 		bUpdateGaitActive = false;
+		ScheduledTargetFPS = 0;
+		Scheduler->UnregisterInstance(this);
+	}
+	else if (bEnable && bWasDormant)
+	{
+		RescheduleGaitUpdate();
+	}
+}
+
+#pragma endregion
+
+
+#pragma region GAIT DORMANCY
+
+void UProceduralGaitAnimInstance::WakeGait()
+{
+	if (!bGaitDormant)
+	{
+		return;
+	}
+
+	ExitGaitDormancy();
+	RescheduleGaitUpdate();
+}
+
+void UProceduralGaitAnimInstance::UpdateGaitDormancy()
+{
+	UWorld* World = GetWorld();
+	if (!bIdleGaitUpdate || !World || !UNobunanimSettings::IsGaitDormancyEnabled())
+	{
+		IdleStartTime = -1.f;
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+	if (IdleStartTime < 0.f)
+	{
+		IdleStartTime = Now;
+	}
+	else if (Now - IdleStartTime >= UNobunanimSettings::GetGaitDormancyDelay())
+	{
+		EnterGaitDormancy();
+	}
+}
+
+void UProceduralGaitAnimInstance::EnterGaitDormancy()
+{
+	UWorld* World = GetWorld();
+	if (bGaitDormant || !OwnedMesh || !World)
+	{
+		return;
+	}
+
+	bGaitDormant = true;
+	IdleStartTime = -1.f;
+
+	// No more gait update. In AnimationProxy mode, the proxy checks @bGaitDormant.
+	if (GaitUpdateMode == EProceduralGaitUpdateMode::Scheduler && ScheduledTargetFPS != 0)
+	{
+		if (UGaitSchedulerSubsystem* Scheduler = World->GetSubsystem<UGaitSchedulerSubsystem>())
+		{
+			Scheduler->UnregisterInstance(this);
+		}
+		ScheduledTargetFPS = 0;
+	}
+
+	// Wake up on move or teleport of the mesh, or ground change around it.
+	DormantTransformHandle = OwnedMesh->TransformUpdated.AddUObject(this, &UProceduralGaitAnimInstance::OnDormantMeshTransformUpdated);
+	if (UGaitGroundCacheSubsystem* GroundCache = World->GetSubsystem<UGaitGroundCacheSubsystem>())
+	{
+		DormantGroundHandle = GroundCache->OnGroundChanged.AddUObject(this, &UProceduralGaitAnimInstance::OnDormantGroundChanged);
+	}
+}
+
+void UProceduralGaitAnimInstance::ExitGaitDormancy()
+{
+	if (!bGaitDormant)
+	{
+		return;
+	}
+
+	bGaitDormant = false;
+
+	if (OwnedMesh)
+	{
+		OwnedMesh->TransformUpdated.Remove(DormantTransformHandle);
+	}
+	DormantTransformHandle.Reset();
+
+	UWorld* World = GetWorld();
+	if (UGaitGroundCacheSubsystem* GroundCache = World ? World->GetSubsystem<UGaitGroundCacheSubsystem>() : nullptr)
+	{
+		GroundCache->OnGroundChanged.Remove(DormantGroundHandle);
+	}
+	DormantGroundHandle.Reset();
+
+	// Don't replay the time spent dormant.
+	if (World)
+	{
+		LastTime = World->GetTimeSeconds();
+	}
+}
+
+void UProceduralGaitAnimInstance::OnDormantMeshTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	WakeGait();
+}
+
+void UProceduralGaitAnimInstance::OnDormantGroundChanged(const FBox& Bounds)
+{
+	if (!OwnedMesh || Bounds.Intersect(OwnedMesh->Bounds.GetBox()))
+	{
+		WakeGait();
+	}
+}
+
+#pragma endregion
+
+
+#pragma region GAIT REPLICATION
+
+FGaitReplicatedState UProceduralGaitAnimInstance::GetReplicatedGaitState() const
+{
+	return GaitState.GetReplicatedState(GaitBinding);
+}
+
+void UProceduralGaitAnimInstance::ApplyReplicatedGaitState(const FGaitReplicatedState& State)
+{
+	if (!GaitBinding.IsBuilt())
+	{
+		InitializeGaitBinding();
+	}
+
+	GaitState.ApplyReplicatedState(State, GaitBinding, [this](FName GaitName) { UpdateGaitMode(GaitName); });
+}
+
+#pragma endregion
+
+
+#pragma region OUTPUT UPSAMPLING
 
-		World->GetTimerManager().ClearTimer(GaitUpdateTimer);
+void UProceduralGaitAnimInstance::BeginOutputSample()
+{
+	UpsampleMode = GaitUpdateLODSetting->OutputUpsampling;
+	UpsampleMaxExtrapolation = GaitUpdateLODSetting->MaxExtrapolation;
+	UpsamplePreviousTime = UpsampleCurrentTime;
+	UpsampleCurrentTime = LastTime;
+
+	if (UpsampleMode == EGaitOutputUpsampling::None)
+	{
+		// Outputs are written directly, from the last presented values.
+		UpsampledTranslations.Reset();
+		UpsampledRotations.Reset();
+		return;
+	}
+
+	// Outputs not written by this sample keep their value.
+	for (TPair<FName, TGaitOutputSamples<FVector>>& Pair : UpsampledTranslations)
+	{
+		Pair.Value.Previous = Pair.Value.Current;
+	}
+	for (TPair<FName, TGaitOutputSamples<FRotator>>& Pair : UpsampledRotations)
+	{
+		Pair.Value.Previous = Pair.Value.Current;
 	}
+
+	GroundReflectionTargets.Previous = GroundReflectionTargets.Current;
+	bGroundReflectionSampleDue = true;
 }
 
-#pragma endregion
\ No newline at end of file
+float UProceduralGaitAnimInstance::GetUpsampleAlpha(float Now) const
+{
+	const float Interval = UpsampleCurrentTime - UpsamplePreviousTime;
+	if (Interval <= KINDA_SMALL_NUMBER)
+	{
+		return 1.f;
+	}
+
+	const float Elapsed = FMath::Max(Now - UpsampleCurrentTime, 0.f) / Interval;
+	return UpsampleMode == EGaitOutputUpsampling::Extrapolate ?
+		1.f + FMath::Min(Elapsed, UpsampleMaxExtrapolation) :
+		FMath::Min(Elapsed, 1.f);
+}
+
+void UProceduralGaitAnimInstance::PresentUpsampledOutputs(float Alpha)
+{
+	NOBUNANIM_SCOPE_COUNTER(Gait_PresentUpsampledOutputs);
+
+	// Keys are kept once added, so this doesn't allocate once warm.
+	for (const TPair<FName, TGaitOutputSamples<FVector>>& Pair : UpsampledTranslations)
+	{
+		EffectorsTranslation.FindOrAdd(Pair.Key) = FMath::Lerp(Pair.Value.Previous, Pair.Value.Current, Alpha);
+	}
+	for (const TPair<FName, TGaitOutputSamples<FRotator>>& Pair : UpsampledRotations)
+	{
+		BonesRotation.FindOrAdd(Pair.Key) = FMath::Lerp(Pair.Value.Previous, Pair.Value.Current, Alpha);
+	}
+}
+
+FRotator UProceduralGaitAnimInstance::UpsampleOutputs(const FRotator* SolvedTarget, float Now)
+{
+	if (SolvedTarget)
+	{
+		GroundReflectionTargets.Current = *SolvedTarget;
+		if (UpsampleMode == EGaitOutputUpsampling::None)
+		{
+			GroundReflectionTargets.Previous = *SolvedTarget;
+		}
+	}
+
+	if (UpsampleMode == EGaitOutputUpsampling::None)
+	{
+		return GroundReflectionTargets.Current;
+	}
+
+	const float Alpha = GetUpsampleAlpha(Now);
+	PresentUpsampledOutputs(Alpha);
+	return FMath::Lerp(GroundReflectionTargets.Previous, GroundReflectionTargets.Current, Alpha);
+}
+
+#pragma endregion
+
+
+#pragma region ANIMATION PROXY MODE
+
+void UProceduralGaitAnimInstance::ProxyPreUpdate(float DeltaSeconds)
+{
+	if (!OwnedMesh)
+	{
+		OwnedMesh = GetOwningComponent();
+	}
+
+	ProxyDeltaSeconds = DeltaSeconds;
+	ProxyPresentTime = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+	bProxyGaitPrepared = false;
+
+	// Same rate as the scheduler bucket of the current LOD.
+	if (bUpdateGaitActive && !bGaitDormant)
+	{
+		const float Interval = 1.f / (float)FMath::Max(GetGaitTargetFPS(), 1);
+
+		ProxyGaitTimeAccumulator += DeltaSeconds;
+		if (ProxyGaitTimeAccumulator >= Interval)
+		{
+			ProxyGaitTimeAccumulator = FMath::Fmod(ProxyGaitTimeAccumulator - Interval, Interval);
+			bProxyGaitPrepared = PrepareGaitUpdate();
+		}
+	}
+
+	// While upsampling, the ground is traced once per gait update.
+	bProxyGroundSampled = !AreGaitOutputsSuspended() && !bGaitDormant && (UpsampleMode == EGaitOutputUpsampling::None || bProxyGaitPrepared);
+	if (bProxyGroundSampled)
+	{
+		NOBUNANIM_SCOPE_COUNTER(TerrainPrediction);
+		GatherGroundReflectionSamples(ProxyGroundSamples);
+	}
+}
+
+void UProceduralGaitAnimInstance::ProxyUpdate()
+{
+	if (bProxyGaitPrepared)
+	{
+		// Outputs are written by the compute phase itself in this mode.
+		BeginOutputSample();
+		ComputeGaitUpdate();
+	}
+
+	TGuardValue<bool> ComputingGuard(bComputingGaitUpdate, true);
+	FRotator SolvedTarget;
+	if (bProxyGroundSampled)
+	{
+		SolvedTarget = SolveGroundReflection(ProxyGroundSamples).GetInverse();
+	}
+
+	const FRotator Target = UpsampleOutputs(bProxyGroundSampled ? &SolvedTarget : nullptr, ProxyPresentTime);
+	GroundReflectionRotation = FMath::Lerp(GroundReflectionRotation, Target, ProxyDeltaSeconds * GroundReflectionLerpSpeed);
+}
+
+void UProceduralGaitAnimInstance::ProxyPostUpdate()
+{
+	if (bProxyGaitPrepared)
+	{
+		bProxyGaitPrepared = false;
+		FinalizeGaitUpdate();
+	}
+#if WITH_EDITOR
+	else
+	{
+		// Ground reflection debug draws.
+		if (UWorld* World = GetWorld())
+		{
+			for (const TFunction<void(UWorld*)>& Draw : DeferredDebugDraws)
+			{
+				Draw(World);
+			}
+		}
+		DeferredDebugDraws.Reset();
+	}
+#endif
+}
+
+#pragma endregion
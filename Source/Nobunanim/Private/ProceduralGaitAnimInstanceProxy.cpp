@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProceduralGaitAnimInstanceProxy.h"
+
+#include "Nobunanim/Private/Nobunanim.h"
+#include "Nobunanim/Public/ProceduralGaitAnimInstance.h"
+
+
+FProceduralGaitAnimInstanceProxy::FProceduralGaitAnimInstanceProxy(UAnimInstance* InAnimInstance)
+	: FAnimInstanceProxy(InAnimInstance)
+	, GaitInstance(Cast<UProceduralGaitAnimInstance>(InAnimInstance))
+{
+}
+
+void FProceduralGaitAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	if (GaitInstance && GaitInstance->GaitUpdateMode == EProceduralGaitUpdateMode::AnimationProxy)
+	{
+		GaitInstance->ProxyPreUpdate(DeltaSeconds);
+	}
+}
+
+void FProceduralGaitAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	if (GaitInstance && GaitInstance->GaitUpdateMode == EProceduralGaitUpdateMode::AnimationProxy)
+	{
+		GaitInstance->ProxyUpdate();
+	}
+}
+
+void FProceduralGaitAnimInstanceProxy::PostUpdate(UAnimInstance* InAnimInstance) const
+{
+	FAnimInstanceProxy::PostUpdate(InAnimInstance);
+
+	if (GaitInstance && GaitInstance->GaitUpdateMode == EProceduralGaitUpdateMode::AnimationProxy)
+	{
+		GaitInstance->ProxyPostUpdate();
+	}
+}
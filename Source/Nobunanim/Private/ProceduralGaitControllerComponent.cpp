@@ -7,6 +7,9 @@
 #include "Nobunanim/Public/GaitDataAsset.h"
 #include "Nobunanim/Public/ProceduralGaitAnimInstance.h"
 #include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Public/GaitGroundCacheSubsystem.h"
+#include "Nobunanim/Public/GaitEvaluationCacheSubsystem.h"
+#include "Nobunanim/Public/GaitQueryCounters.h"
 
 #include <Engine/Classes/Curves/CurveVector.h>
 #include <Engine/Classes/Curves/CurveLinearColor.h>
@@ -16,7 +19,7 @@
 #include <Engine/Classes/Kismet/KismetSystemLibrary.h>
 #include <Engine/Classes/Kismet/KismetMathLibrary.h>
 
-#define ORIENT_TO_VELOCITY(Input) LastVelocity.Rotation().RotateVector(Input)
+#include <Net/UnrealNetwork.h>
 
 #define SPHERECAST_IK_CORRECTION_RADIUS 30.f
 
@@ -85,22 +88,172 @@ void UProceduralGaitControllerComponent::BeginPlay()
 	{
 		SetComponentTickEnabled(IsValid(AnimInstanceRef));
 	}
+
+	if (!GaitBinding.IsBuilt())
+	{
+		InitializeGaitBinding();
+	}
+
+	if (bReplicateGait)
+	{
+		SetIsReplicated(true);
+	}
+
+	if (UGaitSignificanceSubsystem* Significance = UWorld::GetSubsystem<UGaitSignificanceSubsystem>(GetWorld()))
+	{
+		Significance->RegisterInstance(this);
+	}
+
+#if WITH_EDITOR
+	// Pick up LOD settings edited while playing.
+	SettingsChangedHandle = UNobunanimSettings::OnSettingsChanged().AddUObject(this, &UProceduralGaitControllerComponent::UpdateTickInterval);
+#endif
 }
 
+void UProceduralGaitControllerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ExitGaitDormancy();
+
+#if WITH_EDITOR
+	UNobunanimSettings::OnSettingsChanged().Remove(SettingsChangedHandle);
+#endif
+
+	if (UGaitSignificanceSubsystem* Significance = UWorld::GetSubsystem<UGaitSignificanceSubsystem>(GetWorld()))
+	{
+		Significance->UnregisterInstance(this);
+	}
 
+	Super::EndPlay(EndPlayReason);
+}
 
-bool UProceduralGaitControllerComponent::TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius)
+void UProceduralGaitControllerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// The owner drives its own gait.
+	DOREPLIFETIME_CONDITION(UProceduralGaitControllerComponent, ReplicatedGaitState, COND_SimulatedOnly);
+}
+
+
+#pragma region GAIT SIGNIFICANCE INTERFACE
+
+bool UProceduralGaitControllerComponent::GetSignificanceInputs(FGaitSignificanceInputs& OutInputs)
+{
+	if (!OwnedMesh || !IsComponentTickEnabled())
+	{
+		return false;
+	}
+
+	OutInputs.Location = OwnedMesh->Bounds.Origin;
+	OutInputs.BoundsRadius = OwnedMesh->Bounds.SphereRadius;
+	OutInputs.bVisible = OwnedMesh->WasRecentlyRendered(0.2f);
+	OutInputs.Importance = GaitImportance;
+	OutInputs.NaturalLOD = OwnedMesh->PredictedLODLevel;
+	// Ground adaptation and stance correction, at most one each per slot.
+	OutInputs.TracesPerUpdate = GaitBinding.NumSlots() * 2;
+	return true;
+}
+
+void UProceduralGaitControllerComponent::ApplySignificance(float Significance, int32 MinLOD)
+{
+	GaitSignificance = Significance;
+	SignificanceMinLOD = MinLOD;
+}
+
+UObject* UProceduralGaitControllerComponent::GetSignificanceObject()
+{
+	return this;
+}
+
+#pragma endregion
+
+
+#pragma region GAIT EVALUATION SINK
+
+void UProceduralGaitControllerComponent::EmitEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed)
+{
+	AnimInstanceRef->Execute_UpdateEffectorTranslation(AnimInstanceRef, Key, Translation, bLerp, LerpSpeed);
+}
+
+void UProceduralGaitControllerComponent::EmitEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed)
+{
+	AnimInstanceRef->Execute_UpdateEffectorRotation(AnimInstanceRef, Key, Rotation, LerpSpeed);
+}
+
+void UProceduralGaitControllerComponent::EmitGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location)
+{
+	RaiseGaitEvent(Type, Key, Location);
+}
+
+FVector UProceduralGaitControllerComponent::GetCorrectionOrigin(int32 Slot, const FName& SocketName)
+{
+	return SocketName.IsNone() ? SocketCache.GetWorldLocation(Slot) : SocketCache.GetWorldLocation(OwnedMesh, SocketName);
+}
+
+bool UProceduralGaitControllerComponent::TraceCorrection(int32 Slot, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, FVector& OutImpactPoint)
+{
+	TArray<FHitResult>& HitResults = TraceHits;
+	if (!TraceRay(GetWorld(), HitResults, Origin, Dest, TraceChannel, SPHERECAST_IK_CORRECTION_RADIUS, FGaitAsyncTraceQueue::MakeKey(Slot, EGaitAsyncTraceKind::Correction)))
+	{
+		return false;
+	}
+
+	const FHitResult& HitResult = GetBestHitResult(HitResults, Origin);
+	OutImpactPoint = HitResult.ImpactPoint;
+	return HitResult.bBlockingHit;
+}
+
+#if WITH_EDITOR
+void UProceduralGaitControllerComponent::DrawCorrectionDebug(const FVector& Location)
+{
+	DrawDebugPoint(GetWorld(), Location, 10.f, FColor::Red, false, 3.f);
+}
+
+void UProceduralGaitControllerComponent::DrawEffectorDebug(const FVector& Position, const FVector& EffectorLocation, const FVector& CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData)
+{
+	DrawGaitDebug(Position, EffectorLocation, CurrentLocation, Treshold, bAutoAdjustWithIdealEffector, bForceSwing, DebugData);
+}
+#endif
+
+#pragma endregion
+
+
+
+bool UProceduralGaitControllerComponent::TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius, int32 AsyncKey, bool bUseGroundCache)
 {
 	const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
 	
-	// if correction Level0 then zero computation.
-	if (LODSetting.CorrectionLevel == ENobunanimIKCorrectionLevel::IKL_Level0)
+	HitResults.Reset();
+
+	// if correction Level0 (or phase only off screen) then zero computation.
+	if (LODSetting.CorrectionLevel == ENobunanimIKCorrectionLevel::IKL_Level0 || OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly)
 	{
 		return false;
 	}
 
-	FCollisionQueryParams SweepParam(*GetOwner()->GetName(), LODSetting.bTraceOnComplex, GetOwner());
+	// Static trace tag: building one from the owner name would allocate each trace.
+	FCollisionQueryParams SweepParam(SCENE_QUERY_STAT(ProceduralGaitTrace), LODSetting.bTraceOnComplex, GetOwner());
+
+	UGaitGroundCacheSubsystem* GroundCache = bUseGroundCache && UGaitGroundCacheSubsystem::IsCacheable(Origin, Dest) ? UGaitGroundCacheSubsystem::Get(World) : nullptr;
+	const FGaitGroundQuery GroundQuery{ TraceChannel, false, LODSetting.bTraceOnComplex };
+	if (GroundCache)
+	{
+		FHitResult CachedHit;
+		if (GroundCache->FindGround(Origin, Dest, GroundQuery, World->GetTimeSeconds(), CachedHit))
+		{
+			HitResults.Reset();
+			HitResults.Add(CachedHit);
+			return true;
+		}
+	}
+
+	if (AsyncKey != INDEX_NONE && LODSetting.bUseAsyncTraces)
+	{
+		const bool bSweepFallback = LODSetting.CorrectionLevel == ENobunanimIKCorrectionLevel::IKL_Level2;
+		return AsyncTraces.Trace(AsyncKey, Origin, Dest, TraceChannel, SphereCastRadius, bSweepFallback, SweepParam, GetOwner()->GetVelocity(), World->GetTimeSeconds(), LODSetting.bExtrapolateAsyncTraces, HitResults);
+	}
 
+	FGaitQueryCounters::AddTrace();
 	bool bFoundHit = World->LineTraceMultiByChannel
 	(
 		HitResults,
@@ -111,6 +264,12 @@ bool UProceduralGaitControllerComponent::TraceRay(UWorld* World, TArray<FHitResu
 		FCollisionResponseParams::DefaultResponseParam
 	);
 
+	// Only plain line traces are cached: sweep hits aren't under the trace.
+	if (GroundCache)
+	{
+		GroundCache->StoreGround(Origin, Dest, GroundQuery, World->GetTimeSeconds(), HitResults);
+	}
+
 #if WITH_EDITOR
 	if (LODSetting.Debug.bShowCollisionCorrection)
 	{
@@ -125,6 +284,7 @@ bool UProceduralGaitControllerComponent::TraceRay(UWorld* World, TArray<FHitResu
 
 	if (!bFoundHit)
 	{
+		FGaitQueryCounters::AddSweep();
 		bFoundHit = World->SweepMultiByChannel
 		(
 			HitResults,
@@ -174,17 +334,21 @@ void UProceduralGaitControllerComponent::TickComponent(float DeltaTime, ELevelTi
 	NOBUNANIM_SCOPE_COUNTER(ProceduralGait_Tick);
 
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	
 
-	FVector NewCurrentLocation;
-	FVector IdealEffectorLocation;
-	FVector CurrentEffectorLocation;
-	float Treshold = 0.f;
-	bool bForceSwing = false;
-	bool bAllEffectorBlendOutEnd = true;
+	UpdateOffscreenPolicy();
+	if (OffscreenPolicy == EGaitOffscreenPolicy::Suspend)
+	{
+		return;
+	}
+
+	// A gait edited while playing rebuilt its runtime table: slots and effector indices may have changed.
+	if (GaitBinding.IsOutdated())
+	{
+		InitializeGaitBinding();
+	}
 	
 	UWorld* World = GetWorld();
-	FVector CurrentVelocity = GetOwner()->GetVelocity();
+	bIdleGaitUpdate = false;
 
 	if (!bGaitActive)
 	{
@@ -200,346 +364,48 @@ void UProceduralGaitControllerComponent::TickComponent(float DeltaTime, ELevelTi
 	}
 
 	// Update Gaits Data.
-	if (bGaitActive && GaitsData.Contains(CurrentGaitMode))
+	if (bGaitActive && GaitState.CurrentGaitIndex != INDEX_NONE)
 	{
-		const UGaitDataAsset& CurrentAsset = *GaitsData[CurrentGaitMode];
-
-		//if (bGaitActive)
-		//{
-		UpdateEffectors(CurrentAsset);
+		UpdateEffectors(GaitState.CurrentGaitIndex);
 		if (bLastFrameWasDisable)
 		{
 			bLastFrameWasDisable = false;
+			AsyncTraces.Flush(World, this);
 			return;
 		}
-		//}
-
-		bool bZeroVelocity = CurrentVelocity.SizeSquared() == 0.f;
-		bool bCond = CurrentAsset.bComputeWithVelocityOnly ? !bZeroVelocity : true;
-		
-		if (bCond)
-		{
-			if (!bZeroVelocity)
-			{
-				LastVelocity = CurrentVelocity;
-			}
-
-			AnimInstanceRef->Execute_SetProceduralGaitEnable(AnimInstanceRef, true);
-			
-			// Step 1: Timers.
-			TimeBuffer += (DeltaTime * CurrentAsset.GetFrameRatio() * PlayRate);
-			CurrentTime = FMath::Fmod(TimeBuffer, 1.f);
-
-			TArray<FName> SwingValuesKeys;
-			CurrentAsset.GaitSwingValues.GetKeys(SwingValuesKeys);
-
-			// Step 2: Foreach swing values, we will check if we are in 'Swing' or 'Stance' according to @CurrentTime.
-			for (int j = 0, m = SwingValuesKeys.Num(); j < m; ++j)
-			{
-				FName Key = SwingValuesKeys[j];
-				const FGaitSwingData& CurrentData = CurrentAsset.GaitSwingValues[Key];
-
-				if (Effectors.Contains(Key))
-				{
-					FGaitEffectorData& Effector = Effectors[Key];
-
-					// Update blend value
-					{
-						// If there isn't any pending gait, so it's a blend in
-						if (PendingGaitMode.IsNone() || Effector.CurrentGait == PendingGaitMode)
-						{
-							if (CurrentData.BlendData.BlendInTime == 0)
-							{
-								Effector.CurrentBlendValue = 1.f;
-							}
-							else
-							{
-								bBlendIn = true;
-								if (Effector.CurrentBlendValue < 1.f)
-								{
-									Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue + (DeltaTime / CurrentData.BlendData.BlendInTime), 0.f, 1.f);
-								}
-							}
-
-							if (PendingGaitMode.IsNone())
-							{
-								bAllEffectorBlendOutEnd = false;
-							}
-						}
-						else
-						{
-							if (CurrentData.BlendData.BlendOutTime == 0)
-							{
-								Effector.CurrentBlendValue = 0.f;
-								Effector.CurrentGait = PendingGaitMode;
-							}
-							else
-							{
-								bBlendIn = false;
-								if (Effector.CurrentBlendValue > 0.f)
-								{
-									Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue - (DeltaTime / CurrentData.BlendData.BlendOutTime), 0.f, 1.f);
-								}
-
-								// if end blend out, swap gait.
-								if (Effector.CurrentBlendValue == 0.f)
-								{
-									Effector.CurrentGait = PendingGaitMode;
-								}
-							}
-							bAllEffectorBlendOutEnd = false;
-						}
-					}
-
-					// no need to check, check is made when @UpdateGaitMode.
-					const UGaitDataAsset& UpdatedCurrentAsset = *GaitsData[Effector.CurrentGait.IsNone() ? CurrentGaitMode : Effector.CurrentGait];
-					if (UpdatedCurrentAsset.GaitSwingValues.Contains(Key))
-					{
-						const FGaitSwingData& UpdatedCurrentData = UpdatedCurrentAsset.GaitSwingValues[Key];
-
-						// Step 2.1: Check if valid swing data.
-						/*if (Effector.bForceSwing)
-						{
-							if (!CurrentData.CorrectionData.CorrectionSwingTranslationCurve)
-							{
-								DEBUG_LOG_FORMAT(Warning, "Correction is query but there is no valid CorrectionSwingTranslationCurve. From actor %s.", *GetOwner()->GetName());
-								continue;
-							}
-						}*/
-						/*else if ((!CurrentData.TranslationData.SwingTranslationCurve || CurrentData.TranslationData.TranslationFactor == FVector::ZeroVector)
-							&& (!CurrentData.RotationData.SwingRotationCurve || CurrentData.RotationData.RotationFactor == FVector::ZeroVector))
-						{
-							continue;
-						}*/
-
-						bool bCanCompute = Effector.BlockTime == -1.f
-							|| (Effector.BlockTime > UpdatedCurrentData.BeginSwing && CurrentTime >= Effector.BlockTime)
-							|| (Effector.BlockTime < UpdatedCurrentData.BeginSwing && CurrentTime < UpdatedCurrentData.BeginSwing && CurrentTime >= Effector.BlockTime);
-
-						if (bCanCompute)
-						{
-							float MinRange, MaxRange;
-							bool InRange = IsInRange(CurrentTime,
-								Effector.bForceSwing ? Effector.BeginForceSwingInterval : UpdatedCurrentData.BeginSwing,
-								Effector.bForceSwing ? Effector.EndForceSwingInterval : UpdatedCurrentData.EndSwing,
-								MinRange, MaxRange);
-
-							// Step 2.2: If the effector is in 'Swing'.
-							if (InRange)
-							{
-								Effector.bCorrectionIK = false;
-
-								float CurrentCurvePosition = FMath::GetMappedRangeValueClamped(FVector2D(MinRange, MaxRange), FVector2D(0.f, 1.f), CurrentTime);
-								float lerpSpeed = UpdatedCurrentData.TranslationData.LerpSpeed * (Effector.CurrentBlendValue == 1.f ? 1.f : (bBlendIn ? (UpdatedCurrentData.BlendData.BlendInAcceleration ? UpdatedCurrentData.BlendData.BlendInAcceleration->GetFloatValue(Effector.CurrentBlendValue) : 1.f) : (UpdatedCurrentData.BlendData.BlendOutAcceleration ? UpdatedCurrentData.BlendData.BlendOutAcceleration->GetFloatValue(Effector.CurrentBlendValue) : 1.f)));
-
-								// Step 2.2.1: Apply 'Swing' rotation (for bones).
-								if (UpdatedCurrentData.RotationData.bAffectEffector)
-								{
-									FVector CurrentCurveValue = UpdatedCurrentData.RotationData.RotationFactor * (UpdatedCurrentData.RotationData.SwingRotationCurve ? 
-										UpdatedCurrentData.RotationData.SwingRotationCurve->GetVectorValue(CurrentCurvePosition) : FVector(1, 1, 1));
-								
-									AnimInstanceRef->Execute_UpdateEffectorRotation(AnimInstanceRef, Key, FRotator(CurrentCurveValue.X, CurrentCurveValue.Y, CurrentCurveValue.Z)/*OwnedMesh->GetComponentRotation().RotateVector(CurrentCurveValue).Rotation()*/, lerpSpeed);
-								}
-
-								// Step 2.2.1: Apply 'Swing' translation (for effectors IK(socket)).
-								//if (UpdatedCurrentData.TranslationData.SwingTranslationCurve || (Effector.bForceSwing && UpdatedCurrentData.CorrectionData.CorrectionSwingTranslationCurve))
-								if (UpdatedCurrentData.TranslationData.bAffectEffector)
-								{
-									FVector CurrentCurveValue = UpdatedCurrentData.TranslationData.TranslationFactor * UpdatedCurrentData.TranslationData.TranslationSwingScale
-										* (Effector.bForceSwing ? (UpdatedCurrentData.CorrectionData.CorrectionSwingTranslationCurve ? UpdatedCurrentData.CorrectionData.CorrectionSwingTranslationCurve->GetVectorValue(CurrentCurvePosition) : FVector(1, 1, 1))
-											: (UpdatedCurrentData.TranslationData.SwingTranslationCurve ? UpdatedCurrentData.TranslationData.SwingTranslationCurve->GetVectorValue(CurrentCurvePosition) : FVector(1, 1, 1)));
-
-									CurrentCurveValue = UpdatedCurrentData.TranslationData.bOrientToVelocity ?
-										ORIENT_TO_VELOCITY(CurrentCurveValue) : OwnedMesh->GetComponentRotation().RotateVector(CurrentCurveValue);
-
-									FVector Offset = UpdatedCurrentData.TranslationData.Offset * UpdatedCurrentData.TranslationData.TranslationFactor;
-									Offset = UpdatedCurrentData.TranslationData.bOrientToVelocity ?
-										ORIENT_TO_VELOCITY(Offset) : OwnedMesh->GetComponentRotation().RotateVector(Offset);
-
-									CurrentEffectorLocation = Effector.CurrentEffectorLocation;
-									IdealEffectorLocation = Effector.IdealEffectorLocation;
-									NewCurrentLocation = Effector.IdealEffectorLocation + Offset + CurrentCurveValue;
-									Treshold = UpdatedCurrentData.CorrectionData.DistanceTresholdToAdjust;
-									bForceSwing = Effector.bForceSwing;
-
-									if (UpdatedCurrentData.TranslationData.bAdaptToGroundLevel)
-									{
-										NewCurrentLocation.Z += Effector.IdealEffectorLocation.Z - Effector.GroundLocation.Z;
-									}
-
-									AnimInstanceRef->Execute_UpdateEffectorTranslation(AnimInstanceRef, Key, NewCurrentLocation, !bLastFrameWasDisable, lerpSpeed);
-
-									Effector.CurrentEffectorLocation = NewCurrentLocation;
-								}
-							}
-							// Step 2.3: If the effector is in 'Stance'.
-							else
-							{
-								if (Effector.bForceSwing)
-								{
-									Effector.BlockTime = UpdatedCurrentData.EndSwing >= 0.99f ? 0.f : UpdatedCurrentData.EndSwing;
-								}
-								else
-								{
-									Effector.BlockTime = -1.f;
-
-									// check for foot ik.
-									if (!bLastFrameWasDisable && World && !Effector.bCorrectionIK && UpdatedCurrentData.CorrectionData.bComputeCollision)
-									{
-										//const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
-										if (LODSetting.bCanComputeCollisionCorrection)
-										{
-											NOBUNANIM_SCOPE_COUNTER(ProceduralGait_StanceIKCorrection);
-
-											// Get origin for IK
-											FVector Origin;
-											if (UpdatedCurrentData.CorrectionData.bUseCurrentEffector)
-											{
-												Origin = Effector.CurrentEffectorLocation;
-											}
-											else
-											{
-												Origin = UpdatedCurrentData.CorrectionData.OriginCollisionSocketName.IsNone() ?
-													OwnedMesh->GetSocketLocation(Key) :
-													OwnedMesh->GetSocketLocation(UpdatedCurrentData.CorrectionData.OriginCollisionSocketName);
-											}
-											FVector Dir = UpdatedCurrentData.CorrectionData.bOrientToVelocity ? ORIENT_TO_VELOCITY(UpdatedCurrentData.CorrectionData.AbsoluteDirection) : UpdatedCurrentData.CorrectionData.AbsoluteDirection;
-
-											// Get Dest
-											FVector Dest = Origin + Dir;
-
-											// Add inverse absolute direction
-											Origin -= Dir;
-
-											FCollisionQueryParams SweepParam(*GetOwner()->GetName(), false, GetOwner());
-											TArray<FHitResult> HitResults;
-											bool bFoundHit = TraceRay(World, HitResults, Origin, Dest, UpdatedCurrentData.CorrectionData.TraceChannel, SPHERECAST_IK_CORRECTION_RADIUS);
-
-
-											if (bFoundHit)
-											{
-
-												FHitResult& HitResult = GetBestHitResult(HitResults, Origin);
-
-												{
-#if WITH_EDITOR
-													if (LODSetting.Debug.bShowCollisionCorrection)
-													{
-														if (HitResult.bBlockingHit)
-														{
-															DrawDebugPoint(World, HitResult.ImpactPoint + ORIENT_TO_VELOCITY(UpdatedCurrentData.CorrectionData.CollisionSnapOffset), 10.f, FColor::Red, false, 3.f);
-														}
-													}
-#endif
-												}
-
-												// if hit ground
-												if (HitResult.bBlockingHit)
-												{
-													Effector.CurrentEffectorLocation = HitResult.ImpactPoint + ORIENT_TO_VELOCITY(UpdatedCurrentData.CorrectionData.CollisionSnapOffset);
-													Effector.bCorrectionIK = true;
-													if (UpdatedCurrentData.EventData.bRaiseOnCollisionEvent)
-													{
-														OnCollisionEvent.Broadcast(Key, Effector.CurrentEffectorLocation);
-													}
-												}
-											}
-										}
-									}
-
-									AnimInstanceRef->Execute_UpdateEffectorTranslation(AnimInstanceRef, Key, Effector.CurrentEffectorLocation, !bLastFrameWasDisable, UpdatedCurrentData.TranslationData.LerpSpeed);
-								}
-
-								bForceSwing = Effector.bForceSwing = false;
-								//Effector.BeginForceSwingInterval = CurrentAsset.GaitSwingValues[Key].BeginSwing;
-								//Effector.EndForceSwingInterval = CurrentAsset.GaitSwingValues[Key].EndSwing;
-
-								CurrentEffectorLocation = Effector.CurrentEffectorLocation;
-								IdealEffectorLocation = Effector.IdealEffectorLocation;
-								NewCurrentLocation = CurrentEffectorLocation;// Effector.IdealEffectorLocation + TranslationData.Offset + CurrentCurveValue;
-								Treshold = UpdatedCurrentData.CorrectionData.DistanceTresholdToAdjust;
-
-								// Step 2.3.1: Check if the effector need to be adjusted
-								if (!bLastFrameWasDisable && CurrentAsset.GaitSwingValues[Key].CorrectionData.bAutoAdjustWithIdealEffector)
-								{
-									float VectorLength = (Effector.CurrentEffectorLocation - Effector.IdealEffectorLocation).Size2D();
-
-									// Is the distance breaking treshold?
-									if (VectorLength >= CurrentAsset.GaitSwingValues[Key].CorrectionData.DistanceTresholdToAdjust)
-									{
-										// Here we compute the new interval of swing.
-										float Begin = CurrentAsset.GaitSwingValues[Key].BeginSwing;
-										float End = CurrentAsset.GaitSwingValues[Key].EndSwing;
-
-										float Alpha = 0.f;
-										if (Begin > End)
-										{
-											Alpha = (1.f - Begin) + End;
-										}
-										else
-										{
-											Alpha = End - Begin;
-										}
-
-										float Beta = CurrentTime + Alpha;
-										// if the end swing is > 1 (absolute time) we just consider that the swing will end the next cycle.
-										if (Beta >= 1.f)
-										{
-											Beta -= 1.f;
-										}
-
-										Effector.BeginForceSwingInterval = CurrentTime;
-										Effector.EndForceSwingInterval = Beta;
-										bForceSwing = Effector.bForceSwing = true;
-										Effector.BlockTime = -1.f;
-									}
-								}
-
-
-							}
-
-#if WITH_EDITOR
-							// Step 3: Draw Debug.
-							{
-								DrawGaitDebug(NewCurrentLocation, IdealEffectorLocation, CurrentEffectorLocation, Treshold,
-									CurrentAsset.GaitSwingValues[Key].CorrectionData.bAutoAdjustWithIdealEffector, bForceSwing,
-									&CurrentAsset.GaitSwingValues[Key].DebugData);
-							}
-#endif
-						}
-					}
-				}
-			}
-
-			// Step 3: if all effector end blend out swtich gait
-			if (bAllEffectorBlendOutEnd == true)
-			{
-				CurrentGaitMode = PendingGaitMode;
-				PendingGaitMode = "";
-			}
-		}
-		else
-		{
-			CurrentTime = 0;
-			AnimInstanceRef->Execute_SetProceduralGaitEnable(AnimInstanceRef, false);
-		}
 
+		FGaitEvaluationInputs Inputs;
+		Inputs.Binding = &GaitBinding;
+		Inputs.LODSetting = &LODSetting;
+		Inputs.EvaluationCache = UGaitEvaluationCacheSubsystem::Get(World);
+		Inputs.OffscreenPolicy = OffscreenPolicy;
+		Inputs.DeltaTime = DeltaTime;
+		Inputs.PlayRate = PlayRate;
+		Inputs.Velocity = GetOwner()->GetVelocity();
+		Inputs.ComponentRotation = OwnedMesh->GetComponentRotation();
+		Inputs.UpdateCounter = GaitUpdateCounter;
+		Inputs.TracePhase = GetUniqueID();
+		Inputs.bCanTrace = World != nullptr;
+		Inputs.bShowDebug = bShowDebug;
+
+		AnimInstanceRef->Execute_SetProceduralGaitEnable(AnimInstanceRef, FGaitEvaluator::IsGaitPlaying(GaitState, Inputs));
+		bIdleGaitUpdate = FGaitEvaluator::Evaluate(GaitState, Inputs, *this) == EGaitEvaluationResult::Idle;
 	}
 	else
 	{
-		CurrentTime = 0;
+		GaitState.CurrentTime = 0;
 		if (AnimInstanceRef)
 		{
 			AnimInstanceRef->Execute_SetProceduralGaitEnable(AnimInstanceRef, false);
 		}
 	}
 
-#if WITH_EDITOR
-	UpdateLOD(true);
-#else
+	AsyncTraces.Flush(World, this);
+
 	UpdateLOD();
-#endif
-	
+
+	RefreshReplicatedGaitState(false);
+	UpdateGaitDormancy();
 }
 
 void UProceduralGaitControllerComponent::ComputeCollisionCorrection(const FGaitCorrectionData* CorrectionData, FGaitEffectorData& Effector)
@@ -549,116 +415,155 @@ void UProceduralGaitControllerComponent::ComputeCollisionCorrection(const FGaitC
 
 void UProceduralGaitControllerComponent::UpdateGaitMode_Implementation(const FName& NewGaitName)
 {
-	if (GaitsData.Contains(NewGaitName))
+	if (!GaitBinding.IsBuilt())
+	{
+		InitializeGaitBinding();
+	}
+
+	const int32 NewGaitIndex = GaitBinding.FindGait(NewGaitName);
+	if (NewGaitIndex != INDEX_NONE)
 	{
-		if (CurrentGaitMode != NewGaitName)
+		if (GaitState.CurrentGaitIndex != NewGaitIndex)
 		{
-			if (CurrentGaitMode.IsNone() || CurrentGaitMode == "None")
+			if (GaitState.CurrentGaitIndex == INDEX_NONE)
 			{
-				CurrentGaitMode = NewGaitName;
+				GaitState.CurrentGaitIndex = NewGaitIndex;
 			}
 			else
 			{
-				PendingGaitMode = NewGaitName;
+				GaitState.PendingGaitIndex = NewGaitIndex;
+			}
+
+			// Swing windows change with the gait.
+			for (FGaitEffectorData& Effector : GaitState.Effectors)
+			{
+				Effector.PlantedUntil = -1.f;
 			}
+
 			//CurrentGaitMode = NewGaitName;
+			ExitGaitDormancy();
 			SetComponentTickEnabled(true);
+			RefreshReplicatedGaitState(true);
 		}
 	}
 	else
 	{
+		ExitGaitDormancy();
 		SetComponentTickEnabled(false);
 		//DEBUG_LOG_FORMAT(Warning, "Invalid NewGaitName %s. There is no gait data corresponding. Ignored.", NewGaitName);
 	}
 }
 
-void UProceduralGaitControllerComponent::UpdateEffectors(const UGaitDataAsset& CurrentAsset)
+void UProceduralGaitControllerComponent::InitializeGaitBinding()
 {
-	NOBUNANIM_SCOPE_COUNTER(ProceduralGait_UpdateEffectors);
+	// Rebinding (gaits edited while playing) keeps playing the same gaits.
+	const FName CurrentGaitName = GaitBinding.GetGaitName(GaitState.CurrentGaitIndex);
+	const FName PendingGaitName = GaitBinding.GetGaitName(GaitState.PendingGaitIndex);
 
-	TArray<FName> Keys;
-	GaitsData.GetKeys(Keys);
+	GaitBinding.Build(GaitsData);
+	AsyncTraces.Reset();
+	BuildSocketCache();
 
-	for (int i = 0, n = Keys.Num(); i < n; ++i)
-	{
-		TArray<FName> SwingValuesKeys;
-		TMap<FName, FGaitSwingData>& SwingValues = GaitsData[Keys[i]]->GaitSwingValues;
-		SwingValues.GetKeys(SwingValuesKeys);
+	GaitState.Effectors.Reset();
+	GaitState.Effectors.SetNum(GaitBinding.NumSlots());
 
-		for (int j = 0, m = SwingValuesKeys.Num(); j < m; ++j)
-		{
-			FName Key = SwingValuesKeys[j];
-			FVector EffectorLocation = OwnedMesh->GetSocketLocation(Key);
-			if (Effectors.Contains(Key))
-			{
-				Effectors[Key].IdealEffectorLocation = EffectorLocation;
+	GaitState.CurrentGaitIndex = GaitBinding.FindGait(CurrentGaitName);
+	GaitState.PendingGaitIndex = GaitBinding.FindGait(PendingGaitName);
+}
 
-				if (CurrentAsset.GaitSwingValues.Contains(Key) && CurrentAsset.GaitSwingValues[Key].TranslationData.bAdaptToGroundLevel)
-				{
-					FVector GroundLocation;
-					TArray<FHitResult> HitResults;
-					bool bFound = TraceRay(GetWorld(), HitResults, EffectorLocation, EffectorLocation + FVector(0, 0, -100.f), ECollisionChannel::ECC_WorldStatic, SPHERECAST_IK_CORRECTION_RADIUS);
-					if (!bFound)
-					{
-						GroundLocation = EffectorLocation + FVector(0, 0, -100.f);
-					}
-					else
-					{
-						FHitResult& HitResult = GetBestHitResult(HitResults, EffectorLocation);
-						GroundLocation = HitResult.ImpactPoint;
-					}
+void UProceduralGaitControllerComponent::BuildSocketCache()
+{
+	SocketCache.Reset();
 
-					Effectors[Key].GroundLocation = GroundLocation;
-				}
+	// Slots come first: the socket index of a slot is the slot.
+	for (const FName& SlotName : GaitBinding.SlotNames)
+	{
+		SocketCache.AddSocket(SlotName);
+	}
 
-				if (bLastFrameWasDisable)
-				{
-					Effectors[Key].CurrentEffectorLocation = EffectorLocation;
-					AnimInstanceRef->Execute_UpdateEffectorTranslation(AnimInstanceRef, Key, EffectorLocation, false, 0);
-				}
+	for (int32 GaitIndex = 0, n = GaitBinding.NumGaits(); GaitIndex < n; ++GaitIndex)
+	{
+		for (const FGaitSwingData* SwingData : GaitBinding.GetTable(GaitIndex).SwingData)
+		{
+			if (!SwingData->TranslationData.GroundReferenceSocket.IsNone())
+			{
+				SocketCache.AddSocket(SwingData->TranslationData.GroundReferenceSocket);
 			}
-			else
+			if (!SwingData->CorrectionData.OriginCollisionSocketName.IsNone())
 			{
-				FGaitEffectorData Effector;
-				Effector.IdealEffectorLocation = EffectorLocation;
-				Effectors.Add(Key, Effector);
+				SocketCache.AddSocket(SwingData->CorrectionData.OriginCollisionSocketName);
 			}
 		}
 	}
 }
 
-
-bool UProceduralGaitControllerComponent::IsInRange(float Value, float Min, float Max, float& OutRangeMin, float& OutRangeMax)
+void UProceduralGaitControllerComponent::UpdateEffectors(int32 GaitIndex)
 {
-	bool A = Value >= Min && Value <= Max;
-	bool APrime = Value >= Max;
+	NOBUNANIM_SCOPE_COUNTER(ProceduralGait_UpdateEffectors);
 
-	// Gave me headache ._.
-	OutRangeMin = A ? Min : (APrime ? Min : Min - 1.f);
-	OutRangeMax = A ? Max : (APrime ? 1.f /*- Min + Min*/ + Max : Max);
+	SocketCache.Refresh(OwnedMesh);
+	++GaitUpdateCounter;
 
-	if (A)
-	{
-		return true;
-	}
-	else
+	const FProceduralGaitLODSettings& LODSetting = UNobunanimSettings::GetLODSetting(CurrentLOD);
+
+	// Every slot is refreshed, so effectors of the other gaits are ready when blending to them.
+	for (int32 Slot = 0, n = GaitBinding.NumSlots(); Slot < n; ++Slot)
 	{
-		bool B1 = Value <= Min && Value <= Max;
-		bool B2 = Value >= Min && Value >= Max;
-		bool B3 = B1 || B2;
-		bool C = Min >= Max && B3;
+		const FName Key = GaitBinding.SlotNames[Slot];
+		FGaitEffectorData& Effector = GaitState.Effectors[Slot];
 
-		if (C)
+		FVector EffectorLocation = SocketCache.GetWorldLocation(Slot);
+		Effector.IdealEffectorLocation = EffectorLocation;
+
+		const int32 EffectorIndex = GaitBinding.GetEffector(GaitIndex, Slot);
+		const bool bAdaptToGroundLevel = EffectorIndex != INDEX_NONE && GaitBinding.GetTable(GaitIndex).Effectors[EffectorIndex].bAdaptToGroundLevel;
+		if (bAdaptToGroundLevel && !LODSetting.IsTracePhase(GaitUpdateCounter, Slot, GetUniqueID()))
 		{
-			return true;
+			// Off phase: keep the last ground adaptation.
+			Effector.GroundLocation = EffectorLocation + Effector.GroundOffset;
 		}
-		else
+		else if (bAdaptToGroundLevel)
 		{
-			return false;
+			FVector GroundLocation;
+			TArray<FHitResult>& HitResults = TraceHits;
+			bool bFound = TraceRay(GetWorld(), HitResults, EffectorLocation, EffectorLocation + FVector(0, 0, -100.f), ECollisionChannel::ECC_WorldStatic, SPHERECAST_IK_CORRECTION_RADIUS, FGaitAsyncTraceQueue::MakeKey(Slot, EGaitAsyncTraceKind::Ground), true);
+			if (!bFound)
+			{
+				GroundLocation = EffectorLocation + FVector(0, 0, -100.f);
+			}
+			else
+			{
+				FHitResult& HitResult = GetBestHitResult(HitResults, EffectorLocation);
+				GroundLocation = HitResult.ImpactPoint;
+			}
+
+			Effector.GroundLocation = GroundLocation;
+			Effector.GroundOffset = GroundLocation - EffectorLocation;
+		}
+
+		if (bLastFrameWasDisable)
+		{
+			Effector.CurrentEffectorLocation = EffectorLocation;
+			AnimInstanceRef->Execute_UpdateEffectorTranslation(AnimInstanceRef, Key, EffectorLocation, false, 0);
 		}
 	}
 }
 
+void UProceduralGaitControllerComponent::RaiseGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location)
+{
+	if (UGaitEventSubsystem* GaitEvents = UGaitEventSubsystem::Get(GetWorld()))
+	{
+		GaitEvents->QueueEvent({ this, GetOwner(), Key, Location, Type });
+	}
+
+	if (Type == EGaitEventType::Footfall && bBroadcastCollisionEvent)
+	{
+		OnCollisionEvent.Broadcast(Key, Location);
+	}
+}
+
+
+
 void UProceduralGaitControllerComponent::DrawGaitDebug(FVector Position, FVector EffectorLocation, FVector CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData)
 {
 	if (bShowDebug && DebugData->bDrawDebug)
@@ -673,7 +578,7 @@ void UProceduralGaitControllerComponent::DrawGaitDebug(FVector Position, FVector
 			DrawDebugLine(World, EffectorLocation, Position, FColor(255.f, 255.f, 255.f), false, 0.f, 0, 0.5f);
 			//DrawDebugLine(World, CurrentLocation, EffectorLocation, FColor(255.f, 0.f, 0.f), false, 0.f, 0, 1.f);
 
-			FRotator Rot = LastVelocity.Rotation();
+			FRotator Rot = GaitState.LastVelocity.Rotation();
 			DrawDebugDirectionalArrow(World, EffectorLocation, EffectorLocation + (Rot.RotateVector(FVector::ForwardVector) * 10.f), 1, DebugData->VelocityColor, false, 0, 0, 1.f);
 			
 			if (bAutoAdjustWithIdealEffector)
@@ -712,10 +617,209 @@ void UProceduralGaitControllerComponent::ShowGaitLOD()
 
 void UProceduralGaitControllerComponent::UpdateLOD(bool bForceUpdate)
 {
-	if (CurrentLOD != OwnedMesh->PredictedLODLevel
-		|| bForceUpdate)
+	// The gait budget can push the LOD further than the mesh.
+	const int32 PredictedLOD = FMath::Max(OwnedMesh->PredictedLODLevel, SignificanceMinLOD);
+	if (!bForceUpdate)
+	{
+		if (PredictedLOD == CurrentLOD)
+		{
+			PendingLOD = INDEX_NONE;
+			return;
+		}
+
+		// Hysteresis: the new LOD must be kept for a while before being applied.
+		const float Now = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+		if (PredictedLOD != PendingLOD)
+		{
+			PendingLOD = PredictedLOD;
+			PendingLODStartTime = Now;
+		}
+
+		if (Now - PendingLODStartTime < UNobunanimSettings::GetLODHysteresisTime())
+		{
+			return;
+		}
+	}
+
+	PendingLOD = INDEX_NONE;
+	CurrentLOD = PredictedLOD;
+	UpdateTickInterval();
+}
+
+void UProceduralGaitControllerComponent::UpdateTickInterval()
+{
+	const int32 TargetFPS = UNobunanimSettings::GetLODSetting(CurrentLOD).GetEffectiveTargetFPS(OffscreenPolicy);
+	const float Interval = 1.f / (float)FMath::Max(TargetFPS, 1);
+	if (FMath::IsNearlyEqual(Interval, GetComponentTickInterval()))
+	{
+		// The cooldown below postpones the next tick: only apply it when the rate actually changes.
+		return;
+	}
+
+	if (UNobunanimSettings::IsGaitUpdateAmortizationEnabled())
+	{
+		// Delay the next tick by the phase of this component, so components changing rate together don't tick together.
+		SetComponentTickIntervalAndCooldown(Interval * (1.f + UGaitSchedulerSubsystem::GetUpdatePhase(this)));
+	}
+	SetComponentTickInterval(Interval);
+}
+
+void UProceduralGaitControllerComponent::UpdateOffscreenPolicy()
+{
+	const UWorld* World = GetWorld();
+	const EGaitOffscreenPolicy NewPolicy = UNobunanimSettings::ResolveOffscreenPolicy(World ? World->GetNetMode() : NM_Standalone, CurrentLOD, OwnedMesh);
+
+	if (NewPolicy == OffscreenPolicy)
+	{
+		return;
+	}
+
+	// Leaving a policy without effector outputs: rebuild the pose like after a disable.
+	if (OffscreenPolicy == EGaitOffscreenPolicy::Suspend || OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly)
+	{
+		bLastFrameWasDisable = true;
+	}
+
+	const bool bRateChanged = OffscreenPolicy == EGaitOffscreenPolicy::ReducedRate || NewPolicy == EGaitOffscreenPolicy::ReducedRate;
+	OffscreenPolicy = NewPolicy;
+	if (bRateChanged)
+	{
+		UpdateTickInterval();
+	}
+}
+
+
+#pragma region GAIT DORMANCY
+
+void UProceduralGaitControllerComponent::WakeGait()
+{
+	if (!bGaitDormant)
+	{
+		return;
+	}
+
+	ExitGaitDormancy();
+	SetComponentTickEnabled(true);
+}
+
+void UProceduralGaitControllerComponent::UpdateGaitDormancy()
+{
+	UWorld* World = GetWorld();
+	if (!bIdleGaitUpdate || !World || !UNobunanimSettings::IsGaitDormancyEnabled())
+	{
+		IdleStartTime = -1.f;
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+	if (IdleStartTime < 0.f)
+	{
+		IdleStartTime = Now;
+	}
+	else if (Now - IdleStartTime >= UNobunanimSettings::GetGaitDormancyDelay())
+	{
+		EnterGaitDormancy();
+	}
+}
+
+void UProceduralGaitControllerComponent::EnterGaitDormancy()
+{
+	UWorld* World = GetWorld();
+	if (bGaitDormant || !OwnedMesh || !World)
+	{
+		return;
+	}
+
+	bGaitDormant = true;
+	IdleStartTime = -1.f;
+	SetComponentTickEnabled(false);
+
+	// Wake up on move or teleport of the mesh, or ground change around it.
+	DormantTransformHandle = OwnedMesh->TransformUpdated.AddUObject(this, &UProceduralGaitControllerComponent::OnDormantMeshTransformUpdated);
+	if (UGaitGroundCacheSubsystem* GroundCache = World->GetSubsystem<UGaitGroundCacheSubsystem>())
+	{
+		DormantGroundHandle = GroundCache->OnGroundChanged.AddUObject(this, &UProceduralGaitControllerComponent::OnDormantGroundChanged);
+	}
+}
+
+void UProceduralGaitControllerComponent::ExitGaitDormancy()
+{
+	if (!bGaitDormant)
 	{
-		SetComponentTickInterval(1.f / (float)UNobunanimSettings::GetLODSetting(CurrentLOD = OwnedMesh->PredictedLODLevel).TargetFPS);// LODTargetFPS[CurrentLOD = OwnedMesh->PredictedLODLevel]);
+		return;
 	}
+
+	bGaitDormant = false;
+	// The first tick after a wake up only rebuilds the pose, its delta time covers the whole dormancy.
+	bLastFrameWasDisable = true;
+
+	if (OwnedMesh)
+	{
+		OwnedMesh->TransformUpdated.Remove(DormantTransformHandle);
+	}
+	DormantTransformHandle.Reset();
+
+	UWorld* World = GetWorld();
+	if (UGaitGroundCacheSubsystem* GroundCache = World ? World->GetSubsystem<UGaitGroundCacheSubsystem>() : nullptr)
+	{
+		GroundCache->OnGroundChanged.Remove(DormantGroundHandle);
+	}
+	DormantGroundHandle.Reset();
+}
+
+void UProceduralGaitControllerComponent::OnDormantMeshTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	WakeGait();
+}
+
+void UProceduralGaitControllerComponent::OnDormantGroundChanged(const FBox& Bounds)
+{
+	if (!OwnedMesh || Bounds.Intersect(OwnedMesh->Bounds.GetBox()))
+	{
+		WakeGait();
+	}
+}
+
+#pragma endregion
+
+
+#pragma region GAIT REPLICATION
+
+FGaitReplicatedState UProceduralGaitControllerComponent::GetReplicatedGaitState() const
+{
+	return GaitState.GetReplicatedState(GaitBinding);
+}
+
+void UProceduralGaitControllerComponent::ApplyReplicatedGaitState(const FGaitReplicatedState& State)
+{
+	if (!GaitBinding.IsBuilt())
+	{
+		InitializeGaitBinding();
+	}
+
+	GaitState.ApplyReplicatedState(State, GaitBinding, [this](FName GaitName) { UpdateGaitMode(GaitName); });
+}
+
+void UProceduralGaitControllerComponent::OnRep_ReplicatedGaitState()
+{
+	ApplyReplicatedGaitState(ReplicatedGaitState);
+}
+
+void UProceduralGaitControllerComponent::RefreshReplicatedGaitState(bool bForce)
+{
+	if (!bReplicateGait || GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	if (!bForce && WorldTime - LastGaitStateRefreshTime < UNobunanimSettings::GetReplicationSettings().PhaseRefreshInterval)
+	{
+		return;
+	}
+
+	LastGaitStateRefreshTime = WorldTime;
+	ReplicatedGaitState = GetReplicatedGaitState();
 }
 
+#pragma endregion
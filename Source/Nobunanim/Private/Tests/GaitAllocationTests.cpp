@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Private/Tests/GaitTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Nobunanim/Public/AnimNodes/AnimNode_SafeCCDIK.h"
+
+
+namespace GaitTests
+{
+	/** Measured runs of an allocation test: the counters are process wide, a run disturbed by another thread is measured again. */
+	static constexpr int32 NumAllocationAttempts = 3;
+}
+
+
+/** STEADY STATE
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitZeroAllocationTest, "Nobunanim.Gait.Allocation.SteadyState", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitZeroAllocationTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	if (!FGaitAllocationCounter::IsSupported())
+	{
+		AddWarning(TEXT("The allocator of this build doesn't count its calls: allocations aren't measured."));
+		return true;
+	}
+
+	static constexpr int32 NumWarmUpFrames = 120;
+	static constexpr int32 NumMeasuredFrames = FGaitTestWalk::NumFrames;
+
+	// Sampled curves, then baked lookup tables.
+	for (int32 Bake = 0; Bake < 2; ++Bake)
+	{
+		FGaitTestRunner Runner(Bake == 1);
+		FGaitTestInstance& Instance = Runner.AddInstance(0);
+		Runner.Step(NumWarmUpFrames);
+
+		// Socket reads, ground reflection and ground traces, collision correction traces, deferred outputs and events: only the gait update is counted.
+		uint64 NumAllocations = 0;
+		int32 NumFootfalls = 0;
+		for (int32 Attempt = 0; Attempt < NumAllocationAttempts; ++Attempt)
+		{
+			FGaitAllocationCounter Counter;
+			for (int32 i = 0; i < NumMeasuredFrames; ++i)
+			{
+				Runner.BeginFrame();
+				Runner.PoseInstances();
+
+				Counter.Begin();
+				Runner.UpdateInstances();
+				Counter.End();
+				Runner.EndFrame();
+
+				NumFootfalls += Instance.AnimInstance->CountRecords(UGaitTestAnimInstance::FRecord::EType::CollisionEvent);
+			}
+
+			NumAllocations = Counter.NumAllocations;
+			if (NumAllocations == 0)
+			{
+				break;
+			}
+		}
+
+		const TCHAR* Mode = Bake == 1 ? TEXT("baked") : TEXT("sampled");
+		TestTrue(FString::Printf(TEXT("The %s walk is updated (footfalls)"), Mode), NumFootfalls > 0);
+		TestEqual(FString::Printf(TEXT("Allocations after warm up (%s curves)"), Mode), NumAllocations, (uint64)0);
+	}
+
+	return true;
+}
+
+
+/** SAFE CCDIK
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitSafeCCDIKAllocationTest, "Nobunanim.Gait.Allocation.SafeCCDIK", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitSafeCCDIKAllocationTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	if (!FGaitAllocationCounter::IsSupported())
+	{
+		AddWarning(TEXT("The allocator of this build doesn't count its calls: allocations aren't measured."));
+		return true;
+	}
+
+	// Vertical leg of 4 bones, solved toward targets around it, like the anim graph does every frame.
+	static constexpr int32 NumBones = 4;
+	const FVector BoneLocations[NumBones] = { FVector(0.f, 0.f, 120.f), FVector(0.f, 0.f, 80.f), FVector(0.f, 0.f, 40.f), FVector(0.f, 0.f, 0.f) };
+
+	FAnimNode_SafeCCDIK Node;
+#if WITH_EDITOR
+	Node.ResizeRotationLimitPerJoints(NumBones);
+#endif
+
+	TArray<FBoneTransform> BoneTransforms;
+	TArray<FTransform> LocalTransforms;
+	LocalTransforms.Reserve(NumBones);
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		LocalTransforms.Add(FTransform(Bone == 0 ? BoneLocations[0] : BoneLocations[Bone] - BoneLocations[Bone - 1]));
+	}
+
+	int32 NumSolved = 0;
+	auto Solve = [&](int32 Frame)
+	{
+		// The skeletal control base reuses its output array the same way.
+		BoneTransforms.Reset();
+		BoneTransforms.AddUninitialized(NumBones);
+		for (int32 Bone = 0; Bone < NumBones; ++Bone)
+		{
+			BoneTransforms[Bone] = FBoneTransform(FCompactPoseBoneIndex(Bone), FTransform(BoneLocations[Bone]));
+		}
+
+		const float Angle = Frame * 0.1f;
+		NumSolved += Node.SolveChain(BoneTransforms, LocalTransforms, FVector(30.f * FMath::Cos(Angle), 30.f * FMath::Sin(Angle), 20.f)) ? 1 : 0;
+	};
+
+	static constexpr int32 NumWarmUpFrames = 8;
+	static constexpr int32 NumMeasuredFrames = 240;
+
+	int32 Frame = 0;
+	for (int32 i = 0; i < NumWarmUpFrames; ++i)
+	{
+		Solve(Frame++);
+	}
+
+	uint64 NumAllocations = 0;
+	for (int32 Attempt = 0; Attempt < NumAllocationAttempts; ++Attempt)
+	{
+		FGaitAllocationCounter Counter;
+		Counter.Begin();
+		for (int32 i = 0; i < NumMeasuredFrames; ++i)
+		{
+			Solve(Frame++);
+		}
+		Counter.End();
+
+		NumAllocations = Counter.NumAllocations;
+		if (NumAllocations == 0)
+		{
+			break;
+		}
+	}
+
+#if WITH_EDITOR
+	// Joints can't rotate without rotation limits, only settable in editor builds.
+	TestTrue(TEXT("The chain is solved"), NumSolved > 0);
+#endif
+	TestEqual(TEXT("Allocations after warm up"), NumAllocations, (uint64)0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Private/Tests/GaitTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Nobunanim/Public/GaitCrowdEvaluator.h"
+
+
+/** ANIM INSTANCE PARITY
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitCrowdParityTest, "Nobunanim.Gait.Crowd.AnimInstanceParity", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitCrowdParityTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+	using FRecord = UGaitTestAnimInstance::FRecord;
+
+	/**
+	*	One agent per play rate: not a multiple of the SIMD width, so the last lanes are padding.
+	*	Rates keep the cycle times of the walk away from the swing window bounds, where rounding could classify a frame differently.
+	*/
+	static const float BasePlayRates[] = { 1.f, 0.8f, 1.25f, 0.9f, 0.7f, 0.95f, 1.3f, 0.65f, 1.35f, 0.75f };
+	static constexpr int32 NumAgents = UE_ARRAY_COUNT(BasePlayRates);
+	static constexpr int32 NumFrames = 2 * FGaitTestWalk::NumFrames;
+	static constexpr float LocationTolerance = 0.05f;
+	static constexpr float Tolerance = 1.e-3f;
+
+	// Reference: one gait anim instance per agent, updated by its front end.
+	FGaitTestRunner Runner(false, 0.2f);
+	for (int32 Agent = 0; Agent < NumAgents; ++Agent)
+	{
+		Runner.AddInstance(Agent, TEXT("Walk"), BasePlayRates[Agent]);
+	}
+
+	const UGaitDataAsset* Gait = Runner.Gaits.FindChecked(TEXT("Walk"));
+	const FGaitRuntimeTable& Table = Gait->GetRuntimeTable();
+	const int32 NumEffectors = Table.Num();
+	if (!TestEqual(TEXT("Effectors"), NumEffectors, NumLegs))
+	{
+		return false;
+	}
+
+	// Both start with every effector at the origin.
+	FGaitCrowdEvaluator Crowd;
+	Crowd.Initialize(Gait);
+	TArray<int32> AgentIds;
+	for (int32 Agent = 0; Agent < NumAgents; ++Agent)
+	{
+		AgentIds.Add(Crowd.AddAgent(FVector::ZeroVector, BasePlayRates[Agent]));
+	}
+
+	TArray<FGaitCrowdEffectorOutput> Outputs;
+	FVector Ideals[NumLegs];
+	FVector Grounds[NumLegs];
+	int32 NumCompared = 0;
+	int32 NumCorrections = 0;
+	int32 NumMismatches = 0;
+
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		Runner.Step();
+
+		// Same inputs as the instances: their effectors hold the socket and ground locations of this update.
+		for (int32 Agent = 0; Agent < NumAgents; ++Agent)
+		{
+			const FGaitTestInstance& Instance = *Runner.Instances[Agent];
+			const UGaitTestAnimInstance& AnimInstance = *Instance.AnimInstance;
+
+			for (int32 Effector = 0; Effector < NumEffectors; ++Effector)
+			{
+				const FGaitEffectorData& EffectorData = AnimInstance.GetGaitEffector(AnimInstance.GetGaitBinding().GetSlot(0, Effector));
+				Ideals[Effector] = EffectorData.IdealEffectorLocation;
+				Grounds[Effector] = EffectorData.GroundLocation;
+			}
+			Crowd.SetAgentInputs(AgentIds[Agent], Instance.Frame.Velocity, Instance.Frame.ComponentRotation, Ideals, Grounds);
+			Crowd.SetAgentPlayRate(AgentIds[Agent], Instance.BasePlayRate * Instance.Frame.PlayRate);
+		}
+
+		Crowd.Evaluate(Runner.World.GaitDeltaTime);
+
+		for (int32 Agent = 0; Agent < NumAgents; ++Agent)
+		{
+			const UGaitTestAnimInstance& AnimInstance = *Runner.Instances[Agent]->AnimInstance;
+			const int32 AgentId = AgentIds[Agent];
+
+			// The owner resolves the flagged collision corrections against the floor, like the instance trace does.
+			Crowd.GetAgentOutputs(AgentId, Outputs);
+			for (int32 Effector = 0; Effector < NumEffectors; ++Effector)
+			{
+				if (Outputs[Effector].bNeedsCorrection)
+				{
+					const FGaitCorrectionData& CorrectionData = Table.SwingData[Effector]->CorrectionData;
+					const FVector Origin = Outputs[Effector].Translation;
+
+					FHitResult Hit;
+					if (Runner.World.World->LineTraceSingleByChannel(Hit, Origin - CorrectionData.AbsoluteDirection, Origin + CorrectionData.AbsoluteDirection, CorrectionData.TraceChannel))
+					{
+						Crowd.ApplyCorrection(AgentId, Effector, Hit.ImpactPoint + AnimInstance.GetGaitLastVelocity().Rotation().RotateVector(CorrectionData.CollisionSnapOffset));
+						++NumCorrections;
+					}
+				}
+			}
+			Crowd.GetAgentOutputs(AgentId, Outputs);
+
+			for (int32 Effector = 0; Effector < NumEffectors; ++Effector)
+			{
+				const FName Key = Table.EffectorNames[Effector];
+				const FGaitCrowdEffectorOutput& Output = Outputs[Effector];
+
+				// Last outputs of the instance for this effector.
+				const FRecord* Translation = nullptr;
+				const FRecord* Rotation = nullptr;
+				for (const FRecord& Record : AnimInstance.Records)
+				{
+					if (Record.Key == Key)
+					{
+						Translation = Record.Type == FRecord::EType::Translation ? &Record : Translation;
+						Rotation = Record.Type == FRecord::EType::Rotation ? &Record : Rotation;
+					}
+				}
+
+				bool bMatch = Output.bTranslation == (Translation != nullptr) && Output.bRotation == (Rotation != nullptr);
+				if (bMatch && Translation)
+				{
+					bMatch = Output.Translation.Equals(Translation->Value, LocationTolerance) && Output.bLerp == Translation->bLerp
+						&& FMath::IsNearlyEqual(Output.LerpSpeed, Translation->LerpSpeed, Tolerance);
+				}
+				if (bMatch && Rotation)
+				{
+					bMatch = FVector(Output.Rotation.Pitch, Output.Rotation.Yaw, Output.Rotation.Roll).Equals(Rotation->Value, Tolerance);
+				}
+
+				if (!bMatch && NumMismatches++ < 10)
+				{
+					AddError(FString::Printf(TEXT("Frame %d, agent %d, %s: crowd %s (%s) %s, anim instance %s %s."), FrameIndex, Agent, *Key.ToString(),
+						Output.bTranslation ? *Output.Translation.ToString() : TEXT("-"), Output.bLerp ? TEXT("lerp") : TEXT("no lerp"),
+						Output.bRotation ? *Output.Rotation.ToString() : TEXT("-"),
+						Translation ? *Translation->Value.ToString() : TEXT("-"), Rotation ? *Rotation->Value.ToString() : TEXT("-")));
+				}
+				++NumCompared;
+			}
+
+			TestTrue(TEXT("Crowd and anim instance gait times match"), FMath::IsNearlyEqual(Crowd.GetAgentTime(AgentId), AnimInstance.GetGaitTime(), Tolerance));
+		}
+	}
+
+	TestEqual(TEXT("Mismatching effector outputs"), NumMismatches, 0);
+	TestTrue(TEXT("Collision corrections are exercised"), NumCorrections > 0);
+	TestEqual(TEXT("Compared effector outputs"), NumCompared, NumFrames * NumAgents * NumEffectors);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,502 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Private/Tests/GaitTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Nobunanim/Public/GaitEvaluationCacheSubsystem.h"
+#include "Nobunanim/Public/GaitReplicatedState.h"
+
+
+namespace GaitTests
+{
+	/**
+	*	Frozen copy of UProceduralGaitAnimInstance::ComputeGaitUpdate as it was before the gait algorithm moved to @FGaitEvaluator.
+	*	Only the plumbing changed: instance members read from @State and @Inputs, Queue* calls and scene queries go to @Sink
+	*	(outputs dropped under PhaseOnly, like the Queue* methods did), debug draws are left out. Do not update it with the evaluator.
+	*/
+	struct FReferenceGaitUpdate
+	{
+		static bool IsInRange(float Value, float Min, float Max, float& OutRangeMin, float& OutRangeMax)
+		{
+			bool A = Value >= Min && Value <= Max;
+			bool APrime = Value >= Max;
+
+			OutRangeMin = A ? Min : (APrime ? Min : Min - 1.f);
+			OutRangeMax = A ? Max : (APrime ? 1.f + Max : Max);
+
+			if (A)
+			{
+				return true;
+			}
+			else
+			{
+				bool B1 = Value <= Min && Value <= Max;
+				bool B2 = Value >= Min && Value >= Max;
+				bool B3 = B1 || B2;
+				bool C = Min >= Max && B3;
+
+				return C;
+			}
+		}
+
+		static void ComputeGaitUpdate(FGaitEvaluationState& State, const FGaitEvaluationInputs& Inputs, IGaitEvaluationSink& Sink)
+		{
+			const bool bOutputs = Inputs.OffscreenPolicy != EGaitOffscreenPolicy::PhaseOnly;
+			auto QueueEffectorTranslation = [&](const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed) { if (bOutputs) { Sink.EmitEffectorTranslation(Key, Translation, bLerp, LerpSpeed); } };
+			auto QueueEffectorRotation = [&](const FName& Key, const FRotator& Rotation, float LerpSpeed) { if (bOutputs) { Sink.EmitEffectorRotation(Key, Rotation, LerpSpeed); } };
+			auto QueueGaitEvent = [&](EGaitEventType Type, const FName& Key, const FVector& Location) { Sink.EmitGaitEvent(Type, Key, Location); };
+
+			const FGaitSetBinding& GaitBinding = *Inputs.Binding;
+			TArray<FGaitEffectorData>& Effectors = State.Effectors;
+			int32& CurrentGaitIndex = State.CurrentGaitIndex;
+			int32& PendingGaitIndex = State.PendingGaitIndex;
+			float& CurrentTime = State.CurrentTime;
+			float& TimeBuffer = State.TimeBuffer;
+			float& PhaseError = State.PhaseError;
+			FVector& LastVelocity = State.LastVelocity;
+			const float DeltaTime = Inputs.DeltaTime;
+			const float PlayRate = Inputs.PlayRate;
+			const FRotator GaitUpdateComponentRotation = Inputs.ComponentRotation;
+
+			FVector NewCurrentLocation;
+			FVector IdealEffectorLocation;
+			FVector CurrentEffectorLocation;
+			float Treshold = 0.f;
+			bool bForceSwing = false;
+			bool bAllEffectorBlendOutEnd = true;
+
+			const FVector CurrentVelocity = Inputs.Velocity;
+			const FProceduralGaitLODSettings& LODSetting = *Inputs.LODSetting;
+
+			if (CurrentGaitIndex != INDEX_NONE)
+			{
+				const UGaitDataAsset& CurrentAsset = *GaitBinding.Assets[CurrentGaitIndex];
+				const FGaitRuntimeTable& CurrentTable = CurrentAsset.GetRuntimeTable();
+
+				bool bZeroVelocity = CurrentVelocity.SizeSquared() == 0.f;
+				bool bCond = CurrentAsset.bComputeWithVelocityOnly ? !bZeroVelocity : true;
+
+				if (bCond)
+				{
+					if (!bZeroVelocity)
+					{
+						LastVelocity = CurrentVelocity;
+					}
+
+					// Step 1: Timers.
+					const float TimeAdvance = DeltaTime * CurrentAsset.GetFrameRatio() * PlayRate;
+					TimeBuffer += TimeAdvance;
+					if (PhaseError != 0.f)
+					{
+						TimeBuffer += FGaitReplicatedState::ConsumePhaseError(PhaseError, TimeAdvance, UNobunanimSettings::GetReplicationSettings().MaxPhaseCorrection);
+					}
+					CurrentTime = FMath::Fmod(TimeBuffer, 1.f);
+
+					// Step 2: Foreach swing values, we will check if we are in 'Swing' or 'Stance' according to @CurrentTime.
+					for (int j = 0, m = CurrentTable.Num(); j < m; ++j)
+					{
+						const int32 Slot = GaitBinding.GetSlot(CurrentGaitIndex, j);
+						const FName Key = GaitBinding.SlotNames[Slot];
+						const FGaitRuntimeEffector& CurrentData = CurrentTable.Effectors[j];
+						FGaitEffectorData& Effector = Effectors[Slot];
+
+						bool bBlendIn = true;
+
+						// Update blend value
+						{
+							if (PendingGaitIndex == INDEX_NONE || Effector.CurrentGaitIndex == PendingGaitIndex)
+							{
+								if (CurrentData.BlendInTime == 0)
+								{
+									Effector.CurrentBlendValue = 1.f;
+								}
+								else
+								{
+									bBlendIn = true;
+									if (Effector.CurrentBlendValue < 1.f)
+									{
+										Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue + (DeltaTime / CurrentData.BlendInTime), 0.f, 1.f);
+									}
+								}
+
+								if (PendingGaitIndex == INDEX_NONE)
+								{
+									bAllEffectorBlendOutEnd = false;
+								}
+							}
+							else
+							{
+								if (CurrentData.BlendOutTime == 0)
+								{
+									Effector.CurrentBlendValue = 0.f;
+									Effector.CurrentGaitIndex = PendingGaitIndex;
+								}
+								else
+								{
+									bBlendIn = false;
+									if (Effector.CurrentBlendValue > 0.f)
+									{
+										Effector.CurrentBlendValue = FMath::Clamp(Effector.CurrentBlendValue - (DeltaTime / CurrentData.BlendOutTime), 0.f, 1.f);
+									}
+
+									if (Effector.CurrentBlendValue == 0.f)
+									{
+										Effector.CurrentGaitIndex = PendingGaitIndex;
+									}
+								}
+								bAllEffectorBlendOutEnd = false;
+							}
+						}
+
+						const int32 UpdatedGaitIndex = Effector.CurrentGaitIndex == INDEX_NONE ? CurrentGaitIndex : Effector.CurrentGaitIndex;
+						const int32 UpdatedIndex = GaitBinding.GetEffector(UpdatedGaitIndex, Slot);
+						if (UpdatedIndex != INDEX_NONE)
+						{
+							const FGaitRuntimeTable& UpdatedTable = GaitBinding.GetTable(UpdatedGaitIndex);
+							const FGaitRuntimeEffector& UpdatedCurrentData = UpdatedTable.Effectors[UpdatedIndex];
+							const FGaitSwingData& UpdatedSwingData = *UpdatedTable.SwingData[UpdatedIndex];
+							const int32 ParentSlot = UpdatedCurrentData.ParentIndex != INDEX_NONE ? GaitBinding.GetSlot(UpdatedGaitIndex, UpdatedCurrentData.ParentIndex) : INDEX_NONE;
+
+							if (TimeBuffer < Effector.PlantedUntil && PlayRate > 0.f && PendingGaitIndex == INDEX_NONE && !Inputs.bShowDebug
+								&& !(UpdatedCurrentData.bAutoAdjustWithIdealEffector && ((ParentSlot != INDEX_NONE && Effectors[ParentSlot].bForceSwing)
+									|| (Effector.CurrentEffectorLocation - Effector.IdealEffectorLocation).Size2D() >= UpdatedCurrentData.DistanceTresholdToAdjust)))
+							{
+								QueueEffectorTranslation(Key, Effector.CurrentEffectorLocation, UpdatedCurrentData.LerpSpeed > 0, UpdatedCurrentData.LerpSpeed);
+								continue;
+							}
+							Effector.PlantedUntil = -1.f;
+
+							float BeginSwing = UpdatedCurrentData.BeginSwing;
+							float EndSwing = UpdatedCurrentData.EndSwing;
+
+							bool bCanCompute = Effector.BlockTime == -1.f
+								|| (Effector.BlockTime > BeginSwing && CurrentTime >= Effector.BlockTime)
+								|| (Effector.BlockTime < BeginSwing && CurrentTime < BeginSwing && CurrentTime >= Effector.BlockTime);
+
+							if (bCanCompute)
+							{
+								float MinRange, MaxRange;
+								BeginSwing = Effector.bForceSwing ? Effector.BeginForceSwingInterval : BeginSwing;
+								EndSwing = Effector.bForceSwing ? Effector.EndForceSwingInterval : EndSwing;
+
+								bool InRange = IsInRange(CurrentTime, BeginSwing, EndSwing, MinRange, MaxRange);
+
+								// Step 2.2: If the effector is in 'Swing'.
+								if (InRange)
+								{
+									if (!Effector.bSwinging)
+									{
+										Effector.bSwinging = true;
+										QueueGaitEvent(EGaitEventType::BeginSwing, Key, Effector.CurrentEffectorLocation);
+									}
+
+									Effector.bCorrectionIK = false;
+
+									float CurrentCurvePosition = FMath::GetMappedRangeValueClamped(FVector2D(MinRange, MaxRange), FVector2D(0.f, 1.f), CurrentTime);
+
+									float lerpSpeed = UpdatedCurrentData.LerpSpeed <= 0 ? 0
+										: UpdatedCurrentData.LerpSpeed * (Effector.CurrentBlendValue == 1.f ? 1.f
+											: UGaitEvaluationCacheSubsystem::SampleFloat(Inputs.EvaluationCache, UpdatedTable, UpdatedIndex,
+												bBlendIn ? EGaitSharedCurve::BlendInAcceleration : EGaitSharedCurve::BlendOutAcceleration, Effector.CurrentBlendValue));
+
+									// Step 2.2.1: Apply 'Swing' rotation (for bones).
+									if (UpdatedCurrentData.bAffectRotation)
+									{
+										FVector CurrentCurveValue = UpdatedCurrentData.RotationFactor
+											* UGaitEvaluationCacheSubsystem::SampleVector(Inputs.EvaluationCache, UpdatedTable, UpdatedIndex, EGaitSharedCurve::SwingRotation, CurrentCurvePosition);
+
+										QueueEffectorRotation(Key, FRotator(CurrentCurveValue.X, CurrentCurveValue.Y, CurrentCurveValue.Z), lerpSpeed);
+									}
+
+									// Step 2.2.1: Apply 'Swing' translation (for effectors IK(socket)).
+									if (UpdatedCurrentData.bAffectTranslation)
+									{
+										FVector CurrentCurveValue = UpdatedCurrentData.TranslationScale
+											* UGaitEvaluationCacheSubsystem::SampleVector(Inputs.EvaluationCache, UpdatedTable, UpdatedIndex,
+												Effector.bForceSwing ? EGaitSharedCurve::CorrectionSwingTranslation : EGaitSharedCurve::SwingTranslation, CurrentCurvePosition);
+
+										CurrentCurveValue = UpdatedCurrentData.bOrientToVelocity ?
+											LastVelocity.Rotation().RotateVector(CurrentCurveValue) : GaitUpdateComponentRotation.RotateVector(CurrentCurveValue);
+
+										FVector Offset = UpdatedCurrentData.bOrientToVelocity ?
+											LastVelocity.Rotation().RotateVector(UpdatedCurrentData.TranslationOffset) : GaitUpdateComponentRotation.RotateVector(UpdatedCurrentData.TranslationOffset);
+
+										CurrentEffectorLocation = Effector.CurrentEffectorLocation;
+
+										IdealEffectorLocation = UpdatedCurrentData.bAdaptToGroundLevel ? Effector.GroundLocation : Effector.IdealEffectorLocation;
+										NewCurrentLocation = IdealEffectorLocation + Offset + CurrentCurveValue;
+										Treshold = UpdatedCurrentData.DistanceTresholdToAdjust;
+										bForceSwing = Effector.bForceSwing;
+
+										QueueEffectorTranslation(Key, NewCurrentLocation, lerpSpeed > 0, lerpSpeed);
+
+										Effector.CurrentEffectorLocation = NewCurrentLocation;
+									}
+								}
+								// Step 2.3: If the effector is in 'Stance'.
+								else
+								{
+									if (Effector.bSwinging)
+									{
+										Effector.bSwinging = false;
+										QueueGaitEvent(EGaitEventType::EndSwing, Key, Effector.CurrentEffectorLocation);
+									}
+
+									if (Effector.bForceSwing)
+									{
+										Effector.BlockTime = UpdatedCurrentData.EndSwing >= 0.99f ? 0.f : UpdatedCurrentData.EndSwing;
+									}
+									else
+									{
+										Effector.BlockTime = -1.f;
+
+										// check for foot ik.
+										if (Inputs.bCanTrace && !Effector.bCorrectionIK && UpdatedCurrentData.bComputeCollision)
+										{
+											if (Inputs.OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly)
+											{
+												Effector.bCorrectionIK = true;
+												if (UpdatedCurrentData.bRaiseOnCollisionEvent)
+												{
+													QueueGaitEvent(EGaitEventType::Footfall, Key, Effector.CurrentEffectorLocation);
+												}
+											}
+											else if (LODSetting.bCanComputeCollisionCorrection && LODSetting.IsTracePhase(Inputs.UpdateCounter, Slot, Inputs.TracePhase))
+											{
+												const FGaitCorrectionData& CorrectionData = UpdatedSwingData.CorrectionData;
+
+												// Get origin for IK
+												FVector Origin = CorrectionData.bUseCurrentEffector ? Effector.CurrentEffectorLocation : Sink.GetCorrectionOrigin(Slot, CorrectionData.OriginCollisionSocketName);
+												FVector Dir = CorrectionData.bOrientToVelocity ? LastVelocity.Rotation().RotateVector(CorrectionData.AbsoluteDirection) : CorrectionData.AbsoluteDirection;
+
+												// Get Dest
+												FVector Dest = Origin + Dir;
+
+												// Add inverse absolute direction
+												Origin -= Dir;
+
+												FVector ImpactPoint;
+												if (Sink.TraceCorrection(Slot, Origin, Dest, CorrectionData.TraceChannel, ImpactPoint))
+												{
+													// if hit ground
+													Effector.CurrentEffectorLocation = ImpactPoint + LastVelocity.Rotation().RotateVector(CorrectionData.CollisionSnapOffset);
+													Effector.bCorrectionIK = true;
+													if (UpdatedCurrentData.bRaiseOnCollisionEvent)
+													{
+														QueueGaitEvent(EGaitEventType::Footfall, Key, Effector.CurrentEffectorLocation);
+													}
+												}
+											}
+										}
+
+										QueueEffectorTranslation(Key, Effector.CurrentEffectorLocation, UpdatedCurrentData.LerpSpeed > 0, UpdatedCurrentData.LerpSpeed);
+									}
+
+									bForceSwing = Effector.bForceSwing = false;
+
+									CurrentEffectorLocation = Effector.CurrentEffectorLocation;
+									IdealEffectorLocation = Effector.IdealEffectorLocation;
+									NewCurrentLocation = CurrentEffectorLocation;
+									Treshold = UpdatedCurrentData.DistanceTresholdToAdjust;
+
+									// Step 2.3.1: Check if the effector need to be adjusted
+									if (UpdatedCurrentData.bAutoAdjustWithIdealEffector)
+									{
+										float VectorLength = (Effector.CurrentEffectorLocation - Effector.IdealEffectorLocation).Size2D();
+
+										// Is the distance breaking treshold?
+										if ((ParentSlot != INDEX_NONE && Effectors[ParentSlot].bForceSwing) || VectorLength >= UpdatedCurrentData.DistanceTresholdToAdjust)
+										{
+											// Here we compute the new interval of swing.
+											float Begin = BeginSwing;
+											float End = EndSwing;
+
+											float Alpha = 0.f;
+											if (Begin > End)
+											{
+												Alpha = (1.f - Begin) + End;
+											}
+											else
+											{
+												Alpha = End - Begin;
+											}
+
+											float Beta = CurrentTime + Alpha;
+											// if the end swing is > 1 (absolute time) we just consider that the swing will end the next cycle.
+											if (Beta >= 1.f)
+											{
+												Beta -= 1.f;
+											}
+
+											Effector.BeginForceSwingInterval = CurrentTime;
+											Effector.EndForceSwingInterval = Beta;
+											bForceSwing = Effector.bForceSwing = true;
+											Effector.BlockTime = -1.f;
+										}
+									}
+
+									// Step 2.3.2: Planted until the next swing begins (in time buffer units, so play rate changes are accounted for).
+									if (!Effector.bForceSwing && Effector.bCorrectionIK && Effector.BlockTime == -1.f && PendingGaitIndex == INDEX_NONE && PlayRate > 0.f)
+									{
+										Effector.PlantedUntil = TimeBuffer + FMath::Frac(UpdatedCurrentData.BeginSwing - CurrentTime);
+									}
+								}
+							}
+						}
+					}
+
+					// Step 3: if all effector end blend out swtich gait
+					if (bAllEffectorBlendOutEnd == true)
+					{
+						CurrentGaitIndex = PendingGaitIndex;
+						PendingGaitIndex = INDEX_NONE;
+					}
+				}
+				else
+				{
+					CurrentTime = 0;
+				}
+			}
+			else
+			{
+				CurrentTime = 0;
+			}
+		}
+	};
+
+	/** Gait switch of UProceduralGaitAnimInstance::UpdateGaitMode. */
+	void SwitchGait(FGaitEvaluationState& State, int32 NewGaitIndex)
+	{
+		if (State.CurrentGaitIndex != NewGaitIndex && State.PendingGaitIndex != NewGaitIndex)
+		{
+			if (State.CurrentGaitIndex == INDEX_NONE)
+			{
+				State.CurrentGaitIndex = NewGaitIndex;
+			}
+			else
+			{
+				State.PendingGaitIndex = NewGaitIndex;
+			}
+
+			for (FGaitEffectorData& Effector : State.Effectors)
+			{
+				Effector.PlantedUntil = -1.f;
+			}
+		}
+	}
+}
+
+
+/** REFERENCE PARITY
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitEvaluatorParityTest, "Nobunanim.Gait.Evaluator.ReferenceParity", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitEvaluatorParityTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	static constexpr int32 NumFrames = 2 * FGaitTestWalk::NumFrames;
+	static constexpr float Tolerance = 1.e-3f;
+
+	FGaitTestAssets Assets;
+	TMap<FName, UGaitDataAsset*> Gaits;
+	Gaits.Add(TEXT("Walk"), Assets.MakeQuadrupedGait(TEXT("Walk"), 60, 0.f, 0.f, false));
+	Gaits.Add(TEXT("Trot"), Assets.MakeQuadrupedGait(TEXT("Trot"), 40, 0.1f, 0.3f, false));
+
+	FGaitSetBinding Binding;
+	FGaitEvaluationState State;
+	BindGaits(Gaits, Binding, State);
+	FGaitEvaluationState ReferenceState = State;
+	const int32 WalkIndex = Binding.FindGait(TEXT("Walk"));
+	const int32 TrotIndex = Binding.FindGait(TEXT("Trot"));
+
+	FProceduralGaitLODSettings LODSetting;
+	FProceduralGaitLODSettings StrideLODSetting;
+	StrideLODSetting.TraceStride = 3;
+
+	FVector SlotIdeals[NumLegs];
+	FGaitRecordingSink Sink;
+	FGaitRecordingSink ReferenceSink;
+	Sink.CorrectionOrigins = SlotIdeals;
+	ReferenceSink.CorrectionOrigins = SlotIdeals;
+
+	FGaitTestWalk Walk;
+	FGaitTestFrame Frame;
+	int32 NumMismatches = 0;
+	int32 NumRecords = 0;
+	bool bBlended = false;
+
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		Walk.Next(Frame);
+		ApplyFrame(Frame, Binding, State, SlotIdeals);
+		ApplyFrame(Frame, Binding, ReferenceState, SlotIdeals);
+
+		// Gait switches, blended.
+		if (FrameIndex == 90 || FrameIndex == 400)
+		{
+			const int32 NewGait = FrameIndex == 90 ? TrotIndex : WalkIndex;
+			SwitchGait(State, NewGait);
+			SwitchGait(ReferenceState, NewGait);
+		}
+		bBlended |= State.PendingGaitIndex != INDEX_NONE;
+
+		// Replicated state caught up, ahead then behind.
+		if (FrameIndex == 60 || FrameIndex == 540)
+		{
+			State.PhaseError = ReferenceState.PhaseError = FrameIndex == 60 ? 0.03f : -0.02f;
+		}
+
+		FGaitEvaluationInputs Inputs = MakeInputs(Frame, Binding, FrameIndex >= 300 && FrameIndex < 360 ? StrideLODSetting : LODSetting, FrameIndex);
+		Inputs.TracePhase = 7;
+		Inputs.OffscreenPolicy = FrameIndex >= 450 && FrameIndex < 500 ? EGaitOffscreenPolicy::PhaseOnly : EGaitOffscreenPolicy::KeepUpdating;
+
+		Sink.Reset();
+		ReferenceSink.Reset();
+		FGaitEvaluator::Evaluate(State, Inputs, Sink);
+		FReferenceGaitUpdate::ComputeGaitUpdate(ReferenceState, Inputs, ReferenceSink);
+
+		// Side effects, in order.
+		bool bMatch = Sink.Records.Num() == ReferenceSink.Records.Num() && Sink.NumTraces == ReferenceSink.NumTraces;
+		for (int32 i = 0; bMatch && i < Sink.Records.Num(); ++i)
+		{
+			const FGaitRecordingSink::FRecord& Record = Sink.Records[i];
+			const FGaitRecordingSink::FRecord& Reference = ReferenceSink.Records[i];
+			bMatch = Record.Type == Reference.Type && Record.EventType == Reference.EventType && Record.Key == Reference.Key && Record.bLerp == Reference.bLerp
+				&& Record.Value.Equals(Reference.Value, Tolerance) && FMath::IsNearlyEqual(Record.LerpSpeed, Reference.LerpSpeed, Tolerance);
+		}
+		NumRecords += Sink.Records.Num();
+
+		// State.
+		bMatch &= State.CurrentGaitIndex == ReferenceState.CurrentGaitIndex && State.PendingGaitIndex == ReferenceState.PendingGaitIndex
+			&& FMath::IsNearlyEqual(State.TimeBuffer, ReferenceState.TimeBuffer, Tolerance) && FMath::IsNearlyEqual(State.CurrentTime, ReferenceState.CurrentTime, Tolerance)
+			&& FMath::IsNearlyEqual(State.PhaseError, ReferenceState.PhaseError, Tolerance) && State.LastVelocity.Equals(ReferenceState.LastVelocity, Tolerance);
+		for (int32 Slot = 0; bMatch && Slot < State.Effectors.Num(); ++Slot)
+		{
+			const FGaitEffectorData& Effector = State.Effectors[Slot];
+			const FGaitEffectorData& Reference = ReferenceState.Effectors[Slot];
+			bMatch = Effector.CurrentEffectorLocation.Equals(Reference.CurrentEffectorLocation, Tolerance) && Effector.bForceSwing == Reference.bForceSwing
+				&& Effector.bCorrectionIK == Reference.bCorrectionIK && Effector.bSwinging == Reference.bSwinging && Effector.CurrentGaitIndex == Reference.CurrentGaitIndex
+				&& FMath::IsNearlyEqual(Effector.BeginForceSwingInterval, Reference.BeginForceSwingInterval, Tolerance)
+				&& FMath::IsNearlyEqual(Effector.EndForceSwingInterval, Reference.EndForceSwingInterval, Tolerance)
+				&& FMath::IsNearlyEqual(Effector.CurrentBlendValue, Reference.CurrentBlendValue, Tolerance)
+				&& FMath::IsNearlyEqual(Effector.BlockTime, Reference.BlockTime, Tolerance)
+				&& FMath::IsNearlyEqual(Effector.PlantedUntil, Reference.PlantedUntil, Tolerance);
+		}
+
+		if (!bMatch && NumMismatches++ < 10)
+		{
+			AddError(FString::Printf(TEXT("Frame %d: evaluator and reference differ (%d and %d side effects, time %f and %f)."), FrameIndex,
+				Sink.Records.Num(), ReferenceSink.Records.Num(), State.TimeBuffer, ReferenceState.TimeBuffer));
+		}
+	}
+
+	TestEqual(TEXT("Mismatching frames"), NumMismatches, 0);
+	TestTrue(TEXT("Side effects are compared"), NumRecords > 0);
+	TestTrue(TEXT("A gait blend is compared"), bBlended);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Private/Tests/GaitTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+namespace GaitTests
+{
+	/** Outputs of a quadruped walking @NumFrames frames of a standalone world whose net mode policy is @Policy. */
+	struct FNetModeRun
+	{
+		int32 NumTranslations = 0;
+		int32 NumRotations = 0;
+		int32 NumTraces = 0;
+		int32 NumFootfalls[NumLegs] = {};
+		/** Effector and bone outputs of the anim instance at the end of the run. */
+		int32 NumOutputs = 0;
+	};
+
+	FNetModeRun RunNetModePolicy(EGaitOffscreenPolicy Policy, int32 NumFrames)
+	{
+		using FRecord = UGaitTestAnimInstance::FRecord;
+
+		FGaitTestRunner Runner;
+		Runner.Settings.Get<FGaitNetModeSettings>(TEXT("NetMode")).Standalone = Policy;
+		Runner.Settings.Apply();
+
+		const UGaitTestAnimInstance& AnimInstance = *Runner.AddInstance(0).AnimInstance;
+
+		FNetModeRun Run;
+		for (int32 i = 0; i < NumFrames; ++i)
+		{
+			Runner.Step();
+
+			Run.NumTranslations += AnimInstance.CountRecords(FRecord::EType::Translation);
+			Run.NumRotations += AnimInstance.CountRecords(FRecord::EType::Rotation);
+			Run.NumTraces += AnimInstance.GetNumTracesLastUpdate();
+			for (int32 Leg = 0; Leg < NumLegs; ++Leg)
+			{
+				Run.NumFootfalls[Leg] += AnimInstance.CountRecords(FRecord::EType::CollisionEvent, GetLegName(Leg));
+			}
+		}
+
+		Run.NumOutputs = AnimInstance.EffectorsTranslation.Num() + AnimInstance.BonesRotation.Num();
+		return Run;
+	}
+}
+
+
+/** DEDICATED SERVER
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitDedicatedServerTest, "Nobunanim.Gait.NetMode.DedicatedServer", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitDedicatedServerTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	static constexpr int32 NumFrames = FGaitTestWalk::NumFrames;
+
+	// Every net mode keeps updating by default, dedicated servers opt in to PhaseOnly.
+	FGaitNetModeSettings NetModeSettings;
+	TestTrue(TEXT("Dedicated servers keep updating by default"), NetModeSettings.GetPolicy(NM_DedicatedServer) == EGaitOffscreenPolicy::KeepUpdating);
+	TestTrue(TEXT("Clients keep updating"), NetModeSettings.GetPolicy(NM_Client) == EGaitOffscreenPolicy::KeepUpdating);
+	NetModeSettings.DedicatedServer = EGaitOffscreenPolicy::PhaseOnly;
+	const EGaitOffscreenPolicy Policy = NetModeSettings.GetPolicy(NM_DedicatedServer);
+	TestTrue(TEXT("Opted in dedicated server policy is PhaseOnly"), Policy == EGaitOffscreenPolicy::PhaseOnly);
+
+	// Headless: footfalls only, through the front end of the anim instance.
+	const FNetModeRun Server = RunNetModePolicy(Policy, NumFrames);
+	for (int32 Leg = 0; Leg < NumLegs; ++Leg)
+	{
+		TestTrue(FString::Printf(TEXT("%s footfalls on the dedicated server"), *GetLegName(Leg).ToString()), Server.NumFootfalls[Leg] > 0);
+	}
+	TestEqual(TEXT("Effector translations on the dedicated server"), Server.NumTranslations, 0);
+	TestEqual(TEXT("Effector rotations on the dedicated server"), Server.NumRotations, 0);
+	TestEqual(TEXT("Effector and bone outputs on the dedicated server"), Server.NumOutputs, 0);
+	TestEqual(TEXT("Traces on the dedicated server"), Server.NumTraces, 0);
+
+	// Same walk updating: outputs and traces, footfalls too.
+	const FNetModeRun Updating = RunNetModePolicy(EGaitOffscreenPolicy::KeepUpdating, NumFrames);
+	TestTrue(TEXT("Effector translations when updating"), Updating.NumTranslations > 0);
+	TestTrue(TEXT("Effector rotations when updating"), Updating.NumRotations > 0);
+	TestTrue(TEXT("Effector and bone outputs when updating"), Updating.NumOutputs > 0);
+	TestTrue(TEXT("Traces when updating"), Updating.NumTraces > 0);
+	for (int32 Leg = 0; Leg < NumLegs; ++Leg)
+	{
+		TestTrue(FString::Printf(TEXT("%s footfalls when updating"), *GetLegName(Leg).ToString()), Updating.NumFootfalls[Leg] > 0);
+	}
+
+	return true;
+}
+
+
+/** OFFSCREEN RESOLUTION
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitNetModeOffscreenTest, "Nobunanim.Gait.NetMode.OffscreenResolution", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitNetModeOffscreenTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	// A LOD suspending the gait once off-screen.
+	FGaitTestSettingsScope Settings;
+	TMap<int32, FProceduralGaitLODSettings>& LODSettings = Settings.Get<TMap<int32, FProceduralGaitLODSettings>>(TEXT("ProceduralGaitLODSettings"));
+	LODSettings.Reset();
+	FProceduralGaitLODSettings& LODSetting = LODSettings.Add(0);
+	LODSetting.OffscreenPolicy = EGaitOffscreenPolicy::Suspend;
+	LODSetting.OffscreenDelay = 0.5f;
+	FGaitNetModeSettings& NetModeSettings = Settings.Get<FGaitNetModeSettings>(TEXT("NetMode"));
+	Settings.Apply();
+
+	// Never rendered, like every mesh of a dedicated server.
+	FGaitTestWorld World;
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AActor* Actor = World.World->SpawnActor<AActor>(SpawnParameters);
+	UGaitTestMeshComponent* Mesh = NewObject<UGaitTestMeshComponent>(Actor);
+	Actor->SetRootComponent(Mesh);
+	Mesh->RegisterComponent();
+
+	TestTrue(TEXT("Dedicated server keeps updating, whatever the LOD off-screen policy"),
+		UNobunanimSettings::ResolveOffscreenPolicy(NM_DedicatedServer, 0, Mesh) == EGaitOffscreenPolicy::KeepUpdating);
+	TestTrue(TEXT("Unrendered client gets the LOD off-screen policy"),
+		UNobunanimSettings::ResolveOffscreenPolicy(NM_Client, 0, Mesh) == EGaitOffscreenPolicy::Suspend);
+
+	NetModeSettings.DedicatedServer = EGaitOffscreenPolicy::PhaseOnly;
+	Settings.Apply();
+	TestTrue(TEXT("Dedicated server gets its net mode policy"),
+		UNobunanimSettings::ResolveOffscreenPolicy(NM_DedicatedServer, 0, Mesh) == EGaitOffscreenPolicy::PhaseOnly);
+
+	Mesh->SetLastRenderTime(World.World->GetTimeSeconds());
+	TestTrue(TEXT("Rendered client keeps updating"),
+		UNobunanimSettings::ResolveOffscreenPolicy(NM_Client, 0, Mesh) == EGaitOffscreenPolicy::KeepUpdating);
+
+	Actor->Destroy();
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
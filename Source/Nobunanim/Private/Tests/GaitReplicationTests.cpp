@@ -0,0 +1,274 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Private/Tests/GaitTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Nobunanim/Public/GaitReplicatedState.h"
+
+#include <Serialization/BitReader.h>
+#include <Serialization/BitWriter.h>
+
+
+namespace GaitTests
+{
+	/** Serialize @State to bits and read it back in @OutState. Return the number of bits written. */
+	int64 NetRoundTrip(FAutomationTestBase& Test, const FGaitReplicatedState& State, FGaitReplicatedState& OutState)
+	{
+		FGaitReplicatedState Saved = State;
+		FBitWriter Writer(0, true);
+		bool bSuccess = false;
+		Saved.NetSerialize(Writer, nullptr, bSuccess);
+		Test.TestTrue(TEXT("NetSerialize saves"), bSuccess);
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		OutState = FGaitReplicatedState();
+		bSuccess = false;
+		OutState.NetSerialize(Reader, nullptr, bSuccess);
+		Test.TestTrue(TEXT("NetSerialize loads"), bSuccess);
+		Test.TestEqual(TEXT("Every written bit is read"), Reader.GetPosBits(), Writer.GetNumBits());
+
+		return Writer.GetNumBits();
+	}
+
+	FGaitReplicatedState MakeReplicatedState(int32 GaitIndex, int32 PendingGaitIndex, float Phase, float BlendProgress)
+	{
+		FGaitReplicatedState State;
+		State.GaitIndex = GaitIndex;
+		State.PendingGaitIndex = PendingGaitIndex;
+		State.SetPhase(Phase);
+		State.SetBlendProgress(BlendProgress);
+		return State;
+	}
+}
+
+
+/** NET SERIALIZE
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitReplicatedStateNetSerializeTest, "Nobunanim.Gait.Replication.NetSerialize", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitReplicatedStateNetSerializeTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	FGaitReplicatedState Loaded;
+
+	// No gait.
+	{
+		const FGaitReplicatedState State = MakeReplicatedState(INDEX_NONE, INDEX_NONE, 0.f, 1.f);
+		TestEqual(TEXT("No gait bits"), NetRoundTrip(*this, State, Loaded), (int64)32);
+		TestTrue(TEXT("No gait round trip"), Loaded == State);
+	}
+
+	// Gaits, up to the last replicated index.
+	for (int32 GaitIndex : { 0, 1, 63, FGaitReplicatedState::MaxGaits - 1 })
+	{
+		const FGaitReplicatedState State = MakeReplicatedState(GaitIndex, INDEX_NONE, 0.3f, 1.f);
+		TestEqual(FString::Printf(TEXT("Gait %d bits"), GaitIndex), NetRoundTrip(*this, State, Loaded), (int64)32);
+		TestTrue(FString::Printf(TEXT("Gait %d round trip"), GaitIndex), Loaded == State);
+	}
+
+	// Beyond the last replicated index: no gait.
+	{
+		NetRoundTrip(*this, MakeReplicatedState(FGaitReplicatedState::MaxGaits, FGaitReplicatedState::MaxGaits, 0.3f, 1.f), Loaded);
+		TestEqual(TEXT("Gait beyond MaxGaits"), Loaded.GaitIndex, (int32)INDEX_NONE);
+		TestEqual(TEXT("Pending gait beyond MaxGaits"), Loaded.PendingGaitIndex, (int32)INDEX_NONE);
+	}
+
+	// Pending gait.
+	{
+		const FGaitReplicatedState State = MakeReplicatedState(3, FGaitReplicatedState::MaxGaits - 1, 0.6f, 0.4f);
+		TestEqual(TEXT("Pending gait bits"), NetRoundTrip(*this, State, Loaded), (int64)39);
+		TestTrue(TEXT("Pending gait round trip"), Loaded == State);
+
+		const FGaitReplicatedState FirstPending = MakeReplicatedState(INDEX_NONE, 0, 0.6f, 0.f);
+		TestTrue(TEXT("Pending gait bits are at most 39"), NetRoundTrip(*this, FirstPending, Loaded) <= 39);
+		TestTrue(TEXT("Pending gait 0 round trip"), Loaded == FirstPending);
+	}
+
+	// Phase quantization and wrap.
+	{
+		FGaitReplicatedState State;
+		State.SetPhase(1.f);
+		TestEqual(TEXT("Phase 1 wraps to 0"), (int32)State.Phase, 0);
+		State.SetPhase(3.25f);
+		TestEqual(TEXT("Phase 3.25 wraps to 0.25"), (int32)State.Phase, 16384);
+		State.SetPhase(-0.25f);
+		TestEqual(TEXT("Phase -0.25 wraps to 0.75"), (int32)State.Phase, 49152);
+		State.SetPhase(0.99999f);
+		TestEqual(TEXT("Phase just below 1 stays below 1"), (int32)State.Phase, 65535);
+
+		NetRoundTrip(*this, State, Loaded);
+		TestEqual(TEXT("Last phase step round trip"), (int32)Loaded.Phase, 65535);
+
+		for (float Time = 0.f; Time < 1.f; Time += 0.0173f)
+		{
+			State.SetPhase(Time);
+			NetRoundTrip(*this, State, Loaded);
+			const float Error = Time - Loaded.GetPhase();
+			TestTrue(FString::Printf(TEXT("Phase %f quantization"), Time), Error >= 0.f && Error < 1.f / 65536.f + KINDA_SMALL_NUMBER);
+		}
+	}
+
+	return true;
+}
+
+
+/** GAIT INDICES
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitReplicatedGaitIndicesTest, "Nobunanim.Gait.Replication.GaitIndices", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitReplicatedGaitIndicesTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	FGaitTestAssets Assets;
+	UGaitDataAsset* Walk = Assets.MakeQuadrupedGait(TEXT("Walk"), 60, 0.f, 0.f, false);
+	UGaitDataAsset* Trot = Assets.MakeQuadrupedGait(TEXT("Trot"), 40, 0.1f, 0.f, false);
+	UGaitDataAsset* Amble = Assets.MakeQuadrupedGait(TEXT("Amble"), 50, 0.2f, 0.f, false);
+
+	// The same gait set, filled in another order on each machine.
+	TMap<FName, UGaitDataAsset*> ServerGaits;
+	ServerGaits.Add(TEXT("Walk"), Walk);
+	ServerGaits.Add(TEXT("Trot"), Trot);
+	ServerGaits.Add(TEXT("Amble"), Amble);
+
+	TMap<FName, UGaitDataAsset*> ClientGaits;
+	ClientGaits.Add(TEXT("Amble"), Amble);
+	ClientGaits.Add(TEXT("Trot"), Trot);
+	ClientGaits.Add(TEXT("Walk"), Walk);
+
+	FGaitSetBinding ServerBinding;
+	FGaitSetBinding ClientBinding;
+	ServerBinding.Build(ServerGaits);
+	ClientBinding.Build(ClientGaits);
+
+	const FName GaitNames[] = { TEXT("Amble"), TEXT("Trot"), TEXT("Walk") };
+	for (int32 GaitIndex = 0; GaitIndex < UE_ARRAY_COUNT(GaitNames); ++GaitIndex)
+	{
+		const FName GaitName = GaitNames[GaitIndex];
+		TestEqual(FString::Printf(TEXT("%s server index"), *GaitName.ToString()), ServerBinding.FindGait(GaitName), GaitIndex);
+		TestEqual(FString::Printf(TEXT("%s client index"), *GaitName.ToString()), ClientBinding.FindGait(GaitName), GaitIndex);
+		TestTrue(FString::Printf(TEXT("%s asset"), *GaitName.ToString()), ServerBinding.Assets[GaitIndex] == ClientBinding.Assets[GaitIndex]);
+	}
+
+	return true;
+}
+
+
+/** PHASE ERROR
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitReplicatedStatePhaseErrorTest, "Nobunanim.Gait.Replication.PhaseError", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitReplicatedStatePhaseErrorTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	static constexpr float Tolerance = 1.e-3f;
+	static constexpr float Advance = 1.f / 60.f;
+	static constexpr float MaxCorrection = 0.25f;
+
+	// Shortest way around the cycle.
+	{
+		FGaitReplicatedState State;
+		State.SetPhase(0.05f);
+		TestTrue(TEXT("Phase error across the wrap, ahead"), FMath::IsNearlyEqual(State.GetPhaseError(3.95f), 0.1f, Tolerance));
+		State.SetPhase(0.95f);
+		TestTrue(TEXT("Phase error across the wrap, behind"), FMath::IsNearlyEqual(State.GetPhaseError(4.05f), -0.1f, Tolerance));
+		State.SetPhase(0.5f);
+		TestTrue(TEXT("Phase error in sync"), FMath::IsNearlyEqual(State.GetPhaseError(7.5f), 0.f, Tolerance));
+	}
+
+	// A step never exceeds its share of the advance, and the error is consumed.
+	{
+		float PhaseError = 0.1f;
+		const float Step = FGaitReplicatedState::ConsumePhaseError(PhaseError, Advance, MaxCorrection);
+		TestTrue(TEXT("Step is clamped"), FMath::IsNearlyEqual(Step, Advance * MaxCorrection, KINDA_SMALL_NUMBER));
+		TestTrue(TEXT("Step is consumed"), FMath::IsNearlyEqual(PhaseError, 0.1f - Step, KINDA_SMALL_NUMBER));
+
+		PhaseError = -0.001f;
+		TestTrue(TEXT("Small error in one step"), FMath::IsNearlyEqual(FGaitReplicatedState::ConsumePhaseError(PhaseError, Advance, MaxCorrection), -0.001f, KINDA_SMALL_NUMBER));
+		TestEqual(TEXT("Small error consumed"), PhaseError, 0.f);
+	}
+
+	// Client catching up with the server, ahead then behind: the cycle speeds up or slows down, never pops or goes backward.
+	for (float InitialError : { 0.1f, -0.3f, 0.45f })
+	{
+		float ServerTime = 5.f;
+		float ClientTimeBuffer = ServerTime - InitialError + 2.f;
+		float PhaseError = 0.f;
+		float MaxStep = 0.f;
+		bool bMonotonic = true;
+
+		for (int32 Frame = 0; Frame < 600; ++Frame)
+		{
+			ServerTime += Advance;
+
+			// A replicated state every 6 frames.
+			if (Frame % 6 == 0)
+			{
+				FGaitReplicatedState State;
+				State.SetPhase(ServerTime);
+				PhaseError = State.GetPhaseError(ClientTimeBuffer);
+			}
+
+			const float Step = FGaitReplicatedState::ConsumePhaseError(PhaseError, Advance, MaxCorrection);
+			MaxStep = FMath::Max(MaxStep, FMath::Abs(Step));
+
+			const float Previous = ClientTimeBuffer;
+			ClientTimeBuffer += Advance + Step;
+			bMonotonic &= ClientTimeBuffer > Previous;
+		}
+
+		FGaitReplicatedState Final;
+		Final.SetPhase(ServerTime);
+		TestTrue(FString::Printf(TEXT("Error %f: step bounded"), InitialError), MaxStep <= Advance * MaxCorrection + KINDA_SMALL_NUMBER);
+		TestTrue(FString::Printf(TEXT("Error %f: cycle never goes backward"), InitialError), bMonotonic);
+		TestTrue(FString::Printf(TEXT("Error %f: converged"), InitialError), FMath::Abs(Final.GetPhaseError(ClientTimeBuffer)) < Tolerance);
+		TestTrue(FString::Printf(TEXT("Error %f: error consumed"), InitialError), FMath::Abs(PhaseError) < Tolerance);
+	}
+
+	// A client anim instance catches up with a server one walking the same way, from a first state off by the initial error.
+	for (float InitialError : { 0.1f, -0.3f, 0.45f })
+	{
+		static constexpr int32 NumFrames = FGaitTestWalk::NumFrames;
+		static constexpr int32 StateInterval = 6;
+
+		FGaitTestRunner Runner;
+		const UGaitTestAnimInstance& Server = *Runner.AddInstance(0).AnimInstance;
+		UGaitTestAnimInstance& Client = *Runner.AddInstance(0, NAME_None).AnimInstance;
+		const float MaxStateCorrection = UNobunanimSettings::GetReplicationSettings().MaxPhaseCorrection;
+
+		FGaitReplicatedState First = Server.GetReplicatedGaitState();
+		First.SetPhase(First.GetPhase() - InitialError);
+		Client.ApplyReplicatedGaitState(First);
+		TestTrue(FString::Printf(TEXT("Error %f: first state adopted"), InitialError), FMath::IsNearlyEqual(First.GetPhaseError(Client.GetGaitTimeBuffer()), 0.f, Tolerance));
+
+		bool bBounded = true;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const float ServerPrevious = Server.GetGaitTimeBuffer();
+			const float ClientPrevious = Client.GetGaitTimeBuffer();
+			Runner.Step();
+
+			// Same walk: the client advance differs from the server one by its share of correction at most.
+			const float ServerAdvance = Server.GetGaitTimeBuffer() - ServerPrevious;
+			const float ClientAdvance = Client.GetGaitTimeBuffer() - ClientPrevious;
+			bBounded &= FMath::Abs(ClientAdvance - ServerAdvance) <= FMath::Abs(ServerAdvance) * MaxStateCorrection + KINDA_SMALL_NUMBER;
+
+			if (Frame % StateInterval == 0)
+			{
+				Client.ApplyReplicatedGaitState(Server.GetReplicatedGaitState());
+			}
+		}
+
+		const FGaitReplicatedState Final = Server.GetReplicatedGaitState();
+		TestTrue(FString::Printf(TEXT("Error %f: anim instance advance bounded"), InitialError), bBounded);
+		TestTrue(FString::Printf(TEXT("Error %f: anim instance converged"), InitialError), FMath::Abs(Final.GetPhaseError(Client.GetGaitTimeBuffer())) < Tolerance);
+		TestEqual(FString::Printf(TEXT("Error %f: same gait"), InitialError), Client.GetReplicatedGaitState().GaitIndex, Final.GaitIndex);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Private/Tests/GaitTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Nobunanim/Public/GaitSignificanceSubsystem.h"
+
+
+namespace GaitTests
+{
+	/** Significance instance owned by an actor of the test world, recording what the subsystem applies to it. */
+	struct FGaitTestSignificanceInstance : public IGaitSignificanceInstance
+	{
+		AActor* Owner = nullptr;
+		float Importance = 1.f;
+		int32 NumApplied = 0;
+		float LastSignificance = -1.f;
+
+		virtual bool GetSignificanceInputs(FGaitSignificanceInputs& OutInputs) override
+		{
+			OutInputs.Location = Owner->GetActorLocation();
+			OutInputs.Importance = Importance;
+			return true;
+		}
+
+		virtual void ApplySignificance(float Significance, int32 MinLOD) override
+		{
+			++NumApplied;
+			LastSignificance = Significance;
+		}
+
+		virtual UObject* GetSignificanceObject() override
+		{
+			return Owner;
+		}
+	};
+}
+
+
+/** DESTROYED OWNERS
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGaitSignificanceDestroyedOwnerTest, "Nobunanim.Gait.Significance.DestroyedOwners", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGaitSignificanceDestroyedOwnerTest::RunTest(const FString& Parameters)
+{
+	using namespace GaitTests;
+
+	static constexpr int32 NumInstances = 5;
+	static constexpr int32 NumEvaluations = 2;
+
+	FGaitTestSettingsScope Settings;
+	FGaitSignificanceSettings& SignificanceSettings = Settings.Get<FGaitSignificanceSettings>(TEXT("Significance"));
+	SignificanceSettings.bEnabled = true;
+	SignificanceSettings.EvaluationInterval = 0.f;
+	Settings.Apply();
+
+	FGaitTestWorld World;
+	UGaitSignificanceSubsystem* Significance = World.World->GetSubsystem<UGaitSignificanceSubsystem>();
+	if (!TestNotNull(TEXT("Significance subsystem"), Significance))
+	{
+		return false;
+	}
+
+	// Without player view, the significance of an instance is its importance.
+	FGaitTestSignificanceInstance Instances[NumInstances];
+	for (int32 i = 0; i < NumInstances; ++i)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		Instances[i].Owner = World.World->SpawnActor<AActor>(SpawnParameters);
+		Instances[i].Importance = 1.f + i;
+		Significance->RegisterInstance(&Instances[i]);
+	}
+
+	// Owners destroyed without unregistering, in the middle and at the end of the list.
+	Instances[1].Owner->Destroy();
+	Instances[NumInstances - 1].Owner->Destroy();
+
+	for (int32 Evaluation = 0; Evaluation < NumEvaluations; ++Evaluation)
+	{
+		Significance->Tick(1.f / 60.f);
+	}
+
+	for (int32 i = 0; i < NumInstances; ++i)
+	{
+		const bool bDestroyed = i == 1 || i == NumInstances - 1;
+		TestEqual(FString::Printf(TEXT("Instance %d evaluations"), i), Instances[i].NumApplied, bDestroyed ? 0 : NumEvaluations);
+		if (!bDestroyed)
+		{
+			TestEqual(FString::Printf(TEXT("Instance %d gets its own significance"), i), Instances[i].LastSignificance, Instances[i].Importance);
+		}
+	}
+	TestEqual(TEXT("Scored instances"), Significance->GetLastStats().NumInstances, NumInstances - 2);
+
+	for (FGaitTestSignificanceInstance& Instance : Instances)
+	{
+		Significance->UnregisterInstance(&Instance);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
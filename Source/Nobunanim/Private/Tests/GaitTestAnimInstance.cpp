@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitTestAnimInstance.h"
+
+#include <GameFramework/Actor.h>
+
+
+#pragma region UGaitTestMeshComponent
+
+FTransform UGaitTestMeshComponent::GetSocketTransform(FName InSocketName, ERelativeTransformSpace TransformSpace) const
+{
+	const FTransform* Socket = TestSockets.Find(InSocketName);
+	if (!Socket)
+	{
+		return Super::GetSocketTransform(InSocketName, TransformSpace);
+	}
+
+	switch (TransformSpace)
+	{
+		case RTS_World:
+			return *Socket * GetComponentTransform();
+
+		case RTS_Actor:
+			if (const AActor* Actor = GetOwner())
+			{
+				return (*Socket * GetComponentTransform()).GetRelativeTransform(Actor->GetTransform());
+			}
+			return *Socket;
+
+		default:
+			// No bone: component and parent bone spaces are the same.
+			return *Socket;
+	}
+}
+
+#pragma endregion
+
+
+#pragma region UGaitTestAnimInstance
+
+UGaitTestAnimInstance::UGaitTestAnimInstance()
+{
+	// Recording doesn't allocate once warm.
+	Records.Reserve(256);
+}
+
+void UGaitTestAnimInstance::StartGait(const TMap<FName, UGaitDataAsset*>& Gaits, FName GaitName)
+{
+	OwnedMesh = GetOwningComponent();
+	GaitsData = Gaits;
+	bBroadcastCollisionEvent = true;
+	OnCollisionEvent.AddDynamic(this, &UGaitTestAnimInstance::RecordCollisionEvent);
+
+	NativeBeginPlay();
+
+	if (!GaitName.IsNone())
+	{
+		UpdateGaitMode(GaitName);
+	}
+}
+
+int32 UGaitTestAnimInstance::CountRecords(FRecord::EType Type, FName Key) const
+{
+	int32 Num = 0;
+	for (const FRecord& Record : Records)
+	{
+		Num += Record.Type == Type && (Key.IsNone() || Record.Key == Key) ? 1 : 0;
+	}
+	return Num;
+}
+
+void UGaitTestAnimInstance::UpdateEffectorTranslation_Implementation(const FName& TargetBone, FVector Translation, bool bLerp, float LerpSpeed)
+{
+	Records.Add({ FRecord::EType::Translation, TargetBone, Translation, LerpSpeed, bLerp });
+
+	Super::UpdateEffectorTranslation_Implementation(TargetBone, Translation, bLerp, LerpSpeed);
+}
+
+void UGaitTestAnimInstance::UpdateEffectorRotation_Implementation(const FName& TargetBone, FRotator Rotation, float LerpSpeed)
+{
+	Records.Add({ FRecord::EType::Rotation, TargetBone, FVector(Rotation.Pitch, Rotation.Yaw, Rotation.Roll), LerpSpeed, false });
+
+	Super::UpdateEffectorRotation_Implementation(TargetBone, Rotation, LerpSpeed);
+}
+
+void UGaitTestAnimInstance::RecordCollisionEvent(FName EffectorName, FVector ImpactLocation)
+{
+	Records.Add({ FRecord::EType::CollisionEvent, EffectorName, ImpactLocation, 0.f, false });
+}
+
+#pragma endregion
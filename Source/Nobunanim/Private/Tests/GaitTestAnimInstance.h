@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Nobunanim/Public/ProceduralGaitAnimInstance.h"
+
+#include <Components/SkeletalMeshComponent.h>
+#include "GaitTestAnimInstance.generated.h"
+
+
+/**
+*	Skeletal mesh component of the gait automation tests (Nobunanim.Gait.*): sockets are set by the test instead of coming from a mesh asset.
+*/
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UGaitTestMeshComponent : public USkeletalMeshComponent
+{
+	GENERATED_BODY()
+
+	public:
+		/** Component space transform of each test socket. */
+		TMap<FName, FTransform> TestSockets;
+
+	public:
+	/** UNREAL METHODS
+	*/
+		virtual FTransform GetSocketTransform(FName InSocketName, ERelativeTransformSpace TransformSpace = RTS_World) const override;
+};
+
+
+/**
+*	Gait anim instance of the gait automation tests: driven by the test through the front end (@NativeUpdateAnimation and @ProceduralGaitUpdate),
+*	records every effector output and collision event it receives.
+*/
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UGaitTestAnimInstance : public UProceduralGaitAnimInstance
+{
+	GENERATED_BODY()
+
+	public:
+		/** Output received by the instance. */
+		struct FRecord
+		{
+			enum class EType : uint8
+			{
+				Translation,
+				Rotation,
+				CollisionEvent,
+			};
+
+			EType Type;
+			FName Key;
+			/** Translation, rotation (pitch, yaw, roll) or collision location. */
+			FVector Value;
+			float LerpSpeed;
+			bool bLerp;
+		};
+
+		/** Outputs since the last @ResetRecords, in order. */
+		TArray<FRecord> Records;
+
+	public:
+		UGaitTestAnimInstance();
+
+		/** Play @Gaits on the owning test mesh, starting with @GaitName (if not None). */
+		void StartGait(const TMap<FName, UGaitDataAsset*>& Gaits, FName GaitName);
+
+		FORCEINLINE void SetGaitPlayRate(float InPlayRate) { PlayRate = InPlayRate; }
+
+		FORCEINLINE void ResetRecords() { Records.Reset(); }
+
+		/** Number of records of @Type (and of @Key if not None). */
+		int32 CountRecords(FRecord::EType Type, FName Key = NAME_None) const;
+
+		FORCEINLINE const FGaitSetBinding& GetGaitBinding() const { return GaitBinding; }
+		FORCEINLINE const FGaitEffectorData& GetGaitEffector(int32 Slot) const { return GaitState.Effectors[Slot]; }
+		FORCEINLINE float GetGaitTime() const { return GaitState.CurrentTime; }
+		FORCEINLINE float GetGaitTimeBuffer() const { return GaitState.TimeBuffer; }
+		FORCEINLINE const FVector& GetGaitLastVelocity() const { return GaitState.LastVelocity; }
+
+	public:
+	/** PROCEDURAL GAIT INTERFACE
+	*/
+		void UpdateEffectorTranslation_Implementation(const FName& TargetBone, FVector Translation, bool bLerp, float LerpSpeed) override;
+		void UpdateEffectorRotation_Implementation(const FName& TargetBone, FRotator Rotation, float LerpSpeed) override;
+
+	private:
+		UFUNCTION()
+		void RecordCollisionEvent(FName EffectorName, FVector ImpactLocation);
+};
@@ -0,0 +1,654 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Misc/AutomationTest.h>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Nobunanim/Public/GaitDataAsset.h"
+#include "Nobunanim/Public/GaitEvaluator.h"
+#include "Nobunanim/Public/GaitEventSubsystem.h"
+#include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Private/Tests/GaitTestAnimInstance.h"
+
+#include <Components/BoxComponent.h>
+#include <Curves/CurveFloat.h>
+#include <Curves/CurveVector.h>
+#include <Engine/Engine.h>
+#include <Engine/World.h>
+#include <Engine/CollisionProfile.h>
+#include <GameFramework/Actor.h>
+#include <HAL/MemoryBase.h>
+#include <UObject/Package.h>
+#include <UObject/UnrealType.h>
+
+
+/**
+*	Shared fixtures of the gait automation tests (Nobunanim.Gait.*). @FGaitTestRunner drives gait anim instances through their real front end
+*	(@NativeUpdateAnimation, @ProceduralGaitUpdate) in a test world with a floor, along a scripted walk, so a test only holds its assertions.
+*	@FGaitRecordingSink runs the @FGaitEvaluator alone, on the same walk over a sloped terrain, without world or mesh.
+*/
+namespace GaitTests
+{
+	/** Effectors of the test quadruped. */
+	static constexpr int32 NumLegs = 4;
+
+	inline FName GetLegName(int32 Leg)
+	{
+		static const FName Names[NumLegs] = { TEXT("foot_fl"), TEXT("foot_fr"), TEXT("foot_hl"), TEXT("foot_hr") };
+		return Names[Leg];
+	}
+
+	/** Rest position of each foot in the body space. */
+	inline FVector GetLegOffset(int32 Leg)
+	{
+		static const FVector Offsets[NumLegs] = { FVector(60.f, -25.f, 0.f), FVector(60.f, 25.f, 0.f), FVector(-60.f, -25.f, 0.f), FVector(-60.f, 25.f, 0.f) };
+		return Offsets[Leg];
+	}
+
+	/** Socket of the ground adaptation, under the body. */
+	inline FName GetGroundReferenceName()
+	{
+		static const FName Name = TEXT("ground_ref");
+		return Name;
+	}
+
+	/** Height of the test mesh component above the floor. Feet rest 5 cm above the floor, the ground reference 10 cm under it. */
+	static constexpr float BodyHeight = 50.f;
+
+
+	/** Gait assets of a test, rooted until the end of the test. */
+	struct FGaitTestAssets
+	{
+		TArray<UObject*> Objects;
+
+		~FGaitTestAssets()
+		{
+			for (UObject* Object : Objects)
+			{
+				Object->RemoveFromRoot();
+			}
+		}
+
+		UCurveVector* MakeVectorCurve(UObject* Outer, const TArray<FVector>& XKeys, const TArray<FVector>& YKeys, const TArray<FVector>& ZKeys)
+		{
+			// Keys are (time, value, unused).
+			UCurveVector* Curve = NewObject<UCurveVector>(Outer);
+			const TArray<FVector>* Channels[3] = { &XKeys, &YKeys, &ZKeys };
+			for (int32 c = 0; c < 3; ++c)
+			{
+				for (const FVector& Key : *Channels[c])
+				{
+					Curve->FloatCurves[c].AddKey((float)Key.X, (float)Key.Y);
+				}
+			}
+			return Curve;
+		}
+
+		/**
+		*	Quadruped gait: one wrapping swing window, a hind leg following its front parent, rotation on one leg, no lerp on another,
+		*	stance collision correction and footfall events on every leg. Swing windows are offset by @WindowOffset.
+		*	Windows avoid multiples of 1/60 so fixed 60 fps steps never land on a window boundary.
+		*/
+		UGaitDataAsset* MakeQuadrupedGait(FName Name, int32 AnimationFrameCount, float WindowOffset, float BlendTime, bool bBakeCurves)
+		{
+			UGaitDataAsset* Gait = NewObject<UGaitDataAsset>(GetTransientPackage(), Name);
+			Gait->AddToRoot();
+			Objects.Add(Gait);
+
+			Gait->AnimationFrameCount = AnimationFrameCount;
+			Gait->bComputeWithVelocityOnly = true;
+			Gait->CurveBakeSettings.bBakeCurves = bBakeCurves;
+
+			UCurveVector* Swing = MakeVectorCurve(Gait, { FVector(0.f, -15.f, 0.f), FVector(1.f, 15.f, 0.f) }, { FVector(0.f, 0.f, 0.f) }, { FVector(0.f, 0.f, 0.f), FVector(0.5f, 20.f, 0.f), FVector(1.f, 0.f, 0.f) });
+			UCurveVector* Correction = MakeVectorCurve(Gait, { FVector(0.f, -25.f, 0.f), FVector(1.f, 25.f, 0.f) }, { FVector(0.f, 0.f, 0.f) }, { FVector(0.f, 0.f, 0.f), FVector(0.5f, 30.f, 0.f), FVector(1.f, 0.f, 0.f) });
+			UCurveVector* Rotation = MakeVectorCurve(Gait, { FVector(0.f, 0.f, 0.f), FVector(0.5f, 15.f, 0.f), FVector(1.f, 0.f, 0.f) }, { FVector(0.f, 0.f, 0.f) }, { FVector(0.f, 0.f, 0.f) });
+			UCurveFloat* Acceleration = NewObject<UCurveFloat>(Gait);
+			Acceleration->FloatCurve.AddKey(0.f, 0.2f);
+			Acceleration->FloatCurve.AddKey(1.f, 1.f);
+
+			const float Begins[NumLegs] = { 0.013f, 0.513f, 0.863f, 0.263f };
+			const float Ends[NumLegs] = { 0.237f, 0.737f, 0.087f, 0.487f };
+
+			for (int32 Leg = 0; Leg < NumLegs; ++Leg)
+			{
+				FGaitSwingData Data = FGaitSwingData();
+				Data.BeginSwing = FMath::Frac(Begins[Leg] + WindowOffset);
+				Data.EndSwing = FMath::Frac(Ends[Leg] + WindowOffset);
+
+				Data.BlendData.BlendInTime = BlendTime;
+				Data.BlendData.BlendOutTime = BlendTime;
+				Data.BlendData.BlendInAcceleration = Acceleration;
+				Data.BlendData.BlendOutAcceleration = Acceleration;
+
+				Data.EventData.bRaiseOnCollisionEvent = true;
+
+				Data.TranslationData.bAffectEffector = true;
+				Data.TranslationData.SwingTranslationCurve = Swing;
+				Data.TranslationData.LerpSpeed = Leg == 1 ? 0.f : 10.f;
+				Data.TranslationData.Offset = FVector(2.f, 0.f, 1.f);
+				Data.TranslationData.bOrientToVelocity = Leg < 2;
+				Data.TranslationData.bAdaptToGroundLevel = Leg != 3;
+				Data.TranslationData.GroundReferenceSocket = GetGroundReferenceName();
+
+				Data.RotationData.bAffectEffector = Leg == 0;
+				Data.RotationData.SwingRotationCurve = Rotation;
+
+				Data.CorrectionData.bAutoAdjustWithIdealEffector = true;
+				Data.CorrectionData.DistanceTresholdToAdjust = 40.f;
+				Data.CorrectionData.CorrectionSwingTranslationCurve = Correction;
+				Data.CorrectionData.bComputeCollision = true;
+				Data.CorrectionData.TraceChannel = ECC_WorldStatic;
+				Data.CorrectionData.bUseCurrentEffector = true;
+				Data.CorrectionData.CollisionSnapOffset = FVector(0.f, 0.f, 2.f);
+				Data.CorrectionData.AbsoluteDirection = FVector(0.f, 0.f, -100.f);
+
+				// The right hind leg follows the left front one.
+				Data.SwingTime.ParentEffector = Leg == 3 ? GetLegName(0) : NAME_None;
+
+				Gait->GaitSwingValues.Add(GetLegName(Leg), Data);
+			}
+
+			Gait->BuildRuntimeTable();
+			return Gait;
+		}
+	};
+
+
+	/** Inputs of one frame of @FGaitTestWalk. */
+	struct FGaitTestFrame
+	{
+		float DeltaTime = 1.f / 60.f;
+		float PlayRate = 1.f;
+		FVector BodyLocation = FVector::ZeroVector;
+		FVector Velocity = FVector::ZeroVector;
+		FRotator ComponentRotation = FRotator::ZeroRotator;
+	};
+
+	/**
+	*	Scripted walk on the floor: straight line, turn with frame hitches, stop, resume faster, then a side push teleporting the body (auto adjust).
+	*	Deterministic and allocation free. @Seed shifts the start location and heading, never the frame times.
+	*/
+	struct FGaitTestWalk
+	{
+		FVector BodyLocation = FVector::ZeroVector;
+		float Heading = 0.f;
+		int32 Frame = 0;
+
+		explicit FGaitTestWalk(int32 Seed = 0)
+		{
+			BodyLocation = FVector(37.f * Seed, -23.f * Seed, 0.f);
+			Heading = 17.f * Seed;
+		}
+
+		/** Length of the script in frames. It loops afterwards. */
+		static constexpr int32 NumFrames = 300;
+
+		/** Delta time of the frame @Frame of any walk. */
+		static float GetDeltaTime(int32 InFrame)
+		{
+			const int32 LocalFrame = InFrame % NumFrames;
+			return LocalFrame >= 120 && LocalFrame < 180 && LocalFrame % 10 == 0 ? 1.f / 30.f : 1.f / 60.f;
+		}
+
+		/** Pose before the first frame. */
+		void Start(FGaitTestFrame& Out) const
+		{
+			Out.BodyLocation = BodyLocation;
+			Out.ComponentRotation = FRotator(0.f, Heading, 0.f);
+		}
+
+		void Next(FGaitTestFrame& Out)
+		{
+			const int32 LocalFrame = Frame % NumFrames;
+
+			Out.DeltaTime = GetDeltaTime(Frame++);
+			Out.PlayRate = 1.f;
+			float Speed = 150.f;
+
+			if (LocalFrame >= 120 && LocalFrame < 180)
+			{
+				// Turn, with a hitch every 10 frames.
+				Heading += 1.5f;
+			}
+			else if (LocalFrame >= 180 && LocalFrame < 210)
+			{
+				Speed = 0.f;
+			}
+			else if (LocalFrame >= 210)
+			{
+				Out.PlayRate = 1.3f;
+				Speed = 220.f;
+			}
+
+			const FRotator HeadingRotation(0.f, Heading, 0.f);
+			Out.Velocity = HeadingRotation.Vector() * Speed;
+			Out.ComponentRotation = HeadingRotation;
+			BodyLocation += Out.Velocity * Out.DeltaTime;
+
+			// Side push.
+			if (LocalFrame == 260)
+			{
+				BodyLocation += HeadingRotation.RotateVector(FVector(0.f, 60.f, 0.f));
+			}
+
+			Out.BodyLocation = BodyLocation;
+		}
+	};
+
+
+	/**
+	*	Override of the plugin settings (@UNobunanimSettings default object) for the duration of a test. Everything is restored on destruction.
+	*	Settings are protected, they are reached by name through reflection.
+	*/
+	struct FGaitTestSettingsScope
+	{
+		UNobunanimSettings* Saved = nullptr;
+
+		FGaitTestSettingsScope()
+		{
+			Saved = NewObject<UNobunanimSettings>(GetTransientPackage(), NAME_None, RF_NoFlags, GetMutableDefault<UNobunanimSettings>());
+			Saved->AddToRoot();
+		}
+
+		~FGaitTestSettingsScope()
+		{
+			UNobunanimSettings* Settings = GetMutableDefault<UNobunanimSettings>();
+			for (FProperty* Property : TFieldRange<FProperty>(UNobunanimSettings::StaticClass(), EFieldIteratorFlags::ExcludeSuper))
+			{
+				Property->CopyCompleteValue_InContainer(Settings, Saved);
+			}
+			Apply();
+
+			Saved->RemoveFromRoot();
+		}
+
+		/** Setting @PropertyName of the default object. Call @Apply once modified. */
+		template<typename T>
+		T& Get(FName PropertyName)
+		{
+			FProperty* Property = FindFProperty<FProperty>(UNobunanimSettings::StaticClass(), PropertyName);
+			check(Property && Property->GetSize() == sizeof(T));
+			return *Property->ContainerPtrToValuePtr<T>(GetMutableDefault<UNobunanimSettings>());
+		}
+
+		/** Notify the settings they changed, like a config reload. */
+		void Apply()
+		{
+			static_cast<UObject*>(GetMutableDefault<UNobunanimSettings>())->PostReloadConfig(nullptr);
+		}
+	};
+
+
+	/**
+	*	Game world with a floor (top at Z = 0), stepped by hand: the test advances the clock and updates the gait instances itself,
+	*	so the gait scheduler (which the instances still register to) never runs.
+	*/
+	struct FGaitTestWorld
+	{
+		UWorld* World = nullptr;
+		/** Mirror of the gait instances clock: delta time they compute for the current frame. */
+		float GaitDeltaTime = 0.f;
+		float LastTime = 0.f;
+
+		FGaitTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false);
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			AActor* Floor = World->SpawnActor<AActor>(SpawnParameters);
+
+			UBoxComponent* Box = NewObject<UBoxComponent>(Floor);
+			Box->SetMobility(EComponentMobility::Static);
+			Box->SetBoxExtent(FVector(1.e5f, 1.e5f, 50.f), false);
+			Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+			Box->SetRelativeLocation(FVector(0.f, 0.f, -50.f));
+			Floor->SetRootComponent(Box);
+			Box->RegisterComponent();
+
+			// One tick so the floor is in the scene query structures, then restart the clock: gait instances start at time 0.
+			World->Tick(LEVELTICK_All, 1.f / 60.f);
+			World->TimeSeconds = World->UnpausedTimeSeconds = World->RealTimeSeconds = World->AudioTimeSeconds = 0.f;
+		}
+
+		~FGaitTestWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		/** Advance the clock by @DeltaTime. */
+		void BeginFrame(float DeltaTime)
+		{
+			World->TimeSeconds += DeltaTime;
+			World->UnpausedTimeSeconds += DeltaTime;
+			World->RealTimeSeconds += DeltaTime;
+			World->DeltaTimeSeconds = DeltaTime;
+
+			GaitDeltaTime = World->TimeSince(LastTime);
+			LastTime = World->TimeSeconds;
+		}
+	};
+
+
+	/** Gait anim instance on a test mesh (feet and ground reference sockets) walking @FGaitTestWalk. */
+	struct FGaitTestInstance
+	{
+		AActor* Actor = nullptr;
+		UGaitTestMeshComponent* Mesh = nullptr;
+		UGaitTestAnimInstance* AnimInstance = nullptr;
+		FGaitTestWalk Walk;
+		FGaitTestFrame Frame;
+		/** Play rate, multiplied by the play rate of the walk. */
+		float BasePlayRate = 1.f;
+
+		FGaitTestInstance(UWorld* World, const TMap<FName, UGaitDataAsset*>& Gaits, int32 Seed, FName GaitName, float InBasePlayRate)
+			: Walk(Seed)
+			, BasePlayRate(InBasePlayRate)
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			Actor = World->SpawnActor<AActor>(SpawnParameters);
+
+			Mesh = NewObject<UGaitTestMeshComponent>(Actor);
+			Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			for (int32 Leg = 0; Leg < NumLegs; ++Leg)
+			{
+				Mesh->TestSockets.Add(GetLegName(Leg), FTransform(GetLegOffset(Leg) + FVector(0.f, 0.f, 5.f - BodyHeight)));
+			}
+			Mesh->TestSockets.Add(GetGroundReferenceName(), FTransform(FVector(0.f, 0.f, -BodyHeight - 10.f)));
+			Actor->SetRootComponent(Mesh);
+			Mesh->RegisterComponent();
+
+			AnimInstance = NewObject<UGaitTestAnimInstance>(Mesh);
+			AnimInstance->AddToRoot();
+			AnimInstance->GroundReflection.FrontSocket = GetLegName(0);
+			AnimInstance->GroundReflection.RightSocket = GetLegName(1);
+			AnimInstance->GroundReflection.LeftSocket = GetLegName(2);
+			AnimInstance->GroundReflection.BackSocket = GetLegName(3);
+			AnimInstance->GroundReflection.bShowDebugPlanes = false;
+
+			Walk.Start(Frame);
+			Pose();
+			AnimInstance->StartGait(Gaits, GaitName);
+		}
+
+		~FGaitTestInstance()
+		{
+			AnimInstance->NativeUninitializeAnimation();
+			AnimInstance->RemoveFromRoot();
+			Actor->Destroy();
+		}
+
+		/** Move the mesh to the current frame of the walk. */
+		void Pose()
+		{
+			Mesh->SetWorldLocationAndRotation(Frame.BodyLocation + FVector(0.f, 0.f, BodyHeight), Frame.ComponentRotation);
+			Mesh->ComponentVelocity = Frame.Velocity;
+			Mesh->SetLastRenderTime(Mesh->GetWorld()->GetTimeSeconds());
+			AnimInstance->SetGaitPlayRate(BasePlayRate * Frame.PlayRate);
+		}
+
+		/** Animation update then gait update, like the animation and the gait scheduler would. */
+		void Update(float DeltaTime)
+		{
+			AnimInstance->NativeUpdateAnimation(DeltaTime);
+			AnimInstance->ProceduralGaitUpdate();
+		}
+	};
+
+
+	/**
+	*	Test world, gait assets ("Walk", blending in and out in @BlendTime) and settings of a gait test, and its instances.
+	*	LOD settings are pinned to a single LOD 0 without debug draw.
+	*	Each frame: @BeginFrame, @PoseInstances, @UpdateInstances, @EndFrame (or just @Step). Records of the instances are reset each frame.
+	*/
+	struct FGaitTestRunner
+	{
+		FGaitTestSettingsScope Settings;
+		FGaitTestAssets Assets;
+		TMap<FName, UGaitDataAsset*> Gaits;
+		FGaitTestWorld World;
+		TArray<TUniquePtr<FGaitTestInstance>> Instances;
+		int32 Frame = 0;
+
+		explicit FGaitTestRunner(bool bBakeCurves = false, float BlendTime = 0.f)
+		{
+			TMap<int32, FProceduralGaitLODSettings>& LODSettings = Settings.Get<TMap<int32, FProceduralGaitLODSettings>>(TEXT("ProceduralGaitLODSettings"));
+			LODSettings.Reset();
+			FProceduralGaitLODSettings& LODSetting = LODSettings.Add(0);
+		#if WITH_EDITORONLY_DATA
+			LODSetting.Debug.bShowCollisionCorrection = false;
+			LODSetting.Debug.bShowLOD = false;
+		#endif
+			Settings.Get<FGaitGroundCacheSettings>(TEXT("GroundCache")).bEnabled = false;
+			Settings.Apply();
+
+			Gaits.Add(TEXT("Walk"), Assets.MakeQuadrupedGait(TEXT("Walk"), 60, 0.f, BlendTime, bBakeCurves));
+		}
+
+		~FGaitTestRunner()
+		{
+			// Before the world.
+			Instances.Reset();
+		}
+
+		FGaitTestInstance& AddInstance(int32 Seed, FName GaitName = TEXT("Walk"), float BasePlayRate = 1.f)
+		{
+			return *Instances.Add_GetRef(MakeUnique<FGaitTestInstance>(World.World, Gaits, Seed, GaitName, BasePlayRate));
+		}
+
+		void BeginFrame()
+		{
+			World.BeginFrame(FGaitTestWalk::GetDeltaTime(Frame++));
+		}
+
+		void PoseInstances()
+		{
+			for (TUniquePtr<FGaitTestInstance>& Instance : Instances)
+			{
+				Instance->Walk.Next(Instance->Frame);
+				Instance->Pose();
+				Instance->AnimInstance->ResetRecords();
+			}
+		}
+
+		void UpdateInstances()
+		{
+			for (TUniquePtr<FGaitTestInstance>& Instance : Instances)
+			{
+				Instance->Update(World.World->GetDeltaSeconds());
+			}
+		}
+
+		/** Flush the gait events of the frame, like the world tick would. */
+		void EndFrame()
+		{
+			if (UGaitEventSubsystem* GaitEvents = UGaitEventSubsystem::Get(World.World))
+			{
+				GaitEvents->Tick(World.World->GetDeltaSeconds());
+			}
+		}
+
+		void Step(int32 NumFrames = 1)
+		{
+			for (int32 i = 0; i < NumFrames; ++i)
+			{
+				BeginFrame();
+				PoseInstances();
+				UpdateInstances();
+				EndFrame();
+			}
+		}
+	};
+
+
+	/**
+	*	Heap allocations of the whole process (FMalloc call counters) between @Begin and @End, accumulated.
+	*	Other threads may allocate meanwhile: a non zero count should be measured again before failing.
+	*/
+	struct FGaitAllocationCounter
+	{
+		uint64 NumAllocations = 0;
+		uint64 Start = 0;
+
+		/** Does the allocator of this build count its calls? */
+		static bool IsSupported()
+		{
+			const uint64 Before = GetTotal();
+			void* Block = FMemory::Malloc(64);
+			const uint64 After = GetTotal();
+			FMemory::Free(Block);
+			return After > Before;
+		}
+
+		FORCEINLINE void Begin() { Start = GetTotal(); }
+		FORCEINLINE void End() { NumAllocations += GetTotal() - Start; }
+
+	private:
+		static uint64 GetTotal()
+		{
+		#if !UE_BUILD_SHIPPING
+			return (uint64)FMalloc::TotalMallocCalls + (uint64)FMalloc::TotalReallocCalls;
+		#else
+			return 0;
+		#endif
+		}
+	};
+
+
+	/** Height of the terrain of the evaluator tests: a slope in both directions. */
+	inline float GetSlopeHeight(float X, float Y)
+	{
+		return 0.1f * X - 0.05f * Y;
+	}
+
+	/** Vertical trace against the slope. */
+	inline bool TraceSlope(const FVector& Origin, const FVector& Dest, FVector& OutImpactPoint)
+	{
+		const float Height = GetSlopeHeight(Origin.X, Origin.Y);
+		if (Origin.Z < Height || Dest.Z > Height)
+		{
+			return false;
+		}
+
+		OutImpactPoint = FVector(Origin.X, Origin.Y, Height);
+		return true;
+	}
+
+	/** Sink recording every side effect of an evaluation, in order. Traces hit the slope. */
+	class FGaitRecordingSink : public IGaitEvaluationSink
+	{
+		public:
+			enum class ERecordType : uint8
+			{
+				Translation,
+				Rotation,
+				Event
+			};
+
+			struct FRecord
+			{
+				ERecordType Type;
+				EGaitEventType EventType;
+				FName Key;
+				FVector Value;
+				bool bLerp;
+				float LerpSpeed;
+			};
+
+			/** Side effects since the last @Reset. */
+			TArray<FRecord> Records;
+			/** Socket locations returned as correction origins, indexed by slot. */
+			const FVector* CorrectionOrigins = nullptr;
+			int32 NumTraces = 0;
+
+			FGaitRecordingSink()
+			{
+				Records.Reserve(64);
+			}
+
+			void Reset()
+			{
+				Records.Reset();
+				NumTraces = 0;
+			}
+
+			virtual void EmitEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed) override
+			{
+				Records.Add({ ERecordType::Translation, EGaitEventType::Footfall, Key, Translation, bLerp, LerpSpeed });
+			}
+
+			virtual void EmitEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed) override
+			{
+				Records.Add({ ERecordType::Rotation, EGaitEventType::Footfall, Key, FVector(Rotation.Pitch, Rotation.Yaw, Rotation.Roll), false, LerpSpeed });
+			}
+
+			virtual void EmitGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location) override
+			{
+				Records.Add({ ERecordType::Event, Type, Key, Location, false, 0.f });
+			}
+
+			virtual FVector GetCorrectionOrigin(int32 Slot, const FName& SocketName) override
+			{
+				return CorrectionOrigins ? CorrectionOrigins[Slot] : FVector::ZeroVector;
+			}
+
+			virtual bool TraceCorrection(int32 Slot, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, FVector& OutImpactPoint) override
+			{
+				++NumTraces;
+				return TraceSlope(Origin, Dest, OutImpactPoint);
+			}
+	};
+
+	/** Gait set of @Gaits, with one effector slot per leg in @OutState, starting with the first gait. */
+	inline void BindGaits(const TMap<FName, UGaitDataAsset*>& Gaits, FGaitSetBinding& OutBinding, FGaitEvaluationState& OutState)
+	{
+		OutBinding.Build(Gaits);
+		OutState = FGaitEvaluationState();
+		OutState.Effectors.SetNum(OutBinding.NumSlots());
+		OutState.CurrentGaitIndex = 0;
+	}
+
+	/** Set the socket (5 cm above the slope) and ground locations of the legs at @Frame to the effectors of @State, like the front ends UpdateEffectors. */
+	inline void ApplyFrame(const FGaitTestFrame& Frame, const FGaitSetBinding& Binding, FGaitEvaluationState& State, FVector* OutSlotIdeals)
+	{
+		for (int32 Slot = 0, n = Binding.NumSlots(); Slot < n; ++Slot)
+		{
+			for (int32 Leg = 0; Leg < NumLegs; ++Leg)
+			{
+				if (Binding.SlotNames[Slot] == GetLegName(Leg))
+				{
+					const FVector Foot = Frame.BodyLocation + Frame.ComponentRotation.RotateVector(GetLegOffset(Leg));
+					const float Height = GetSlopeHeight(Foot.X, Foot.Y);
+					State.Effectors[Slot].IdealEffectorLocation = OutSlotIdeals[Slot] = FVector(Foot.X, Foot.Y, Height + 5.f);
+					State.Effectors[Slot].GroundLocation = FVector(Foot.X, Foot.Y, Height);
+				}
+			}
+		}
+	}
+
+	/** Evaluation inputs of @Frame. */
+	inline FGaitEvaluationInputs MakeInputs(const FGaitTestFrame& Frame, const FGaitSetBinding& Binding, const FProceduralGaitLODSettings& LODSetting, uint32 UpdateCounter)
+	{
+		FGaitEvaluationInputs Inputs;
+		Inputs.Binding = &Binding;
+		Inputs.LODSetting = &LODSetting;
+		Inputs.DeltaTime = Frame.DeltaTime;
+		Inputs.PlayRate = Frame.PlayRate;
+		Inputs.Velocity = Frame.Velocity;
+		Inputs.ComponentRotation = Frame.ComponentRotation;
+		Inputs.UpdateCounter = UpdateCounter;
+		return Inputs;
+	}
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
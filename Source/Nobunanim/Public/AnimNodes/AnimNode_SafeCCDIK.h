@@ -27,7 +27,7 @@ public:
 
 	/** Child bones which are overlapping this bone.
 	 * They have a zero length distance, so they will inherit this bone's transformation. */
-	TArray<int32> ChildZeroLengthTransformIndices;
+	TArray<int32, TInlineAllocator<4>> ChildZeroLengthTransformIndices;
 
 	float CurrentAngleDelta;
 
@@ -106,6 +106,12 @@ public:
 	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
 	// End of FAnimNode_SkeletalControlBase interface
 
+	/**
+	*	Pose independent part of EvaluateSkeletalControl_AnyThread: solve the chain of @InOutBoneTransforms (component space, root to tip, of
+	*	local transforms @InLocalTransforms) toward @TargetLocation (component space), in place. Return true if a bone moved.
+	*/
+	bool SolveChain(TArray<FBoneTransform>& InOutBoneTransforms, const TArray<FTransform>& InLocalTransforms, const FVector& TargetLocation);
+
 private:
 	// FAnimNode_SkeletalControlBase interface
 	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
@@ -118,6 +124,11 @@ private:
 
 	// return true if updated
 	bool UpdateChainLink(TArray<SafeCCDIKChainLink>& Chain, int32 LinkIndex, const FVector& TargetPos) const;
+
+	/** Scratch arrays of EvaluateSkeletalControl_AnyThread, kept between evaluations so they don't allocate once warm. */
+	TArray<FCompactPoseBoneIndex> BoneIndices;
+	TArray<FTransform> LocalTransforms;
+	TArray<SafeCCDIKChainLink> Chain;
 public:
 #if WITH_EDITOR
 #if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <Engine/EngineTypes.h>
+#include <CollisionQueryParams.h>
+
+
+/** What a gait trace is used for. Part of the async trace key. */
+enum class EGaitAsyncTraceKind : uint8
+{
+	/** Stance IK correction. */
+	Correction,
+	/** Ground adaptation (@bAdaptToGroundLevel). */
+	Ground,
+	/** Ground reflection probe (@FGroundReflectionSocketData). */
+	GroundReflection,
+};
+
+
+/**
+*	Asynchronous traces of one gait owner (anim instance or component), see @FProceduralGaitLODSettings::bUseAsyncTraces.
+*	A trace requested during a gait update is issued by @Flush with AsyncLineTraceByChannel (and AsyncSweepByChannel for the IKL_Level2 fallback).
+*	Its result is consumed by the next request of the same key, extrapolated along the velocity to hide the latency.
+*	@Trace can be called from the gait compute phase (any thread). @Flush and the trace delegates run on the game thread.
+*/
+struct NOBUNANIM_API FGaitAsyncTraceQueue
+{
+	public:
+		/** Key of the trace of an effector slot (or ground reflection probe). */
+		static int32 MakeKey(int32 Slot, EGaitAsyncTraceKind Kind) { return Slot * ((int32)EGaitAsyncTraceKind::GroundReflection + 1) + (int32)Kind; }
+
+		/**
+		*	Consume the last result of @Key (into @OutHits) and request a new trace for the next update.
+		*	Return true if the consumed result has a blocking hit, false if there is no hit or no result yet.
+		*/
+		bool Trace(int32 Key, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, float SphereCastRadius, bool bSweepFallback,
+			const FCollisionQueryParams& Params, const FVector& Velocity, float Now, bool bExtrapolate, TArray<FHitResult>& OutHits);
+
+		/** Can the next @Trace of @Key at @Now consume a result (done and recent enough), with or without hit? */
+		bool IsResultReady(int32 Key, float Now) const;
+
+		/** Issue the requested traces. Results are routed back through delegates weakly bound to @Owner (which must own this queue). Game thread. */
+		void Flush(UWorld* World, UObject* Owner);
+
+		/** Drop all requests and results. */
+		void Reset();
+
+	private:
+		struct FRequest
+		{
+			int32 Key;
+			FVector Origin;
+			FVector Dest;
+			ECollisionChannel Channel;
+			float Radius;
+			bool bSweepFallback;
+			float Time;
+			FCollisionQueryParams Params;
+		};
+
+		struct FResult
+		{
+			TArray<FHitResult> LineHits;
+			TArray<FHitResult> SweepHits;
+			/** World time of the request. */
+			float Time = 0.f;
+			/** Ignore late results of replaced requests. */
+			uint32 Serial = 0;
+			bool bLineDone = false;
+			bool bSweepDone = false;
+			bool bSweepFallback = false;
+			bool bConsumed = true;
+		};
+
+		/** Called by the async trace delegates. */
+		void OnTraceDone(int32 Key, uint32 Serial, bool bSweep, const FTraceDatum& Datum);
+
+		/** Requests of the current update. */
+		TArray<FRequest> Requests;
+		/** Last result of each key. */
+		TMap<int32, FResult> Results;
+		uint32 NextSerial = 0;
+};
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+class UGaitDataAsset;
+struct FGaitRuntimeTable;
+
+
+/** Output of one effector of one crowd agent by the last @FGaitCrowdEvaluator::Evaluate. */
+struct FGaitCrowdEffectorOutput
+{
+	/** Effector translation, see IProceduralGaitInterface::UpdateEffectorTranslation. */
+	FVector Translation = FVector::ZeroVector;
+	/** Effector rotation, see IProceduralGaitInterface::UpdateEffectorRotation. */
+	FRotator Rotation = FRotator::ZeroRotator;
+	float LerpSpeed = 0.f;
+	/** Were @Translation and @Rotation written by the last update? */
+	bool bTranslation = false;
+	bool bRotation = false;
+	/** Should @Translation be lerped? */
+	bool bLerp = false;
+	/** The effector is in stance and needs its collision correction: trace it, then call @FGaitCrowdEvaluator::ApplyCorrection on hit. */
+	bool bNeedsCorrection = false;
+};
+
+
+/**
+*	Gait update of a crowd of agents playing the same gait, for crowds too large for one UObject per agent.
+*	The per agent state (timer, blend, force swing interval, block time, effector locations) is kept in structure of arrays form: one array per
+*	value and per effector, agents contiguous and padded to the SIMD width. Phase classification (swing windows), curve sampling and offset
+*	composition run as VectorRegister kernels over 4 agents at a time, and the results are written to per agent effector output arrays.
+*	Follows the gait update of @FGaitEvaluator for agents staying on one gait, except:
+*	- no gait transition: an agent changing gait moves to the evaluator of the new gait (blending in again),
+*	- no scene query: stance collision corrections are flagged in the outputs and resolved by the owner after the update (see @ApplyCorrection),
+*	  so the auto adjust distance of this update is measured before the correction,
+*	- one delta time for every agent,
+*	- no event and no debug draw.
+*	Not thread safe.
+*/
+struct NOBUNANIM_API FGaitCrowdEvaluator
+{
+	public:
+		/** Evaluate @InGait. Removes every agent. */
+		void Initialize(const UGaitDataAsset* InGait);
+		/** Remove every agent. */
+		void Reset();
+
+		FORCEINLINE const UGaitDataAsset* GetGait() const { return Gait; }
+		/** Number of agents. */
+		FORCEINLINE int32 Num() const { return NumAgents; }
+		/** Number of effectors of each agent, indexed like the runtime table of the gait. */
+		FORCEINLINE int32 NumEffectors() const { return EffectorCount; }
+
+		/** Add an agent with every effector at @Location. Return its id, valid until removed. */
+		int32 AddAgent(const FVector& Location, float PlayRate = 1.f);
+		void RemoveAgent(int32 AgentId);
+		FORCEINLINE bool IsValidAgent(int32 AgentId) const { return AgentIndices.IsValidIndex(AgentId) && AgentIndices[AgentId] != INDEX_NONE; }
+
+		/** Inputs of the next @Evaluate. @IdealLocations and @GroundLocations hold @NumEffectors locations (world space). */
+		void SetAgentInputs(int32 AgentId, const FVector& Velocity, const FRotator& ComponentRotation, const FVector* IdealLocations, const FVector* GroundLocations);
+		void SetAgentPlayRate(int32 AgentId, float PlayRate);
+
+		/** Advance every agent by @DeltaTime. */
+		void Evaluate(float DeltaTime);
+
+		/** Outputs of the last @Evaluate for @AgentId, one per effector. */
+		void GetAgentOutputs(int32 AgentId, TArray<FGaitCrowdEffectorOutput>& OutOutputs) const;
+		/** Gait time (0-1) of @AgentId. */
+		float GetAgentTime(int32 AgentId) const;
+
+		/** Collision correction hit of an effector flagged by @Evaluate: the effector lands at @Location, which becomes its output. */
+		void ApplyCorrection(int32 AgentId, int32 EffectorIndex, const FVector& Location);
+
+	private:
+		/** Per agent channels. */
+		enum EAgentChannel
+		{
+			AC_TimeBuffer,
+			AC_CurrentTime,
+			AC_PlayRate,
+			/** 1 if the agent plays the gait (velocity only gaits idle without velocity). */
+			AC_Active,
+			/** Rotation matrix of the last non zero velocity, row major (9 channels). */
+			AC_Orient,
+			/** Rotation matrix of the component, row major (9 channels). */
+			AC_Component = AC_Orient + 9,
+			AC_Num = AC_Component + 9
+		};
+
+		/** Per effector and per agent channels. Vectors take 3 channels (X, Y, Z or Pitch, Yaw, Roll). Booleans are 0 or 1. */
+		enum EEffectorChannel
+		{
+			EC_BlendValue,
+			EC_BeginForceSwing,
+			EC_EndForceSwing,
+			EC_BlockTime,
+			EC_ForceSwing,
+			EC_CorrectionIK,
+			EC_Current,
+			EC_Ideal = EC_Current + 3,
+			EC_Ground = EC_Ideal + 3,
+			EC_OutTranslation = EC_Ground + 3,
+			EC_OutRotation = EC_OutTranslation + 3,
+			EC_OutLerpSpeed = EC_OutRotation + 3,
+			EC_OutTranslationFlag,
+			EC_OutRotationFlag,
+			EC_OutLerpFlag,
+			EC_OutCorrectionFlag,
+			EC_Num
+		};
+
+		/** SIMD width. */
+		static constexpr int32 Width = 4;
+
+		const UGaitDataAsset* Gait = nullptr;
+		const FGaitRuntimeTable* Table = nullptr;
+		int32 EffectorCount = 0;
+
+		int32 NumAgents = 0;
+		/** Allocated agents per channel, multiple of @Width. */
+		int32 Stride = 0;
+		/** [Channel][Agent]. */
+		TArray<float, TAlignedHeapAllocator<16>> AgentData;
+		/** [Channel][Effector][Agent]. */
+		TArray<float, TAlignedHeapAllocator<16>> EffectorData;
+
+		/** Agent index of each id, INDEX_NONE if free. */
+		TArray<int32> AgentIndices;
+		/** Id of each agent index. */
+		TArray<int32> AgentIds;
+		/** Free ids. */
+		TArray<int32> FreeIds;
+
+		FORCEINLINE float* AgentChannel(int32 Channel) { return &AgentData[Channel * Stride]; }
+		FORCEINLINE const float* AgentChannel(int32 Channel) const { return &AgentData[Channel * Stride]; }
+		FORCEINLINE float* EffectorChannel(int32 Channel, int32 Effector) { return &EffectorData[(Channel * EffectorCount + Effector) * Stride]; }
+		FORCEINLINE const float* EffectorChannel(int32 Channel, int32 Effector) const { return &EffectorData[(Channel * EffectorCount + Effector) * Stride]; }
+
+		/** Reallocate the channels for @NewStride agents, keeping the current ones. */
+		void Reserve(int32 NewStride);
+		/** Copy every channel of the agent @From to @To. */
+		void CopyAgent(int32 From, int32 To);
+		/** Evaluate the effector @EffectorIndex of the agents [@First, @First + @Width). */
+		void EvaluateEffector(int32 EffectorIndex, int32 First, float DeltaTime);
+};
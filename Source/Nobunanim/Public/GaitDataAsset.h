@@ -4,6 +4,7 @@
 
 #include <Engine/DataAsset.h>
 #include <Runtime/Core/Public/Containers/Map.h>
+#include <Math/Float16.h>
 
 #include "Nobunanim/Public/ProceduralGaitInterface.h"
 
@@ -47,6 +48,194 @@ struct FGaitGroundReflectionData
 	TArray<FGaitGroundReflectionPlaneData> Planes;};
 
 
+/**
+* Curve pre-sampling settings of a gait asset.
+*/
+USTRUCT(BlueprintType)
+struct FGaitCurveBakeSettings
+{
+	GENERATED_BODY()
+
+	/** Should swing and blend curves be pre-sampled into lookup tables when the asset loads? */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", EditAnywhere, BlueprintReadOnly)
+	bool bBakeCurves = false;
+
+	/** Maximum deviation allowed between a lookup table and its source curve. Resolution doubles until it is reached. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0", EditCondition = "bBakeCurves"))
+	float Tolerance = 0.01f;
+
+	/** Initial number of samples per curve. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "2", ClampMax = "4096", EditCondition = "bBakeCurves"))
+	int32 MinResolution = 16;
+
+	/** Maximum number of samples per curve. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "2", ClampMax = "4096", EditCondition = "bBakeCurves"))
+	int32 MaxResolution = 256;
+
+	/** Store samples as half floats. Halves the memory at the cost of precision (included in the reported deviation). */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", EditAnywhere, BlueprintReadOnly, meta = (EditCondition = "bBakeCurves"))
+	bool bHalfPrecision = false;
+};
+
+/**
+* Result of the pre-sampling of one curve.
+*/
+USTRUCT(BlueprintType)
+struct FGaitCurveBakeReport
+{
+	GENERATED_BODY()
+
+	/** Baked curve. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", VisibleAnywhere)
+	FString CurveName;
+
+	/** Number of samples of the lookup table. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", VisibleAnywhere)
+	int32 Resolution = 0;
+
+	/** Maximum deviation measured between the lookup table and the source curve on [0,1]. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", VisibleAnywhere)
+	float MaxDeviation = 0.f;
+
+	/** Is @MaxDeviation under the asset tolerance? */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", VisibleAnywhere)
+	bool bWithinTolerance = true;
+};
+
+/** Fixed resolution lookup table of a curve sampled on [0,1]. */
+struct FGaitCurveLUT
+{
+	/** First value in the owning table sample storage. */
+	int32 FirstValue = 0;
+	/** Number of samples. */
+	int32 NumSamples = 0;
+};
+
+/** Vector curve used at runtime, optionally backed by a lookup table. Evaluates to FVector(1,1,1) if not set. */
+struct FGaitRuntimeVectorCurve
+{
+	const UCurveVector* Curve = nullptr;
+	int32 LUTIndex = INDEX_NONE;
+};
+
+/** Float curve used at runtime, optionally backed by a lookup table. Evaluates to 1 if not set. */
+struct FGaitRuntimeFloatCurve
+{
+	const UCurveFloat* Curve = nullptr;
+	int32 LUTIndex = INDEX_NONE;
+};
+
+/**
+* Baked per-effector data read on every gait update.
+* Only the fields needed each tick live here, stance correction and debug data stay in @FGaitSwingData.
+*/
+struct FGaitRuntimeEffector
+{
+	/** Begin of the swing in absolute time (0-1).*/
+	float BeginSwing = 0.f;
+	/** End of the swing in absolute time (0-1).*/
+	float EndSwing = 1.f;
+	/** Index of SwingTime.ParentEffector in the same runtime table. INDEX_NONE if unset or unknown. */
+	int32 ParentIndex = INDEX_NONE;
+
+	/** Blend in time in second. */
+	float BlendInTime = 0.f;
+	/** Blend out time in second. */
+	float BlendOutTime = 0.f;
+	/** @LerpSpeed acceleration during blend in. */
+	FGaitRuntimeFloatCurve BlendInAcceleration;
+	/** @LerpSpeed acceleration during blend out. */
+	FGaitRuntimeFloatCurve BlendOutAcceleration;
+
+	/** Translation swing curve. */
+	FGaitRuntimeVectorCurve SwingTranslationCurve;
+	/** Translation swing curve used during a force swing. */
+	FGaitRuntimeVectorCurve CorrectionSwingTranslationCurve;
+	/** Rotation swing curve. */
+	FGaitRuntimeVectorCurve SwingRotationCurve;
+
+	/** TranslationFactor * TranslationSwingScale. */
+	FVector TranslationScale = FVector(1.f, 1.f, 1.f);
+	/** Offset * TranslationFactor. */
+	FVector TranslationOffset = FVector::ZeroVector;
+	/** Factor to apply on rotation swing.*/
+	FVector RotationFactor = FVector(1.f, 1.f, 1.f);
+	/** Lerp speed of the translation. */
+	float LerpSpeed = 10.f;
+	/** Distance treshold to adjust (if enabled) if too far from ideal effector. */
+	float DistanceTresholdToAdjust = 100.f;
+
+	/** Transform space to compute effector. */
+	TEnumAsByte<ERelativeTransformSpace> TransformSpace = ERelativeTransformSpace::RTS_World;
+	uint8 bAffectTranslation : 1;
+	uint8 bAffectRotation : 1;
+	uint8 bOrientToVelocity : 1;
+	uint8 bAdaptToGroundLevel : 1;
+	uint8 bAutoAdjustWithIdealEffector : 1;
+	uint8 bComputeCollision : 1;
+	uint8 bRaiseOnCollisionEvent : 1;
+
+	FGaitRuntimeEffector()
+		: bAffectTranslation(true)
+		, bAffectRotation(false)
+		, bOrientToVelocity(true)
+		, bAdaptToGroundLevel(true)
+		, bAutoAdjustWithIdealEffector(true)
+		, bComputeCollision(false)
+		, bRaiseOnCollisionEvent(false)
+	{
+	}
+};
+
+/**
+* Flat, index-addressed form of UGaitDataAsset::GaitSwingValues.
+* All arrays are index-aligned: effector i is described by EffectorNames[i], Effectors[i] and SwingData[i].
+*/
+struct NOBUNANIM_API FGaitRuntimeTable
+{
+	/** Effector names. */
+	TArray<FName> EffectorNames;
+	/** Hot per-effector data. */
+	TArray<FGaitRuntimeEffector> Effectors;
+	/** Cold per-effector data (stance correction, debug). Points into UGaitDataAsset::GaitSwingValues. */
+	TArray<const FGaitSwingData*> SwingData;
+
+	/** Curve lookup tables. */
+	TArray<FGaitCurveLUT> LUTs;
+	/** LUT samples, components interleaved (3 per sample for vector curves). Used if not @bHalfPrecision. */
+	TArray<float> Values;
+	/** LUT samples, components interleaved (3 per sample for vector curves). Used if @bHalfPrecision. */
+	TArray<FFloat16> HalfValues;
+	/** Are LUT samples stored as half floats. */
+	bool bHalfPrecision = false;
+
+	/** Has the table been built from the owning asset. */
+	bool bBuilt = false;
+	/** Build version, unique across every table build (0 until built). Changes when the owning asset rebuilds the table, e.g. when edited while playing. */
+	uint32 Version = 0;
+
+	/** Return the index of @EffectorName, INDEX_NONE if not found. */
+	FORCEINLINE int32 Find(FName EffectorName) const { return EffectorNames.IndexOfByKey(EffectorName); }
+	FORCEINLINE int32 Num() const { return Effectors.Num(); }
+	void Reset();
+
+	/** Evaluate @Curve at @Time, through its lookup table if baked. */
+	FVector SampleVector(const FGaitRuntimeVectorCurve& Curve, float Time) const;
+	/** Evaluate @Curve at @Time, through its lookup table if baked. */
+	float SampleFloat(const FGaitRuntimeFloatCurve& Curve, float Time) const;
+
+	/** Evaluate @Curve at the @Num @Times. Components are written to separate arrays (structure of arrays). */
+	void SampleVectorBatch(const FGaitRuntimeVectorCurve& Curve, const float* Times, int32 Num, float* OutX, float* OutY, float* OutZ) const;
+	/** Evaluate @Curve at the @Num @Times. */
+	void SampleFloatBatch(const FGaitRuntimeFloatCurve& Curve, const float* Times, int32 Num, float* OutValues) const;
+
+private:
+	/** Lerp between the two samples surrounding @Time (see @FGaitMath::SampleLUT). */
+	template<int32 NumComponents>
+	void SampleLUT(const FGaitCurveLUT& LUT, float Time, float* OutValues) const;
+};
+
+
 /**
  * 
  */
@@ -72,8 +261,88 @@ class NOBUNANIM_API UGaitDataAsset : public UPrimaryDataAsset
 		UPROPERTY(Category = "[NOBUNANIM]|Gait Data", EditAnywhere, BlueprintReadOnly)
 		bool bComputeWithVelocityOnly = true;
 
+		/** Pre-sampling of the swing and blend curves. */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", EditAnywhere, BlueprintReadOnly)
+		FGaitCurveBakeSettings CurveBakeSettings;
+
+#if WITH_EDITORONLY_DATA
+		/** Deviation of each baked curve from its source. Updated each time the runtime table is built. */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Data|Curve Baking", VisibleAnywhere, Transient)
+		TArray<FGaitCurveBakeReport> CurveBakeReport;
+#endif
+
+	private:
+		/** Baked form of @GaitSwingValues. */
+		FGaitRuntimeTable RuntimeTable;
+
 	public:
 		/** Return the ratio according to the animation framecount. (1 sec = 60frames). */
 		UFUNCTION(Category = "[NOBUNANIM]|Gait Data", BlueprintCallable)
 		float GetFrameRatio() const;
+
+		/** Return the baked runtime table. Only the game thread builds it if needed: bind the asset (@FGaitSetBinding::Build) before evaluating it from workers. */
+		const FGaitRuntimeTable& GetRuntimeTable() const;
+
+		/** Rebuild the runtime table from @GaitSwingValues. */
+		void BuildRuntimeTable();
+		/** Build the runtime table if it isn't built yet (assets created at runtime never go through PostLoad). Game thread only. */
+		void ConditionalBuildRuntimeTable();
+
+	private:
+		/** Sample @Curve into a lookup table of @RuntimeTable. Return the LUT index, INDEX_NONE if @Curve is null or baking is disabled. */
+		int32 BakeCurve(const UCurveBase* Curve, int32 NumComponents, const FString& CurveName, TMap<const UCurveBase*, int32>& BakedCurves);
+
+	public:
+	/** UNREAL METHODS
+	*/
+		virtual void PostLoad() override;
+#if WITH_EDITOR
+		virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+		virtual void PostEditUndo() override;
+#endif
+};
+
+
+/**
+* Binding of a set of gaits (name -> asset) to effector slots owned by a gait instance.
+* Slots are the union of the effectors of every gait, so per-effector state survives gait switches.
+*/
+struct NOBUNANIM_API FGaitSetBinding
+{
+	/** Gait names, in lexical order (gait indices are replicated), index-aligned with @Assets. */
+	TArray<FName> GaitNames;
+	/** Gait assets. */
+	TArray<const UGaitDataAsset*> Assets;
+	/** Effector name of each slot. */
+	TArray<FName> SlotNames;
+
+	/** Build the binding from a gait set. */
+	void Build(const TMap<FName, UGaitDataAsset*>& GaitsData);
+	void Reset();
+
+	FORCEINLINE bool IsBuilt() const { return bBuilt; }
+	/** Has the runtime table of a bound gait been rebuilt since @Build (asset edited while playing)? Slots and effector indices may be stale: build again. Game thread only. */
+	bool IsOutdated() const;
+	FORCEINLINE int32 NumGaits() const { return Assets.Num(); }
+	FORCEINLINE int32 NumSlots() const { return SlotNames.Num(); }
+	FORCEINLINE int32 FindGait(FName GaitName) const { return GaitName.IsNone() ? INDEX_NONE : GaitNames.IndexOfByKey(GaitName); }
+	FORCEINLINE FName GetGaitName(int32 GaitIndex) const { return GaitNames.IsValidIndex(GaitIndex) ? GaitNames[GaitIndex] : NAME_None; }
+	FORCEINLINE const FGaitRuntimeTable& GetTable(int32 GaitIndex) const { return Assets[GaitIndex]->GetRuntimeTable(); }
+
+	/** Slot of the effector @EffectorIndex of the gait @GaitIndex. */
+	FORCEINLINE int32 GetSlot(int32 GaitIndex, int32 EffectorIndex) const { return SlotOfEffector[GaitOffsets[GaitIndex] + EffectorIndex]; }
+	/** Effector index in the gait @GaitIndex of the slot @Slot. INDEX_NONE if this gait doesn't drive the slot. */
+	FORCEINLINE int32 GetEffector(int32 GaitIndex, int32 Slot) const { return EffectorOfSlot[GaitIndex * SlotNames.Num() + Slot]; }
+
+private:
+	/** First entry of each gait in @SlotOfEffector. */
+	TArray<int32> GaitOffsets;
+	/** Flattened [Gait][Effector] -> slot. */
+	TArray<int32> SlotOfEffector;
+	/** Flattened [Gait][Slot] -> effector index. */
+	TArray<int32> EffectorOfSlot;
+	/** Runtime table version of each gait when bound. */
+	TArray<uint32> TableVersions;
+	/** Has @Build been called since the last @Reset. */
+	bool bBuilt = false;
 };
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <Subsystems/WorldSubsystem.h>
+
+#include "GaitEvaluationCacheSubsystem.generated.h"
+
+struct FGaitRuntimeTable;
+
+
+/** Curves of a runtime effector shared by @UGaitEvaluationCacheSubsystem. */
+enum class EGaitSharedCurve : uint8
+{
+	SwingTranslation,
+	CorrectionSwingTranslation,
+	SwingRotation,
+	BlendInAcceleration,
+	BlendOutAcceleration
+};
+
+
+/**
+*	Cache of gait curve samples shared by the gait instances.
+*	Instances playing the same gait sample the same curves at close phases: samples are keyed by (runtime table, effector, curve, quantized
+*	phase) and evaluated at the quantized phase, so every instance reads the same value whoever fills the entry. Only the orientation and
+*	offset composition stays per instance. The quantization step trades accuracy against hit rate (see @FGaitSharedEvaluationSettings).
+*	Lock free: every thread of the compute phase (scheduler workers, anim workers, game thread) fills and reads its own samples.
+*	Samples only depend on the runtime table, so they are kept across frames and worlds: a table rebuilt while playing (see
+*	@FGaitRuntimeTable::Version) is sampled again. The world subsystem enables the cache and reports its stats.
+*/
+UCLASS()
+class NOBUNANIM_API UGaitEvaluationCacheSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	protected:
+	/** UNREAL METHODS
+	*/
+		virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	public:
+		virtual void Tick(float DeltaTime) override;
+		virtual TStatId GetStatId() const override;
+
+
+	public:
+	/** EVALUATION CACHE
+	*/
+		/** Cache of @World, or nullptr if the shared evaluation is disabled (see @UNobunanimSettings). */
+		static UGaitEvaluationCacheSubsystem* Get(const UWorld* World);
+
+		/** Sample the vector @Curve of the effector @EffectorIndex of @Table at @Phase, through @Cache if not null. */
+		static FVector SampleVector(UGaitEvaluationCacheSubsystem* Cache, const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase);
+		/** Sample the float @Curve of the effector @EffectorIndex of @Table at @Phase, through @Cache if not null. */
+		static float SampleFloat(UGaitEvaluationCacheSubsystem* Cache, const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase);
+
+		/** Number of samples cached by every thread. */
+		UFUNCTION(Category = "[NOBUNANIM]|Evaluation Cache", BlueprintPure)
+		int32 GetNumSamples() const;
+
+
+	private:
+		/** Find or evaluate the sample of @Curve at the quantized @Phase. */
+		FVector FindOrSample(const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase);
+		/** Evaluate @Curve at @Phase without the cache. */
+		static FVector Sample(const FGaitRuntimeTable& Table, int32 EffectorIndex, EGaitSharedCurve Curve, float Phase);
+};
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+#include "Nobunanim/Public/GaitDataAsset.h"
+#include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Public/GaitEventSubsystem.h"
+#include "Nobunanim/Public/GaitReplicatedState.h"
+
+#include "GaitEvaluator.generated.h"
+
+class UGaitEvaluationCacheSubsystem;
+
+
+USTRUCT(BlueprintType)
+struct FGaitEffectorData
+{
+	GENERATED_BODY()
+
+	/** @to do: Documentation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
+	FVector CurrentEffectorLocation = FVector::ZeroVector;
+	/** @to do: Documentation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
+	FVector IdealEffectorLocation = FVector::ZeroVector;
+
+	/** @to do: Documentation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
+	FVector GroundLocation = FVector::ZeroVector;
+
+	/** @to do: Documentation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
+	bool bForceSwing = false;
+
+	/** @to do: Documentation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
+	bool bCorrectionIK = false;
+
+	/** @to do: Documentation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
+	float BeginForceSwingInterval = 0;
+	/** @to do: Documentation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
+	float EndForceSwingInterval = 0;
+
+	/** @to do: Documentation. */
+	float CurrentBlendValue = 0.f;
+	/** Index of the gait driving this effector in the owner gait binding. INDEX_NONE means the current gait. */
+	int32 CurrentGaitIndex = INDEX_NONE;
+	/** @to do: Documentation. */
+	float BlockTime = -1.f;
+	/** Ground adaptation of the last ground trace, reused by the updates skipping it (see @FProceduralGaitLODSettings::TraceStride). */
+	FVector GroundOffset = FVector::ZeroVector;
+	/** Planted effector (corrected stance): gait time buffer at which its swing begins. Until then, the phase tests are skipped. Negative if not planted. */
+	float PlantedUntil = -1.f;
+	/** Was the effector in swing at its last update? Raises the swing begin and end events (see @UGaitEventSubsystem). */
+	bool bSwinging = false;
+};
+
+
+/** Gait state of one instance, advanced by @FGaitEvaluator::Evaluate. */
+struct NOBUNANIM_API FGaitEvaluationState
+{
+	/** Index of the current gait in the gait set binding. */
+	int32 CurrentGaitIndex = INDEX_NONE;
+	/** Index of the pending gait in the gait set binding. Use to switch gait with blend time. */
+	int32 PendingGaitIndex = INDEX_NONE;
+	/** Current time of the cycle (in absolute time [0,1]). */
+	float CurrentTime = 0.f;
+	/** Current time buffer used to compute current time. */
+	float TimeBuffer = 0.f;
+	/** Phase left to catch up with the last applied replicated state (in cycles, see @FGaitReplicatedState). */
+	float PhaseError = 0.f;
+	/** Last non zero velocity. Effectors oriented to velocity keep it while stopping. */
+	FVector LastVelocity = FVector::ZeroVector;
+	/** Effectors data, indexed by gait set binding slot. */
+	TArray<FGaitEffectorData> Effectors;
+
+	/** Current gait, phase and blend progress in @Binding, quantized for replication. */
+	FGaitReplicatedState GetReplicatedState(const FGaitSetBinding& Binding) const;
+
+	/**
+	*	Resynchronize on @Replicated, a state of the server in the same gait set @Binding. Gait switches go through @SwitchGait, the gait switch
+	*	of the front end (i.e. UpdateGaitMode). The first state is adopted as is, then gait changes blend as usual and the phase error is left
+	*	in @PhaseError for the next evaluations to catch up.
+	*/
+	void ApplyReplicatedState(const FGaitReplicatedState& Replicated, const FGaitSetBinding& Binding, TFunctionRef<void(FName GaitName)> SwitchGait);
+};
+
+
+/** Inputs of one @FGaitEvaluator::Evaluate, gathered by the front end. */
+struct NOBUNANIM_API FGaitEvaluationInputs
+{
+	/** Gait set of the state. */
+	const FGaitSetBinding* Binding = nullptr;
+	/** LOD settings of the update. */
+	const FProceduralGaitLODSettings* LODSetting = nullptr;
+	/** Shared curve samples, nullptr to sample the curves directly. */
+	UGaitEvaluationCacheSubsystem* EvaluationCache = nullptr;
+	/** Off-screen policy in effect. PhaseOnly writes no effector output and skips the collision correction traces, footfalls land where the effectors are. */
+	EGaitOffscreenPolicy OffscreenPolicy = EGaitOffscreenPolicy::KeepUpdating;
+
+	float DeltaTime = 0.f;
+	float PlayRate = 1.f;
+	/** Owner velocity. */
+	FVector Velocity = FVector::ZeroVector;
+	/** Mesh rotation, orients the effectors not oriented to velocity. */
+	FRotator ComponentRotation = FRotator::ZeroRotator;
+
+	/** Update counter and instance phase of the trace phase (see @FProceduralGaitLODSettings::IsTracePhase). */
+	uint32 UpdateCounter = 0;
+	uint32 TracePhase = 0;
+	/** May the collision correction be computed (is there a world to trace)? */
+	bool bCanTrace = true;
+	/** Is the effector debug shown? Every effector is then fully evaluated. */
+	bool bShowDebug = false;
+};
+
+
+/** Result of one @FGaitEvaluator::Evaluate. */
+enum class EGaitEvaluationResult : uint8
+{
+	/** No current gait. */
+	NoGait,
+	/** Velocity only gait without velocity: nothing evaluated. */
+	Idle,
+	/** The cycle advanced and the effectors were evaluated. */
+	Updated
+};
+
+
+/**
+*	Side effects of @FGaitEvaluator::Evaluate, implemented by the front end.
+*	Called from the thread running the evaluation: implementations touching other objects must defer the call.
+*/
+class NOBUNANIM_API IGaitEvaluationSink
+{
+	public:
+		virtual ~IGaitEvaluationSink() {}
+
+		/** Effector outputs, see @IProceduralGaitInterface::UpdateEffectorTranslation and @IProceduralGaitInterface::UpdateEffectorRotation. */
+		virtual void EmitEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed) = 0;
+		virtual void EmitEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed) = 0;
+
+		/** Gait event (see @UGaitEventSubsystem). */
+		virtual void EmitGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location) = 0;
+
+		/** World location of the collision correction origin of the effector @Slot: the socket @SocketName, or the effector socket if none. */
+		virtual FVector GetCorrectionOrigin(int32 Slot, const FName& SocketName) = 0;
+
+		/** Collision correction trace of the effector @Slot. Return true with the impact point of the best blocking hit. */
+		virtual bool TraceCorrection(int32 Slot, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, FVector& OutImpactPoint) = 0;
+
+	#if WITH_EDITOR
+		/** Debug draws, see @FProceduralGaitLODSettings::Debug. */
+		virtual void DrawCorrectionDebug(const FVector& Location) {}
+		virtual void DrawEffectorDebug(const FVector& Position, const FVector& EffectorLocation, const FVector& CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData) {}
+	#endif
+};
+
+
+/**
+*	Gait algorithm shared by @UProceduralGaitAnimInstance and @UProceduralGaitControllerComponent.
+*	Advances the cycle of a @FGaitEvaluationState and evaluates each effector of the current gait: blend to the pending gait, swing curves,
+*	stance collision correction and auto adjust to the ideal effector. Writes nothing but the state, every side effect goes through the
+*	@IGaitEvaluationSink, so it can run on any thread as long as the sink does.
+*	The front end gathers the ideal and ground locations of the effectors before (see UpdateEffectors).
+*/
+struct NOBUNANIM_API FGaitEvaluator
+{
+	/** Is the current gait of @State played with @Inputs (velocity only gaits idle without velocity)? */
+	static bool IsGaitPlaying(const FGaitEvaluationState& State, const FGaitEvaluationInputs& Inputs);
+
+	/** Advance @State by @Inputs.DeltaTime. */
+	static EGaitEvaluationResult Evaluate(FGaitEvaluationState& State, const FGaitEvaluationInputs& Inputs, IGaitEvaluationSink& Sink);
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <Subsystems/WorldSubsystem.h>
+#include <UObject/ObjectKey.h>
+
+#include "GaitEventSubsystem.generated.h"
+
+
+/** Kind of a gait event. */
+UENUM(BlueprintType)
+enum class EGaitEventType : uint8
+{
+	/** A stance effector landed (collision correction hit, see @FGaitEventData::bRaiseOnCollisionEvent). */
+	Footfall,
+	/** An effector entered its swing. */
+	BeginSwing,
+	/** An effector left its swing. */
+	EndSwing
+};
+
+
+/** One gait event, as queued by @UGaitEventSubsystem. Plain data: copied as is and valid for the flush only. */
+struct FGaitEventRecord
+{
+	/** Anim instance or gait controller component raising the event. Resolve it to use it, it may be gone by the flush. */
+	FObjectKey Source;
+	/** Actor owning @Source. */
+	FObjectKey Owner;
+	/** Effector (socket) name. */
+	FName Effector;
+	/** World location of the effector. */
+	FVector Location;
+	EGaitEventType Type;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGaitEvents, TArrayView<const FGaitEventRecord> /*Events*/);
+
+
+/**
+*	Per world queue of gait events (footfalls, swing begin and end) for native consumers (audio, VFX, AI noise...).
+*	Gait instances append POD records during their update, and the queue is flushed once per frame to @OnGaitEvents as one array, in
+*	append order, so each consumer pays one call per frame instead of one dynamic broadcast per event.
+*	@OnCollisionEvent of the gait instances is still broadcast when they opt in (bBroadcastCollisionEvent).
+*	Game thread only.
+*/
+UCLASS()
+class NOBUNANIM_API UGaitEventSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	private:
+		/** Events of the current frame. */
+		TArray<FGaitEventRecord> Events;
+		/** Events being flushed, swapped with @Events so consumers may queue events (flushed the next frame). */
+		TArray<FGaitEventRecord> FlushedEvents;
+
+
+	protected:
+	/** UNREAL METHODS
+	*/
+		virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	public:
+		virtual void Deinitialize() override;
+		virtual void Tick(float DeltaTime) override;
+		virtual TStatId GetStatId() const override;
+
+
+	public:
+	/** EVENT QUEUE
+	*/
+		/** Queue of @World, or nullptr. */
+		static UGaitEventSubsystem* Get(const UWorld* World);
+
+		/** Append an event, delivered on the next flush. */
+		void QueueEvent(const FGaitEventRecord& Event);
+
+		/** Number of events waiting for the next flush. */
+		FORCEINLINE int32 GetNumQueuedEvents() const { return Events.Num(); }
+
+		/** Broadcast once per frame with every event queued since the last flush. Not called without event. */
+		FOnGaitEvents OnGaitEvents;
+
+
+	private:
+		/** Deliver the queued events to @OnGaitEvents. */
+		void Flush();
+};
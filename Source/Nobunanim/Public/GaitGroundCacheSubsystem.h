@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <Subsystems/WorldSubsystem.h>
+#include <Engine/EngineTypes.h>
+#include <Containers/ArrayView.h>
+#include <Misc/ScopeRWLock.h>
+
+#include "GaitGroundCacheSubsystem.generated.h"
+
+
+/** What a ground query collides with. Part of the cache key: different queries can see different grounds. */
+struct FGaitGroundQuery
+{
+	/** Trace channel, or object type if @bObjectQuery. */
+	ECollisionChannel Channel = ECC_WorldStatic;
+	bool bObjectQuery = false;
+	bool bTraceComplex = false;
+};
+
+
+/** Ground changed inside @Bounds. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGaitGroundChanged, const FBox& /*Bounds*/);
+
+
+/**
+*	Per world cache of ground samples shared by every gait instance.
+*	Also the place where gameplay notifies ground changes: @InvalidateBox and @InvalidateAll broadcast @OnGroundChanged even if the cache is
+*	disabled (i.e. to wake dormant gait instances).
+*	Samples come from vertical traces hitting static geometry and are keyed by quantized XY cell and query.
+*	A sample answers a later vertical trace of the same cell if the trace segment is inside the range the sample proved empty, the height
+*	being evaluated on the sample plane. Samples expire after @FGaitGroundCacheSettings::Lifetime, and cells are invalidated when a trace
+*	hits something movable or through @InvalidateBox (i.e. when dynamic geometry moves).
+*	Thread safe: queried from the gait compute phase.
+*/
+UCLASS()
+class NOBUNANIM_API UGaitGroundCacheSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	private:
+		struct FCellKey
+		{
+			int32 X = 0;
+			int32 Y = 0;
+			uint8 Channel = 0;
+			uint8 Flags = 0;
+
+			bool operator==(const FCellKey& Other) const
+			{
+				return X == Other.X && Y == Other.Y && Channel == Other.Channel && Flags == Other.Flags;
+			}
+
+			friend uint32 GetTypeHash(const FCellKey& Key)
+			{
+				return HashCombine(HashCombine(GetTypeHash(Key.X), GetTypeHash(Key.Y)), GetTypeHash((Key.Channel << 8) | Key.Flags));
+			}
+		};
+
+		struct FSample
+		{
+			/** Impact point. */
+			FVector Location;
+			/** Impact normal. */
+			FVector Normal;
+			/** Start height of the trace: nothing between it and the impact. */
+			float ClearZ;
+			/** World time of the trace. */
+			float Time;
+		};
+
+		TMap<FCellKey, FSample> Cells;
+		mutable FRWLock CellsLock;
+
+
+	protected:
+	/** UNREAL METHODS
+	*/
+		virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	public:
+		virtual void Deinitialize() override;
+
+
+	public:
+	/** GROUND CACHE
+	*/
+		/** Cache of @World, or nullptr if the cache is disabled (see @UNobunanimSettings). */
+		static UGaitGroundCacheSubsystem* Get(const UWorld* World);
+
+		/** Can a trace from @Origin to @Dest use the cache (vertical and going down)? */
+		static bool IsCacheable(const FVector& Origin, const FVector& Dest);
+
+		/** Find the ground hit by the trace from @Origin to @Dest. Return false on cache miss. */
+		bool FindGround(const FVector& Origin, const FVector& Dest, const FGaitGroundQuery& Query, float Now, FHitResult& OutHit) const;
+
+		/** Store the result of the trace from @Origin to @Dest. Hits on movable components invalidate the cell instead. */
+		void StoreGround(const FVector& Origin, const FVector& Dest, const FGaitGroundQuery& Query, float Now, TArrayView<const FHitResult> HitResults);
+
+		/** Broadcast by @InvalidateBox and @InvalidateAll (with an infinite box). */
+		FOnGaitGroundChanged OnGroundChanged;
+
+		/** Drop every cell overlapping @Box. */
+		UFUNCTION(Category = "[NOBUNANIM]|Ground Cache", BlueprintCallable)
+		void InvalidateBox(const FBox& Box);
+
+		/** Drop every cell. */
+		UFUNCTION(Category = "[NOBUNANIM]|Ground Cache", BlueprintCallable)
+		void InvalidateAll();
+
+		/** Number of cached cells. */
+		UFUNCTION(Category = "[NOBUNANIM]|Ground Cache", BlueprintPure)
+		int32 GetNumCells() const;
+
+
+	private:
+		/** Key of the cell containing @Location. */
+		static FCellKey MakeKey(const FVector& Location, const FGaitGroundQuery& Query, float CellSize);
+		/** Purge expired cells. Call with the write lock. */
+		void PurgeExpired(float Now, float Lifetime);
+};
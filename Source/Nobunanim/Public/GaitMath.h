@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+#include <type_traits>
+
+
+/**
+*	Engine independent kernels of the gait update: header only, standard library only, no UObject.
+*	Vector arguments are templates reading X, Y and Z (FVector or any plain struct), curve samples are anything convertible to float (float, FFloat16).
+*	The runtime (@FGaitEvaluator, @FGaitRuntimeTable, ground reflection, @FAnimNode_SafeCCDIK) calls these, so they can be built and profiled outside of the engine.
+*/
+struct FGaitMath
+{
+	public:
+	/** PHASE
+	*/
+		/** Gait time (0-1) of @TimeBuffer, the accumulated cycle time. */
+		static inline float GetPhase(float TimeBuffer)
+		{
+			return std::fmod(TimeBuffer, 1.f);
+		}
+
+		/** Advance @InOutTimeBuffer by @Advance (delta time * frame ratio * play rate) and return the new gait time (0-1). */
+		static inline float AdvancePhase(float& InOutTimeBuffer, float Advance)
+		{
+			InOutTimeBuffer += Advance;
+			return GetPhase(InOutTimeBuffer);
+		}
+
+		/** Cycle time from @Phase to the next occurrence of @TargetPhase, in [0, 1). */
+		static inline float GetTimeUntilPhase(float Phase, float TargetPhase)
+		{
+			const float Delta = TargetPhase - Phase;
+			return Delta - std::floor(Delta);
+		}
+
+		/** Number of multiples of @Step in [0, 1], both bounds included: the phases sampled by the evaluation cache. */
+		static inline int GetNumQuantizedPhases(float Step)
+		{
+			return (int)std::floor(1.f / Step + 0.5f) + 1;
+		}
+
+		/** Index of the multiple of @Step nearest to @Phase clamped to [0, 1], in [0, GetNumQuantizedPhases(@Step)). */
+		static inline int QuantizePhase(float Phase, float Step)
+		{
+			const float Clamped = Phase < 0.f ? 0.f : (Phase > 1.f ? 1.f : Phase);
+			return (int)std::floor(Clamped / Step + 0.5f);
+		}
+
+
+	/** SWING WINDOW
+	*/
+		/**
+		*	Is @Value in the swing window [@Min, @Max]? The window wraps around the cycle when @Min > @Max.
+		*	@OutRangeMin and @OutRangeMax receive the window unwrapped around @Value, to map @Value to the swing progress.
+		*/
+		static inline bool IsInSwingRange(float Value, float Min, float Max, float& OutRangeMin, float& OutRangeMax)
+		{
+			bool A = Value >= Min && Value <= Max;
+			bool APrime = Value >= Max;
+
+			// Gave me headache ._.
+			OutRangeMin = A ? Min : (APrime ? Min : Min - 1.f);
+			OutRangeMax = A ? Max : (APrime ? 1.f /*- Min + Min*/ + Max : Max);
+
+			if (A)
+			{
+				return true;
+			}
+			else
+			{
+				bool B1 = Value <= Min && Value <= Max;
+				bool B2 = Value >= Min && Value >= Max;
+				bool B3 = B1 || B2;
+				bool C = Min >= Max && B3;
+
+				return C;
+			}
+		}
+
+		/** Swing window of the same length as [@BeginSwing, @EndSwing] starting at @CurrentTime, used to force a swing. */
+		static inline void ComputeForceSwingInterval(float CurrentTime, float BeginSwing, float EndSwing, float& OutBegin, float& OutEnd)
+		{
+			const float Length = BeginSwing > EndSwing ? (1.f - BeginSwing) + EndSwing : EndSwing - BeginSwing;
+
+			// if the end swing is > 1 (absolute time) we just consider that the swing will end the next cycle.
+			float End = CurrentTime + Length;
+			if (End >= 1.f)
+			{
+				End -= 1.f;
+			}
+
+			OutBegin = CurrentTime;
+			OutEnd = End;
+		}
+
+
+	/** CURVE LOOKUP TABLE
+	*/
+		/** Lerp between the two samples of @Samples (@NumSamples >= 2 samples of @NumComponents interleaved components, on [0,1]) surrounding @Time. */
+		template<int NumComponents, typename SampleType>
+		static inline void SampleLUT(const SampleType* Samples, int NumSamples, float Time, float* OutValues)
+		{
+			const float Position = (Time < 0.f ? 0.f : (Time > 1.f ? 1.f : Time)) * (float)(NumSamples - 1);
+			const int Floor = (int)std::floor(Position);
+			const int Index = Floor < NumSamples - 2 ? Floor : NumSamples - 2;
+			const float Alpha = Position - (float)Index;
+			const SampleType* First = Samples + Index * NumComponents;
+
+			for (int c = 0; c < NumComponents; ++c)
+			{
+				const float A = static_cast<float>(First[c]);
+				const float B = static_cast<float>(First[NumComponents + c]);
+				OutValues[c] = A + Alpha * (B - A);
+			}
+		}
+
+
+	/** GROUND PLANE
+	*/
+		/** Least squares plane z = a.x + b.y through @Points. False if fewer than 3 points or degenerate in XY (@OutNormal unchanged). */
+		template<typename VectorType>
+		static inline bool FitPlane(const VectorType* Points, int NumPoints, VectorType& OutCentroid, VectorType& OutNormal)
+		{
+			using ScalarType = std::decay_t<decltype(Points->X)>;
+
+			if (NumPoints < 3)
+			{
+				return false;
+			}
+
+			ScalarType CX = 0, CY = 0, CZ = 0;
+			for (int PointIdx = 0; PointIdx < NumPoints; ++PointIdx)
+			{
+				CX += Points[PointIdx].X;
+				CY += Points[PointIdx].Y;
+				CZ += Points[PointIdx].Z;
+			}
+			CX /= (ScalarType)NumPoints;
+			CY /= (ScalarType)NumPoints;
+			CZ /= (ScalarType)NumPoints;
+			OutCentroid = VectorType{ CX, CY, CZ };
+
+			// Fit z = a.x + b.y around the centroid: solve the 2x2 normal equations.
+			float XX = 0.f, XY = 0.f, YY = 0.f, XZ = 0.f, YZ = 0.f;
+			for (int PointIdx = 0; PointIdx < NumPoints; ++PointIdx)
+			{
+				const float DX = (float)(Points[PointIdx].X - CX);
+				const float DY = (float)(Points[PointIdx].Y - CY);
+				const float DZ = (float)(Points[PointIdx].Z - CZ);
+				XX += DX * DX;
+				XY += DX * DY;
+				YY += DY * DY;
+				XZ += DX * DZ;
+				YZ += DY * DZ;
+			}
+
+			const float Det = XX * YY - XY * XY;
+			if (std::fabs(Det) <= 1.e-4f)
+			{
+				return false;
+			}
+
+			const float A = (XZ * YY - YZ * XY) / Det;
+			const float B = (YZ * XX - XZ * XY) / Det;
+
+			// Never degenerate: Z is 1.
+			const float InvLength = 1.f / std::sqrt(A * A + B * B + 1.f);
+			OutNormal = VectorType{ -A * InvLength, -B * InvLength, InvLength };
+			return true;
+		}
+
+
+	/** CCD
+	*/
+		/**
+		*	Rotation of one CCD link toward the target: the rotation around @OutAxis by @OutAngle (radians) bringing the direction link -> tip toward
+		*	link -> target, clamped by @LimitRadians. With @bEnableRotationLimit, the rotation accumulated by the link this solve (@InOutAngleDelta)
+		*	is limited too and updated. False if the link doesn't rotate.
+		*/
+		template<typename VectorType>
+		static inline bool ComputeCCDLinkRotation(const VectorType& LinkLocation, const VectorType& TipLocation, const VectorType& TargetLocation,
+			float LimitRadians, bool bEnableRotationLimit, float& InOutAngleDelta, VectorType& OutAxis, float& OutAngle)
+		{
+			float ToEnd[3] = { (float)(TipLocation.X - LinkLocation.X), (float)(TipLocation.Y - LinkLocation.Y), (float)(TipLocation.Z - LinkLocation.Z) };
+			float ToTarget[3] = { (float)(TargetLocation.X - LinkLocation.X), (float)(TargetLocation.Y - LinkLocation.Y), (float)(TargetLocation.Z - LinkLocation.Z) };
+			Normalize(ToEnd);
+			Normalize(ToTarget);
+
+			// Normalized vectors can still round the dot product just past 1: clamp it before acos.
+			float Dot = ToEnd[0] * ToTarget[0] + ToEnd[1] * ToTarget[1] + ToEnd[2] * ToTarget[2];
+			Dot = Dot < -1.f ? -1.f : (Dot > 1.f ? 1.f : Dot);
+
+			// Acos is in [0, PI]: clamping it to the limit is enough.
+			float Angle = std::acos(Dot);
+			Angle = Angle < -LimitRadians ? -LimitRadians : (Angle > LimitRadians ? LimitRadians : Angle);
+
+			const bool bCanRotate = (std::fabs(Angle) > 1.e-4f) && (!bEnableRotationLimit || LimitRadians > InOutAngleDelta);
+			if (!bCanRotate)
+			{
+				return false;
+			}
+
+			// check rotation limit first, if fails, just abort
+			if (bEnableRotationLimit)
+			{
+				if (LimitRadians < InOutAngleDelta + Angle)
+				{
+					Angle = LimitRadians - InOutAngleDelta;
+					if (Angle <= 1.e-4f)
+					{
+						return false;
+					}
+				}
+
+				InOutAngleDelta += Angle;
+			}
+
+			// continue with rotating toward to target
+			float Axis[3] =
+			{
+				ToEnd[1] * ToTarget[2] - ToEnd[2] * ToTarget[1],
+				ToEnd[2] * ToTarget[0] - ToEnd[0] * ToTarget[2],
+				ToEnd[0] * ToTarget[1] - ToEnd[1] * ToTarget[0]
+			};
+			if (Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2] <= 0.f)
+			{
+				return false;
+			}
+
+			Normalize(Axis);
+			OutAxis = VectorType{ Axis[0], Axis[1], Axis[2] };
+			OutAngle = Angle;
+			return true;
+		}
+
+	private:
+		/** Normalize @V in place, left unchanged if too small (FVector::Normalize). */
+		static inline void Normalize(float* V)
+		{
+			const float SquareSum = V[0] * V[0] + V[1] * V[1] + V[2] * V[2];
+			if (SquareSum > 1.e-8f)
+			{
+				const float Scale = 1.f / std::sqrt(SquareSum);
+				V[0] *= Scale;
+				V[1] *= Scale;
+				V[2] *= Scale;
+			}
+		}
+};
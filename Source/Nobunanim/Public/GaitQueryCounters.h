@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+#include <atomic>
+
+
+/**
+*	Number of scene queries issued by the gait updates (every instance of every world) since the module started. Cache hits aren't counted.
+*	Thread safe, queries of the parallel compute phase are counted too. Read as deltas by tools (i.e. the gait benchmark commandlet).
+*/
+struct NOBUNANIM_API FGaitQueryCounters
+{
+	public:
+		/** Count a line trace (sync or async). */
+		static FORCEINLINE void AddTrace() { NumTraces.fetch_add(1, std::memory_order_relaxed); }
+		/** Count a sweep (sync or async). */
+		static FORCEINLINE void AddSweep() { NumSweeps.fetch_add(1, std::memory_order_relaxed); }
+
+		static FORCEINLINE uint64 GetNumTraces() { return NumTraces.load(std::memory_order_relaxed); }
+		static FORCEINLINE uint64 GetNumSweeps() { return NumSweeps.load(std::memory_order_relaxed); }
+
+	private:
+		static std::atomic<uint64> NumTraces;
+		static std::atomic<uint64> NumSweeps;
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+#include "GaitReplicatedState.generated.h"
+
+class UPackageMap;
+
+
+/**
+*	Compact gait state sent by the server so clients keep evaluating the gait locally, in sync (see @UProceduralGaitControllerComponent::bReplicateGait).
+*	Gaits are identified by their index in the gait set binding: server and clients must play the same gait set.
+*	Serialized on 32 bits (39 while blending to another gait): current gait (7 bits), pending flag (1 bit) and gait (7 bits), phase (16 bits),
+*	blend progress (8 bits).
+*/
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitReplicatedState
+{
+	GENERATED_BODY()
+
+	/** Gaits of a binding beyond this count are replicated as no gait. */
+	static constexpr int32 MaxGaits = 127;
+
+	/** Index of the current gait in the gait set binding. INDEX_NONE if none. */
+	int32 GaitIndex = INDEX_NONE;
+	/** Index of the gait being blended to in the gait set binding. INDEX_NONE if none. */
+	int32 PendingGaitIndex = INDEX_NONE;
+	/** Cycle time [0, 1) quantized on 16 bits. */
+	uint16 Phase = 0;
+	/** Mean blend value of the effectors driven by the current gait, quantized on 8 bits. */
+	uint8 BlendProgress = 255;
+
+	FORCEINLINE void SetPhase(float Time) { Phase = (uint16)FMath::Min(FMath::FloorToInt(FMath::Frac(Time) * 65536.f), 65535); }
+	FORCEINLINE float GetPhase() const { return Phase / 65536.f; }
+
+	FORCEINLINE void SetBlendProgress(float Blend) { BlendProgress = (uint8)FMath::RoundToInt(FMath::Clamp(Blend, 0.f, 1.f) * 255.f); }
+	FORCEINLINE float GetBlendProgress() const { return BlendProgress / 255.f; }
+
+	/** Shortest signed distance (in cycles, [-0.5, 0.5)) from the local time buffer @TimeBuffer to the replicated phase. */
+	FORCEINLINE float GetPhaseError(float TimeBuffer) const { return FMath::Frac(GetPhase() - TimeBuffer + 0.5f) - 0.5f; }
+
+	/**
+	*	Part of @PhaseError to add to the time buffer of an update advancing the cycle by @Advance, at most @MaxCorrection of @Advance,
+	*	so the cycle only speeds up or slows down. @PhaseError is decreased by the returned correction.
+	*/
+	static float ConsumePhaseError(float& PhaseError, float Advance, float MaxCorrection);
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FGaitReplicatedState& Other) const;
+	FORCEINLINE bool operator!=(const FGaitReplicatedState& Other) const { return !(*this == Other); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FGaitReplicatedState> : public TStructOpsTypeTraitsBase2<FGaitReplicatedState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
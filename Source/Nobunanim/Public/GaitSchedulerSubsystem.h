@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <Subsystems/WorldSubsystem.h>
+
+#include "GaitSchedulerSubsystem.generated.h"
+
+
+/**
+*	Native interface of everything that can be updated by the @UGaitSchedulerSubsystem.
+*	Implementers must be UObjects: the scheduler keeps a weak reference on @GetScheduledObject() and never calls a dead instance.
+*	Instances supporting parallel update split their update in three phases instead of @ScheduledGaitUpdate:
+*	Prepare (game thread), Compute (any thread, concurrently with other instances) and Finalize (game thread, registration order).
+*/
+class NOBUNANIM_API IGaitScheduledInstance
+{
+	public:
+		virtual ~IGaitScheduledInstance() {}
+
+		/** Called by the scheduler each time the bucket of this instance is due. Not called if @SupportsParallelGaitUpdate. */
+		virtual void ScheduledGaitUpdate() = 0;
+
+		/** UObject implementing this interface. */
+		virtual UObject* GetScheduledObject() = 0;
+
+		/** May the update be split in Prepare/Compute/Finalize? */
+		virtual bool SupportsParallelGaitUpdate() const { return false; }
+
+		/** Game thread. Gather the inputs of the compute phase. Return false to skip Compute and Finalize. */
+		virtual bool PrepareGaitUpdate() { return false; }
+
+		/** Any thread. Must only write data owned by this instance, side effects are queued for @FinalizeGaitUpdate. */
+		virtual void ComputeGaitUpdate() {}
+
+		/** Game thread. Apply the side effects of the compute phase (events, debug draws...). */
+		virtual void FinalizeGaitUpdate() {}
+
+		/** Number of scene queries issued by the last update (cache hits excluded). Only used for the scheduler load stats. */
+		virtual int32 GetNumTracesLastUpdate() const { return 0; }
+};
+
+
+/** Stats of one scheduler bucket. */
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitSchedulerBucketStats
+{
+	GENERATED_BODY()
+
+	/** Refresh rate of the bucket. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 TargetFPS = 0;
+
+	/** Number of registered instances. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumInstances = 0;
+
+	/** Number of instances updated during the last frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumUpdatedLastFrame = 0;
+
+	/** Number of instances updated during the last frame with a parallel compute phase. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumParallelLastFrame = 0;
+
+	/** Number of traces issued by the instances updated during the last frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumTracesLastFrame = 0;
+
+	/** Total number of bucket updates since the world started. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumBucketUpdates = 0;
+
+	/** Time spent updating the bucket during the last frame (in milliseconds). */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	float LastUpdateTimeMs = 0.f;
+};
+
+
+/** Per frame load of the scheduler, all buckets together. Peaks far above the averages mean synchronized updates. */
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitSchedulerFrameStats
+{
+	GENERATED_BODY()
+
+	/** Number of frames the peaks and averages are computed on. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumFrames = 0;
+
+	/** Number of instances updated during the last frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumUpdatedLastFrame = 0;
+
+	/** Number of traces issued during the last frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumTracesLastFrame = 0;
+
+	/** Highest number of instances updated in one frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 MaxUpdatedPerFrame = 0;
+
+	/** Highest number of traces issued in one frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	int32 MaxTracesPerFrame = 0;
+
+	/** Average number of instances updated per frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	float AverageUpdatedPerFrame = 0.f;
+
+	/** Average number of traces issued per frame. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Scheduler", VisibleAnywhere, BlueprintReadOnly)
+	float AverageTracesPerFrame = 0.f;
+};
+
+
+/**
+*	Updates every registered procedural gait instance from a single world tick.
+*	Instances are bucketed by target refresh rate (see @FProceduralGaitLODSettings::TargetFPS). By default a bucket is amortized: every frame it
+*	updates the share of its instances that is due, round-robin, so each instance keeps its rate but the load doesn't spike every Nth frame.
+*	Otherwise each bucket accumulates time and, when due, updates all its instances in one loop (see @UNobunanimSettings::bAmortizeGaitUpdates).
+*	Buckets run by ascending rate and instances by registration order (round-robin when amortized), so the update order is deterministic.
+*	Registration changes requested during an update (i.e. LOD change from the update itself) are deferred to the end of the frame.
+*	Instances supporting it are updated in three phases, the compute phase of a bucket running in a ParallelFor (see @UNobunanimSettings).
+*/
+UCLASS()
+class NOBUNANIM_API UGaitSchedulerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	private:
+		/** Registered instance. */
+		struct FScheduledEntry
+		{
+			/** Registration order. Use to keep update order deterministic. */
+			uint32 Serial = 0;
+			IGaitScheduledInstance* Instance = nullptr;
+			TWeakObjectPtr<UObject> Object;
+		};
+
+		/** Instances updated at the same rate. */
+		struct FBucket
+		{
+			int32 TargetFPS = 0;
+			/** 1 / TargetFPS. */
+			float Interval = 0.f;
+			/** Time elapsed since the last update of the bucket. */
+			float Accumulator = 0.f;
+			/** Amortized mode: fraction of an instance update owed to the bucket. */
+			float Progress = 0.f;
+			/** Amortized mode: index of the next entry to update. */
+			int32 Cursor = 0;
+			/** Sorted by serial. */
+			TArray<FScheduledEntry> Entries;
+			/** Stats. */
+			FGaitSchedulerBucketStats Stats;
+		};
+
+		/** Deferred registration change. A TargetFPS of INDEX_NONE means unregister. */
+		struct FPendingChange
+		{
+			IGaitScheduledInstance* Instance = nullptr;
+			int32 TargetFPS = INDEX_NONE;
+		};
+
+		/** Buckets sorted by TargetFPS. */
+		TArray<FBucket> Buckets;
+		/** Serial and bucket rate of each registered instance. */
+		TMap<IGaitScheduledInstance*, TPair<uint32, int32>> Registry;
+		/** Changes requested while updating. */
+		TArray<FPendingChange> PendingChanges;
+		/** Next registration serial. */
+		uint32 NextSerial = 0;
+		/** Is the scheduler running the buckets? */
+		bool bIsUpdating = false;
+		/** Entry indices of the instances prepared for the compute phase of the bucket being updated. */
+		TArray<int32> PreparedEntries;
+
+		/** Load of one frame. */
+		struct FFrameLoad
+		{
+			int32 NumUpdated = 0;
+			int32 NumTraces = 0;
+		};
+
+		/** Number of frames kept in @FrameHistory. */
+		static constexpr int32 FrameHistorySize = 120;
+		/** Ring buffer of the last frames load. */
+		TArray<FFrameLoad> FrameHistory;
+		/** Next write index in @FrameHistory. */
+		int32 FrameHistoryIndex = 0;
+
+
+	protected:
+	/** UNREAL METHODS
+	*/
+		virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	public:
+		virtual void Deinitialize() override;
+		virtual void Tick(float DeltaTime) override;
+		virtual TStatId GetStatId() const override;
+
+
+	public:
+	/** SCHEDULER
+	*/
+		/** Register @Instance (or move it to another bucket if already registered). @TargetFPS is clamped to 1. */
+		void RegisterInstance(IGaitScheduledInstance* Instance, int32 TargetFPS);
+
+		/** Unregister @Instance. It won't be updated anymore, even if the scheduler is currently updating. */
+		void UnregisterInstance(IGaitScheduledInstance* Instance);
+
+		/** Is @Instance registered? */
+		bool IsInstanceRegistered(IGaitScheduledInstance* Instance) const;
+
+		/** Number of registered instances. */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Scheduler", BlueprintPure)
+		int32 GetNumInstances() const;
+
+		/** Stats of each bucket, by ascending refresh rate. */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Scheduler", BlueprintPure)
+		TArray<FGaitSchedulerBucketStats> GetBucketStats() const;
+
+		/** Per frame load over the last frames. */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Scheduler", BlueprintPure)
+		FGaitSchedulerFrameStats GetFrameStats() const;
+
+		/** Stable phase of @Object in [0, 1), evenly spread across objects. Use to stagger updates the scheduler doesn't run. */
+		static float GetUpdatePhase(const UObject* Object);
+
+
+	private:
+		/** Apply a registration change. Must not be called while updating. */
+		void ApplyRegister(IGaitScheduledInstance* Instance, int32 TargetFPS);
+		void ApplyUnregister(IGaitScheduledInstance* Instance);
+
+		/** Find or add the bucket of @TargetFPS, keeping @Buckets sorted. */
+		FBucket& FindOrAddBucket(int32 TargetFPS);
+		/** Find bucket index of @TargetFPS. */
+		int32 FindBucketIndex(int32 TargetFPS) const;
+
+		/** Update @NumEntries instances of @Bucket from @FirstEntry, wrapping around. */
+		void UpdateBucket(FBucket& Bucket, int32 FirstEntry, int32 NumEntries);
+};
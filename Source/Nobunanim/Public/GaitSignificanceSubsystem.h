@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <Subsystems/WorldSubsystem.h>
+
+#include "GaitSignificanceSubsystem.generated.h"
+
+
+/** What an instance tells the @UGaitSignificanceSubsystem to be scored. */
+struct FGaitSignificanceInputs
+{
+	/** Center and radius of the instance bounds. */
+	FVector Location = FVector::ZeroVector;
+	float BoundsRadius = 100.f;
+	/** Was the instance rendered recently? */
+	bool bVisible = true;
+	/** Gameplay importance, multiplies the significance. */
+	float Importance = 1.f;
+	/** LOD the instance would use without budget (i.e. mesh predicted LOD). */
+	int32 NaturalLOD = 0;
+	/** Traces per gait update at a correction level of IKL_Level1. */
+	int32 TracesPerUpdate = 0;
+};
+
+
+/**
+*	Native interface of everything the @UGaitSignificanceSubsystem can degrade.
+*	Implementers must be UObjects: the subsystem keeps a weak reference on @GetSignificanceObject() and never calls a dead instance.
+*/
+class NOBUNANIM_API IGaitSignificanceInstance
+{
+	public:
+		virtual ~IGaitSignificanceInstance() {}
+
+		/** Fill @OutInputs. Return false to skip this instance (it keeps its natural LOD). */
+		virtual bool GetSignificanceInputs(FGaitSignificanceInputs& OutInputs) = 0;
+
+		/** Minimum LOD the instance must use until the next evaluation (0 means no constraint). */
+		virtual void ApplySignificance(float Significance, int32 MinLOD) = 0;
+
+		/** UObject implementing this interface. */
+		virtual UObject* GetSignificanceObject() = 0;
+};
+
+
+/** Result of the last significance evaluation. */
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitSignificanceStats
+{
+	GENERATED_BODY()
+
+	/** Number of scored instances. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Significance", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumInstances = 0;
+
+	/** Number of instances pushed above their natural LOD. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Significance", VisibleAnywhere, BlueprintReadOnly)
+	int32 NumDegraded = 0;
+
+	/** Estimated gait update time per frame after degradation (in milliseconds). */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Significance", VisibleAnywhere, BlueprintReadOnly)
+	float EstimatedFrameCostMs = 0.f;
+
+	/** Estimated gait traces per frame after degradation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Significance", VisibleAnywhere, BlueprintReadOnly)
+	float EstimatedTracesPerFrame = 0.f;
+
+	/** Measured cost of one gait update (in milliseconds). */
+	UPROPERTY(Category = "[NOBUNANIM]|Gait Significance", VisibleAnywhere, BlueprintReadOnly)
+	float AverageUpdateCostMs = 0.f;
+};
+
+
+/**
+*	Keeps the total cost of procedural gait under a global budget (see @FGaitSignificanceSettings).
+*	Every evaluation, instances are scored by screen size (distance and bounds against the closest player view), visibility and gameplay
+*	importance. By descending significance, each instance gets its natural LOD if the remaining time and trace budgets allow it, or the first
+*	higher LOD that fits (the last one otherwise). As LODs drive the update rate, correction level and trace settings, low significance
+*	instances degrade gracefully instead of being culled.
+*	The cost of an update is measured from the @UGaitSchedulerSubsystem buckets.
+*/
+UCLASS()
+class NOBUNANIM_API UGaitSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	private:
+		struct FRegisteredInstance
+		{
+			IGaitSignificanceInstance* Instance = nullptr;
+			TWeakObjectPtr<UObject> Object;
+		};
+
+		struct FScoredInstance
+		{
+			int32 RegisteredIndex = INDEX_NONE;
+			float Significance = 0.f;
+			FGaitSignificanceInputs Inputs;
+		};
+
+		TArray<FRegisteredInstance> Instances;
+		/** Scratch of @Evaluate. */
+		TArray<FScoredInstance> Scored;
+		/** Time elapsed since the last evaluation. */
+		float TimeSinceEvaluation = 0.f;
+		/** Smoothed frame delta time, use to convert update rates to updates per frame. */
+		float AverageDeltaTime = 1.f / 60.f;
+		/** Smoothed cost of one gait update (in milliseconds). Negative until measured. */
+		float AverageUpdateCostMs = -1.f;
+		/** Is any instance currently constrained? */
+		bool bHasConstraints = false;
+		FGaitSignificanceStats LastStats;
+
+
+	protected:
+	/** UNREAL METHODS
+	*/
+		virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	public:
+		virtual void Deinitialize() override;
+		virtual void Tick(float DeltaTime) override;
+		virtual TStatId GetStatId() const override;
+
+
+	public:
+	/** SIGNIFICANCE
+	*/
+		void RegisterInstance(IGaitSignificanceInstance* Instance);
+		void UnregisterInstance(IGaitSignificanceInstance* Instance);
+
+		/** Result of the last evaluation. */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Significance", BlueprintPure)
+		FGaitSignificanceStats GetLastStats() const;
+
+
+	private:
+		/** Score every instance and distribute the budget. */
+		void Evaluate();
+		/** Update @AverageUpdateCostMs from the scheduler buckets of this frame. */
+		void MeasureUpdateCost();
+		/** Remove every constraint (i.e. when the budget gets disabled). */
+		void ReleaseConstraints();
+};
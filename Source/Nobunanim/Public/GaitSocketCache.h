@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <Engine/EngineTypes.h>
+
+class USkeletalMeshComponent;
+class USkeletalMesh;
+
+
+/**
+*	Sockets (or bones) read by a gait owner each update, resolved once to bone indices.
+*	@Refresh reads the component space transform buffer of the mesh once and computes the world transform of every socket, so the gait
+*	update doesn't pay a name lookup per socket and per call. Resolution is redone automatically when the skeletal mesh asset changes.
+*	Accessors can be called from any thread between two @Refresh (game thread).
+*/
+struct NOBUNANIM_API FGaitSocketCache
+{
+	public:
+		/** Forget every socket. */
+		void Reset();
+
+		/** Add @SocketName (if not already added). Return its index. None is the component transform. */
+		int32 AddSocket(FName SocketName);
+
+		/** Index of @SocketName, INDEX_NONE if not added. */
+		FORCEINLINE int32 FindSocket(FName SocketName) const
+		{
+			const int32* Index = SocketIndices.Find(SocketName);
+			return Index ? *Index : INDEX_NONE;
+		}
+
+		FORCEINLINE int32 Num() const { return Entries.Num(); }
+
+		/** Read the transform of every socket from @Mesh. Re-resolve the sockets if the mesh asset changed. Game thread. */
+		void Refresh(const USkeletalMeshComponent* Mesh);
+
+		/** Was @Refresh called with a mesh? */
+		FORCEINLINE bool IsValid() const { return bRefreshed; }
+
+		/** World transform of the socket @Index at the last @Refresh. */
+		FORCEINLINE const FTransform& GetWorldTransform(int32 Index) const { return Entries[Index].WorldTransform; }
+		FORCEINLINE FVector GetWorldLocation(int32 Index) const { return Entries[Index].WorldTransform.GetLocation(); }
+
+		/** World location of @SocketName, from the cache if added or from @Mesh otherwise. */
+		FVector GetWorldLocation(const USkeletalMeshComponent* Mesh, FName SocketName) const;
+
+		/** Transform of the socket @Index in @Space, like USkeletalMeshComponent::GetSocketTransform. */
+		FTransform GetTransform(const USkeletalMeshComponent* Mesh, int32 Index, ERelativeTransformSpace Space) const;
+
+	private:
+		struct FEntry
+		{
+			FName Name;
+			/** Mesh bone index, INDEX_NONE if unresolved (read through the mesh instead). */
+			int32 BoneIndex = INDEX_NONE;
+			/** Socket transform relative to its bone (identity for bones). */
+			FTransform LocalTransform;
+			FTransform ComponentTransform;
+			FTransform WorldTransform;
+		};
+
+		TArray<FEntry> Entries;
+		TMap<FName, int32> SocketIndices;
+		/** Mesh asset the sockets are resolved against. */
+		TWeakObjectPtr<const USkeletalMesh> ResolvedMesh;
+		bool bResolved = false;
+		bool bRefreshed = false;
+
+		/** Resolve every socket to a bone index of @Mesh. */
+		void Resolve(const USkeletalMeshComponent* Mesh);
+};
@@ -5,6 +5,13 @@
 #include <Engine/DeveloperSettings.h>
 #include "NobunanimSettings.generated.h"
 
+class UPrimitiveComponent;
+
+#if WITH_EDITOR
+/** Broadcast after an edit of @UNobunanimSettings. */
+DECLARE_MULTICAST_DELEGATE(FOnNobunanimSettingsChanged);
+#endif
+
 USTRUCT(BlueprintType)
 struct NOBUNANIM_API FProceduralGaitLODSettingsDebugData
 {
@@ -40,6 +47,32 @@ enum class ENobunanimIKCorrectionLevel : uint8
 	IKL_Level2			UMETA(DisplayName = "Raycast & Spherecast"),
 };
 
+/** How the anim instance presents gait outputs between two gait updates. */
+UENUM()
+enum class EGaitOutputUpsampling : uint8
+{
+	/** Outputs change on gait updates only. */
+	None				UMETA(DisplayName = "None"),
+	/** Blend between the last two gait samples. Smooth, one gait update of latency. */
+	Interpolate			UMETA(DisplayName = "Interpolate"),
+	/** Continue the motion of the last two gait samples. No latency, may overshoot on direction changes (see @MaxExtrapolation). */
+	Extrapolate			UMETA(DisplayName = "Extrapolate"),
+};
+
+/** What a gait instance does while its mesh isn't rendered. */
+UENUM()
+enum class EGaitOffscreenPolicy : uint8
+{
+	/** Same update as on screen. */
+	KeepUpdating		UMETA(DisplayName = "Keep updating"),
+	/** No gait update at all. The pose is rebuilt on the first update back on screen. */
+	Suspend				UMETA(DisplayName = "Suspend"),
+	/** Cycle clock and footfall events only: no trace and no effector output. */
+	PhaseOnly			UMETA(DisplayName = "Phase only"),
+	/** Full update at @OffscreenTargetFPS. */
+	ReducedRate			UMETA(DisplayName = "Reduced rate"),
+};
+
 USTRUCT(BlueprintType)
 struct NOBUNANIM_API FProceduralGaitLODSettings
 {
@@ -65,12 +98,179 @@ struct NOBUNANIM_API FProceduralGaitLODSettings
 	/** Effector correction IK.*/
 	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config)
 	ENobunanimIKCorrectionLevel CorrectionLevel = ENobunanimIKCorrectionLevel::IKL_Level1;
+
+	/** May stance IK correction and ground adaptation traces be asynchronous? 
+	* Results are consumed on the next gait update: removes the trace stalls at the cost of one update of latency. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config)
+	bool bUseAsyncTraces = false;
+
+	/** May asynchronous trace results be moved along the velocity to hide their latency? */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config, meta = (EditCondition = "bUseAsyncTraces"))
+	bool bExtrapolateAsyncTraces = true;
+
+	/** Stance IK correction and ground adaptation traces of an effector run once every TraceStride gait updates.
+	* Effectors and instances are offset by phase so the traces of a crowd are spread evenly; skipped updates reuse the last ground adaptation. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config, meta = (ClampMin = "1"))
+	int32 TraceStride = 1;
+
+	/** May the anim instance upsample effector translations, bone rotations and ground reflection to the render rate?
+	* Lets low TargetFPS LODs move smoothly. Ground reflection is then traced once per gait update. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config)
+	EGaitOutputUpsampling OutputUpsampling = EGaitOutputUpsampling::None;
+
+	/** Furthest extrapolation past the last gait sample, as a fraction of the gait update interval. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config, meta = (ClampMin = "0", ClampMax = "2", EditCondition = "OutputUpsampling == EGaitOutputUpsampling::Extrapolate"))
+	float MaxExtrapolation = 0.5f;
+
+	/** What the gait does once the mesh hasn't been rendered for @OffscreenDelay. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD|Offscreen", EditAnywhere, Config)
+	EGaitOffscreenPolicy OffscreenPolicy = EGaitOffscreenPolicy::KeepUpdating;
+
+	/** Time (in seconds) without being rendered before @OffscreenPolicy applies. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD|Offscreen", EditAnywhere, Config, meta = (ClampMin = "0", EditCondition = "OffscreenPolicy != EGaitOffscreenPolicy::KeepUpdating"))
+	float OffscreenDelay = 1.f;
+
+	/** Refresh rate while off screen with the ReducedRate policy. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD|Offscreen", EditAnywhere, Config, meta = (ClampMin = "1", EditCondition = "OffscreenPolicy == EGaitOffscreenPolicy::ReducedRate"))
+	int32 OffscreenTargetFPS = 5;
 	
 #if WITH_EDITORONLY_DATA
 	/** Debug Data. */
 	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config)
 	FProceduralGaitLODSettingsDebugData Debug;
 #endif
+
+	/** Should effector @Slot of an instance of phase @InstancePhase trace during its gait update number @UpdateCounter? (see @TraceStride) */
+	FORCEINLINE bool IsTracePhase(uint32 UpdateCounter, int32 Slot, uint32 InstancePhase) const
+	{
+		return TraceStride <= 1 || (UpdateCounter + InstancePhase + (uint32)Slot) % (uint32)TraceStride == 0;
+	}
+
+	/** Refresh rate of an instance of this LOD under @Policy (KeepUpdating on screen). */
+	FORCEINLINE int32 GetEffectiveTargetFPS(EGaitOffscreenPolicy Policy) const
+	{
+		return Policy == EGaitOffscreenPolicy::ReducedRate ? OffscreenTargetFPS : TargetFPS;
+	}
+};
+
+/**
+*	Policy forced on every gait instance of a world, by net mode. KeepUpdating (default) lets the LOD off-screen policy apply.
+*	i.e. opt in to PhaseOnly on dedicated servers to keep the cycle clock and the footfall events (OnCollisionEvent) for gameplay, without trace,
+*	ground reflection or effector output.
+*/
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitNetModeSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Net Mode", EditAnywhere, Config)
+	EGaitOffscreenPolicy DedicatedServer = EGaitOffscreenPolicy::KeepUpdating;
+
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Net Mode", EditAnywhere, Config)
+	EGaitOffscreenPolicy ListenServer = EGaitOffscreenPolicy::KeepUpdating;
+
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Net Mode", EditAnywhere, Config)
+	EGaitOffscreenPolicy Client = EGaitOffscreenPolicy::KeepUpdating;
+
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Net Mode", EditAnywhere, Config)
+	EGaitOffscreenPolicy Standalone = EGaitOffscreenPolicy::KeepUpdating;
+
+	/** Policy of @NetMode. */
+	FORCEINLINE EGaitOffscreenPolicy GetPolicy(ENetMode NetMode) const
+	{
+		switch (NetMode)
+		{
+			case NM_DedicatedServer:	return DedicatedServer;
+			case NM_ListenServer:		return ListenServer;
+			case NM_Client:				return Client;
+			default:					return Standalone;
+		}
+	}
+};
+
+/** Gait state replication (see @FGaitReplicatedState). */
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitReplicationSettings
+{
+	GENERATED_BODY()
+
+	/** Server: minimum time between two phase refreshes of the replicated state (in seconds). Gait changes are sent at once. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Replication", EditAnywhere, Config, meta = (ClampMin = "0"))
+	float PhaseRefreshInterval = 0.5f;
+
+	/** Client: the cycle catches up with the replicated phase by playing at most this much faster or slower (fraction of the play rate). */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Replication", EditAnywhere, Config, meta = (ClampMin = "0", ClampMax = "1"))
+	float MaxPhaseCorrection = 0.25f;
+};
+
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitGroundCacheSettings
+{
+	GENERATED_BODY()
+
+	/** May vertical ground traces be served from the shared ground cache (see @UGaitGroundCacheSubsystem)? */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Ground Cache", EditAnywhere, Config)
+	bool bEnabled = false;
+
+	/** Size of a cache cell (in cm). Ground inside a cell is approximated by the plane of its sample. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Ground Cache", EditAnywhere, Config, meta = (ClampMin = "1"))
+	float CellSize = 25.f;
+
+	/** Lifetime of a cached sample (in seconds). */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Ground Cache", EditAnywhere, Config, meta = (ClampMin = "0"))
+	float Lifetime = 2.f;
+
+	/** Above this number of cells, expired cells are purged (and the whole cache if still above). */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Ground Cache", EditAnywhere, Config, meta = (ClampMin = "1"))
+	int32 MaxCells = 65536;
+};
+
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitSharedEvaluationSettings
+{
+	GENERATED_BODY()
+
+	/** May gait curve samples be shared by the instances playing the same gait (see @UGaitEvaluationCacheSubsystem)? */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Shared Evaluation", EditAnywhere, Config)
+	bool bEnabled = false;
+
+	/** Phase quantization step. Curves are sampled at multiples of this step: larger steps share more samples but are less accurate. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Shared Evaluation", EditAnywhere, Config, meta = (ClampMin = "0.0001", ClampMax = "0.25"))
+	float PhaseStep = 1.f / 128.f;
+
+	/** Maximum number of samples cached per thread (effectors * 5 curves * phases per gait). Once reached, the thread starts over. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Shared Evaluation", EditAnywhere, Config, meta = (ClampMin = "1"))
+	int32 MaxSamples = 16384;
+};
+
+USTRUCT(BlueprintType)
+struct NOBUNANIM_API FGaitSignificanceSettings
+{
+	GENERATED_BODY()
+
+	/** May gait instances be degraded to higher LODs to fit the budget below (see @UGaitSignificanceSubsystem)? */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Significance", EditAnywhere, Config)
+	bool bEnabled = false;
+
+	/** Gait update time allowed per frame (in milliseconds), all instances together. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Significance", EditAnywhere, Config, meta = (ClampMin = "0"))
+	float FrameBudgetMs = 1.5f;
+
+	/** Gait traces allowed per frame, all instances together. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Significance", EditAnywhere, Config, meta = (ClampMin = "0"))
+	int32 TraceBudgetPerFrame = 256;
+
+	/** Time between two significance evaluations (in seconds). */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Significance", EditAnywhere, Config, meta = (ClampMin = "0"))
+	float EvaluationInterval = 0.1f;
+
+	/** Significance multiplier of instances not rendered recently. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Significance", EditAnywhere, Config, meta = (ClampMin = "0", ClampMax = "1"))
+	float OffscreenSignificanceScale = 0.25f;
+
+	/** Cost of one gait update (in milliseconds) until measured by the gait scheduler. */
+	UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Significance", EditAnywhere, Config, meta = (ClampMin = "0"))
+	float DefaultUpdateCostMs = 0.02f;
 };
 
 UCLASS(Category = "[NOBUNANIM]|Settings", Config = Game, defaultConfig)
@@ -87,16 +287,133 @@ class NOBUNANIM_API UNobunanimSettings : public UDeveloperSettings
 		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait", EditAnywhere, Config, meta = (ClampMn = "0"))
 		int32 FramePerSecond = 60;
 
-		/** Map of procedural gait settings. */
+		/** Map of procedural gait settings. Missing LODs use the nearest defined one. */
 		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config)
 		TMap<int32, FProceduralGaitLODSettings> ProceduralGaitLODSettings;
 
+		/** Time (in seconds) a new predicted LOD must be kept before being applied. Avoids rescheduling gait instances when the LOD flickers. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", EditAnywhere, Config, meta = (ClampMin = "0"))
+		float LODHysteresisTime = 0.25f;
+
+		/** May the gait scheduler run the compute phase of the gait updates on worker threads? */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Scheduler", EditAnywhere, Config)
+		bool bParallelGaitUpdate = true;
+
+		/** Minimum number of instances updated in the same frame and bucket to go wide. Below, everything runs on the game thread. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Scheduler", EditAnywhere, Config, meta = (ClampMin = "1", EditCondition = "bParallelGaitUpdate"))
+		int32 ParallelGaitUpdateMinInstances = 8;
+
+		/** Spread the instances of each scheduler bucket evenly across frames instead of updating the whole bucket when due.
+		* Each instance keeps its refresh rate, but the per frame load is flat. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Scheduler", EditAnywhere, Config)
+		bool bAmortizeGaitUpdates = true;
+
+		/** May idle gait instances (velocity only gait without velocity) go dormant: no update, no trace, frozen outputs?
+		* Dormant instances wake when their mesh moves or teleports, when the ground around them changes (see @UGaitGroundCacheSubsystem::InvalidateBox) or on gait change. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Dormancy", EditAnywhere, Config)
+		bool bGaitDormancy = true;
+
+		/** Time (in seconds) an instance must stay idle before going dormant. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Dormancy", EditAnywhere, Config, meta = (ClampMin = "0", EditCondition = "bGaitDormancy"))
+		float GaitDormancyDelay = 0.5f;
+
+		/** Gait policy by net mode (i.e. footfall events only on dedicated servers). */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Net Mode", EditAnywhere, Config)
+		FGaitNetModeSettings NetMode;
+
+		/** Gait state replication. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Replication", EditAnywhere, Config)
+		FGaitReplicationSettings Replication;
+
+		/** Shared ground height cache. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Ground Cache", EditAnywhere, Config)
+		FGaitGroundCacheSettings GroundCache;
+
+		/** Curve samples shared by the instances playing the same gait. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Shared Evaluation", EditAnywhere, Config)
+		FGaitSharedEvaluationSettings SharedEvaluation;
+
+		/** Global gait budget. */
+		UPROPERTY(Category = "[NOBUNANIM]|Settings|Procedural Gait|Significance", EditAnywhere, Config)
+		FGaitSignificanceSettings Significance;
+
 	public:
 		/** Static accessor of FramePerSecond. */
 		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", BlueprintPure)
 		static int32 GetFramePerSecond();
 
-		/** Gets the specified LOD setting. Return default one if invalid settings or @Lod. */
-		UFUNCTION(Category = "STARK|Settings|Matter", BlueprintPure)
-		static FProceduralGaitLODSettings GetLODSetting(int32 Lod);
+		/** Gets the specified LOD setting, from the resolved LOD table (O(1)). @Lod is clamped to the defined range. */
+		static const FProceduralGaitLODSettings& GetLODSetting(int32 Lod);
+
+		/** Blueprint version of @GetLODSetting. */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", BlueprintPure, meta = (DisplayName = "Get LOD Setting"))
+		static FProceduralGaitLODSettings K2_GetLODSetting(int32 Lod);
+
+		/** Number of entries of the resolved LOD table (at least 1). */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", BlueprintPure)
+		static int32 GetNumLODSettings();
+
+		/** Static accessor of LODHysteresisTime. */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|LOD", BlueprintPure)
+		static float GetLODHysteresisTime();
+
+		/** Static accessor of bParallelGaitUpdate. */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|Scheduler", BlueprintPure)
+		static bool IsParallelGaitUpdateEnabled();
+
+		/** Static accessor of ParallelGaitUpdateMinInstances. */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|Scheduler", BlueprintPure)
+		static int32 GetParallelGaitUpdateMinInstances();
+
+		/** Static accessor of bAmortizeGaitUpdates. */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|Scheduler", BlueprintPure)
+		static bool IsGaitUpdateAmortizationEnabled();
+
+		/** Static accessor of bGaitDormancy. */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|Dormancy", BlueprintPure)
+		static bool IsGaitDormancyEnabled();
+
+		/** Static accessor of GaitDormancyDelay. */
+		UFUNCTION(Category = "[NOBUNANIM]|Settings|Procedural Gait|Dormancy", BlueprintPure)
+		static float GetGaitDormancyDelay();
+
+		/** Static accessor of NetMode. */
+		static const FGaitNetModeSettings& GetNetModeSettings();
+
+		/**
+		*	Update policy of a gait instance at @Lod in @NetMode: the net mode policy if not KeepUpdating, else the LOD off-screen policy
+		*	once @Mesh was not rendered for its OffscreenDelay. Dedicated servers never render, their net mode policy is used as is.
+		*/
+		static EGaitOffscreenPolicy ResolveOffscreenPolicy(ENetMode NetMode, int32 Lod, const UPrimitiveComponent* Mesh);
+
+		/** Static accessor of Replication. */
+		static const FGaitReplicationSettings& GetReplicationSettings();
+
+		/** Static accessor of GroundCache. */
+		static const FGaitGroundCacheSettings& GetGroundCacheSettings();
+
+		/** Static accessor of SharedEvaluation. */
+		static const FGaitSharedEvaluationSettings& GetSharedEvaluationSettings();
+
+		/** Static accessor of Significance. */
+		static const FGaitSignificanceSettings& GetSignificanceSettings();
+
+	public:
+	/** UNREAL METHODS
+	*/
+		virtual void PostInitProperties() override;
+		virtual void PostReloadConfig(FProperty* PropertyThatWasLoaded) override;
+#if WITH_EDITOR
+		virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+		/** Broadcast once an edit is applied (LOD table resolved again), i.e. to pick up settings edited while playing. */
+		static FOnNobunanimSettingsChanged& OnSettingsChanged();
+#endif
+
+	private:
+		/** @ProceduralGaitLODSettings resolved to one entry per LOD, from 0 to the highest defined LOD. */
+		TArray<FProceduralGaitLODSettings> ResolvedLODSettings;
+
+		/** Rebuild @ResolvedLODSettings. */
+		void ResolveLODSettings();
 };
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 #include "Nobunanim/Public/ProceduralGaitInterface.h"
 #include "Nobunanim/Public/ProceduralAnimAsset.h"
+#include "Nobunanim/Public/GaitSchedulerSubsystem.h"
 
 #include "ProceduralAnimator.generated.h"
 
@@ -54,7 +55,7 @@ struct FEffectorAnimData
 
 // This class does not need to be modified.
 UCLASS()
-class NOBUNANIM_API UProceduralAnimator : public UObject, public IProceduralGaitInterface
+class NOBUNANIM_API UProceduralAnimator : public UObject, public IProceduralGaitInterface, public IGaitScheduledInstance
 {
 	GENERATED_BODY()
 
@@ -104,8 +105,8 @@ class NOBUNANIM_API UProceduralAnimator : public UObject, public IProceduralGait
 
 		int updateCount;
 
-		/** TimerHandle for internal update. */
-		FTimerHandle updateTimerHandle;
+		/** Gait scheduler running the internal update. */
+		TWeakObjectPtr<UGaitSchedulerSubsystem> scheduler;
 
 		/** Animations total weight. */
 		UPROPERTY(Category = "[NOBUNANIM]|Procedural Animator", VisibleAnywhere, BlueprintReadOnly)
@@ -157,6 +158,17 @@ class NOBUNANIM_API UProceduralAnimator : public UObject, public IProceduralGait
 		UFUNCTION(Category = "[NOBUNANIM]|Procedural Animator", BlueprintCallable)
 		void SetActive(bool _bEnable);
 
+	public:
+	/** UNREAL METHODS
+	*/
+		virtual void BeginDestroy() override;
+
+	public:
+	/** GAIT SCHEDULER INTERFACE
+	*/
+		virtual void ScheduledGaitUpdate() override;
+		virtual UObject* GetScheduledObject() override;
+
 	protected:
 		/** .*/
 		virtual void UpdateEffectorTranslation_Implementation(const FName& _Socket, FVector _Translation, bool _bLerp, float _LerpSpeed) override;
@@ -176,7 +188,4 @@ class NOBUNANIM_API UProceduralAnimator : public UObject, public IProceduralGait
 
 		/** Update global weight based on all active procedural anim weight. */
 		void UpdateGlobalWeight();
-
-		/** Return if a value is in the range [0;1] and output adjusted ranges. */
-		bool IsInSwingRange(float _Value, float _Min, float _Max, float& out_RangeMin, float& out_RangeMax);
 };
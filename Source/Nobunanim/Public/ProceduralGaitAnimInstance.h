@@ -6,12 +6,33 @@
 #include "ProceduralGaitInterface.h"
 
 #include "Nobunanim/Public/ProceduralGaitControllerComponent.h"
+#include "Nobunanim/Public/GaitDataAsset.h"
+#include "Nobunanim/Public/GaitSchedulerSubsystem.h"
+#include "Nobunanim/Public/GaitSignificanceSubsystem.h"
+#include "Nobunanim/Public/GaitAsyncTrace.h"
+#include "Nobunanim/Public/GaitSocketCache.h"
+#include "Nobunanim/Public/NobunanimSettings.h"
+#include "Nobunanim/Public/GaitReplicatedState.h"
+#include "Nobunanim/Public/GaitEvaluator.h"
 #include "Animation/AnimInstance.h"
 #include "ProceduralGaitAnimInstance.generated.h"
 
 
 class UCurveFloat;
 class UGaitDataAsset;
+class UGaitEvaluationCacheSubsystem;
+struct FProceduralGaitAnimInstanceProxy;
+
+
+/** Where the procedural gait of an anim instance is updated. */
+UENUM(BlueprintType)
+enum class EProceduralGaitUpdateMode : uint8
+{
+	/** Updated by the gait scheduler (see @UGaitSchedulerSubsystem). */
+	Scheduler			UMETA(DisplayName = "Gait scheduler"),
+	/** Updated with the animation, in the anim instance proxy (worker thread with parallel animation update). */
+	AnimationProxy		UMETA(DisplayName = "Animation proxy"),
+};
 
 
 //USTRUCT(BlueprintType)
@@ -107,41 +128,65 @@ struct FGroundReflectionSocketData
 	UPROPERTY(Category = "[NOBUNANIM]|Procedural Gait Anim Instance", EditAnywhere, BlueprintReadWrite)
 	bool  bShowDebugPlanes = true;
 
-	/** Should use half of the plane's vectors. */
-	UPROPERTY(Category = "[NOBUNANIM]|Procedural Gait Anim Instance", EditAnywhere, BlueprintReadWrite)
+	/** Deprecated and ignored (warns at begin play): the ground plane is a least-squares fit of all the samples, half vectors would give the same plane. */
+	UPROPERTY(Category = "[NOBUNANIM]|Procedural Gait Anim Instance", EditAnywhere, BlueprintReadWrite, meta = (DeprecatedProperty, DeprecationMessage = "Ignored: the ground plane is a least-squares fit of all the probes."))
 	bool  bUseHalfVector = false;
 
+	/** The ground isn't traced again while the mesh moved less than this distance (in cm) since the last trace. */
+	UPROPERTY(Category = "[NOBUNANIM]|Procedural Gait Anim Instance", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float RecomputeDistanceEpsilon = 1.f;
+
+	/** The ground isn't traced again while the mesh rotated less than this angle (in degrees) since the last trace. */
+	UPROPERTY(Category = "[NOBUNANIM]|Procedural Gait Anim Instance", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float RecomputeAngleEpsilon = 0.5f;
+
 	/** Lerp speed of effectors. */
 	UPROPERTY(Category = "[NOBUNANIM]|Procedural Gait Anim Instance", EditAnywhere, BlueprintReadWrite)
 	float GroundReflectionLerpSpeed = 10.f;
 };
 
 
+/** Ground points traced under the ground reflection sockets. */
+struct FGroundReflectionSamples
+{
+	/** Front, back, right, left and (at LOD 0 only) center. */
+	static constexpr int32 MaxPoints = 5;
+
+	FVector Points[MaxPoints];
+	int32 NumPoints = 0;
+	FVector RightVector = FVector::RightVector;
+	/** The mesh didn't move enough since the last samples: reuse the last solve. */
+	bool bReuseLastSolve = false;
+};
+
+
 /**
  * Only manage 
  */
 UCLASS()
-class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public IProceduralGaitInterface
+class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public IProceduralGaitInterface, public IGaitScheduledInstance, public IGaitSignificanceInstance, public IGaitEvaluationSink
 {
 	GENERATED_BODY()
 
 	
 	protected:
-		/** Current gait monde name.*/
-		FName CurrentGaitMode;
-		/** Pending gait mode name. Use to switch gaot with blend time. */
-		FName PendingGaitMode = "";
-		/** Current time of the cycle (in absolute time [0,1]).*/
-		float CurrentTime = 0;
-		/** Current time buffer used to compute current time.*/
-		float TimeBuffer = 0;
+		/** Gait, cycle time and effectors, advanced by the @FGaitEvaluator. Effectors are indexed by @GaitBinding slot. */
+		FGaitEvaluationState GaitState;
 		/** Current LOD.*/
 		int32 CurrentLOD = 0;
-
-		/** Map of Gaits data. Keys are the name of the Gait. */
-		TMap<FName, FGaitEffectorData> Effectors;
-		/** @to do: documentation. */
-		FVector LastVelocity;
+		/** Predicted LOD waiting for the hysteresis time before being applied. INDEX_NONE if none. */
+		int32 PendingLOD = INDEX_NONE;
+		/** World time @PendingLOD was first predicted. */
+		float PendingLODStartTime = 0.f;
+		/** Minimum LOD imposed by the gait budget. */
+		int32 SignificanceMinLOD = 0;
+		/** Last significance computed by the gait budget. */
+		float GaitSignificance = 1.f;
+		/** Is this instance registered to the @UGaitSignificanceSubsystem? */
+		bool bRegisteredSignificance = false;
+
+		/** Resolved @GaitsData. */
+		FGaitSetBinding GaitBinding;
 		/** */
 		//bool bLastFrameWasDisable = true;
 		bool bUpdateGaitActive = false;
@@ -169,6 +214,14 @@ class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public I
 		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller|Debug", EditAnywhere, BlueprintReadWrite)
 		bool bShowDebug = false;
 
+		/** Where the gait is updated. With AnimationProxy, Blueprint overrides of UpdateEffectorTranslation/UpdateEffectorRotation are bypassed. */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller", EditDefaultsOnly, BlueprintReadOnly)
+		EProceduralGaitUpdateMode GaitUpdateMode = EProceduralGaitUpdateMode::Scheduler;
+
+		/** Gameplay importance of this instance for the gait budget (see @UGaitSignificanceSubsystem). */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+		float GaitImportance = 1.f;
+
 
 	#if WITH_EDITORONLY_DATA
 		/** Show effector debug. */
@@ -205,17 +258,131 @@ class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public I
 		UPROPERTY(Category = "[NOBUNANIM]|Procedural Gait Anim Instance", EditAnywhere, BlueprintReadWrite)
 		float GroundReflectionLerpSpeed = 10.f;
 
-		/** Called each time than an effector that must raise the event enter in collision. */
+		/** Called each time than an effector that must raise the event enter in collision. Only if @bBroadcastCollisionEvent (see @UGaitEventSubsystem). */
 		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller|Debug", BlueprintAssignable)
 		FOnEffectorCollision OnCollisionEvent;
 
+		/** Also broadcast @OnCollisionEvent for each footfall. Gait events go to the @UGaitEventSubsystem queue either way. */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller", EditAnywhere, BlueprintReadWrite)
+		bool bBroadcastCollisionEvent = false;
+
 
 	private:
 		float DeltaTime = 0.f;
 		/** Last time from procedural gait update. Use to compute deltatime. */
 		float LastTime = 0.f;
-		/** The timer used for deferred gaits update. */
-		FTimerHandle GaitUpdateTimer;
+		/** Refresh rate the gait update is currently scheduled at. */
+		int32 ScheduledTargetFPS = 0;
+
+		/** Side effect of the compute phase, applied in order by @FinalizeGaitUpdate. */
+		struct FGaitDeferredCommand
+		{
+			enum class EType : uint8
+			{
+				Translation,
+				Rotation,
+				GaitEvent,
+			};
+
+			EType Type;
+			FName Key;
+			/** Translation, rotation (pitch, yaw, roll) or event location. */
+			FVector Value;
+			float LerpSpeed;
+			bool bLerp;
+			EGaitEventType EventType = EGaitEventType::Footfall;
+		};
+
+		/** Inputs of the compute phase, gathered by @PrepareGaitUpdate. */
+		UWorld* GaitUpdateWorld = nullptr;
+		FVector GaitUpdateVelocity = FVector::ZeroVector;
+		FRotator GaitUpdateComponentRotation = FRotator::ZeroRotator;
+		/** Entry of the resolved LOD table (see @UNobunanimSettings::GetLODSetting), not copied. Null before the first update. */
+		const FProceduralGaitLODSettings* GaitUpdateLODSetting = nullptr;
+		/** Shared curve samples, nullptr if disabled. */
+		UGaitEvaluationCacheSubsystem* GaitUpdateEvaluationCache = nullptr;
+
+		/** Outputs of the compute phase. */
+		TArray<FGaitDeferredCommand> DeferredCommands;
+		/** Asynchronous traces, flushed by @FinalizeGaitUpdate (and @TraceGroundProbes for the ground reflection probes). */
+		FGaitAsyncTraceQueue AsyncTraces;
+		/** Scratch hit results of @TraceRay, reused so traces don't allocate once warm. */
+		TArray<FHitResult> TraceHits;
+		/** Scratch hit results of the async ground reflection probes (game thread). */
+		TArray<FHitResult> GroundProbeHits;
+		/** Number of gait updates. With the unique id, drives the trace phase of the effectors (see @FProceduralGaitLODSettings::TraceStride). */
+		uint32 GaitUpdateCounter = 0;
+		/** Traces issued by the current (or last) gait update. */
+		int32 NumGaitTraces = 0;
+		/** Every socket read by the gait update and the ground reflection, refreshed once per update (see @BuildSocketCache). */
+		FGaitSocketCache SocketCache;
+	#if WITH_EDITOR
+		TArray<TFunction<void(UWorld*)>> DeferredDebugDraws;
+	#endif
+		/** Is the compute phase running? Side effects are deferred while true. */
+		bool bComputingGaitUpdate = false;
+
+		/** AnimationProxy mode: time accumulated toward the next gait update. */
+		float ProxyGaitTimeAccumulator = 0.f;
+		/** AnimationProxy mode: was the gait prepared this frame? */
+		bool bProxyGaitPrepared = false;
+		/** AnimationProxy mode: ground samples gathered this frame. */
+		FGroundReflectionSamples ProxyGroundSamples;
+		/** AnimationProxy mode: delta time of the animation update. */
+		float ProxyDeltaSeconds = 0.f;
+		/** AnimationProxy mode: were ground samples gathered this frame? */
+		bool bProxyGroundSampled = false;
+		/** AnimationProxy mode: world time of the animation update. */
+		float ProxyPresentTime = 0.f;
+
+		/** Last two gait samples of an output, presented every frame by @PresentUpsampledOutputs. */
+		template<typename T>
+		struct TGaitOutputSamples
+		{
+			T Previous;
+			T Current;
+		};
+
+		/** Upsampling mode of the last gait sample (see @FProceduralGaitLODSettings::OutputUpsampling). */
+		EGaitOutputUpsampling UpsampleMode = EGaitOutputUpsampling::None;
+		/** Extrapolation limit of the last gait sample. */
+		float UpsampleMaxExtrapolation = 0.f;
+		/** World time of the last two gait samples. */
+		float UpsamplePreviousTime = 0.f;
+		float UpsampleCurrentTime = 0.f;
+		/** Gait samples of @EffectorsTranslation and @BonesRotation while upsampling. */
+		TMap<FName, TGaitOutputSamples<FVector>> UpsampledTranslations;
+		TMap<FName, TGaitOutputSamples<FRotator>> UpsampledRotations;
+		/** Ground reflection target of the last two gait samples (the last solve if not upsampling). */
+		TGaitOutputSamples<FRotator> GroundReflectionTargets = { FRotator::ZeroRotator, FRotator::ZeroRotator };
+		/** Upsampling: must the ground be traced for the last gait sample? */
+		bool bGroundReflectionSampleDue = true;
+
+		/** Off-screen policy in effect, KeepUpdating while on screen (see @FProceduralGaitLODSettings::OffscreenPolicy). */
+		EGaitOffscreenPolicy OffscreenPolicy = EGaitOffscreenPolicy::KeepUpdating;
+		/** Back on screen: rebuild the effectors from the ideal pose on the next update. */
+		bool bResyncGait = false;
+		/** Write the outputs of the current update without lerp. */
+		bool bSnapGaitOutputs = false;
+
+		/** Was the last gait update idle (velocity only gait without velocity)? */
+		bool bIdleGaitUpdate = false;
+		/** World time the gait became idle, negative if not idle. */
+		float IdleStartTime = -1.f;
+		/** Is the gait update dormant (unscheduled, no trace, frozen outputs)? */
+		bool bGaitDormant = false;
+		/** Wake up bindings while dormant. */
+		FDelegateHandle DormantTransformHandle;
+		FDelegateHandle DormantGroundHandle;
+
+		/** Mesh transform when the ground was last traced. */
+		FTransform LastGroundReflectionTransform;
+		/** Was the ground traced at least once (and at which LOD)? */
+		int32 LastGroundReflectionLOD = INDEX_NONE;
+		/** Rotation from the last ground samples. */
+		FRotator LastGroundReflectionSolve = FRotator::ZeroRotator;
+
+		friend struct FProceduralGaitAnimInstanceProxy;
 
 		//USkeletalMeshComponent* OwnedMesh;
 		/** Current LOD.*/
@@ -228,7 +395,10 @@ class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public I
 		// Native update override point. It is usually a good idea to simply gather data in this step and 
 		// for the bulk of the work to be done in NativeUpdateAnimation.
 		virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+		virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
 		virtual void NativeBeginPlay() override;
+		virtual void NativeUninitializeAnimation() override;
+		virtual void BeginDestroy() override;
 
 	public:
 	/** PROCEDURAL GAIT INTERFACE
@@ -240,6 +410,78 @@ class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public I
 		/** Update of procedural gait. */
 		void virtual ProceduralGaitUpdate();
 		//void virtual ProceduralGaitUpdate(float DeltaTime);
+
+	public:
+	/** GAIT SCHEDULER INTERFACE
+	*/
+		virtual void ScheduledGaitUpdate() override;
+		virtual UObject* GetScheduledObject() override;
+		virtual bool SupportsParallelGaitUpdate() const override;
+		virtual bool PrepareGaitUpdate() override;
+		virtual void ComputeGaitUpdate() override;
+		virtual void FinalizeGaitUpdate() override;
+		virtual int32 GetNumTracesLastUpdate() const override;
+
+	public:
+	/** GAIT SIGNIFICANCE INTERFACE
+	*/
+		virtual bool GetSignificanceInputs(FGaitSignificanceInputs& OutInputs) override;
+		virtual void ApplySignificance(float Significance, int32 MinLOD) override;
+		virtual UObject* GetSignificanceObject() override;
+
+	private:
+		/** Unregister from the @UGaitSignificanceSubsystem if registered. */
+		void UnregisterSignificance();
+
+	private:
+	/** GAIT EVALUATION SINK
+	*	Called by the compute phase: outputs, events and debug draws are deferred through the Queue* methods.
+	*/
+		virtual void EmitEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed) override;
+		virtual void EmitEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed) override;
+		virtual void EmitGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location) override;
+		virtual FVector GetCorrectionOrigin(int32 Slot, const FName& SocketName) override;
+		virtual bool TraceCorrection(int32 Slot, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, FVector& OutImpactPoint) override;
+	#if WITH_EDITOR
+		virtual void DrawCorrectionDebug(const FVector& Location) override;
+		virtual void DrawEffectorDebug(const FVector& Position, const FVector& EffectorLocation, const FVector& CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData) override;
+	#endif
+
+	public:
+	/** GAIT DORMANCY
+	*/
+		/** Wake the gait update up if dormant (see @UNobunanimSettings::bGaitDormancy). */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller", BlueprintCallable)
+		void WakeGait();
+
+		/** Is the gait update dormant? */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller", BlueprintPure)
+		bool IsGaitDormant() const { return bGaitDormant; }
+
+	private:
+		/** Go dormant if idle for long enough. Game thread, after the gait update. */
+		void UpdateGaitDormancy();
+		void EnterGaitDormancy();
+		/** Leave dormancy without rescheduling. */
+		void ExitGaitDormancy();
+		void OnDormantMeshTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+		void OnDormantGroundChanged(const FBox& Bounds);
+
+	public:
+	/** GAIT REPLICATION
+	*	Anim instances don't replicate: the owner replicates @GetReplicatedGaitState (i.e. a replicated property of the character,
+	*	refreshed on gait change and periodically, see @FGaitReplicationSettings) and applies it on simulated proxies.
+	*/
+		/** Current gait, phase and blend progress, quantized for replication. */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller|Replication", BlueprintPure)
+		FGaitReplicatedState GetReplicatedGaitState() const;
+
+		/**
+		*	Resynchronize the local gait on a state of the server. The first state is adopted as is, then gait changes blend as usual and
+		*	the phase is caught up by playing the cycle slightly faster or slower (see @FGaitReplicationSettings::MaxPhaseCorrection).
+		*/
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller|Replication", BlueprintCallable)
+		void ApplyReplicatedGaitState(const FGaitReplicatedState& State);
 	
 
 	protected:
@@ -249,19 +491,26 @@ class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public I
 	private:
 	/** TERRAIN PREDICTION UTILITIES
 	*/
-		FRotator GetPlaneRotation(FVector A, FVector B, FVector C, FVector RightVector, FRotator& OutRotation, bool bComputeHalf, bool bShowDebug);
-		FVector TraceGroundRaycast(UWorld* World, FVector Origin, FVector Dest);
+		/**
+		*	Trace the ground under each of the @NumProbes @Origins along @RayVector. Probes without hit return their destination.
+		*	With async traces (@FProceduralGaitLODSettings::bUseAsyncTraces), the probes are issued together and the results of the previous request
+		*	are used: return false while any of them is missing. Game thread.
+		*/
+		bool TraceGroundProbes(UWorld* World, const FVector* Origins, int32 NumProbes, FVector* OutPoints);
 
 
-		FRotator ComputeGroundReflection_LOD0();
-		FRotator ComputeGroundReflection_LOD1();
+		/** Trace the ground under the ground reflection sockets. Game thread. */
+		void GatherGroundReflectionSamples(FGroundReflectionSamples& OutSamples);
+		/** Ground reflection rotation from the traced samples. Any thread. */
+		FRotator SolveGroundReflection(const FGroundReflectionSamples& Samples);
 
 
 	private:
 	/** PROCEDURAL GAIT UTILITIES
 	*/
-		/** Trace complexe ray... */
-		bool TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius);
+		/** Trace complexe ray... With a valid @AsyncKey and async traces enabled for the LOD, return the result of the previous request of this key.
+		*	With @bUseGroundCache, vertical traces are answered by the @UGaitGroundCacheSubsystem when possible. */
+		bool TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius, int32 AsyncKey = INDEX_NONE, bool bUseGroundCache = false);
 
 		/** Get best hit result according to the ideal location.*/
 		FHitResult& GetBestHitResult(TArray<FHitResult>& HitResults, FVector IdealLocation);
@@ -270,14 +519,58 @@ class NOBUNANIM_API UProceduralGaitAnimInstance : public UAnimInstance, public I
 		void ComputeCollisionCorrection(const FGaitCorrectionData* CorrectionData, FGaitEffectorData& Effector);
 
 		/** Update effectors data.*/
-		void UpdateEffectors(const UGaitDataAsset& CurrentAsset);
+		void UpdateEffectors(int32 GaitIndex);
 
-		/** AARJHALJKDHFLKJDAHL(some kind of dying scream). */
-		bool IsInRange(float Value, float Min, float Max, float& OutRangeMin, float& OutRangeMax);
+		/** Resolve @GaitsData into @GaitBinding and allocate effector slots. */
+		void InitializeGaitBinding();
+		/** Add the effector, ground reference, collision origin and ground reflection sockets to @SocketCache. */
+		void BuildSocketCache();
 
 		void DrawGaitDebug(FVector Position, FVector EffectorLocation, FVector CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData);
 
 		void UpdateLOD(bool bForceUpdate = false);
 
+		/** Call UpdateEffectorTranslation, or defer it while computing. */
+		void QueueEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed);
+		/** Call UpdateEffectorRotation, or defer it while computing. */
+		void QueueEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed);
+		/** Call @RaiseGaitEvent, or defer it while computing. */
+		void QueueGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location);
+		/** Queue a gait event to the @UGaitEventSubsystem, and broadcast @OnCollisionEvent for footfalls if @bBroadcastCollisionEvent. Game thread. */
+		void RaiseGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location);
+	#if WITH_EDITOR
+		/** Draw now, or defer it while computing. */
+		void QueueDebugDraw(TFunction<void(UWorld*)>&& Draw);
+	#endif
+
 		void SetProceduralGaitUpdateEnable(bool bEnable);
+
+		/** Refresh rate of the gait update for the current LOD and off-screen policy. */
+		int32 GetGaitTargetFPS() const;
+		/** Move to the scheduler bucket of @GetGaitTargetFPS if needed. */
+		void RescheduleGaitUpdate();
+		/** Apply the off-screen policy of the current LOD if the mesh hasn't been rendered recently. Game thread. */
+		void UpdateOffscreenPolicy();
+		/** Are effector outputs and ground reflection suspended by the off-screen policy? */
+		FORCEINLINE bool AreGaitOutputsSuspended() const { return OffscreenPolicy == EGaitOffscreenPolicy::Suspend || OffscreenPolicy == EGaitOffscreenPolicy::PhaseOnly; }
+
+	/** OUTPUT UPSAMPLING
+	*/
+		/** Start a new gait sample: the outputs written until the next one belong to it. Call before applying the gait outputs. */
+		void BeginOutputSample();
+		/** Blend factor between the last two gait samples at @Now (above 1 when extrapolating). */
+		float GetUpsampleAlpha(float Now) const;
+		/** Write the blend of the last two gait samples into @EffectorsTranslation and @BonesRotation. */
+		void PresentUpsampledOutputs(float Alpha);
+		/** Store the new ground reflection solve if any, present the upsampled outputs at @Now and return the ground reflection target. */
+		FRotator UpsampleOutputs(const FRotator* SolvedTarget, float Now);
+
+	/** ANIMATION PROXY MODE
+	*/
+		/** Game thread, before the animation update. */
+		void ProxyPreUpdate(float DeltaSeconds);
+		/** Animation update thread. */
+		void ProxyUpdate();
+		/** Game thread, after the animation update. */
+		void ProxyPostUpdate();
 };
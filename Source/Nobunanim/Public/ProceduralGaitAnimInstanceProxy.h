@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Animation/AnimInstanceProxy.h"
+#include "ProceduralGaitAnimInstanceProxy.generated.h"
+
+
+class UProceduralGaitAnimInstance;
+
+
+/**
+*	Proxy of @UProceduralGaitAnimInstance.
+*	When the instance is in AnimationProxy update mode, inputs are gathered in PreUpdate (game thread), the gait and the ground reflection are
+*	computed in Update (animation worker thread, before the graph reads @EffectorsTranslation, @BonesRotation and @GroundReflectionRotation)
+*	and events/debug draws are flushed in PostUpdate (game thread).
+*/
+USTRUCT()
+struct NOBUNANIM_API FProceduralGaitAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	public:
+		FProceduralGaitAnimInstanceProxy()
+		{
+		}
+
+		FProceduralGaitAnimInstanceProxy(UAnimInstance* InAnimInstance);
+
+		virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+		virtual void Update(float DeltaSeconds) override;
+		virtual void PostUpdate(UAnimInstance* InAnimInstance) const override;
+
+	private:
+		/** Owning instance. Only its gait state is touched from the animation thread. */
+		UProceduralGaitAnimInstance* GaitInstance = nullptr;
+};
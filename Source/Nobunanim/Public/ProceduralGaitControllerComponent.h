@@ -3,6 +3,14 @@
 #include <Runtime/Core/Public/Containers/Map.h>
 #include <Engine/Classes/Components/ActorComponent.h>
 
+#include "Nobunanim/Public/GaitDataAsset.h"
+#include "Nobunanim/Public/GaitAsyncTrace.h"
+#include "Nobunanim/Public/GaitSocketCache.h"
+#include "Nobunanim/Public/GaitSignificanceSubsystem.h"
+#include "Nobunanim/Public/GaitReplicatedState.h"
+#include "Nobunanim/Public/GaitEventSubsystem.h"
+#include "Nobunanim/Public/GaitEvaluator.h"
+
 #include "ProceduralGaitControllerComponent.generated.h"
 
 class UCurveFloat;
@@ -17,74 +25,32 @@ struct FGaitCorrectionData;
 DECLARE_DYNAMIC_DELEGATE(FSwingEvent);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnEffectorCollision, FName, EffectorName, FVector, ImpactLocation);
 
-USTRUCT(BlueprintType)
-struct FGaitEffectorData
-{
-	GENERATED_BODY()
-
-	/** @to do: Documentation. */
-	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
-	FVector CurrentEffectorLocation = FVector::ZeroVector;
-	/** @to do: Documentation. */
-	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
-	FVector IdealEffectorLocation = FVector::ZeroVector;
-
-	/** @to do: Documentation. */
-	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
-	FVector GroundLocation = FVector::ZeroVector;
-
-	/** @to do: Documentation. */
-	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
-	bool bForceSwing = false;
-
-	/** @to do: Documentation. */
-	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
-	bool bCorrectionIK = false;
-
-	/** @to do: Documentation. */
-	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
-	float BeginForceSwingInterval = 0;
-	/** @to do: Documentation. */
-	UPROPERTY(Category = "[NOBUNANIM]|Effector Data", EditAnywhere, BlueprintReadWrite)
-	float EndForceSwingInterval = 0;
-
-	//FSwingEvent OnBeginSwing;
-	//FSwingEvent OnEndSwing;
-
-	//FSwingEvent OnBeginForceSwing;
-	//FSwingEvent OnEndForceSwing;
-
-	/** @to do: Documentation. */
-	float CurrentBlendValue = 0.f;
-	/** @to do: Documentation. */
-	FName CurrentGait;
-	/** @to do: Documentation. */
-	float BlockTime = -1.f;
-};
-
-
 // RENAME AS UProceduralProceduralGaitControllerComponentComponentCOMPONENT
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
-class NOBUNANIM_API UProceduralGaitControllerComponent : public UActorComponent
+class NOBUNANIM_API UProceduralGaitControllerComponent : public UActorComponent, public IGaitSignificanceInstance, public IGaitEvaluationSink
 {
 	GENERATED_BODY()
 
 	private:
-		/** Current gait monde name.*/
-		FName CurrentGaitMode;
-		/** Pending gait mode name. Use to switch gaot with blend time. */
-		FName PendingGaitMode = "";
-		/** Current time of the cycle (in absolute time [0,1]).*/
-		float CurrentTime = 0;
-		/** Current time buffer used to compute current time.*/
-		float TimeBuffer = 0;
+		/** Gait, cycle time and effectors, advanced by the @FGaitEvaluator. Effectors are indexed by @GaitBinding slot. */
+		FGaitEvaluationState GaitState;
 		/** Owned anim instance. */
 		UProceduralGaitAnimInstance* AnimInstanceRef = nullptr;
 		/** Current LOD.*/
 		int32 CurrentLOD = 0;
-		/** @to do: document. */
-		bool bBlendIn = true;
-
+		/** Predicted LOD waiting for the hysteresis time before being applied. INDEX_NONE if none. */
+		int32 PendingLOD = INDEX_NONE;
+		/** World time @PendingLOD was first predicted. */
+		float PendingLODStartTime = 0.f;
+		/** Minimum LOD imposed by the gait budget. */
+		int32 SignificanceMinLOD = 0;
+		/** Last significance computed by the gait budget. */
+		float GaitSignificance = 1.f;
+		/** Gait state sent to simulated proxies, refreshed by the server (see @bReplicateGait). */
+		UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedGaitState)
+		FGaitReplicatedState ReplicatedGaitState;
+		/** World time of the last refresh of @ReplicatedGaitState. */
+		float LastGaitStateRefreshTime = -1.f;
 
 
 	protected:
@@ -109,6 +75,18 @@ class NOBUNANIM_API UProceduralGaitControllerComponent : public UActorComponent
 		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller|Debug", EditAnywhere, BlueprintReadWrite)
 		bool bShowDebug = false;
 
+		/** Gameplay importance of this component for the gait budget (see @UGaitSignificanceSubsystem). */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+		float GaitImportance = 1.f;
+
+		/** Also broadcast @OnCollisionEvent for each footfall. Gait events go to the @UGaitEventSubsystem queue either way. */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller", EditAnywhere, BlueprintReadWrite)
+		bool bBroadcastCollisionEvent = false;
+
+		/** Replicate a compact gait state to simulated proxies, which keep evaluating the gait locally and resynchronize on it (see @FGaitReplicatedState). */
+		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller|Replication", EditDefaultsOnly, BlueprintReadOnly)
+		bool bReplicateGait = false;
+
 		
 #if WITH_EDITORONLY_DATA
 		/** Show effector debug. */
@@ -117,11 +95,33 @@ class NOBUNANIM_API UProceduralGaitControllerComponent : public UActorComponent
 #endif
 
 	protected:
-		/** Map of Gaits data. Keys are the name of the Gait. */
-		TMap<FName, FGaitEffectorData> Effectors;
-	
-		/** @to do: documentation. */
-		FVector LastVelocity;
+		/** Resolved @GaitsData. */
+		FGaitSetBinding GaitBinding;
+		/** Asynchronous traces, flushed at the end of each tick. */
+		FGaitAsyncTraceQueue AsyncTraces;
+		/** Scratch hit results of @TraceRay, reused so traces don't allocate once warm. */
+		TArray<FHitResult> TraceHits;
+		/** Number of gait updates. With the unique id, drives the trace phase of the effectors (see @FProceduralGaitLODSettings::TraceStride). */
+		uint32 GaitUpdateCounter = 0;
+		/** Off-screen policy in effect, KeepUpdating while on screen (see @FProceduralGaitLODSettings::OffscreenPolicy). */
+		EGaitOffscreenPolicy OffscreenPolicy = EGaitOffscreenPolicy::KeepUpdating;
+		/** Every socket read by the gait update, refreshed once per tick (see @BuildSocketCache). */
+		FGaitSocketCache SocketCache;
+
+		/** Was the last tick idle (velocity only gait without velocity)? */
+		bool bIdleGaitUpdate = false;
+#if WITH_EDITOR
+		/** Binding to @UNobunanimSettings::OnSettingsChanged, to pick up LOD settings edited while playing. */
+		FDelegateHandle SettingsChangedHandle;
+#endif
+		/** World time the gait became idle, negative if not idle. */
+		float IdleStartTime = -1.f;
+		/** Is the component dormant (tick disabled until woken up)? */
+		bool bGaitDormant = false;
+		/** Wake up bindings while dormant. */
+		FDelegateHandle DormantTransformHandle;
+		FDelegateHandle DormantGroundHandle;
+
 		
 		/** */
 		bool bLastFrameWasDisable = true;
@@ -134,6 +134,30 @@ class NOBUNANIM_API UProceduralGaitControllerComponent : public UActorComponent
 	protected:
 		// Called when the game starts
 		virtual void BeginPlay() override;
+		virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	public:
+		virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	public:
+	/** GAIT SIGNIFICANCE INTERFACE
+	*/
+		virtual bool GetSignificanceInputs(FGaitSignificanceInputs& OutInputs) override;
+		virtual void ApplySignificance(float Significance, int32 MinLOD) override;
+		virtual UObject* GetSignificanceObject() override;
+
+	private:
+	/** GAIT EVALUATION SINK
+	*/
+		virtual void EmitEffectorTranslation(const FName& Key, const FVector& Translation, bool bLerp, float LerpSpeed) override;
+		virtual void EmitEffectorRotation(const FName& Key, const FRotator& Rotation, float LerpSpeed) override;
+		virtual void EmitGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location) override;
+		virtual FVector GetCorrectionOrigin(int32 Slot, const FName& SocketName) override;
+		virtual bool TraceCorrection(int32 Slot, const FVector& Origin, const FVector& Dest, ECollisionChannel TraceChannel, FVector& OutImpactPoint) override;
+	#if WITH_EDITOR
+		virtual void DrawCorrectionDebug(const FVector& Location) override;
+		virtual void DrawEffectorDebug(const FVector& Position, const FVector& EffectorLocation, const FVector& CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData) override;
+	#endif
 
 	public:	
 		// Called every frame
@@ -142,10 +166,40 @@ class NOBUNANIM_API UProceduralGaitControllerComponent : public UActorComponent
 		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller", BlueprintNativeEvent, BlueprintCallable)
 		void UpdateGaitMode(const FName& NewGaitName);
 		
-		/** Called each time than an effector that must raise the event enter in collision. */
+		/** Called each time than an effector that must raise the event enter in collision. Only if @bBroadcastCollisionEvent (see @UGaitEventSubsystem). */
 		UPROPERTY(Category = "[NOBUNANIM]|Gait Controller|Debug", BlueprintAssignable)
 		FOnEffectorCollision OnCollisionEvent;
 
+		/** Wake the component up if dormant (see @UNobunanimSettings::bGaitDormancy). */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller", BlueprintCallable)
+		void WakeGait();
+
+		/** Is the component dormant? */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller", BlueprintPure)
+		bool IsGaitDormant() const { return bGaitDormant; }
+
+	public:
+	/** GAIT REPLICATION
+	*/
+		/** Current gait, phase and blend progress, quantized for replication. */
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller|Replication", BlueprintPure)
+		FGaitReplicatedState GetReplicatedGaitState() const;
+
+		/**
+		*	Resynchronize the local gait on a state of the server. The first state is adopted as is, then gait changes blend as usual and
+		*	the phase is caught up by playing the cycle slightly faster or slower (see @FGaitReplicationSettings::MaxPhaseCorrection).
+		*	Called on simulated proxies when @bReplicateGait.
+		*/
+		UFUNCTION(Category = "[NOBUNANIM]|Gait Controller|Replication", BlueprintCallable)
+		void ApplyReplicatedGaitState(const FGaitReplicatedState& State);
+
+	private:
+		UFUNCTION()
+		void OnRep_ReplicatedGaitState();
+
+		/** Server: refresh @ReplicatedGaitState if @bForce or the phase refresh interval elapsed. */
+		void RefreshReplicatedGaitState(bool bForce);
+
 
 #if WITH_EDITOR
 		/** [NOBUNANIM] Toggle procedural gait debug for this actor. */
@@ -163,16 +217,35 @@ class NOBUNANIM_API UProceduralGaitControllerComponent : public UActorComponent
 		void ComputeCollisionCorrection(const FGaitCorrectionData* CorrectionData, FGaitEffectorData& Effector);
 
 		/** Update effectors data.*/
-		void UpdateEffectors(const UGaitDataAsset& CurrentAsset);
+		void UpdateEffectors(int32 GaitIndex);
+
+		/** Queue a gait event to the @UGaitEventSubsystem, and broadcast @OnCollisionEvent for footfalls if @bBroadcastCollisionEvent. */
+		void RaiseGaitEvent(EGaitEventType Type, const FName& Key, const FVector& Location);
 
-		/** AARJHALJKDHFLKJDAHL(some kind of dying scream). */
-		bool IsInRange(float Value, float Min, float Max, float& OutRangeMin, float& OutRangeMax);
+		/** Resolve @GaitsData into @GaitBinding and allocate effector slots. */
+		void InitializeGaitBinding();
+		/** Add the effector, ground reference and collision origin sockets to @SocketCache. */
+		void BuildSocketCache();
 
 		void DrawGaitDebug(FVector Position, FVector EffectorLocation, FVector CurrentLocation, float Treshold, bool bAutoAdjustWithIdealEffector, bool bForceSwing, const FGaitDebugData* DebugData);
 
 		void UpdateLOD(bool bForceUpdate = false);
-
-		bool TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius);
+		/** Set the tick interval for the current LOD and off-screen policy. No-op if it doesn't change. */
+		void UpdateTickInterval();
+		/** Apply the off-screen policy of the current LOD if the mesh hasn't been rendered recently. */
+		void UpdateOffscreenPolicy();
+
+		/** Go dormant if idle for long enough. */
+		void UpdateGaitDormancy();
+		void EnterGaitDormancy();
+		/** Leave dormancy without enabling the tick. */
+		void ExitGaitDormancy();
+		void OnDormantMeshTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+		void OnDormantGroundChanged(const FBox& Bounds);
+
+		/** With a valid @AsyncKey and async traces enabled for the LOD, return the result of the previous request of this key.
+		*	With @bUseGroundCache, vertical traces are answered by the @UGaitGroundCacheSubsystem when possible. */
+		bool TraceRay(UWorld* World, TArray<FHitResult>& HitResults, FVector Origin, FVector Dest, TEnumAsByte<ECollisionChannel> TraceChannel, float SphereCastRadius, int32 AsyncKey = INDEX_NONE, bool bUseGroundCache = false);
 
 		FHitResult& GetBestHitResult(TArray<FHitResult>& HitResults, FVector IdealLocation);
 		
@@ -40,6 +40,8 @@ public class NobunanimEditor : ModuleRules
             "AnimGraph",
             "AnimGraphRuntime",
             "SlateCore",
+            "Json",
+            "JsonUtilities",
             "Nobunanim"
         });
 
@@ -0,0 +1,457 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GaitBenchmarkCommandlet.h"
+#include "NobunanimEditor.h"
+
+#include "Nobunanim/Public/ProceduralGaitAnimInstance.h"
+#include "Nobunanim/Public/ProceduralGaitControllerComponent.h"
+#include "Nobunanim/Public/GaitQueryCounters.h"
+
+#include "Components/BoxComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/PlatformMemory.h"
+#include "JsonObjectConverter.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+
+/** Relative change from @Base to @Value. */
+static double GetRelativeChange(double Base, double Value)
+{
+	if (Base > 0.0)
+	{
+		return (Value - Base) / Base;
+	}
+	return Value > 0.0 ? 1.0 : 0.0;
+}
+
+
+UGaitBenchmarkCommandlet::UGaitBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	ShowErrorCount = true;
+
+	HelpDescription = TEXT("Measure the gait update cost of characters walking on procedural terrains, as JSON.");
+	HelpUsage = TEXT("UnrealEditor-Cmd <Project> -run=GaitBenchmark -nullrhi -unattended -AnimInstanceCharacter=<Class> -ComponentCharacter=<Class> [-Count=100] [-Frames=600] [-Output=<File>] [-Baseline=<File>]");
+
+	HelpParamNames.Add(TEXT("AnimInstanceCharacter"));
+	HelpParamDescriptions.Add(TEXT("Character class whose mesh runs a UProceduralGaitAnimInstance."));
+	HelpParamNames.Add(TEXT("ComponentCharacter"));
+	HelpParamDescriptions.Add(TEXT("Character class with a UProceduralGaitControllerComponent."));
+	HelpParamNames.Add(TEXT("Count"));
+	HelpParamDescriptions.Add(TEXT("Characters per run, 1 to 10000 (default 100)."));
+	HelpParamNames.Add(TEXT("Frames"));
+	HelpParamDescriptions.Add(TEXT("Measured frames per run (default 600)."));
+	HelpParamNames.Add(TEXT("Warmup"));
+	HelpParamDescriptions.Add(TEXT("Frames ticked before measuring (default 60)."));
+	HelpParamNames.Add(TEXT("DeltaTime"));
+	HelpParamDescriptions.Add(TEXT("Fixed delta time in seconds (default 1/60)."));
+	HelpParamNames.Add(TEXT("Terrain"));
+	HelpParamDescriptions.Add(TEXT("Terrains to run, separated by '+' (default Flat+Slope+Steps)."));
+	HelpParamNames.Add(TEXT("Offscreen"));
+	HelpParamDescriptions.Add(TEXT("Leave the characters off-screen, the off-screen policy of the gait LOD applies."));
+	HelpParamNames.Add(TEXT("Output"));
+	HelpParamDescriptions.Add(TEXT("JSON report file (default <Project>/Saved/GaitBenchmark.json)."));
+	HelpParamNames.Add(TEXT("Baseline"));
+	HelpParamDescriptions.Add(TEXT("JSON report to compare with. Runs more than -Tolerance (default 0.1) slower or busier fail."));
+}
+
+int32 UGaitBenchmarkCommandlet::Main(const FString& Params)
+{
+	// PARAMETERS
+	FParse::Value(*Params, TEXT("Count="), NumInstances);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupFrames);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	bOffscreen = FParse::Param(*Params, TEXT("Offscreen"));
+
+	NumInstances = FMath::Clamp(NumInstances, 1, 10000);
+	NumFrames = FMath::Max(NumFrames, 1);
+	NumWarmupFrames = FMath::Max(NumWarmupFrames, 0);
+	DeltaTime = FMath::Max(DeltaTime, KINDA_SMALL_NUMBER);
+
+	TArray<TPair<FString, TSubclassOf<ACharacter>>> FrontEnds;
+	for (const TCHAR* FrontEnd : { TEXT("AnimInstance"), TEXT("Component") })
+	{
+		FString ClassPath;
+		if (!FParse::Value(*Params, *FString::Printf(TEXT("%sCharacter="), FrontEnd), ClassPath))
+		{
+			continue;
+		}
+
+		UClass* CharacterClass = LoadClass<ACharacter>(nullptr, *ClassPath);
+		if (!CharacterClass)
+		{
+			DEBUG_LOG_FORMAT(Error, "Can't load the character class %s.", *ClassPath);
+			return 1;
+		}
+		FrontEnds.Emplace(FrontEnd, CharacterClass);
+	}
+
+	if (FrontEnds.Num() == 0)
+	{
+		DEBUG_LOG_FORMAT(Error, "No character class given. Usage: %s", *HelpUsage);
+		return 1;
+	}
+
+	FString TerrainParam = TEXT("Flat+Slope+Steps");
+	FParse::Value(*Params, TEXT("Terrain="), TerrainParam);
+	TArray<FString> TerrainNames;
+	TerrainParam.ParseIntoArray(TerrainNames, TEXT("+"));
+
+	TArray<ETerrain> Terrains;
+	for (const FString& TerrainName : TerrainNames)
+	{
+		const int32 NumTerrains = Terrains.Num();
+		for (ETerrain Candidate : { ETerrain::Flat, ETerrain::Slope, ETerrain::Steps })
+		{
+			if (TerrainName.Equals(GetTerrainName(Candidate), ESearchCase::IgnoreCase))
+			{
+				Terrains.Add(Candidate);
+				break;
+			}
+		}
+
+		if (Terrains.Num() == NumTerrains)
+		{
+			DEBUG_LOG_FORMAT(Error, "Unknown terrain %s (Flat, Slope or Steps).", *TerrainName);
+			return 1;
+		}
+	}
+
+	// RUNS
+	FGaitBenchmarkReport Report;
+	Report.DeltaTime = DeltaTime;
+	Report.NumWarmupFrames = NumWarmupFrames;
+	Report.bOffscreen = bOffscreen;
+	Report.Tolerance = Tolerance;
+
+	for (const TPair<FString, TSubclassOf<ACharacter>>& FrontEnd : FrontEnds)
+	{
+		for (ETerrain Terrain : Terrains)
+		{
+			FGaitBenchmarkRun& Run = Report.Runs.AddDefaulted_GetRef();
+			if (!RunBenchmark(FrontEnd.Value, FrontEnd.Key, Terrain, Run))
+			{
+				return 1;
+			}
+
+			UE_LOG(logNobunanimEditor, Display, TEXT("%s: %d instances, %.3f ms/frame (p95 %.3f), %.4f ms/instance, %.1f traces/frame, %.1f sweeps/frame, %.1f allocations/frame."),
+				*Run.Name, Run.NumInstances, Run.AverageFrameMs, Run.P95FrameMs, Run.MsPerInstance, Run.TracesPerFrame, Run.SweepsPerFrame, Run.AllocationsPerFrame);
+		}
+	}
+
+	// BASELINE
+	if (FParse::Value(*Params, TEXT("Baseline="), Report.Baseline))
+	{
+		FString BaselineJson;
+		FGaitBenchmarkReport BaselineReport;
+		if (!FFileHelper::LoadFileToString(BaselineJson, *Report.Baseline) || !FJsonObjectConverter::JsonObjectStringToUStruct(BaselineJson, &BaselineReport, 0, 0))
+		{
+			DEBUG_LOG_FORMAT(Error, "Can't read the baseline %s.", *Report.Baseline);
+			return 1;
+		}
+
+		CompareWithBaseline(BaselineReport, Report);
+	}
+
+	// OUTPUT
+	FString OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("GaitBenchmark.json"));
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	FString ReportJson;
+	if (!FJsonObjectConverter::UStructToJsonObjectString(Report, ReportJson) || !FFileHelper::SaveStringToFile(ReportJson, *OutputPath))
+	{
+		DEBUG_LOG_FORMAT(Error, "Can't write the report %s.", *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(logNobunanimEditor, Display, TEXT("Gait benchmark report written to %s."), *OutputPath);
+	return Report.bRegressed ? 1 : 0;
+}
+
+bool UGaitBenchmarkCommandlet::RunBenchmark(TSubclassOf<ACharacter> CharacterClass, const FString& FrontEnd, ETerrain Terrain, FGaitBenchmarkRun& OutRun) const
+{
+	OutRun.FrontEnd = FrontEnd;
+	OutRun.Terrain = GetTerrainName(Terrain);
+	OutRun.Name = FString::Printf(TEXT("%s_%s"), *OutRun.FrontEnd, *OutRun.Terrain);
+	OutRun.NumInstances = NumInstances;
+	OutRun.NumFrames = NumFrames;
+
+	const int64 UsedMemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+	// WORLD
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("GaitBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+	// No game mode to start the play.
+	if (!World->HasBegunPlay())
+	{
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	// Square grid, walking along +X for the whole run.
+	const ACharacter* CharacterCDO = CharacterClass->GetDefaultObject<ACharacter>();
+	const float WalkSpeed = CharacterCDO->GetCharacterMovement() ? CharacterCDO->GetCharacterMovement()->MaxWalkSpeed : 600.f;
+	const float HalfHeight = CharacterCDO->GetSimpleCollisionHalfHeight();
+	const int32 Columns = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumInstances)));
+	const int32 Rows = FMath::DivideAndRoundUp(NumInstances, Columns);
+	const float HalfWidth = (Columns + 1) * Spacing * 0.5f;
+	const float WalkLength = (NumWarmupFrames + NumFrames) * DeltaTime * WalkSpeed;
+
+	BuildTerrain(World, Terrain, -Spacing, Rows * Spacing + WalkLength + Spacing, HalfWidth);
+
+	TArray<ACharacter*> Characters;
+	Characters.Reserve(NumInstances);
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	bool bValidFrontEnd = true;
+	for (int32 Index = 0; Index < NumInstances && bValidFrontEnd; ++Index)
+	{
+		const float X = (Index / Columns) * Spacing;
+		const float Y = ((Index % Columns) - (Columns - 1) * 0.5f) * Spacing;
+		const FVector Location(X, Y, GetTerrainHeight(Terrain, X) + HalfHeight + 2.f);
+
+		ACharacter* Character = World->SpawnActor<ACharacter>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (!Character)
+		{
+			continue;
+		}
+
+		USkeletalMeshComponent* Mesh = Character->GetMesh();
+		const bool bHasAnimInstance = Mesh && Cast<UProceduralGaitAnimInstance>(Mesh->GetAnimInstance());
+		const bool bHasComponent = Character->FindComponentByClass<UProceduralGaitControllerComponent>() != nullptr;
+		bValidFrontEnd = FrontEnd == TEXT("Component") ? bHasComponent : bHasAnimInstance && !bHasComponent;
+
+		// Nothing renders: keep the pose evaluated, and walk without controller.
+		if (Mesh)
+		{
+			Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+		}
+		if (UCharacterMovementComponent* Movement = Character->GetCharacterMovement())
+		{
+			Movement->bRunPhysicsWithNoController = true;
+		}
+		Characters.Add(Character);
+	}
+
+	if (!bValidFrontEnd)
+	{
+		DEBUG_LOG_FORMAT(Error, "%s isn't driven by the gait %s.", *CharacterClass->GetName(), *FrontEnd);
+	}
+
+	// FRAMES
+	TArray<double> FrameMs;
+	FrameMs.Reserve(NumFrames);
+	uint64 TracesBefore = 0;
+	uint64 SweepsBefore = 0;
+	int64 AllocationsBefore = 0;
+
+	for (int32 Frame = 0; Frame < NumWarmupFrames + NumFrames && bValidFrontEnd; ++Frame)
+	{
+		if (Frame == NumWarmupFrames)
+		{
+			TracesBefore = FGaitQueryCounters::GetNumTraces();
+			SweepsBefore = FGaitQueryCounters::GetNumSweeps();
+			AllocationsBefore = GetNumAllocations();
+		}
+
+		for (ACharacter* Character : Characters)
+		{
+			Character->AddMovementInput(FVector::ForwardVector, 1.f, true);
+			if (!bOffscreen && Character->GetMesh())
+			{
+				Character->GetMesh()->SetLastRenderTime(World->GetTimeSeconds());
+			}
+		}
+
+		FApp::SetDeltaTime(DeltaTime);
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+
+		const double StartTime = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, DeltaTime);
+		const double EndTime = FPlatformTime::Seconds();
+		++GFrameCounter;
+
+		if (Frame >= NumWarmupFrames)
+		{
+			FrameMs.Add((EndTime - StartTime) * 1000.0);
+		}
+	}
+
+	if (bValidFrontEnd)
+	{
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		OutRun.UsedMemoryDelta = static_cast<int64>(MemoryStats.UsedPhysical) - UsedMemoryBefore;
+		OutRun.PeakUsedMemory = MemoryStats.PeakUsedPhysical;
+
+		OutRun.NumTraces = FGaitQueryCounters::GetNumTraces() - TracesBefore;
+		OutRun.NumSweeps = FGaitQueryCounters::GetNumSweeps() - SweepsBefore;
+		OutRun.TracesPerFrame = static_cast<double>(OutRun.NumTraces) / NumFrames;
+		OutRun.SweepsPerFrame = static_cast<double>(OutRun.NumSweeps) / NumFrames;
+
+		const int64 AllocationsAfter = GetNumAllocations();
+		if (AllocationsAfter != INDEX_NONE)
+		{
+			OutRun.NumAllocations = AllocationsAfter - AllocationsBefore;
+			OutRun.AllocationsPerFrame = static_cast<double>(OutRun.NumAllocations) / NumFrames;
+		}
+
+		double TotalMs = 0.0;
+		for (double Ms : FrameMs)
+		{
+			TotalMs += Ms;
+		}
+		FrameMs.Sort();
+		OutRun.AverageFrameMs = TotalMs / NumFrames;
+		OutRun.P95FrameMs = FrameMs[FMath::Min(FMath::FloorToInt(NumFrames * 0.95f), NumFrames - 1)];
+		OutRun.MaxFrameMs = FrameMs.Last();
+		OutRun.MsPerInstance = OutRun.AverageFrameMs / NumInstances;
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	return bValidFrontEnd;
+}
+
+
+#pragma region TERRAIN
+
+void UGaitBenchmarkCommandlet::BuildTerrain(UWorld* World, ETerrain Terrain, float MinX, float MaxX, float HalfWidth) const
+{
+	constexpr float Thickness = 100.f;
+	const float HalfLength = (MaxX - MinX) * 0.5f;
+	const float CenterX = (MaxX + MinX) * 0.5f;
+
+	switch (Terrain)
+	{
+		case ETerrain::Flat:
+		{
+			AddBox(World, FVector(CenterX, 0.f, -Thickness * 0.5f), FVector(HalfLength, HalfWidth, Thickness * 0.5f));
+			break;
+		}
+
+		case ETerrain::Slope:
+		{
+			// Top face through the origin, rising along +X.
+			const float Angle = FMath::DegreesToRadians(SlopeAngle);
+			const FVector Up(-FMath::Sin(Angle), 0.f, FMath::Cos(Angle));
+			const FVector Center = FVector(CenterX, 0.f, GetTerrainHeight(Terrain, CenterX)) - Up * Thickness * 0.5f;
+			AddBox(World, Center, FVector(HalfLength / FMath::Cos(Angle), HalfWidth, Thickness * 0.5f), FRotator(SlopeAngle, 0.f, 0.f));
+			break;
+		}
+
+		case ETerrain::Steps:
+		{
+			// Flat before the first step, then one box per step, all resting on the same bottom.
+			AddBox(World, FVector(MinX * 0.5f, 0.f, -Thickness * 0.5f), FVector(-MinX * 0.5f, HalfWidth, Thickness * 0.5f));
+
+			const int32 NumSteps = FMath::CeilToInt(MaxX / StepDepth);
+			for (int32 Step = 0; Step < NumSteps; ++Step)
+			{
+				const float Top = Step * StepHeight;
+				AddBox(World, FVector((Step + 0.5f) * StepDepth, 0.f, (Top - Thickness) * 0.5f), FVector(StepDepth * 0.5f, HalfWidth, (Top + Thickness) * 0.5f));
+			}
+			break;
+		}
+	}
+}
+
+float UGaitBenchmarkCommandlet::GetTerrainHeight(ETerrain Terrain, float X) const
+{
+	switch (Terrain)
+	{
+		case ETerrain::Slope:
+			return X * FMath::Tan(FMath::DegreesToRadians(SlopeAngle));
+
+		case ETerrain::Steps:
+			return X > 0.f ? FMath::FloorToFloat(X / StepDepth) * StepHeight : 0.f;
+
+		default:
+			return 0.f;
+	}
+}
+
+void UGaitBenchmarkCommandlet::AddBox(UWorld* World, const FVector& Center, const FVector& Extent, const FRotator& Rotation) const
+{
+	AActor* BoxActor = World->SpawnActor<AActor>();
+	UBoxComponent* Box = NewObject<UBoxComponent>(BoxActor, TEXT("Collision"));
+	Box->SetMobility(EComponentMobility::Static);
+	Box->SetBoxExtent(Extent, false);
+	Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	BoxActor->SetRootComponent(Box);
+	Box->SetWorldLocationAndRotation(Center, Rotation);
+	Box->RegisterComponent();
+}
+
+#pragma endregion
+
+
+void UGaitBenchmarkCommandlet::CompareWithBaseline(const FGaitBenchmarkReport& BaselineReport, FGaitBenchmarkReport& Report) const
+{
+	for (FGaitBenchmarkRun& Run : Report.Runs)
+	{
+		const FGaitBenchmarkRun* BaselineRun = BaselineReport.Runs.FindByPredicate([&Run](const FGaitBenchmarkRun& Other)
+		{
+			return Other.Name == Run.Name && Other.NumInstances == Run.NumInstances;
+		});
+
+		if (!BaselineRun)
+		{
+			DEBUG_LOG_FORMAT(Warning, "No baseline for %s with %d instances.", *Run.Name, Run.NumInstances);
+			continue;
+		}
+
+		Run.bHasBaseline = true;
+		Run.FrameMsChange = GetRelativeChange(BaselineRun->AverageFrameMs, Run.AverageFrameMs);
+		Run.QueriesChange = GetRelativeChange(BaselineRun->TracesPerFrame + BaselineRun->SweepsPerFrame, Run.TracesPerFrame + Run.SweepsPerFrame);
+
+		const bool bCountedAllocations = BaselineRun->NumAllocations != INDEX_NONE && Run.NumAllocations != INDEX_NONE;
+		Run.AllocationsChange = bCountedAllocations ? GetRelativeChange(BaselineRun->AllocationsPerFrame, Run.AllocationsPerFrame) : 0.0;
+
+		Run.bRegressed = Run.FrameMsChange > Tolerance || Run.QueriesChange > Tolerance || Run.AllocationsChange > Tolerance;
+		if (Run.bRegressed)
+		{
+			DEBUG_LOG_FORMAT(Warning, "%s regressed: %+.1f%% ms/frame, %+.1f%% queries, %+.1f%% allocations.",
+				*Run.Name, Run.FrameMsChange * 100.0, Run.QueriesChange * 100.0, Run.AllocationsChange * 100.0);
+		}
+		Report.bRegressed |= Run.bRegressed;
+	}
+}
+
+const TCHAR* UGaitBenchmarkCommandlet::GetTerrainName(ETerrain Terrain)
+{
+	switch (Terrain)
+	{
+		case ETerrain::Slope:
+			return TEXT("Slope");
+		case ETerrain::Steps:
+			return TEXT("Steps");
+		default:
+			return TEXT("Flat");
+	}
+}
+
+int64 UGaitBenchmarkCommandlet::GetNumAllocations()
+{
+#if !UE_BUILD_SHIPPING
+	return static_cast<int64>(FMalloc::TotalMallocCalls + FMalloc::TotalReallocCalls);
+#else
+	return INDEX_NONE;
+#endif
+}
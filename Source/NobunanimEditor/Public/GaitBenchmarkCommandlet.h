@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "GaitBenchmarkCommandlet.generated.h"
+
+class ACharacter;
+class UWorld;
+
+
+/** Measures of one benchmark run: one gait front end on one terrain. */
+USTRUCT()
+struct FGaitBenchmarkRun
+{
+	GENERATED_BODY()
+
+	/** "<FrontEnd>_<Terrain>", key of the baseline comparison. */
+	UPROPERTY()
+	FString Name;
+
+	/** AnimInstance (UProceduralGaitAnimInstance) or Component (UProceduralGaitControllerComponent). */
+	UPROPERTY()
+	FString FrontEnd;
+
+	/** Flat, Slope or Steps. */
+	UPROPERTY()
+	FString Terrain;
+
+	UPROPERTY()
+	int32 NumInstances = 0;
+
+	/** Measured frames, warm up excluded. */
+	UPROPERTY()
+	int32 NumFrames = 0;
+
+	/** World tick time (in milliseconds), character movement and animation included. */
+	UPROPERTY()
+	double AverageFrameMs = 0.0;
+
+	UPROPERTY()
+	double P95FrameMs = 0.0;
+
+	UPROPERTY()
+	double MaxFrameMs = 0.0;
+
+	/** @AverageFrameMs / @NumInstances. */
+	UPROPERTY()
+	double MsPerInstance = 0.0;
+
+	/** Scene queries issued by the gait updates, see @FGaitQueryCounters. */
+	UPROPERTY()
+	int64 NumTraces = 0;
+
+	UPROPERTY()
+	int64 NumSweeps = 0;
+
+	UPROPERTY()
+	double TracesPerFrame = 0.0;
+
+	UPROPERTY()
+	double SweepsPerFrame = 0.0;
+
+	/** Malloc and realloc calls of the whole process during the measured frames. INDEX_NONE if the allocator doesn't count them. */
+	UPROPERTY()
+	int64 NumAllocations = INDEX_NONE;
+
+	UPROPERTY()
+	double AllocationsPerFrame = 0.0;
+
+	/** Physical memory used at the end of the run minus before its world was created (in bytes). */
+	UPROPERTY()
+	int64 UsedMemoryDelta = 0;
+
+	/** Peak physical memory of the process at the end of the run (in bytes). */
+	UPROPERTY()
+	int64 PeakUsedMemory = 0;
+
+	/** Was a run of the same name and instance count found in the baseline? */
+	UPROPERTY()
+	bool bHasBaseline = false;
+
+	/** Relative changes against the baseline run (0.1 means 10% more). */
+	UPROPERTY()
+	double FrameMsChange = 0.0;
+
+	/** Traces and sweeps together. */
+	UPROPERTY()
+	double QueriesChange = 0.0;
+
+	UPROPERTY()
+	double AllocationsChange = 0.0;
+
+	/** Is one of the changes above the tolerance? */
+	UPROPERTY()
+	bool bRegressed = false;
+};
+
+
+/** Output of the @UGaitBenchmarkCommandlet, also read back as baseline. */
+USTRUCT()
+struct FGaitBenchmarkReport
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float DeltaTime = 0.f;
+
+	UPROPERTY()
+	int32 NumWarmupFrames = 0;
+
+	/** Were the characters left off-screen (the off-screen policy of the gait LOD applies)? */
+	UPROPERTY()
+	bool bOffscreen = false;
+
+	UPROPERTY()
+	TArray<FGaitBenchmarkRun> Runs;
+
+	/** Baseline file compared with, empty if none. */
+	UPROPERTY()
+	FString Baseline;
+
+	/** Maximum relative change accepted against the baseline. */
+	UPROPERTY()
+	float Tolerance = 0.f;
+
+	/** Did one run regress against the baseline? */
+	UPROPERTY()
+	bool bRegressed = false;
+};
+
+
+/**
+*	Headless gait benchmark, i.e.:
+*	UnrealEditor-Cmd <Project> -run=GaitBenchmark -nullrhi -unattended -AnimInstanceCharacter=/Game/A.A_C -ComponentCharacter=/Game/B.B_C -Count=1000
+*	For each front end given (a character class driven by a UProceduralGaitAnimInstance or by a UProceduralGaitControllerComponent) and each terrain,
+*	spawns -Count characters walking forward on procedurally built box collision in a new game world, ticks it at a fixed delta time and measures it.
+*	Writes a @FGaitBenchmarkReport as JSON to -Output, compared with the report -Baseline if given. Returns 1 on error or regression.
+*/
+UCLASS()
+class UGaitBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	private:
+		enum class ETerrain : uint8
+		{
+			Flat,
+			Slope,
+			Steps
+		};
+
+		/** Number of characters per run (1 to 10000). */
+		int32 NumInstances = 100;
+		/** Measured frames per run. */
+		int32 NumFrames = 600;
+		/** Frames ticked before measuring (gait blend in, caches warm up). */
+		int32 NumWarmupFrames = 60;
+		/** Fixed delta time of the world ticks (in seconds). */
+		float DeltaTime = 1.f / 60.f;
+		/** Distance between two characters of the spawn grid. */
+		float Spacing = 300.f;
+		/** Slope terrain angle (in degrees). */
+		float SlopeAngle = 15.f;
+		/** Steps terrain step size. */
+		float StepHeight = 20.f;
+		float StepDepth = 100.f;
+		/** Leave the characters off-screen instead of marking them rendered each frame. */
+		bool bOffscreen = false;
+		/** Maximum relative change accepted against the baseline. */
+		float Tolerance = 0.1f;
+
+	public:
+		UGaitBenchmarkCommandlet();
+
+		virtual int32 Main(const FString& Params) override;
+
+	private:
+		/** Measure @CharacterClass on @Terrain in a new world. Return false if the characters don't use the gait @FrontEnd. */
+		bool RunBenchmark(TSubclassOf<ACharacter> CharacterClass, const FString& FrontEnd, ETerrain Terrain, FGaitBenchmarkRun& OutRun) const;
+
+		/** Add the collision of @Terrain covering [@MinX, @MaxX] x [-@HalfWidth, @HalfWidth]. */
+		void BuildTerrain(UWorld* World, ETerrain Terrain, float MinX, float MaxX, float HalfWidth) const;
+		/** Height of @Terrain at @X. */
+		float GetTerrainHeight(ETerrain Terrain, float X) const;
+		/** Add a blocking box to @World. */
+		void AddBox(UWorld* World, const FVector& Center, const FVector& Extent, const FRotator& Rotation = FRotator::ZeroRotator) const;
+
+		/** Fill the baseline changes of the runs of @Report. */
+		void CompareWithBaseline(const FGaitBenchmarkReport& BaselineReport, FGaitBenchmarkReport& Report) const;
+
+		static const TCHAR* GetTerrainName(ETerrain Terrain);
+		/** Malloc and realloc calls since start, INDEX_NONE if not counted. */
+		static int64 GetNumAllocations();
+};
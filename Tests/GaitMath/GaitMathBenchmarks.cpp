@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Public/GaitMath.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+
+namespace
+{
+	/** Plain vector standing in for FVector. */
+	struct FBenchVector
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	/** Deterministic pseudo random values in [0, 1). */
+	std::vector<float> MakeUnitValues(int Count, unsigned Seed)
+	{
+		std::vector<float> Values(Count);
+		for (float& Value : Values)
+		{
+			Seed = Seed * 1664525u + 1013904223u;
+			Value = (float)(Seed >> 8) / (float)(1u << 24);
+		}
+		return Values;
+	}
+
+	constexpr int NumInputs = 1024;
+}
+
+
+/** Swing classification of one effector per input, half of the windows wrapping around the cycle. */
+static void BM_SwingClassification(benchmark::State& State)
+{
+	const std::vector<float> Times = MakeUnitValues(NumInputs, 1u);
+	const std::vector<float> Begins = MakeUnitValues(NumInputs, 2u);
+	const std::vector<float> Ends = MakeUnitValues(NumInputs, 3u);
+
+	for (auto _ : State)
+	{
+		int NumInRange = 0;
+		for (int Idx = 0; Idx < NumInputs; ++Idx)
+		{
+			float Min, Max;
+			NumInRange += FGaitMath::IsInSwingRange(Times[Idx], Begins[Idx], Ends[Idx], Min, Max) ? 1 : 0;
+			benchmark::DoNotOptimize(Min);
+			benchmark::DoNotOptimize(Max);
+		}
+		benchmark::DoNotOptimize(NumInRange);
+	}
+	State.SetItemsProcessed(State.iterations() * NumInputs);
+}
+BENCHMARK(BM_SwingClassification);
+
+/** Phase accumulation of one gait instance per input. */
+static void BM_PhaseAccumulation(benchmark::State& State)
+{
+	const std::vector<float> Advances = MakeUnitValues(NumInputs, 4u);
+	std::vector<float> TimeBuffers(NumInputs, 0.f);
+
+	for (auto _ : State)
+	{
+		for (int Idx = 0; Idx < NumInputs; ++Idx)
+		{
+			benchmark::DoNotOptimize(FGaitMath::AdvancePhase(TimeBuffers[Idx], Advances[Idx] * 0.05f));
+		}
+		benchmark::ClobberMemory();
+	}
+	State.SetItemsProcessed(State.iterations() * NumInputs);
+}
+BENCHMARK(BM_PhaseAccumulation);
+
+/** Force swing interval of one effector per input. */
+static void BM_ForceSwingInterval(benchmark::State& State)
+{
+	const std::vector<float> Times = MakeUnitValues(NumInputs, 5u);
+	const std::vector<float> Begins = MakeUnitValues(NumInputs, 6u);
+	const std::vector<float> Ends = MakeUnitValues(NumInputs, 7u);
+
+	for (auto _ : State)
+	{
+		for (int Idx = 0; Idx < NumInputs; ++Idx)
+		{
+			float Begin, End;
+			FGaitMath::ComputeForceSwingInterval(Times[Idx], Begins[Idx], Ends[Idx], Begin, End);
+			benchmark::DoNotOptimize(Begin);
+			benchmark::DoNotOptimize(End);
+		}
+	}
+	State.SetItemsProcessed(State.iterations() * NumInputs);
+}
+BENCHMARK(BM_ForceSwingInterval);
+
+/** Vector curve lookup (3 interleaved components), table size as argument. */
+static void BM_SampleLUT(benchmark::State& State)
+{
+	const int NumSamples = (int)State.range(0);
+	const std::vector<float> Samples = MakeUnitValues(NumSamples * 3, 8u);
+	const std::vector<float> Times = MakeUnitValues(NumInputs, 9u);
+
+	for (auto _ : State)
+	{
+		for (int Idx = 0; Idx < NumInputs; ++Idx)
+		{
+			float Out[3];
+			FGaitMath::SampleLUT<3>(Samples.data(), NumSamples, Times[Idx], Out);
+			benchmark::DoNotOptimize(Out);
+		}
+	}
+	State.SetItemsProcessed(State.iterations() * NumInputs);
+}
+BENCHMARK(BM_SampleLUT)->Arg(16)->Arg(64)->Arg(256);
+
+/**
+*	Shared evaluation cache lookup (UGaitEvaluationCacheSubsystem): quantized phase index into the samples of the calling thread, filled from a
+*	64 sample LUT on first use. Phase steps per cycle as argument. Compare with @BM_SampleLUT, what the cache replaces for baked curves.
+*/
+static void BM_SharedSampleLookup(benchmark::State& State)
+{
+	const float Step = 1.f / (float)State.range(0);
+	const int NumPhases = FGaitMath::GetNumQuantizedPhases(Step);
+	const int NumLUTSamples = 64;
+	const std::vector<float> Samples = MakeUnitValues(NumLUTSamples * 3, 8u);
+	const std::vector<float> Times = MakeUnitValues(NumInputs, 9u);
+
+	std::vector<float> Cached(NumPhases * 3);
+	std::vector<unsigned char> Valid(NumPhases, 0);
+
+	for (auto _ : State)
+	{
+		for (int Idx = 0; Idx < NumInputs; ++Idx)
+		{
+			const int Phase = FGaitMath::QuantizePhase(Times[Idx], Step);
+			float* Out = &Cached[Phase * 3];
+			if (!Valid[Phase])
+			{
+				const float QuantizedTime = (float)Phase * Step;
+				FGaitMath::SampleLUT<3>(Samples.data(), NumLUTSamples, QuantizedTime < 1.f ? QuantizedTime : 1.f, Out);
+				Valid[Phase] = 1;
+			}
+			benchmark::DoNotOptimize(Out[0]);
+			benchmark::DoNotOptimize(Out[1]);
+			benchmark::DoNotOptimize(Out[2]);
+		}
+	}
+	State.SetItemsProcessed(State.iterations() * NumInputs);
+}
+BENCHMARK(BM_SharedSampleLookup)->Arg(32)->Arg(128)->Arg(512);
+
+/** Ground plane fit, number of probes as argument. */
+static void BM_FitPlane(benchmark::State& State)
+{
+	const int NumPoints = (int)State.range(0);
+	const std::vector<float> Noise = MakeUnitValues(NumPoints * 3, 10u);
+	std::vector<FBenchVector> Points(NumPoints);
+	for (int Idx = 0; Idx < NumPoints; ++Idx)
+	{
+		const float X = Noise[Idx * 3] * 100.f;
+		const float Y = Noise[Idx * 3 + 1] * 100.f;
+		Points[Idx] = FBenchVector{ X, Y, 0.2f * X - 0.1f * Y + Noise[Idx * 3 + 2] };
+	}
+
+	for (auto _ : State)
+	{
+		FBenchVector Centroid{}, Normal{};
+		benchmark::DoNotOptimize(FGaitMath::FitPlane(Points.data(), NumPoints, Centroid, Normal));
+		benchmark::DoNotOptimize(Normal);
+	}
+	State.SetItemsProcessed(State.iterations() * NumPoints);
+}
+BENCHMARK(BM_FitPlane)->Arg(4)->Arg(8)->Arg(32);
+
+/** One CCD link rotation per input, with the rotation limit. */
+static void BM_CCDLink(benchmark::State& State)
+{
+	const std::vector<float> Noise = MakeUnitValues(NumInputs * 6, 11u);
+	std::vector<FBenchVector> Tips(NumInputs), Targets(NumInputs);
+	for (int Idx = 0; Idx < NumInputs; ++Idx)
+	{
+		Tips[Idx] = FBenchVector{ Noise[Idx * 6] - 0.5f, Noise[Idx * 6 + 1] - 0.5f, Noise[Idx * 6 + 2] - 0.5f };
+		Targets[Idx] = FBenchVector{ Noise[Idx * 6 + 3] - 0.5f, Noise[Idx * 6 + 4] - 0.5f, Noise[Idx * 6 + 5] - 0.5f };
+	}
+	const FBenchVector Link{ 0.f, 0.f, 0.f };
+
+	for (auto _ : State)
+	{
+		for (int Idx = 0; Idx < NumInputs; ++Idx)
+		{
+			FBenchVector Axis;
+			float Angle, AngleDelta = 0.f;
+			benchmark::DoNotOptimize(FGaitMath::ComputeCCDLinkRotation(Link, Tips[Idx], Targets[Idx], 0.5f, true, AngleDelta, Axis, Angle));
+			benchmark::DoNotOptimize(AngleDelta);
+		}
+	}
+	State.SetItemsProcessed(State.iterations() * NumInputs);
+}
+BENCHMARK(BM_CCDLink);
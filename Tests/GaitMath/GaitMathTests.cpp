@@ -0,0 +1,253 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Nobunanim/Public/GaitMath.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+
+namespace
+{
+	/** Plain vector standing in for FVector. */
+	struct FTestVector
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	/** Curve sample type convertible to float, standing in for FFloat16. */
+	struct FTestSample
+	{
+		float Value;
+		explicit operator float() const { return Value; }
+	};
+
+	constexpr float Tolerance = 1.e-5f;
+	constexpr float Pi = 3.14159265358979f;
+}
+
+
+/** PHASE
+*/
+TEST(GaitMathPhase, GetPhaseWrapsTheTimeBuffer)
+{
+	EXPECT_NEAR(FGaitMath::GetPhase(0.25f), 0.25f, Tolerance);
+	EXPECT_NEAR(FGaitMath::GetPhase(3.75f), 0.75f, Tolerance);
+	EXPECT_NEAR(FGaitMath::GetPhase(1.f), 0.f, Tolerance);
+}
+
+TEST(GaitMathPhase, AdvancePhaseAccumulates)
+{
+	float TimeBuffer = 0.f;
+	float Phase = 0.f;
+	for (int Step = 0; Step < 10; ++Step)
+	{
+		Phase = FGaitMath::AdvancePhase(TimeBuffer, 0.15f);
+	}
+
+	EXPECT_NEAR(TimeBuffer, 1.5f, Tolerance);
+	EXPECT_NEAR(Phase, 0.5f, Tolerance);
+}
+
+TEST(GaitMathPhase, TimeUntilPhaseWrapsForward)
+{
+	EXPECT_NEAR(FGaitMath::GetTimeUntilPhase(0.2f, 0.5f), 0.3f, Tolerance);
+	EXPECT_NEAR(FGaitMath::GetTimeUntilPhase(0.8f, 0.1f), 0.3f, Tolerance);
+	EXPECT_NEAR(FGaitMath::GetTimeUntilPhase(0.4f, 0.4f), 0.f, Tolerance);
+}
+
+TEST(GaitMathPhase, QuantizedPhasesCoverTheCycle)
+{
+	const float Step = 1.f / 128.f;
+	const int NumPhases = FGaitMath::GetNumQuantizedPhases(Step);
+	EXPECT_EQ(NumPhases, 129);
+
+	EXPECT_EQ(FGaitMath::QuantizePhase(0.f, Step), 0);
+	EXPECT_EQ(FGaitMath::QuantizePhase(0.5f * Step - 1.e-4f, Step), 0);
+	EXPECT_EQ(FGaitMath::QuantizePhase(0.5f * Step + 1.e-4f, Step), 1);
+	EXPECT_EQ(FGaitMath::QuantizePhase(1.f, Step), NumPhases - 1);
+
+	// Out of range phases are clamped.
+	EXPECT_EQ(FGaitMath::QuantizePhase(-0.5f, Step), 0);
+	EXPECT_EQ(FGaitMath::QuantizePhase(1.5f, Step), NumPhases - 1);
+
+	// Steps not dividing the cycle.
+	EXPECT_EQ(FGaitMath::QuantizePhase(1.f, 0.3f), FGaitMath::GetNumQuantizedPhases(0.3f) - 1);
+}
+
+
+/** SWING WINDOW
+*/
+TEST(GaitMathSwing, InsideAndOutsideAPlainWindow)
+{
+	float Min, Max;
+	EXPECT_TRUE(FGaitMath::IsInSwingRange(0.3f, 0.2f, 0.6f, Min, Max));
+	EXPECT_NEAR(Min, 0.2f, Tolerance);
+	EXPECT_NEAR(Max, 0.6f, Tolerance);
+
+	EXPECT_FALSE(FGaitMath::IsInSwingRange(0.1f, 0.2f, 0.6f, Min, Max));
+	EXPECT_FALSE(FGaitMath::IsInSwingRange(0.7f, 0.2f, 0.6f, Min, Max));
+}
+
+TEST(GaitMathSwing, WrappingWindowIsUnwrappedAroundTheValue)
+{
+	float Min, Max;
+
+	// After the begin: the end moves to the next cycle.
+	EXPECT_TRUE(FGaitMath::IsInSwingRange(0.9f, 0.8f, 0.2f, Min, Max));
+	EXPECT_NEAR(Min, 0.8f, Tolerance);
+	EXPECT_NEAR(Max, 1.2f, Tolerance);
+
+	// Before the end: the begin moves to the previous cycle.
+	EXPECT_TRUE(FGaitMath::IsInSwingRange(0.1f, 0.8f, 0.2f, Min, Max));
+	EXPECT_NEAR(Min, -0.2f, Tolerance);
+	EXPECT_NEAR(Max, 0.2f, Tolerance);
+
+	EXPECT_FALSE(FGaitMath::IsInSwingRange(0.5f, 0.8f, 0.2f, Min, Max));
+}
+
+TEST(GaitMathSwing, ForceSwingIntervalKeepsTheWindowLength)
+{
+	float Begin, End;
+	FGaitMath::ComputeForceSwingInterval(0.1f, 0.4f, 0.7f, Begin, End);
+	EXPECT_NEAR(Begin, 0.1f, Tolerance);
+	EXPECT_NEAR(End, 0.4f, Tolerance);
+
+	// Wrapping source window, wrapping result.
+	FGaitMath::ComputeForceSwingInterval(0.9f, 0.8f, 0.2f, Begin, End);
+	EXPECT_NEAR(Begin, 0.9f, Tolerance);
+	EXPECT_NEAR(End, 0.3f, Tolerance);
+}
+
+
+/** CURVE LOOKUP TABLE
+*/
+TEST(GaitMathLUT, SamplesInterpolateAndClamp)
+{
+	// 3 samples of 2 components on [0, 1].
+	const float Samples[] = { 0.f, 10.f, 1.f, 20.f, 3.f, 40.f };
+	float Out[2];
+
+	FGaitMath::SampleLUT<2>(Samples, 3, 0.25f, Out);
+	EXPECT_NEAR(Out[0], 0.5f, Tolerance);
+	EXPECT_NEAR(Out[1], 15.f, Tolerance);
+
+	FGaitMath::SampleLUT<2>(Samples, 3, 0.75f, Out);
+	EXPECT_NEAR(Out[0], 2.f, Tolerance);
+	EXPECT_NEAR(Out[1], 30.f, Tolerance);
+
+	// Last sample exactly, and out of range times.
+	FGaitMath::SampleLUT<2>(Samples, 3, 1.f, Out);
+	EXPECT_NEAR(Out[0], 3.f, Tolerance);
+	FGaitMath::SampleLUT<2>(Samples, 3, 2.f, Out);
+	EXPECT_NEAR(Out[1], 40.f, Tolerance);
+	FGaitMath::SampleLUT<2>(Samples, 3, -1.f, Out);
+	EXPECT_NEAR(Out[0], 0.f, Tolerance);
+}
+
+TEST(GaitMathLUT, ConvertibleSampleType)
+{
+	const FTestSample Samples[] = { { 2.f }, { 4.f } };
+	float Out;
+	FGaitMath::SampleLUT<1>(Samples, 2, 0.5f, &Out);
+	EXPECT_NEAR(Out, 3.f, Tolerance);
+}
+
+
+/** GROUND PLANE
+*/
+TEST(GaitMathPlane, FitsASlope)
+{
+	// z = 0.5 x + 10
+	const FTestVector Points[] = { { 0.f, 0.f, 10.f }, { 2.f, 0.f, 11.f }, { 0.f, 2.f, 10.f }, { 2.f, 2.f, 11.f } };
+	FTestVector Centroid{}, Normal{};
+	ASSERT_TRUE(FGaitMath::FitPlane(Points, 4, Centroid, Normal));
+
+	EXPECT_NEAR(Centroid.X, 1.f, Tolerance);
+	EXPECT_NEAR(Centroid.Y, 1.f, Tolerance);
+	EXPECT_NEAR(Centroid.Z, 10.5f, Tolerance);
+
+	const float InvLength = 1.f / std::sqrt(1.25f);
+	EXPECT_NEAR(Normal.X, -0.5f * InvLength, Tolerance);
+	EXPECT_NEAR(Normal.Y, 0.f, Tolerance);
+	EXPECT_NEAR(Normal.Z, InvLength, Tolerance);
+}
+
+TEST(GaitMathPlane, RejectsTooFewOrCollinearPoints)
+{
+	const FTestVector Unchanged{ 7.f, 8.f, 9.f };
+	FTestVector Centroid{}, Normal = Unchanged;
+
+	const FTestVector Two[] = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f } };
+	EXPECT_FALSE(FGaitMath::FitPlane(Two, 2, Centroid, Normal));
+
+	const FTestVector Line[] = { { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f }, { 2.f, 2.f, 2.f } };
+	EXPECT_FALSE(FGaitMath::FitPlane(Line, 3, Centroid, Normal));
+
+	EXPECT_EQ(Normal.X, Unchanged.X);
+	EXPECT_EQ(Normal.Y, Unchanged.Y);
+	EXPECT_EQ(Normal.Z, Unchanged.Z);
+}
+
+
+/** CCD
+*/
+TEST(GaitMathCCD, RotatesTowardTheTarget)
+{
+	const FTestVector Link{ 0.f, 0.f, 0.f }, Tip{ 1.f, 0.f, 0.f }, Target{ 0.f, 1.f, 0.f };
+	FTestVector Axis{};
+	float Angle = 0.f, AngleDelta = 0.f;
+
+	ASSERT_TRUE(FGaitMath::ComputeCCDLinkRotation(Link, Tip, Target, Pi, false, AngleDelta, Axis, Angle));
+	EXPECT_NEAR(Angle, 0.5f * Pi, Tolerance);
+	EXPECT_NEAR(Axis.X, 0.f, Tolerance);
+	EXPECT_NEAR(Axis.Y, 0.f, Tolerance);
+	EXPECT_NEAR(Axis.Z, 1.f, Tolerance);
+	EXPECT_EQ(AngleDelta, 0.f);
+}
+
+TEST(GaitMathCCD, ClampsToThePerJointAndAccumulatedLimits)
+{
+	const FTestVector Link{ 0.f, 0.f, 0.f }, Tip{ 1.f, 0.f, 0.f }, Target{ 0.f, 1.f, 0.f };
+	FTestVector Axis{};
+	float Angle = 0.f, AngleDelta = 0.f;
+
+	ASSERT_TRUE(FGaitMath::ComputeCCDLinkRotation(Link, Tip, Target, 0.3f, true, AngleDelta, Axis, Angle));
+	EXPECT_NEAR(Angle, 0.3f, Tolerance);
+	EXPECT_NEAR(AngleDelta, 0.3f, Tolerance);
+
+	// The link already used its whole limit this solve.
+	EXPECT_FALSE(FGaitMath::ComputeCCDLinkRotation(Link, Tip, Target, 0.3f, true, AngleDelta, Axis, Angle));
+
+	// Partially used: only the rest is granted.
+	AngleDelta = 0.2f;
+	ASSERT_TRUE(FGaitMath::ComputeCCDLinkRotation(Link, Tip, Target, 0.3f, true, AngleDelta, Axis, Angle));
+	EXPECT_NEAR(Angle, 0.1f, Tolerance);
+	EXPECT_NEAR(AngleDelta, 0.3f, Tolerance);
+}
+
+TEST(GaitMathCCD, AlignedDirectionsNeverProduceNaN)
+{
+	// Directions that normalize to a dot product rounding past 1.
+	const FTestVector Link{ 0.1f, 0.2f, 0.3f };
+	const FTestVector Tip{ 0.1f + 3.f, 0.2f + 7.f, 0.3f + 11.f };
+	const FTestVector Target{ 0.1f + 6.f, 0.2f + 14.f, 0.3f + 22.f };
+
+	for (int Scale = 1; Scale < 200; ++Scale)
+	{
+		const FTestVector ScaledTarget{ Link.X + (Target.X - Link.X) * Scale, Link.Y + (Target.Y - Link.Y) * Scale, Link.Z + (Target.Z - Link.Z) * Scale };
+		FTestVector Axis{ 0.f, 0.f, 0.f };
+		float Angle = 0.f, AngleDelta = 0.f;
+
+		// Rounding may still leave a residual rotation, but never a NaN one.
+		if (FGaitMath::ComputeCCDLinkRotation(Link, Tip, ScaledTarget, Pi, true, AngleDelta, Axis, Angle))
+		{
+			EXPECT_FALSE(std::isnan(Angle));
+			EXPECT_LT(Angle, 1.e-2f);
+		}
+		EXPECT_FALSE(std::isnan(AngleDelta));
+		EXPECT_LT(AngleDelta, 1.e-2f);
+	}
+}